@@ -0,0 +1,320 @@
+/**
+ * @file archive_pc.c
+ *
+ * @brief Command-line front-end of the scenario archive (traffic_archive.h).
+ *
+ *     traffic_archive pack [--responses RESP.bin] COMMANDS.bin ARCHIVE.tsa
+ *     traffic_archive unpack [--from STEP] [--to STEP] ARCHIVE.tsa > COMMANDS.bin
+ *     traffic_archive json [--from STEP] [--to STEP] ARCHIVE.tsa > window.json
+ *     traffic_archive info ARCHIVE.tsa
+ *
+ * pack compresses a binary command stream (traffic_sim input, traffic_import
+ * output) and, with --responses, the step responses traffic_sim wrote for it,
+ * which adds the departures of every step. Only scenario commands are kept.
+ * unpack writes the command stream of the steps [from, to) back and json writes
+ * them in the formats of run_simulation.py: {"commands": [...]} with addVehicle,
+ * step and updateTiming commands (CMD_CONFIG and CMD_SET_STRATEGY as "config"
+ * and "setStrategy"), "timingPlans", and "stepStatuses" when the archive holds
+ * departures. Only the blocks of the window are read.
+ *
+ * traffic_sim writes archives itself with --record and replays them with --input.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "protocol.h"
+#include "traffic_fsm.h"
+#include "traffic_archive.h"
+
+static const char* const ROAD_NAMES[ROAD_COUNT] = {"north", "east", "south", "west"};
+
+static int usage(void) {
+    fprintf(stderr, "Usage: traffic_archive pack [--responses RESP.bin] COMMANDS.bin ARCHIVE.tsa\n"
+                    "       traffic_archive unpack [--from STEP] [--to STEP] ARCHIVE.tsa\n"
+                    "       traffic_archive json [--from STEP] [--to STEP] ARCHIVE.tsa\n"
+                    "       traffic_archive info ARCHIVE.tsa\n");
+    return 1;
+}
+
+/**
+ * @brief Payload size of a scenario command, -1 for commands that are not archived.
+ */
+static int payload_size(uint8_t cmd_type) {
+    switch (cmd_type) {
+        case CMD_CONFIG: return sizeof(PayloadConfig);
+        case CMD_ADD_VEHICLE: return sizeof(PayloadAddVehicle);
+        case CMD_STEP: return 0;
+        case CMD_SET_STRATEGY: return sizeof(PayloadStrategy);
+        case CMD_UPDATE_TIMING: return sizeof(PayloadConfig);
+        case CMD_ADD_TIMING_PLAN: return sizeof(PayloadTimingPlan);
+        default: return -1;
+    }
+}
+
+static int pack(const char* commands_path, const char* responses_path, const char* archive_path) {
+    FILE* in = fopen(commands_path, "rb");
+    FILE* responses = responses_path ? fopen(responses_path, "rb") : NULL;
+    FILE* out = fopen(archive_path, "wb");
+    if (!in || !out || (responses_path && !responses)) {
+        fprintf(stderr, "[C-ERR] Cannot open the input or output files\n");
+        return 1;
+    }
+
+    ArchiveWriter w;
+    archive_writer_open(&w, out, responses ? ARCHIVE_HAS_DEPARTURES : 0);
+    uint64_t in_bytes = 0, skipped = 0;
+    bool ok = true;
+    int c;
+
+    while (ok && (c = fgetc(in)) != EOF && c != CMD_STOP) {
+        uint8_t command[ARCHIVE_COMMAND_MAX] = {(uint8_t)c};
+        int size = payload_size((uint8_t)c);
+        if (size < 0) {
+            // Queries have responses of their own, which would desynchronise --responses
+            fprintf(stderr, "[C-ERR] Command %d is not a scenario command\n", c);
+            ok = !responses;
+            skipped++;
+            continue;
+        }
+        if (size > 0 && fread(command + 1, (size_t)size, 1, in) != 1) {
+            fprintf(stderr, "[C-WARN] Truncated command at byte %llu\n", (unsigned long long)in_bytes);
+            break;
+        }
+        in_bytes += 1 + (size_t)size;
+
+        if (c == CMD_ADD_VEHICLE) {
+            PayloadAddVehicle v;
+            memcpy(&v, command + 1, sizeof(v));
+            v.vehicle_id[VEHICLE_ID_LEN - 1] = '\0';
+            archive_write_vehicle(&w, v.vehicle_id, v.start_road, v.end_road, v.arrival_time);
+        } else if (c == CMD_STEP) {
+            ResponseStep resp = {0};
+            char departed[ARCHIVE_DEPARTURES_MAX][VEHICLE_ID_LEN];
+            if (responses) {
+                if (fread(&resp, sizeof(resp), 1, responses) != 1 || resp.vehicles_out > ARCHIVE_DEPARTURES_MAX ||
+                    (resp.vehicles_out > 0 && fread(departed, VEHICLE_ID_LEN, resp.vehicles_out, responses) != resp.vehicles_out)) {
+                    fprintf(stderr, "[C-ERR] Responses end before step %u\n", w.step + 1);
+                    ok = false;
+                    break;
+                }
+                for (uint16_t i = 0; i < resp.vehicles_out; i++) {
+                    departed[i][VEHICLE_ID_LEN - 1] = '\0';
+                }
+            }
+            archive_write_step(&w, (const char(*)[VEHICLE_ID_LEN])departed, resp.vehicles_out);
+        } else {
+            archive_write_command(&w, command, 1 + (size_t)size);
+        }
+    }
+
+    uint32_t steps = w.step;
+    ok = archive_writer_close(&w) && ok;
+    long out_bytes = ftell(out);
+    fclose(out);
+    fclose(in);
+    if (responses) fclose(responses);
+
+    if (!ok) {
+        fprintf(stderr, "[C-ERR] Packing failed\n");
+        remove(archive_path);
+        return 1;
+    }
+    fprintf(stderr, "[C-OK] %u steps, %llu command bytes -> %ld bytes (%.1fx)%s\n", steps,
+            (unsigned long long)in_bytes, out_bytes, out_bytes > 0 ? (double)in_bytes / out_bytes : 0.0,
+            skipped ? ", queries skipped" : "");
+    return 0;
+}
+
+static void json_string(const char* s) {
+    putchar('"');
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            printf("\\%c", c);
+        } else if (c < 0x20) {
+            printf("\\u%04x", c);
+        } else {
+            putchar(c);
+        }
+    }
+    putchar('"');
+}
+
+static void json_road(uint8_t road) {
+    if (road < ROAD_COUNT) {
+        printf("\"%s\"", ROAD_NAMES[road]);
+    } else {
+        printf("%u", road);
+    }
+}
+
+static void json_timing(const PayloadConfig* t) {
+    printf("{\"green_st\": %u, \"green_lt\": %u, \"yellow\": %u, \"all_red\": %u, "
+           "\"ext_threshold\": %u, \"max_ext\": %u, \"skip_limit\": %u}",
+           t->green_st, t->green_lt, t->yellow, t->all_red, t->ext_threshold, t->max_ext, t->skip_limit);
+}
+
+/**
+ * @brief Writes the events of the steps [from, to) as a command stream or as JSON.
+ */
+static int extract(ArchiveReader* r, uint32_t from, uint32_t to, bool json) {
+    ArchiveEvent e;
+    bool first_command = true;
+    PayloadTimingPlan* plans = NULL;
+    uint32_t n_plans = 0;
+
+    if (!archive_reader_seek(r, from)) {
+        fprintf(stderr, "[C-ERR] Corrupt archive\n");
+        return 1;
+    }
+
+    if (!json) {
+        if (!archive_export_commands(r, to, stdout)) {
+            fprintf(stderr, "[C-ERR] Corrupt archive or write error\n");
+            return 1;
+        }
+        return 0;
+    }
+
+    printf("{\n\"commands\": [");
+    while (archive_read_next(r, &e) && e.step < to) {
+        PayloadConfig timing;
+        if (e.type == ARCHIVE_EVENT_COMMAND && e.command[0] == CMD_ADD_TIMING_PLAN) {
+            PayloadTimingPlan* grown = realloc(plans, (n_plans + 1) * sizeof(PayloadTimingPlan));
+            if (grown && e.command_len == 1 + sizeof(PayloadTimingPlan)) {
+                plans = grown;
+                memcpy(&plans[n_plans++], e.command + 1, sizeof(PayloadTimingPlan));
+            }
+            continue;
+        }
+
+        printf(first_command ? "\n" : ",\n");
+        first_command = false;
+        if (e.type == ARCHIVE_EVENT_VEHICLE) {
+            printf("{\"type\": \"addVehicle\", \"vehicleId\": ");
+            json_string(e.id);
+            printf(", \"startRoad\": ");
+            json_road(e.start_road);
+            printf(", \"endRoad\": ");
+            json_road(e.end_road);
+            printf("}");
+        } else if (e.type == ARCHIVE_EVENT_STEP) {
+            printf("{\"type\": \"step\"}");
+        } else if ((e.command[0] == CMD_CONFIG || e.command[0] == CMD_UPDATE_TIMING) &&
+                   e.command_len == 1 + sizeof(PayloadConfig)) {
+            memcpy(&timing, e.command + 1, sizeof(timing));
+            printf("{\"type\": \"%s\", \"timing\": ", e.command[0] == CMD_CONFIG ? "config" : "updateTiming");
+            json_timing(&timing);
+            printf("}");
+        } else if (e.command[0] == CMD_SET_STRATEGY && e.command_len == 2) {
+            printf("{\"type\": \"setStrategy\", \"strategy\": \"v%u\"}", e.command[1] + 1u);
+        } else {
+            printf("{\"type\": \"command\", \"code\": %u}", e.command[0]);
+        }
+    }
+    if (r->corrupt) {
+        fprintf(stderr, "[C-ERR] Corrupt archive\n");
+        free(plans);
+        return 1;
+    }
+
+    printf("\n],\n\"timingPlans\": [");
+    for (uint32_t i = 0; i < n_plans; i++) {
+        printf("%s{\"startStep\": %u, \"timing\": ", i ? ",\n" : "\n", plans[i].start_step);
+        json_timing(&plans[i].timing);
+        printf("}");
+    }
+    free(plans);
+    printf("%s]", n_plans ? "\n" : "");
+
+    // Departures: second pass over the same blocks
+    if (r->flags & ARCHIVE_HAS_DEPARTURES) {
+        bool first_step = true;
+        printf(",\n\"stepStatuses\": [");
+        archive_reader_seek(r, from);
+        while (archive_read_next(r, &e) && e.step < to) {
+            if (e.type != ARCHIVE_EVENT_STEP) continue;
+            printf("%s{\"leftVehicles\": [", first_step ? "\n" : ",\n");
+            first_step = false;
+            for (uint16_t i = 0; i < e.departures; i++) {
+                if (i) printf(", ");
+                json_string(e.departed[i]);
+            }
+            printf("]}");
+        }
+        printf("\n]");
+    }
+    printf("\n}\n");
+    return 0;
+}
+
+static int info(ArchiveReader* r, const char* path) {
+    uint64_t vehicles = 0, bytes = 0;
+    for (uint32_t i = 0; i < r->block_count; i++) {
+        vehicles += r->index[i].vehicles;
+        bytes += r->index[i].length;
+    }
+    printf("%s: %u steps, %llu vehicles, %u blocks, %llu bytes of events, departures %s\n", path, r->total_steps,
+           (unsigned long long)vehicles, r->block_count, (unsigned long long)bytes,
+           (r->flags & ARCHIVE_HAS_DEPARTURES) ? "included" : "not included");
+    for (uint32_t i = 0; i < r->block_count; i++) {
+        const ArchiveBlockInfo* b = &r->index[i];
+        printf("  block %u: steps %u-%u, %u vehicles, %u bytes at %llu\n", i, b->first_step,
+               b->first_step + b->steps, b->vehicles, b->length, (unsigned long long)b->offset);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        return usage();
+    }
+    const char* mode = argv[1];
+    const char* responses = NULL;
+    const char* paths[2] = {NULL, NULL};
+    int n_paths = 0;
+    uint32_t from = 0, to = UINT32_MAX;
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--responses") == 0 && i + 1 < argc) {
+            responses = argv[++i];
+        } else if (strcmp(argv[i], "--from") == 0 && i + 1 < argc) {
+            from = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--to") == 0 && i + 1 < argc) {
+            to = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (n_paths < 2 && argv[i][0] != '-') {
+            paths[n_paths++] = argv[i];
+        } else {
+            return usage();
+        }
+    }
+
+    if (strcmp(mode, "pack") == 0) {
+        return n_paths == 2 ? pack(paths[0], responses, paths[1]) : usage();
+    }
+    if (n_paths != 1 || responses) {
+        return usage();
+    }
+
+    FILE* f = fopen(paths[0], "rb");
+    ArchiveReader r;
+    if (!f || !archive_reader_open(&r, f)) {
+        fprintf(stderr, "[C-ERR] %s is not a valid archive\n", paths[0]);
+        return 1;
+    }
+
+    int status;
+    if (strcmp(mode, "unpack") == 0 || strcmp(mode, "json") == 0) {
+        status = extract(&r, from, to, strcmp(mode, "json") == 0);
+    } else if (strcmp(mode, "info") == 0) {
+        status = info(&r, paths[0]);
+    } else {
+        status = usage();
+    }
+
+    archive_reader_close(&r);
+    fclose(f);
+    return status;
+}
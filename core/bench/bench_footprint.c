@@ -0,0 +1,181 @@
+/**
+ * @file bench_footprint.c
+ * @brief Memory per intersection and step throughput for 1, 1k and 100k intersections.
+ *
+ * Each size runs in its own process, so that its peak RSS is its own. The
+ * intersections are hosted as a worker does (traffic_sessions.h): up to
+ * SESSION_ID_MAX + 1 per table, SESSION_CACHE_DEFAULT of them live per table
+ * (--cache N, fewer for smaller sizes), the others parked as snapshots. For each size the benchmark reports the
+ * accounted bytes per intersection (sessions_footprint()) at rest, right after
+ * creation, and under jam load, after every lane has been filled and the
+ * intersections have been stepped in rounds at a saturated arrival rate. It
+ * also reports the peak RSS per intersection and the steps per second of the
+ * rounds, including the parking and unparking of sessions.
+ *
+ * Usage: bench_footprint [--cache N] [SIZE...]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "traffic_sessions.h"
+
+#define MIN_ROUNDS 3
+#define TARGET_STEPS 300000u // Steps per size, spread over the intersections
+#define ARRIVAL_PERCENT 60 // Per road and step during the rounds
+#define TABLE_SIZE (SESSION_ID_MAX + 1)
+
+static uint32_t cache_capacity = SESSION_CACHE_DEFAULT;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static long peak_rss_kb(void) {
+    struct rusage usage;
+    return (getrusage(RUSAGE_SELF, &usage) == 0) ? usage.ru_maxrss : 0;
+}
+
+/**
+ * @brief Sums the footprints of the tables.
+ */
+static void footprint(const SessionTable* tables, uint32_t n_tables, SessionsFootprint* total) {
+    sessions_footprint(NULL, total);
+    for (uint32_t t = 0; t < n_tables; t++) {
+        SessionsFootprint f;
+        sessions_footprint(&tables[t], &f);
+        total->sessions += f.sessions;
+        total->live += f.live;
+        total->parked += f.parked;
+        total->total_bytes += f.total_bytes;
+        if (f.parked_max > total->parked_max) total->parked_max = f.parked_max;
+        if (f.peak_queue > total->peak_queue) total->peak_queue = f.peak_queue;
+    }
+}
+
+/**
+ * @brief Adds the arrivals of one step (ARRIVAL_PERCENT per road).
+ */
+static void add_arrivals(TrafficSystem* sys, uint32_t* seed) {
+    char id[12];
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        *seed = *seed * 1103515245u + 12345u;
+        if ((*seed >> 16) % 100 >= ARRIVAL_PERCENT) continue;
+        snprintf(id, sizeof(id), "j%u", (unsigned)(*seed >> 12) % 100000u);
+        traffic_add_vehicle(sys, id, road, (road + 1 + (*seed >> 8) % 3) % ROAD_COUNT, sys->current_step);
+    }
+}
+
+/**
+ * @brief Measures one size (in the calling process).
+ *
+ * @return 0 on success
+ */
+static int measure(uint32_t size) {
+    uint32_t n_tables = (size + TABLE_SIZE - 1) / TABLE_SIZE;
+    SessionTable* tables = calloc(n_tables, sizeof(SessionTable));
+    TimingConfig config = DEFAULT_TIMING;
+    char out_ids[ROAD_COUNT * LANES_PER_ROAD][VEHICLE_ID_LEN];
+    uint32_t seed = 12345;
+    long base_rss = peak_rss_kb();
+
+    uint32_t cache_slots = size < cache_capacity ? size : cache_capacity;
+
+    for (uint32_t i = 0; tables && i < size; i++) {
+        SessionTable* table = &tables[i / TABLE_SIZE];
+        if ((i % TABLE_SIZE == 0 && !sessions_init(table, cache_slots)) ||
+            !sessions_create(table, (uint16_t)(i % TABLE_SIZE), config)) {
+            fprintf(stderr, "Out of memory at %u intersections\n", i);
+            return 1;
+        }
+    }
+
+    SessionsFootprint rest, jam;
+    footprint(tables, n_tables, &rest);
+
+    // Jam: every lane full, then rounds of saturated arrivals
+    for (uint32_t i = 0; i < size; i++) {
+        TrafficSystem* sys = sessions_acquire(&tables[i / TABLE_SIZE], (uint16_t)(i % TABLE_SIZE));
+        if (!sys) {
+            fprintf(stderr, "Cannot acquire intersection %u\n", i);
+            return 1;
+        }
+        for (uint32_t v = 0; v < MAX_VEHICLES_PER_ROAD; v++) {
+            for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+                traffic_add_vehicle(sys, "jam", road, (road + 1) % ROAD_COUNT, 0); // Left lane
+                traffic_add_vehicle(sys, "jam", road, (road + 2) % ROAD_COUNT, 0); // Straight lane
+            }
+        }
+    }
+
+    uint32_t rounds = TARGET_STEPS / size;
+    if (rounds < MIN_ROUNDS) rounds = MIN_ROUNDS;
+
+    double start = now_ns();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (uint32_t i = 0; i < size; i++) {
+            TrafficSystem* sys = sessions_acquire(&tables[i / TABLE_SIZE], (uint16_t)(i % TABLE_SIZE));
+            if (!sys) {
+                fprintf(stderr, "Cannot acquire intersection %u\n", i);
+                return 1;
+            }
+            add_arrivals(sys, &seed);
+            traffic_fsm_step(sys, out_ids);
+        }
+    }
+    double elapsed = now_ns() - start;
+    footprint(tables, n_tables, &jam);
+    long rss = peak_rss_kb() - base_rss;
+
+    printf("%7u  %10.0f %10.0f %10.0f  %10u/%u  %12.0f\n", size, (double)rest.total_bytes / size,
+           (double)jam.total_bytes / size, rss * 1024.0 / size, jam.peak_queue, MAX_VEHICLES_PER_ROAD,
+           (double)rounds * size / (elapsed / 1e9));
+
+    for (uint32_t t = 0; t < n_tables; t++) {
+        sessions_free(&tables[t]);
+    }
+    free(tables);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    const uint32_t default_sizes[] = {1, 1000, 100000};
+    int first = 1;
+    if (argc > 2 && strcmp(argv[1], "--cache") == 0) {
+        cache_capacity = (uint32_t)strtoul(argv[2], NULL, 10);
+        first = 3;
+    }
+    uint32_t n_sizes = (argc > first) ? (uint32_t)(argc - first) : 3;
+
+    printf("TrafficSystem %zu bytes, up to %u live per table\n", sizeof(TrafficSystem), cache_capacity);
+    printf("         -------- bytes per intersection --------\n");
+    printf("  count     at rest     jammed   peak RSS  longest queue       steps/s\n");
+    fflush(stdout);
+
+    for (uint32_t s = 0; s < n_sizes; s++) {
+        uint32_t size = (argc > first) ? (uint32_t)strtoul(argv[s + first], NULL, 10) : default_sizes[s];
+        if (size == 0) continue;
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            int rc = measure(size);
+            fflush(stdout);
+            _exit(rc);
+        }
+
+        int status = 0;
+        if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "Measurement of %u intersections failed\n", size);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file bench_queue.c
+ * @brief Per-vehicle cost of the VehicleQueue operations.
+ *
+ * Pushes vehicles through one lane, one at a time (queue_enqueue/queue_dequeue)
+ * and in batches of several sizes (queue_enqueue_n, then one queue_dequeue per
+ * vehicle as in the FSM), so that the head and tail keep crossing the wrap point
+ * of the ring. Each figure is the best
+ * of REPEATS runs, in ns per vehicle for an enqueue plus a dequeue.
+ *
+ * Usage: bench_queue [VEHICLES]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "traffic_queue.h"
+
+#define DEFAULT_VEHICLES 20000000u
+#define REPEATS 5 // Best of
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief Moves `vehicles` vehicles through the lane in batches of `batch` (0 = single operations).
+ *
+ * @return Elapsed time in ns
+ */
+static double run(uint32_t vehicles, uint16_t batch, uint64_t* checksum) {
+    static VehicleQueue q;
+    Vehicle in[MAX_VEHICLES_PER_ROAD];
+    char id[VEHICLE_ID_LEN];
+    uint64_t sum = 0;
+
+    queue_init(&q);
+    for (uint16_t i = 0; i < MAX_VEHICLES_PER_ROAD; i++) {
+        memset(&in[i], 0, sizeof(Vehicle));
+        snprintf(in[i].id, VEHICLE_ID_LEN, "vehicle_%u", (unsigned)i);
+        in[i].end_road = SOUTH;
+    }
+
+    // Keep a partially filled queue, so the batches cross the wrap point
+    queue_enqueue_n(&q, in, MAX_VEHICLES_PER_ROAD / 3);
+
+    double start = now_ns();
+    if (batch == 0) {
+        for (uint32_t v = 0; v < vehicles; v++) {
+            queue_enqueue(&q, in[v % MAX_VEHICLES_PER_ROAD].id, NORTH, SOUTH, v);
+            queue_dequeue(&q, id, v + 3, NULL);
+            sum += (uint8_t)id[8];
+        }
+    } else {
+        for (uint32_t v = 0; v < vehicles; v += batch) {
+            in[0].arrival_step = v;
+            queue_enqueue_n(&q, in, batch);
+            for (uint16_t i = 0; i < batch; i++) {
+                queue_dequeue(&q, id, v + 3, NULL);
+            }
+            sum += (uint8_t)id[8];
+        }
+    }
+    double elapsed = now_ns() - start;
+
+    *checksum = sum + q.max_wait_time + wait_hist_total(&q.wait_hist);
+    return elapsed;
+}
+
+int main(int argc, char** argv) {
+    uint32_t vehicles = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : DEFAULT_VEHICLES;
+    const uint16_t batches[] = {0, 1, 2, 4, 8, 16, 32};
+    const int batch_count = sizeof(batches) / sizeof(batches[0]);
+    double best[sizeof(batches) / sizeof(batches[0])];
+    uint64_t checksum = 0;
+
+    for (int i = 0; i < batch_count; i++) best[i] = 1e300;
+    for (int r = 0; r < REPEATS; r++) {
+        for (int i = 0; i < batch_count; i++) {
+            double ns = run(vehicles, batches[i], &checksum);
+            if (ns < best[i]) best[i] = ns;
+        }
+    }
+
+    printf("single enqueue/dequeue  %6.2f ns/vehicle\n", best[0] / vehicles);
+    for (int i = 1; i < batch_count; i++) {
+        printf("batches of %2u           %6.2f ns/vehicle\n", batches[i], best[i] / vehicles);
+    }
+    printf("(checksum %llu)\n", (unsigned long long)checksum);
+    return 0;
+}
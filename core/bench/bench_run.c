@@ -0,0 +1,166 @@
+/**
+ * @file bench_run.c
+ * @brief Scenario throughput of traffic_run() against the per-event API.
+ *
+ * For each load profile, replays the same pre-generated scenario (unique IDs,
+ * sorted by step) through traffic_add_vehicle() + traffic_fsm_step() and through
+ * traffic_run() with a counting sink and without a sink. The departures and
+ * statistics must be the same for all three. Each figure is the best of REPEATS
+ * runs; where permitted, the hardware counters (perf_counters.h) of that run
+ * are reported per step.
+ *
+ * Usage: bench_run [STEPS]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "traffic_fsm.h"
+#include "perf_counters.h"
+
+#define DEFAULT_STEPS 2000000u
+#define REPEATS 5 // Best of
+#define MODE_COUNT 3
+
+/**
+ * @brief Load profile: probability of an arrival per road and step.
+ */
+typedef struct {
+    const char* name;
+    uint32_t percent;
+} LoadProfile;
+
+static const LoadProfile PROFILES[] = {
+    {"light", 10},
+    {"rush", 30},
+    {"saturated", 60},
+};
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief Generates the arrivals of a profile.
+ *
+ * @return Number of arrivals
+ */
+static uint32_t make_scenario(const LoadProfile* profile, uint32_t steps, TrafficArrival* arrivals,
+                              char (*ids)[VEHICLE_ID_LEN]) {
+    uint32_t n = 0, seed = 12345;
+    for (uint32_t step = 0; step < steps; step++) {
+        for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+            seed = seed * 1103515245u + 12345u;
+            if ((seed >> 16) % 100 >= profile->percent) continue;
+            snprintf(ids[n], VEHICLE_ID_LEN, "vehicle_%u", (unsigned)n);
+            arrivals[n].id = ids[n];
+            arrivals[n].step = step;
+            arrivals[n].start_road = road;
+            arrivals[n].end_road = (uint8_t)((road + 1 + (seed >> 8) % 3) % ROAD_COUNT);
+            n++;
+        }
+    }
+    return n;
+}
+
+static void count_departure(void* ctx, const Vehicle* v, uint32_t step, uint32_t wait) {
+    (void)step;
+    (void)wait;
+    *(uint64_t*)ctx += (uint8_t)v->id[8];
+}
+
+/**
+ * @brief Runs the scenario (mode 0: per-event API, 1: traffic_run with sink, 2: without sink).
+ *
+ * @return Elapsed time in ns
+ */
+static double run(int mode, uint32_t steps, const TrafficArrival* arrivals, uint32_t n, PerfCounters* counters,
+                  uint64_t* checksum) {
+    TimingConfig config = DEFAULT_TIMING;
+    TrafficSystem* sys = malloc(sizeof(TrafficSystem));
+    char out_ids[ROAD_COUNT * LANES_PER_ROAD][VEHICLE_ID_LEN];
+    uint64_t departed = 0;
+    TrafficRunSink sink = {count_departure, &departed};
+
+    traffic_init(sys, config);
+
+    perf_counters_start(counters);
+    double start = now_ns();
+    if (mode == 0) {
+        uint32_t next = 0;
+        for (uint32_t step = 0; step < steps; step++) {
+            while (next < n && arrivals[next].step <= sys->current_step) {
+                const TrafficArrival* a = &arrivals[next++];
+                traffic_add_vehicle(sys, a->id, a->start_road, a->end_road, a->step);
+            }
+            uint8_t count = traffic_fsm_step(sys, out_ids);
+            for (uint8_t i = 0; i < count; i++) departed += (uint8_t)out_ids[i][8];
+        }
+    } else {
+        traffic_run(sys, arrivals, n, steps, mode == 1 ? &sink : NULL);
+    }
+    double elapsed = now_ns() - start;
+    perf_counters_stop(counters);
+
+    *checksum = sys->stats.departures * 1000003ull + sys->stats.total_wait;
+    if (mode != 2) *checksum ^= departed << 40;
+    free(sys);
+    return elapsed;
+}
+
+int main(int argc, char** argv) {
+    uint32_t steps = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : DEFAULT_STEPS;
+    const char* names[MODE_COUNT] = {"add_vehicle + fsm_step", "traffic_run, sink", "traffic_run, no sink"};
+    PerfCounters counters;
+
+    TrafficArrival* arrivals = malloc((size_t)steps * ROAD_COUNT * sizeof(TrafficArrival));
+    char (*ids)[VEHICLE_ID_LEN] = malloc((size_t)steps * ROAD_COUNT * VEHICLE_ID_LEN);
+    if (!arrivals || !ids) {
+        fprintf(stderr, "Cannot allocate the scenario\n");
+        return 1;
+    }
+    bool have_counters = perf_counters_open(&counters);
+    if (!have_counters) {
+        perf_counters_print(&counters, "hardware counters:", 1);
+    }
+
+    for (size_t p = 0; p < sizeof(PROFILES) / sizeof(PROFILES[0]); p++) {
+        double best[MODE_COUNT] = {1e300, 1e300, 1e300};
+        PerfCounters best_counters[MODE_COUNT] = {counters, counters, counters};
+        uint64_t checksums[MODE_COUNT];
+        uint32_t n = make_scenario(&PROFILES[p], steps, arrivals, ids);
+
+        for (int r = 0; r < REPEATS; r++) {
+            // Interleaved, so frequency changes affect every mode alike
+            for (int mode = 0; mode < MODE_COUNT; mode++) {
+                double ns = run(mode, steps, arrivals, n, &counters, &checksums[mode]);
+                if (ns < best[mode]) {
+                    best[mode] = ns;
+                    best_counters[mode] = counters;
+                }
+            }
+            uint64_t stats_mask = (1ull << 40) - 1;
+            if (checksums[0] != checksums[1] || (checksums[0] & stats_mask) != (checksums[2] & stats_mask)) {
+                fprintf(stderr, "traffic_run diverged from the per-event API (%s)\n", PROFILES[p].name);
+                return 1;
+            }
+        }
+
+        printf("%s: %u arrivals over %u steps\n", PROFILES[p].name, (unsigned)n, (unsigned)steps);
+        for (int mode = 0; mode < MODE_COUNT; mode++) {
+            printf("  %-24s %7.1f ns/step  %5.2fx\n", names[mode], best[mode] / steps, best[0] / best[mode]);
+            if (have_counters) {
+                perf_counters_print(&best_counters[mode], "    per step:", steps);
+            }
+        }
+    }
+
+    perf_counters_close(&counters);
+    free(ids);
+    free(arrivals);
+    return 0;
+}
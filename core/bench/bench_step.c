@@ -0,0 +1,136 @@
+/**
+ * @file bench_step.c
+ * @brief Step and decision throughput of the FSM on a deterministic rush-hour load.
+ *
+ * Built twice by `make bench`: generic, and with TRAFFIC_FROZEN_TIMING, so the two
+ * lines of output compare the frozen-configuration step with the generic one. The
+ * load runs DEFAULT_TIMING, so with FROZEN_TIMING at its default the checksum must be
+ * the same for both builds. Each figure is the best of REPEATS runs. Where permitted,
+ * the hardware counters (perf_counters.h) of the fastest step loop are reported per
+ * step.
+ *
+ * Usage: bench_step [STEPS]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "traffic_fsm.h"
+#include "perf_counters.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define DEFAULT_STEPS 2000000u
+#define DECISIONS_PER_STEP 8 // Extra decisions per step in the decision loop
+#define REPEATS 5 // Best of
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint64_t ticks(void) {
+#ifdef HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Adds the arrivals of one step (about 0.3 vehicles per road).
+ */
+static void add_arrivals(TrafficSystem* sys, uint32_t* seed) {
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        *seed = *seed * 1103515245u + 12345u;
+        if ((*seed >> 16) % 100 >= 30) continue;
+        traffic_add_vehicle(sys, "bench", road, (road + 1 + (*seed >> 8) % 3) % ROAD_COUNT,
+                            sys->current_step);
+    }
+}
+
+/**
+ * @brief Runs the simulation, with `extra` additional decisions per step.
+ *
+ * @param counters Counters to run around the step loop (NULL = none)
+ */
+static void run(uint32_t steps, int extra, PerfCounters* counters, double* ns, uint64_t* tsc, uint64_t* checksum) {
+    TimingConfig config = DEFAULT_TIMING;
+    TrafficSystem* sys = malloc(sizeof(TrafficSystem));
+    char out_ids[ROAD_COUNT * LANES_PER_ROAD][VEHICLE_ID_LEN];
+    uint32_t seed = 12345;
+    uint64_t sum = 0;
+
+    traffic_init(sys, config);
+
+    if (counters) perf_counters_start(counters);
+    double start = now_ns();
+    uint64_t start_tsc = ticks();
+    for (uint32_t step = 0; step < steps; step++) {
+        add_arrivals(sys, &seed);
+        traffic_fsm_advance_clock(sys);
+
+        TrafficDecision decision;
+        for (int i = 0; i < extra; i++) {
+            traffic_fsm_decide(sys, &sys->timing, &decision);
+            sum += decision.next_state;
+        }
+        traffic_fsm_decide(sys, &sys->timing, &decision);
+        traffic_fsm_apply(sys, &decision, out_ids);
+    }
+    *tsc = ticks() - start_tsc;
+    *ns = now_ns() - start;
+    if (counters) perf_counters_stop(counters);
+    *checksum = sys->stats.departures * 1000003ull + sys->stats.total_wait + sum;
+
+    free(sys);
+}
+
+int main(int argc, char** argv) {
+    uint32_t steps = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : DEFAULT_STEPS;
+    double step_ns, extra_ns;
+    uint64_t step_tsc, extra_tsc, checksum, extra_checksum;
+    PerfCounters counters, best_counters;
+
+    bool have_counters = perf_counters_open(&counters);
+    best_counters = counters;
+
+    step_ns = extra_ns = 1e300;
+    step_tsc = extra_tsc = UINT64_MAX;
+    for (int r = 0; r < REPEATS; r++) {
+        double ns;
+        uint64_t tsc;
+        run(steps, 0, &counters, &ns, &tsc, &checksum);
+        if (ns < step_ns) {
+            step_ns = ns;
+            best_counters = counters;
+        }
+        if (tsc < step_tsc) step_tsc = tsc;
+
+        run(steps, DECISIONS_PER_STEP, NULL, &ns, &tsc, &extra_checksum);
+        if (ns < extra_ns) extra_ns = ns;
+        if (tsc < extra_tsc) extra_tsc = tsc;
+    }
+
+    double decisions = (double)steps * DECISIONS_PER_STEP;
+#ifdef TRAFFIC_FROZEN_TIMING
+    const char* build = "frozen";
+#else
+    const char* build = "generic";
+#endif
+
+    printf("%-8s %7.1f ns/step %7.1f ns/decision", build, step_ns / steps, (extra_ns - step_ns) / decisions);
+#ifdef HAVE_TSC
+    printf(" %7.1f TSC ticks/decision", (double)(extra_tsc - step_tsc) / decisions);
+#endif
+    printf("  checksum %llu\n", (unsigned long long)checksum);
+    perf_counters_print(&best_counters, have_counters ? "         per step:" : "         hardware counters:", steps);
+    perf_counters_close(&counters);
+    return 0;
+}
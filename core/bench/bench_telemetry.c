@@ -0,0 +1,133 @@
+/**
+ * @file bench_telemetry.c
+ * @brief Cost of the sampled telemetry (traffic_telemetry.h) on the step loop.
+ *
+ * Runs the rush-hour load of bench_step without telemetry and with a sample
+ * every N steps, and reports the overhead of each sampling rate. The record is
+ * published into a memory-mapped file like traffic_sim --telemetry does. At
+ * sparse rates the overhead is below the run-to-run noise, so the budget check
+ * extrapolates the cost of one sample (measured with a sample every step) to
+ * the default rate and fails above OVERHEAD_BUDGET percent. Each figure is the
+ * best of REPEATS runs.
+ *
+ * Usage: bench_telemetry [STEPS]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "traffic_fsm.h"
+#include "traffic_telemetry.h"
+
+#define DEFAULT_STEPS 2000000u
+#define REPEATS 5 // Best of
+#define OVERHEAD_BUDGET 3.0 // Percent at TELEMETRY_EVERY_DEFAULT
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief Adds the arrivals of one step (about 0.3 vehicles per road).
+ */
+static void add_arrivals(TrafficSystem* sys, uint32_t* seed) {
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        *seed = *seed * 1103515245u + 12345u;
+        if ((*seed >> 16) % 100 >= 30) continue;
+        traffic_add_vehicle(sys, "bench", road, (road + 1 + (*seed >> 8) % 3) % ROAD_COUNT,
+                            sys->current_step);
+    }
+}
+
+/**
+ * @brief Runs the simulation with a sample every `every` steps (0 = no telemetry).
+ *
+ * @return Elapsed time in ns
+ */
+static double run(uint32_t steps, uint32_t every, TelemetryRecord* record, uint64_t* checksum) {
+    TimingConfig config = DEFAULT_TIMING;
+    TrafficSystem* sys = malloc(sizeof(TrafficSystem));
+    char out_ids[ROAD_COUNT * LANES_PER_ROAD][VEHICLE_ID_LEN];
+    TrafficTelemetry telemetry = {0};
+    uint32_t seed = 12345;
+
+    traffic_init(sys, config);
+    if (every > 0) {
+        traffic_telemetry_init(&telemetry, record, every, sys);
+    }
+
+    double start = now_ns();
+    for (uint32_t step = 0; step < steps; step++) {
+        add_arrivals(sys, &seed);
+        traffic_fsm_step(sys, out_ids);
+        if (telemetry.record) {
+            traffic_telemetry_step(&telemetry, sys);
+        }
+    }
+    double elapsed = now_ns() - start;
+
+    *checksum = sys->stats.departures * 1000003ull + sys->stats.total_wait;
+    free(sys);
+    return elapsed;
+}
+
+int main(int argc, char** argv) {
+    uint32_t steps = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : DEFAULT_STEPS;
+    const uint32_t rates[] = {0, 1000, TELEMETRY_EVERY_DEFAULT, 10, 1};
+    const int rate_count = sizeof(rates) / sizeof(rates[0]);
+    double best[sizeof(rates) / sizeof(rates[0])];
+
+    char path[] = "/tmp/bench_telemetry_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0 || ftruncate(fd, sizeof(TelemetryRecord)) != 0) {
+        fprintf(stderr, "Cannot create the telemetry file\n");
+        return 1;
+    }
+    TelemetryRecord* record = mmap(NULL, sizeof(TelemetryRecord), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    unlink(path);
+    if (record == MAP_FAILED) {
+        fprintf(stderr, "Cannot map the telemetry file\n");
+        return 1;
+    }
+
+    uint64_t reference = 0, checksum;
+    for (int i = 0; i < rate_count; i++) best[i] = 1e300;
+    for (int r = 0; r < REPEATS; r++) {
+        // Interleaved, so frequency changes affect every rate alike
+        for (int i = 0; i < rate_count; i++) {
+            double ns = run(steps, rates[i], record, &checksum);
+            if (ns < best[i]) best[i] = ns;
+            if (i == 0) reference = checksum;
+            if (checksum != reference) {
+                fprintf(stderr, "Telemetry changed the simulation (rate %u)\n", rates[i]);
+                return 1;
+            }
+        }
+    }
+    munmap(record, sizeof(TelemetryRecord));
+
+    printf("telemetry off       %7.1f ns/step\n", best[0] / steps);
+    for (int i = 1; i < rate_count; i++) {
+        double overhead = (best[i] - best[0]) / best[0] * 100.0;
+        printf("every %5u steps   %7.1f ns/step  %+6.2f %%\n", rates[i], best[i] / steps, overhead);
+    }
+
+    double sample_ns = (best[rate_count - 1] - best[0]) / steps;
+    double budget_overhead = sample_ns / TELEMETRY_EVERY_DEFAULT / (best[0] / steps) * 100.0;
+    printf("%.1f ns/sample: %.2f %% at the default rate (every %u steps, budget %.1f %%)\n", sample_ns,
+           budget_overhead, TELEMETRY_EVERY_DEFAULT, OVERHEAD_BUDGET);
+
+    if (budget_overhead > OVERHEAD_BUDGET) {
+        printf("Default sampling exceeds the %.1f %% budget\n", OVERHEAD_BUDGET);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file perf_counters.c
+ * @brief perf_event_open counters for the benchmarks, with a no-op fallback.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "perf_counters.h"
+
+static const char* const COUNTER_NAMES[PERF_COUNTER_COUNT] = {
+    "cycles", "instr", "br-miss", "L1d-miss", "LLC-miss"
+};
+
+#ifdef __linux__
+
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#define CACHE_READ_MISS(cache) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static const struct {
+    uint32_t type;
+    uint64_t config;
+} COUNTER_EVENTS[PERF_COUNTER_COUNT] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D)},
+    {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_LL)},
+};
+
+bool perf_counters_open(PerfCounters* pc) {
+    bool any = false;
+    memset(pc, 0, sizeof(*pc));
+
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = COUNTER_EVENTS[c].type;
+        attr.config = COUNTER_EVENTS[c].config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1; // Permitted up to perf_event_paranoid 2
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        pc->fds[c] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        if (pc->fds[c] < 0 && pc->error == 0) {
+            pc->error = errno;
+        }
+        any = any || pc->fds[c] >= 0;
+    }
+    return any;
+}
+
+void perf_counters_start(PerfCounters* pc) {
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+        if (pc->fds[c] < 0) continue;
+        ioctl(pc->fds[c], PERF_EVENT_IOC_RESET, 0);
+        ioctl(pc->fds[c], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void perf_counters_stop(PerfCounters* pc) {
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+        if (pc->fds[c] < 0) continue;
+        ioctl(pc->fds[c], PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+        uint64_t data[3]; // value, time enabled, time running
+        pc->values[c] = 0;
+        if (pc->fds[c] < 0 || read(pc->fds[c], data, sizeof(data)) != (ssize_t)sizeof(data)) continue;
+
+        pc->values[c] = data[0];
+        if (data[2] > 0 && data[2] < data[1]) {
+            pc->values[c] = (uint64_t)((double)data[0] * data[1] / data[2]);
+        }
+    }
+}
+
+void perf_counters_close(PerfCounters* pc) {
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+        if (pc->fds[c] >= 0) close(pc->fds[c]);
+        pc->fds[c] = -1;
+    }
+}
+
+#else // !__linux__
+
+bool perf_counters_open(PerfCounters* pc) {
+    memset(pc, 0, sizeof(*pc));
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++) pc->fds[c] = -1;
+    pc->error = ENOSYS;
+    return false;
+}
+
+void perf_counters_start(PerfCounters* pc) { (void)pc; }
+void perf_counters_stop(PerfCounters* pc) { (void)pc; }
+void perf_counters_close(PerfCounters* pc) { (void)pc; }
+
+#endif // __linux__
+
+void perf_counters_print(const PerfCounters* pc, const char* label, double per) {
+    bool any = false;
+    printf("%s", label);
+
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+        if (!perf_counter_available(pc, c)) continue;
+        printf("  %s %.2f", COUNTER_NAMES[c], pc->values[c] / per);
+        any = true;
+    }
+    if (perf_counter_available(pc, PERF_CYCLES) && perf_counter_available(pc, PERF_INSTRUCTIONS) &&
+        pc->values[PERF_CYCLES] > 0) {
+        printf("  IPC %.2f", (double)pc->values[PERF_INSTRUCTIONS] / pc->values[PERF_CYCLES]);
+    }
+
+    if (!any) {
+        // ENOENT: no (virtual) PMU; EACCES/EPERM: perf_event_paranoid or seccomp
+        printf("  counters unavailable (%s)", strerror(pc->error));
+    }
+    printf("\n");
+}
@@ -0,0 +1,74 @@
+/**
+ * @file perf_counters.h
+ * @brief Hardware performance counters (Linux perf_event_open) for the benchmarks.
+ * @details Counts cycles, instructions, branch misses and L1d/LLC read misses of
+ * the calling thread in user space, around a measured region. Each counter is
+ * opened on its own, so a PMU without one of the events still reports the
+ * others. Where counters are not permitted (perf_event_paranoid, containers,
+ * VMs without a virtual PMU, other systems) every counter is unavailable, the
+ * calls do nothing and perf_counters_print() says why.
+ */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS,
+    PERF_BRANCH_MISSES,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_COUNTER_COUNT
+} PerfCounter;
+
+/**
+ * @brief Counters of one measured region.
+ */
+typedef struct {
+    int fds[PERF_COUNTER_COUNT]; // -1 if unavailable
+    uint64_t values[PERF_COUNTER_COUNT]; // Counts of the last start/stop region
+    int error; // errno of the first counter that failed to open
+} PerfCounters;
+
+/**
+ * @brief Opens the counters (disabled).
+ *
+ * @return true if at least one counter is available
+ */
+bool perf_counters_open(PerfCounters* pc);
+
+/**
+ * @brief Resets and enables the counters.
+ */
+void perf_counters_start(PerfCounters* pc);
+
+/**
+ * @brief Disables the counters and stores their counts in values[].
+ *
+ * @details Counts are scaled up if the kernel multiplexed the counters.
+ */
+void perf_counters_stop(PerfCounters* pc);
+
+/**
+ * @brief Closes the counters.
+ */
+void perf_counters_close(PerfCounters* pc);
+
+/**
+ * @brief True if the counter could be opened.
+ */
+static inline bool perf_counter_available(const PerfCounters* pc, PerfCounter c) {
+    return pc->fds[c] >= 0;
+}
+
+/**
+ * @brief Prints the counts divided by `per` (e.g. per step), or why there are none.
+ *
+ * @param label Prefix of the line
+ */
+void perf_counters_print(const PerfCounters* pc, const char* label, double per);
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,288 @@
+/**
+ * @file diff_engine.c
+ * @brief Differential harness: live engine vs the frozen reference kernel.
+ *
+ * Runs randomised scenarios (timing, strategy, arrival rate, timing updates,
+ * plans, restarts) on both engines in lock-step and compares every return value,
+ * every departing vehicle ID (and their order), and after each step the lights,
+ * FSM state, queues, statistics and wait histograms (RefObservation). The live
+ * engine is stepped either with traffic_fsm_step() or with the
+ * advance_clock/decide/apply split, chosen at random.
+ *
+ * Every scenario derives from its own seed, printed on a mismatch together with
+ * the step and the differing observation, so it replays with `diff_engine 1 SEED`.
+ *
+ * Usage: diff_engine [SCENARIOS] [SEED]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "traffic_fsm.h"
+#include "reference/ref_engine.h"
+
+#define DEFAULT_SCENARIOS 1000u
+#define DEFAULT_SEED 1u
+#define MAX_SCENARIO_STEPS 2000u
+
+_Static_assert(REF_ROAD_COUNT == ROAD_COUNT && REF_LANES_PER_ROAD == LANES_PER_ROAD &&
+               REF_MOVEMENT_COUNT == MOVEMENT_COUNT && REF_VEHICLE_ID_LEN == VEHICLE_ID_LEN &&
+               REF_HIST_BUCKETS == WAIT_HIST_BUCKETS, "Live layout does not match ref_engine.h");
+
+/**
+ * @brief splitmix64 generator, one stream per scenario.
+ */
+static uint64_t next_random(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static uint32_t random_below(uint64_t* state, uint32_t bound) {
+    return (uint32_t)(next_random(state) % bound);
+}
+
+/**
+ * @brief Random timing: mostly plausible values, sometimes zeros, sometimes DEFAULT_TIMING.
+ * A frozen build runs its compiled-in timing only, so that is all it gets.
+ */
+static TimingConfig random_timing(uint64_t* rng) {
+#ifdef TRAFFIC_FROZEN_TIMING
+    TimingConfig timing = TRAFFIC_FROZEN_TIMING;
+    (void)rng;
+    return timing;
+#else
+    TimingConfig timing = DEFAULT_TIMING;
+    if (random_below(rng, 4) == 0) {
+        return timing;
+    }
+
+    uint32_t zero_chance = random_below(rng, 8) == 0 ? 4 : 0; // Zero durations in 1 of 8 configs
+    timing.green_st = random_below(rng, 30) + (random_below(rng, 16) < zero_chance ? 0 : 1);
+    timing.green_lt = random_below(rng, 20) + (random_below(rng, 16) < zero_chance ? 0 : 1);
+    timing.yellow = random_below(rng, 5) + (random_below(rng, 16) < zero_chance ? 0 : 1);
+    timing.all_red = random_below(rng, 5) + (random_below(rng, 16) < zero_chance ? 0 : 1);
+    timing.red_yellow = random_below(rng, 3) + (random_below(rng, 16) < zero_chance ? 0 : 1);
+    timing.ext_threshold = random_below(rng, 12);
+    timing.max_ext = random_below(rng, 40);
+    timing.skip_limit = random_below(rng, 6);
+    return timing;
+#endif
+}
+
+static void timing_fields(const TimingConfig* timing, uint32_t out[REF_TIMING_FIELDS]) {
+    memcpy(out, timing, REF_TIMING_FIELDS * sizeof(uint32_t));
+}
+
+/**
+ * @brief Captures the live engine in the reference observation layout.
+ */
+static void observe_live(const TrafficSystem* sys, RefObservation* out) {
+    memset(out, 0, sizeof(*out));
+    out->state = (uint8_t)sys->current_state;
+    out->step = sys->current_step;
+    out->state_timer = sys->state_timer;
+    out->extension_timer = sys->extension_timer;
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            out->lights[road][lane] = (uint8_t)sys->lights[road][lane];
+            out->queue_size[road][lane] = traffic_get_queue_size(sys, road, lane);
+            out->queue_max_wait[road][lane] = queue_get_max_wait(&sys->queues[road][lane]);
+        }
+        out->skip_counters[road] = sys->phase_skip_counters[road];
+    }
+    timing_fields(&sys->timing, out->timing);
+    out->timing_pending = sys->timing_pending;
+    out->strategy = sys->strategy;
+    out->departures = sys->stats.departures;
+    out->total_wait = sys->stats.total_wait;
+    out->max_wait = sys->stats.max_wait;
+    out->left_departures = sys->stats.left_departures;
+    out->left_total_wait = sys->stats.left_total_wait;
+    for (uint8_t movement = 0; movement < MOVEMENT_COUNT; movement++) {
+        WaitHistogram hist;
+        traffic_movement_wait_hist(sys, movement, &hist);
+        memcpy(out->wait_hist[movement], hist.counts, sizeof(out->wait_hist[movement]));
+    }
+}
+
+/**
+ * @brief Prints the fields of two observations that differ.
+ */
+static void print_observation_diff(const RefObservation* ref, const RefObservation* live) {
+#define DIFF_FIELD(field) \
+    if (ref->field != live->field) \
+        fprintf(stderr, "  %-16s reference %" PRIu64 ", live %" PRIu64 "\n", #field, \
+                (uint64_t)ref->field, (uint64_t)live->field)
+
+    DIFF_FIELD(state);
+    DIFF_FIELD(step);
+    DIFF_FIELD(state_timer);
+    DIFF_FIELD(extension_timer);
+    DIFF_FIELD(timing_pending);
+    DIFF_FIELD(strategy);
+    DIFF_FIELD(departures);
+    DIFF_FIELD(total_wait);
+    DIFF_FIELD(max_wait);
+    DIFF_FIELD(left_departures);
+    DIFF_FIELD(left_total_wait);
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            DIFF_FIELD(lights[road][lane]);
+            DIFF_FIELD(queue_size[road][lane]);
+            DIFF_FIELD(queue_max_wait[road][lane]);
+        }
+        DIFF_FIELD(skip_counters[road]);
+    }
+    for (uint8_t i = 0; i < REF_TIMING_FIELDS; i++) {
+        DIFF_FIELD(timing[i]);
+    }
+    for (uint8_t movement = 0; movement < MOVEMENT_COUNT; movement++) {
+        for (uint8_t bucket = 0; bucket < WAIT_HIST_BUCKETS; bucket++) {
+            DIFF_FIELD(wait_hist[movement][bucket]);
+        }
+    }
+#undef DIFF_FIELD
+}
+
+/**
+ * @brief Steps the live engine, through the decide/apply split when `split` is set.
+ */
+static uint8_t step_live(TrafficSystem* sys, bool split, char out_ids[][VEHICLE_ID_LEN]) {
+    if (!split) {
+        return traffic_fsm_step(sys, out_ids);
+    }
+
+    TrafficDecision decision;
+    traffic_fsm_advance_clock(sys);
+    traffic_fsm_decide(sys, &sys->timing, &decision);
+    return traffic_fsm_apply(sys, &decision, out_ids);
+}
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "[DIFF] seed %" PRIu64 ", step %u: ", seed, step); \
+        fprintf(stderr, __VA_ARGS__); \
+        fprintf(stderr, "\n"); \
+        return false; \
+    } \
+} while (0)
+
+/**
+ * @brief Runs one scenario on both engines.
+ *
+ * @return false on the first difference (details on stderr)
+ */
+static bool run_scenario(uint64_t seed, TrafficSystem* live, RefEngine* ref, uint64_t* steps_done) {
+    uint64_t rng = seed;
+    uint32_t fields[REF_TIMING_FIELDS];
+    char live_ids[ROAD_COUNT * LANES_PER_ROAD][VEHICLE_ID_LEN];
+    char ref_ids[ROAD_COUNT * LANES_PER_ROAD][VEHICLE_ID_LEN];
+    RefObservation live_obs, ref_obs;
+    uint32_t step = 0;
+
+    TimingConfig timing = random_timing(&rng);
+    timing_fields(&timing, fields);
+    traffic_init(live, timing);
+    ref_engine_init(ref, fields);
+
+    uint8_t strategy = (uint8_t)random_below(&rng, STRATEGY_COUNT + 1); // Includes an invalid ID
+    CHECK(traffic_set_strategy(live, strategy) == ref_engine_set_strategy(ref, strategy), "set_strategy result");
+
+    uint32_t steps = random_below(&rng, MAX_SCENARIO_STEPS) + 1;
+    uint32_t rate = random_below(&rng, 101); // Arrival chance per road and step, percent
+    bool split = random_below(&rng, 2) == 0;
+    uint32_t vehicle = 0;
+
+    for (step = 0; step < steps; step++) {
+        for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+            if (random_below(&rng, 100) >= rate) continue;
+
+            char id[VEHICLE_ID_LEN];
+            snprintf(id, sizeof(id), "v%u", vehicle++);
+            uint8_t end = (uint8_t)random_below(&rng, ROAD_COUNT + 1); // U-turns and invalid roads too
+            uint32_t arrival = live->current_step;
+            if (random_below(&rng, 64) == 0) {
+                arrival = (uint32_t)next_random(&rng); // Clock skew in the input
+            }
+            CHECK(traffic_add_vehicle(live, id, road, end, arrival) ==
+                  ref_engine_add_vehicle(ref, id, road, end, arrival), "add_vehicle %s result", id);
+        }
+
+        uint32_t event = random_below(&rng, 1000);
+        if (event < 4) {
+            timing = random_timing(&rng);
+            timing_fields(&timing, fields);
+            traffic_update_timing(live, &timing);
+            ref_engine_update_timing(ref, fields);
+        } else if (event < 8) {
+            TimingPlan plan = {.start_step = live->current_step + random_below(&rng, 200), .timing = random_timing(&rng)};
+            timing_fields(&plan.timing, fields);
+            CHECK(traffic_add_timing_plan(live, &plan) == ref_engine_add_timing_plan(ref, plan.start_step, fields),
+                  "add_timing_plan result");
+        } else if (event < 10) {
+            strategy = (uint8_t)random_below(&rng, STRATEGY_COUNT + 1);
+            CHECK(traffic_set_strategy(live, strategy) == ref_engine_set_strategy(ref, strategy),
+                  "set_strategy result");
+        } else if (event < 11) {
+            traffic_restart_cycle(live);
+            ref_engine_restart_cycle(ref);
+        } else if (event < 12) {
+            timing = random_timing(&rng);
+            timing_fields(&timing, fields);
+            traffic_init(live, timing);
+            ref_engine_init(ref, fields);
+        }
+
+        uint8_t live_count = step_live(live, split, live_ids);
+        uint8_t ref_count = ref_engine_step(ref, ref_ids);
+        CHECK(live_count == ref_count, "%u departures, reference %u", live_count, ref_count);
+        for (uint8_t i = 0; i < live_count; i++) {
+            CHECK(strcmp(live_ids[i], ref_ids[i]) == 0, "departure %u is %s, reference %s", i, live_ids[i], ref_ids[i]);
+        }
+
+        observe_live(live, &live_obs);
+        ref_engine_observe(ref, &ref_obs);
+        if (memcmp(&live_obs, &ref_obs, sizeof(RefObservation)) != 0) {
+            fprintf(stderr, "[DIFF] seed %" PRIu64 ", step %u: observation differs\n", seed, step);
+            print_observation_diff(&ref_obs, &live_obs);
+            return false;
+        }
+    }
+
+    *steps_done += steps;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    uint64_t scenarios = argc > 1 ? strtoull(argv[1], NULL, 10) : DEFAULT_SCENARIOS;
+    uint64_t seed = argc > 2 ? strtoull(argv[2], NULL, 10) : DEFAULT_SEED;
+    uint32_t fields[REF_TIMING_FIELDS];
+    TimingConfig timing = DEFAULT_TIMING;
+    uint64_t steps = 0;
+
+    timing_fields(&timing, fields);
+    TrafficSystem* live = malloc(sizeof(TrafficSystem));
+    RefEngine* ref = ref_engine_create(fields);
+    if (!live || !ref) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    uint64_t failures = 0, i;
+    for (i = 0; i < scenarios && failures < 10; i++) {
+        if (!run_scenario(seed + i, live, ref, &steps)) {
+            fprintf(stderr, "[DIFF] replay: %s 1 %" PRIu64 "\n", argv[0], seed + i);
+            failures++;
+        }
+    }
+
+    printf("Differential: %" PRIu64 " scenarios, %" PRIu64 " steps, %" PRIu64 " mismatching\n",
+           i, steps, failures);
+
+    free(live);
+    ref_engine_free(ref);
+    return failures == 0 ? 0 : 1;
+}
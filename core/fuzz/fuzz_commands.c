@@ -0,0 +1,91 @@
+/**
+ * @file fuzz_commands.c
+ * @brief Fuzz target for the command parser of main_pc.c.
+ *
+ * libFuzzer entry point: the first byte selects the mode (odd = --framed) and the
+ * rest is the command stream, executed by process_commands() or run_framed() on a
+ * fresh default intersection with a 2-slot session cache (so sessions get parked
+ * and restored). Responses are discarded; the parser must neither crash nor touch
+ * memory it does not own, which AddressSanitizer/UBSan check.
+ *
+ * Build with clang -fsanitize=fuzzer,address together with main_pc.c compiled with
+ * -DTRAFFIC_SIM_NO_MAIN, or with gcc through `make fuzz`, which links the
+ * standalone coverage-guided driver (fuzz_driver.c).
+ */
+
+#define _POSIX_C_SOURCE 200809L // fmemopen
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "traffic_fsm.h"
+#include "traffic_sessions.h"
+#include "frame_codec.h"
+#include "traffic_aggregate.h"
+
+#define FUZZ_SESSION_CACHE 2
+
+// Parser state owned by main_pc.c
+extern TrafficSystem sys;
+extern TrafficSystem* active;
+extern uint16_t active_id;
+extern SessionTable sessions;
+extern FILE* input;
+extern FILE* output;
+extern FrameDecoder decoder;
+extern uint64_t input_offset;
+extern uint64_t resume_offset;
+extern const char* checkpoint_path;
+extern TrafficAggregator aggregator;
+
+bool process_commands();
+void run_framed();
+void release_subscriptions();
+
+int LLVMFuzzerInitialize(int* argc, char*** argv) {
+    (void)argc;
+    (void)argv;
+
+    // The parser logs every command: keep the sanitizer reports (written to fd 2) readable
+    FILE* sink = fopen("/dev/null", "w");
+    if (sink) {
+        stderr = sink;
+        stdout = sink; // run_framed() answers on stdout
+    }
+    return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size < 2) {
+        return 0; // fmemopen() rejects empty buffers
+    }
+    bool framed = data[0] & 1;
+
+    TimingConfig config = DEFAULT_TIMING;
+    traffic_init(&sys, config);
+    active = &sys;
+    active_id = 0;
+    input_offset = 0;
+    resume_offset = 0;
+    checkpoint_path = NULL;
+    aggregator.mode = AGGREGATE_OFF;
+    frame_decoder_init(&decoder);
+    if (!sessions_init(&sessions, FUZZ_SESSION_CACHE)) {
+        return 0;
+    }
+
+    input = fmemopen((void*)(data + 1), size - 1, "rb");
+    output = stdout;
+    if (input) {
+        if (framed) {
+            run_framed();
+        } else {
+            process_commands();
+        }
+        fclose(input);
+    }
+
+    sessions_free(&sessions);
+    release_subscriptions();
+    return 0;
+}
@@ -0,0 +1,435 @@
+/**
+ * @file fuzz_driver.c
+ * @brief Standalone coverage-guided driver for libFuzzer-style targets.
+ *
+ * Stand-in for libFuzzer where clang is not available: the target is compiled with
+ * gcc -fsanitize-coverage=trace-pc, this file (compiled without it) collects the
+ * edges every input reaches into a hashed map of hit counters, and mutated inputs
+ * reaching a new edge or a new hit-count class (AFL buckets) join the corpus.
+ * Mutations are stacked byte-level edits, interesting values and splices with
+ * other corpus entries.
+ *
+ * Usage: fuzz_driver [--runs N] [--seed S] [--max-len L] [CORPUS_DIR]
+ *        fuzz_driver FILE...   (replays the files once, e.g. a crash reproducer)
+ *
+ * New corpus entries are written to CORPUS_DIR (created beforehand). When an input
+ * crashes, it is saved as crash-<hash> in the working directory first.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#if defined(__SANITIZE_ADDRESS__)
+#include <sanitizer/common_interface_defs.h>
+#endif
+
+#define MAP_SIZE (1u << 16) // Edge map entries (hashed)
+#define DEFAULT_RUNS 100000u
+#define DEFAULT_MAX_LEN 4096u
+#define MAX_STACKED_MUTATIONS 8
+
+#define ARRAY_LEN(arr) (sizeof(arr) / sizeof((arr)[0]))
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+__attribute__((weak)) int LLVMFuzzerInitialize(int* argc, char*** argv);
+
+typedef struct {
+    uint8_t* data;
+    size_t len;
+} Input;
+
+static uint8_t edges[MAP_SIZE]; // Hit counters of the current input
+static uint8_t seen[MAP_SIZE]; // Hit-count classes reached by any input so far
+static uintptr_t prev_block;
+
+static Input* corpus;
+static size_t corpus_len, corpus_cap;
+static const char* corpus_dir;
+
+static const uint8_t* current_data; // Input being executed, saved on a crash
+static size_t current_len;
+
+static FILE* out; // Our own handle on stdout: the target may redirect stdout/stderr
+static uint64_t rng_state;
+
+/**
+ * @brief Called by every basic block of the instrumented code: counts the edge
+ * from the previous block (AFL-style prev/cur hashing).
+ */
+__attribute__((no_sanitize_coverage))
+void __sanitizer_cov_trace_pc(void) {
+    uintptr_t block = (uintptr_t)__builtin_return_address(0);
+    block = (block ^ (block >> 15)) * 0x9E3779B1u;
+    edges[(block ^ prev_block) & (MAP_SIZE - 1)]++;
+    prev_block = block >> 1;
+}
+
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static size_t random_below(size_t bound) {
+    return bound ? (size_t)(next_random() % bound) : 0;
+}
+
+static uint64_t fnv1a(const uint8_t* data, size_t len) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ data[i]) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+static void format_hash(char* dst, uint64_t hash) {
+    static const char hex[] = "0123456789abcdef";
+    for (int i = 15; i >= 0; i--) {
+        dst[i] = hex[hash & 0xF];
+        hash >>= 4;
+    }
+    dst[16] = '\0';
+}
+
+/**
+ * @brief Writes the current input to crash-<hash> (async-signal-safe).
+ */
+static void save_crash(void) {
+    char path[32] = "crash-";
+    format_hash(path + 6, fnv1a(current_data, current_len));
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0) {
+        ssize_t written = write(fd, current_data, current_len);
+        (void)written;
+        close(fd);
+    }
+    static const char msg[] = "[FUZZ] crashing input saved to ";
+    ssize_t written = write(STDERR_FILENO, msg, sizeof(msg) - 1);
+    written = write(STDERR_FILENO, path, strlen(path));
+    written = write(STDERR_FILENO, "\n", 1);
+    (void)written;
+}
+
+static void on_signal(int sig) {
+    save_crash();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+/**
+ * @brief AFL hit-count class: 1, 2, 3, 4-7, 8-15, 16-31, 32-127, 128+.
+ */
+static uint8_t count_class(uint8_t count) {
+    if (count == 0) return 0;
+    if (count <= 3) return (uint8_t)(1u << (count - 1));
+    if (count < 8) return 8;
+    if (count < 16) return 16;
+    if (count < 32) return 32;
+    if (count < 128) return 64;
+    return 128;
+}
+
+/**
+ * @brief Executes one input.
+ *
+ * @return Number of edge classes reached for the first time
+ */
+static uint32_t run_input(const uint8_t* data, size_t len) {
+    memset(edges, 0, sizeof(edges));
+    prev_block = 0;
+    current_data = data;
+    current_len = len;
+
+    LLVMFuzzerTestOneInput(data, len);
+
+    uint32_t new_classes = 0;
+    for (uint32_t i = 0; i < MAP_SIZE; i++) {
+        uint8_t cls = count_class(edges[i]);
+        if (cls & ~seen[i]) {
+            seen[i] |= cls;
+            new_classes++;
+        }
+    }
+    return new_classes;
+}
+
+static uint32_t coverage_edges(void) {
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < MAP_SIZE; i++) {
+        n += seen[i] != 0;
+    }
+    return n;
+}
+
+static bool corpus_add(const uint8_t* data, size_t len, bool persist) {
+    if (corpus_len == corpus_cap) {
+        size_t cap = corpus_cap ? corpus_cap * 2 : 64;
+        Input* grown = realloc(corpus, cap * sizeof(Input));
+        if (!grown) return false;
+        corpus = grown;
+        corpus_cap = cap;
+    }
+
+    uint8_t* copy = malloc(len ? len : 1);
+    if (!copy) return false;
+    memcpy(copy, data, len);
+    corpus[corpus_len].data = copy;
+    corpus[corpus_len].len = len;
+    corpus_len++;
+
+    if (persist && corpus_dir) {
+        char path[4096], name[17];
+        format_hash(name, fnv1a(data, len));
+        snprintf(path, sizeof(path), "%s/%s", corpus_dir, name);
+        FILE* f = fopen(path, "wb");
+        if (f) {
+            fwrite(data, 1, len, f);
+            fclose(f);
+        }
+    }
+    return true;
+}
+
+static bool read_file(const char* path, uint8_t** data, size_t* len) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+
+    size_t cap = 4096, n = 0;
+    uint8_t* buf = malloc(cap);
+    size_t got;
+    while (buf && (got = fread(buf + n, 1, cap - n, f)) > 0) {
+        n += got;
+        if (n == cap) {
+            uint8_t* grown = realloc(buf, cap *= 2);
+            if (!grown) {
+                free(buf);
+                buf = NULL;
+                break;
+            }
+            buf = grown;
+        }
+    }
+    fclose(f);
+
+    *data = buf;
+    *len = n;
+    return buf != NULL;
+}
+
+/**
+ * @brief Runs the files of the corpus directory, keeping those that add coverage.
+ */
+static void load_corpus(const char* dir) {
+    DIR* d = opendir(dir);
+    if (!d) {
+        fprintf(out, "[FUZZ] Cannot open corpus directory %s\n", dir);
+        return;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(d)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+
+        char path[4096];
+        uint8_t* data;
+        size_t len;
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        if (!read_file(path, &data, &len)) continue;
+
+        if (run_input(data, len) > 0 || corpus_len == 0) {
+            corpus_add(data, len, false);
+        }
+        free(data);
+    }
+    closedir(d);
+}
+
+/**
+ * @brief Applies one random edit to buf (len in/out, at most max_len bytes).
+ */
+static void mutate_once(uint8_t* buf, size_t* len, size_t max_len) {
+    static const uint8_t interesting8[] = {0, 1, 2, 3, 4, 7, 8, 12, 13, 14, 16, 32, 64, 99, 0x7F, 0x80, 0xFF};
+    static const uint32_t interesting32[] = {0, 1, 2, 0xFF, 0x100, 0x7FFF, 0xFFFF, 0x10000,
+                                             0x7FFFFFFF, 0x80000000u, 0xFFFFFFFFu};
+    size_t n = *len;
+
+    switch (random_below(8)) {
+        case 0: // Bit flip
+            if (n) buf[random_below(n)] ^= (uint8_t)(1u << random_below(8));
+            break;
+
+        case 1: // Random byte
+            if (n) buf[random_below(n)] = (uint8_t)next_random();
+            break;
+
+        case 2: // Interesting byte (opcodes, boundaries)
+            if (n) buf[random_below(n)] = interesting8[random_below(ARRAY_LEN(interesting8))];
+            break;
+
+        case 3: { // Interesting 16/32-bit little-endian value
+            uint32_t value = interesting32[random_below(ARRAY_LEN(interesting32))];
+            size_t width = random_below(2) ? 4 : 2;
+            if (n >= width) {
+                size_t pos = random_below(n - width + 1);
+                for (size_t i = 0; i < width; i++) {
+                    buf[pos + i] = (uint8_t)(value >> (8 * i));
+                }
+            }
+            break;
+        }
+
+        case 4: { // Delete a block
+            if (n < 2) break;
+            size_t pos = random_below(n), cut = 1 + random_below(n - pos < 64 ? n - pos : 64);
+            memmove(buf + pos, buf + pos + cut, n - pos - cut);
+            *len = n - cut;
+            break;
+        }
+
+        case 5: { // Insert random bytes
+            size_t add = 1 + random_below(40);
+            if (n + add > max_len) break;
+            size_t pos = random_below(n + 1);
+            memmove(buf + pos + add, buf + pos, n - pos);
+            for (size_t i = 0; i < add; i++) {
+                buf[pos + i] = (uint8_t)next_random();
+            }
+            *len = n + add;
+            break;
+        }
+
+        case 6: { // Duplicate a block (repeats commands)
+            if (n == 0) break;
+            size_t src = random_below(n), copy = 1 + random_below(n - src);
+            if (n + copy > max_len) break;
+            size_t pos = random_below(n + 1);
+            uint8_t* block = malloc(copy);
+            if (!block) break;
+            memcpy(block, buf + src, copy);
+            memmove(buf + pos + copy, buf + pos, n - pos);
+            memcpy(buf + pos, block, copy);
+            free(block);
+            *len = n + copy;
+            break;
+        }
+
+        case 7: { // Splice in a block of another corpus entry
+            const Input* other = &corpus[random_below(corpus_len)];
+            if (other->len == 0) break;
+            size_t src = random_below(other->len), copy = 1 + random_below(other->len - src);
+            if (n + copy > max_len) break;
+            size_t pos = random_below(n + 1);
+            memmove(buf + pos + copy, buf + pos, n - pos);
+            memcpy(buf + pos, other->data + src, copy);
+            *len = n + copy;
+            break;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    uint64_t runs = DEFAULT_RUNS;
+    size_t max_len = DEFAULT_MAX_LEN;
+    const char* files[64];
+    int n_files = 0;
+
+    rng_state = (uint64_t)time(NULL) | 1;
+    for (int i = 1; i < argc; i++) {
+        struct stat st;
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            rng_state = strtoull(argv[++i], NULL, 10) | 1;
+        } else if (strcmp(argv[i], "--max-len") == 0 && i + 1 < argc) {
+            max_len = strtoul(argv[++i], NULL, 10);
+        } else if (stat(argv[i], &st) == 0 && S_ISDIR(st.st_mode)) {
+            corpus_dir = argv[i];
+        } else if (stat(argv[i], &st) == 0 && n_files < (int)ARRAY_LEN(files)) {
+            files[n_files++] = argv[i];
+        } else {
+            fprintf(stderr, "Usage: %s [--runs N] [--seed S] [--max-len L] [CORPUS_DIR | FILE...]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    out = fdopen(dup(STDOUT_FILENO), "w");
+    if (!out || max_len < 2) return 1;
+    setvbuf(out, NULL, _IOLBF, 0);
+
+    signal(SIGSEGV, on_signal);
+    signal(SIGABRT, on_signal);
+    signal(SIGFPE, on_signal);
+    signal(SIGBUS, on_signal);
+#if defined(__SANITIZE_ADDRESS__)
+    __sanitizer_set_death_callback(save_crash);
+#endif
+
+    if (LLVMFuzzerInitialize) {
+        LLVMFuzzerInitialize(&argc, &argv);
+    }
+
+    if (n_files > 0) {
+        for (int i = 0; i < n_files; i++) {
+            uint8_t* data;
+            size_t len;
+            if (!read_file(files[i], &data, &len)) continue;
+            run_input(data, len);
+            fprintf(out, "[FUZZ] %s: %zu bytes, ok\n", files[i], len);
+            free(data);
+        }
+        return 0;
+    }
+
+    if (corpus_dir) {
+        load_corpus(corpus_dir);
+    }
+    if (corpus_len == 0) {
+        static const uint8_t empty[2] = {0, 0};
+        run_input(empty, sizeof(empty));
+        corpus_add(empty, sizeof(empty), false);
+    }
+    fprintf(out, "[FUZZ] corpus %zu, edges %u\n", corpus_len, coverage_edges());
+
+    uint8_t* buf = malloc(max_len);
+    if (!buf) return 1;
+
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint64_t run = 1; run <= runs; run++) {
+        const Input* parent = &corpus[random_below(corpus_len)];
+        size_t len = parent->len < max_len ? parent->len : max_len;
+        memcpy(buf, parent->data, len);
+
+        size_t stacked = 1 + random_below(MAX_STACKED_MUTATIONS);
+        for (size_t i = 0; i < stacked; i++) {
+            mutate_once(buf, &len, max_len);
+        }
+
+        if (run_input(buf, len) > 0) {
+            corpus_add(buf, len, true);
+        }
+
+        if ((run & (run - 1)) == 0 || run == runs) {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            double elapsed = (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) * 1e-9;
+            fprintf(out, "[FUZZ] #%llu corpus %zu, edges %u, %.0f exec/s\n", (unsigned long long)run,
+                    corpus_len, coverage_edges(), elapsed > 0 ? run / elapsed : 0.0);
+        }
+    }
+
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,82 @@
+"""
+Seed corpus for fuzz_commands (see fuzz_commands.c).
+
+Writes a few valid command streams, covering every opcode, as raw streams
+(mode byte 0) and as COBS/CRC frames (mode byte 1), which random mutation
+alone would hardly ever produce because of the CRC.
+
+Usage:
+    python3 make_corpus.py OUTPUT_DIR
+"""
+import os
+import struct
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'pc-simulation'))
+
+from framing import encode_frame, split_messages  # noqa: E402
+
+MODE_RAW = b'\x00'
+MODE_FRAMED = b'\x01'
+
+TIMING = struct.pack('<IIIIIII', 4, 3, 2, 3, 1, 15, 2)
+SHORT_TIMING = struct.pack('<IIIIIII', 1, 1, 1, 0, 0, 0, 0)
+
+
+def vehicle(vehicle_id: str, start: int, end: int, arrival: int) -> bytes:
+    return struct.pack('<B32sBBI', 1, vehicle_id.encode(), start, end, arrival)
+
+
+def steps(n: int) -> bytes:
+    return b'\x02' * n
+
+
+def scenario_stream() -> bytes:
+    stream = b'\x00' + TIMING + struct.pack('<BB', 6, 4)
+    for i in range(12):
+        stream += vehicle(f'v{i}', i % 4, (i + 1 + i % 3) % 4, i // 4)
+    stream += steps(30) + b'\x03\x04\x05\x0d'
+    stream += struct.pack('<BBI', 15, 1, 7) + steps(20) + struct.pack('<BBI', 15, 2, 0) + steps(20)
+    return stream + b'\x63'
+
+
+def timing_stream() -> bytes:
+    stream = b'\x00' + TIMING + struct.pack('<BB', 6, 5)
+    stream += b'\x07' + SHORT_TIMING + struct.pack('<BI', 8, 10) + TIMING + struct.pack('<BI', 8, 20) + SHORT_TIMING
+    stream += vehicle('a', 0, 2, 0) + vehicle('b', 1, 2, 0) + steps(40) + b'\x0e\x03'
+    return stream
+
+
+def session_stream() -> bytes:
+    stream = b''
+    for session_id in (1, 2, 3):
+        stream += struct.pack('<BH', 9, session_id) + TIMING
+    stream += struct.pack('<BH', 10, 2) + vehicle('s', 3, 1, 0) + steps(3)
+    stream += struct.pack('<BHH', 16, 2, 2) + struct.pack('<BHH', 16, 0, 1) + struct.pack('<BHH', 16, 9, 1)
+    stream += struct.pack('<BHHHHH', 12, 4, 0, 1, 2, 7)
+    stream += struct.pack('<BHH', 16, 2, 0) + b'\x00' + TIMING + steps(2)
+    stream += struct.pack('<BH', 11, 2) + struct.pack('<BH', 10, 3) + b'\x03\x11'
+    return stream
+
+
+def main() -> None:
+    if len(sys.argv) != 2:
+        print(__doc__)
+        sys.exit(1)
+    out_dir = sys.argv[1]
+    os.makedirs(out_dir, exist_ok=True)
+
+    streams = {'scenario': scenario_stream(), 'timing': timing_stream(), 'sessions': session_stream()}
+    for name, stream in streams.items():
+        with open(os.path.join(out_dir, f'seed-{name}'), 'wb') as f:
+            f.write(MODE_RAW + stream)
+
+        framed = b''.join(encode_frame(seq, 0, chunk)
+                          for seq, chunk in enumerate(split_messages(stream, 256)))
+        framed += encode_frame(0, 0, b'\x03')  # Retransmission of seq 0
+        with open(os.path.join(out_dir, f'seed-{name}-framed'), 'wb') as f:
+            f.write(MODE_FRAMED + framed)
+
+
+if __name__ == '__main__':
+    main()
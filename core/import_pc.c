@@ -0,0 +1,277 @@
+/**
+ * @file import_pc.c
+ *
+ * @brief Command-line front-end of the detector log importer.
+ *
+ * Memory-maps a CSV detector log (see traffic_import.h for the format) and
+ * writes the scenario as the binary command stream of traffic_sim
+ * (CMD_ADD_VEHICLE / CMD_STEP, as encode_scenario() in optimize_timings.py), so
+ * it can be stored or piped straight into the core:
+ *
+ *     traffic_import detectors.csv | traffic_sim > responses.bin
+ *
+ * With --simulate [STRATEGY] the log is fed directly to an in-process
+ * TrafficSystem (DEFAULT_TIMING) instead and the statistics are printed.
+ * The import counters and throughput are reported on standard error.
+ *
+ * Usage: traffic_import [--step-ms N] [--unit s|ms] [--origin TIMESTAMP] [--drain N]
+ *                       [--output FILE] [--simulate [v1-v6]] LOG.csv|-
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "protocol.h"
+#include "traffic_fsm.h"
+#include "traffic_import.h"
+
+#define OUTPUT_BUFFER_SIZE (1u << 20)
+
+/**
+ * @brief Sink writing the binary command stream through a large buffer.
+ */
+typedef struct {
+    FILE* file;
+    uint8_t* buf;
+    size_t used;
+    bool failed;
+} StreamWriter;
+
+static void writer_flush(StreamWriter* w) {
+    if (w->used > 0 && fwrite(w->buf, 1, w->used, w->file) != w->used) {
+        w->failed = true;
+    }
+    w->used = 0;
+}
+
+static void stream_add_vehicle(void* ctx, const char* id, Direction start, Direction end, uint32_t step) {
+    StreamWriter* w = ctx;
+    if (OUTPUT_BUFFER_SIZE - w->used < sizeof(CmdHeader) + sizeof(PayloadAddVehicle)) {
+        writer_flush(w);
+    }
+
+    CmdHeader header = {.cmd_type = CMD_ADD_VEHICLE};
+    PayloadAddVehicle payload = {.start_road = (uint8_t)start, .end_road = (uint8_t)end, .arrival_time = step};
+    memcpy(payload.vehicle_id, id, strlen(id)); // At most VEHICLE_ID_LEN - 1, zero padded
+    memcpy(w->buf + w->used, &header, sizeof(header));
+    memcpy(w->buf + w->used + sizeof(header), &payload, sizeof(payload));
+    w->used += sizeof(header) + sizeof(payload);
+}
+
+static void stream_step(void* ctx, uint32_t count) {
+    StreamWriter* w = ctx;
+    while (count > 0) {
+        if (w->used == OUTPUT_BUFFER_SIZE) {
+            writer_flush(w);
+        }
+        size_t n = OUTPUT_BUFFER_SIZE - w->used;
+        if (n > count) n = count;
+        memset(w->buf + w->used, CMD_STEP, n);
+        w->used += n;
+        count -= (uint32_t)n;
+    }
+}
+
+/**
+ * @brief Sink simulating the log in process.
+ */
+typedef struct {
+    TrafficSystem sys;
+    uint64_t rejected; // Vehicles refused by a full queue
+} SimulationSink;
+
+static void sim_add_vehicle(void* ctx, const char* id, Direction start, Direction end, uint32_t step) {
+    SimulationSink* sim = ctx;
+    if (!traffic_add_vehicle(&sim->sys, id, start, end, step)) {
+        sim->rejected++;
+    }
+}
+
+static void sim_step(void* ctx, uint32_t count) {
+    SimulationSink* sim = ctx;
+    char out_ids[ROAD_COUNT * LANES_PER_ROAD][VEHICLE_ID_LEN];
+    for (uint32_t i = 0; i < count; i++) {
+        traffic_fsm_step(&sim->sys, out_ids);
+    }
+}
+
+/**
+ * @brief Reads a whole stream (standard input) into memory.
+ */
+static char* read_stream(FILE* f, size_t* len) {
+    size_t cap = 1u << 20, n = 0, got;
+    char* buf = malloc(cap);
+    while (buf && (got = fread(buf + n, 1, cap - n, f)) > 0) {
+        n += got;
+        if (n == cap) {
+            char* grown = realloc(buf, cap *= 2);
+            if (!grown) {
+                free(buf);
+                return NULL;
+            }
+            buf = grown;
+        }
+    }
+    *len = n;
+    return buf;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [--step-ms N] [--unit s|ms] [--origin TIMESTAMP] [--drain N] "
+                    "[--output FILE] [--simulate [v1-v6]] LOG.csv|-\n", prog);
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    ImportOptions options = IMPORT_DEFAULT_OPTIONS;
+    const char* origin = NULL;
+    const char* output_path = NULL;
+    const char* log_path = NULL;
+    bool simulate = false;
+    TrafficStrategyId strategy = DEFAULT_STRATEGY;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--step-ms") == 0 && i + 1 < argc) {
+            options.step_ms = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--unit") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "s") == 0) {
+                options.unit_ms = 1000;
+            } else if (strcmp(argv[i], "ms") == 0) {
+                options.unit_ms = 1;
+            } else {
+                return usage(argv[0]);
+            }
+        } else if (strcmp(argv[i], "--origin") == 0 && i + 1 < argc) {
+            origin = argv[++i];
+        } else if (strcmp(argv[i], "--drain") == 0 && i + 1 < argc) {
+            options.drain_steps = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (strcmp(argv[i], "--simulate") == 0) {
+            simulate = true;
+            if (i + 1 < argc && argv[i + 1][0] == 'v' && argv[i + 1][1] >= '1' &&
+                argv[i + 1][1] < '1' + STRATEGY_COUNT && argv[i + 1][2] == '\0') {
+                strategy = (TrafficStrategyId)(argv[++i][1] - '1');
+            }
+        } else if (!log_path && (argv[i][0] != '-' || strcmp(argv[i], "-") == 0)) {
+            log_path = argv[i];
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (!log_path || options.step_ms == 0) {
+        return usage(argv[0]);
+    }
+    if (origin && !traffic_import_parse_time(origin, strlen(origin), options.unit_ms, &options.origin_ms)) {
+        fprintf(stderr, "[C-ERR] Cannot parse --origin %s\n", origin);
+        return 1;
+    }
+
+    // Map the log (or read standard input)
+    char* data = NULL;
+    size_t len = 0;
+    bool mapped = false;
+    if (strcmp(log_path, "-") == 0) {
+        data = read_stream(stdin, &len);
+    } else {
+        int fd = open(log_path, O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            fprintf(stderr, "[C-ERR] Cannot open %s\n", log_path);
+            return 1;
+        }
+        len = (size_t)st.st_size;
+        if (len > 0) {
+            data = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                data = NULL;
+            } else {
+                mapped = true;
+                posix_madvise(data, len, POSIX_MADV_SEQUENTIAL);
+            }
+        }
+        close(fd);
+    }
+    if (!data && len > 0) {
+        fprintf(stderr, "[C-ERR] Cannot read %s\n", log_path);
+        return 1;
+    }
+
+    ImportStats stats;
+    ImportSink sink;
+    StreamWriter writer = {0};
+    SimulationSink* sim = NULL;
+    bool ok;
+    double start = now_s();
+
+    if (simulate) {
+        TimingConfig config = DEFAULT_TIMING;
+        sim = calloc(1, sizeof(SimulationSink));
+        if (!sim) return 1;
+        traffic_init(&sim->sys, config);
+        traffic_set_strategy(&sim->sys, strategy);
+        sink = (ImportSink){.add_vehicle = sim_add_vehicle, .step = sim_step, .ctx = sim};
+    } else {
+        writer.file = output_path ? fopen(output_path, "wb") : stdout;
+        writer.buf = malloc(OUTPUT_BUFFER_SIZE);
+        if (!writer.file || !writer.buf) {
+            fprintf(stderr, "[C-ERR] Cannot open the output\n");
+            return 1;
+        }
+        sink = (ImportSink){.add_vehicle = stream_add_vehicle, .step = stream_step, .ctx = &writer};
+    }
+
+    ok = traffic_import_csv(data ? data : "", len, &options, &sink, &stats);
+    if (!simulate) {
+        writer_flush(&writer);
+        ok = ok && !writer.failed && fflush(writer.file) == 0;
+    }
+    double elapsed = now_s() - start;
+
+    fprintf(stderr, "[C-OK] %llu lines, %llu vehicles, %llu steps, %llu late, %llu malformed",
+            (unsigned long long)stats.lines, (unsigned long long)stats.vehicles, (unsigned long long)stats.steps,
+            (unsigned long long)stats.late, (unsigned long long)stats.malformed);
+    if (stats.first_malformed_line > 0) {
+        fprintf(stderr, " (first: line %llu)", (unsigned long long)stats.first_malformed_line);
+    }
+    fprintf(stderr, ", %.1f MB in %.3f s (%.0f MB/s)\n", len / 1e6, elapsed, elapsed > 0 ? len / 1e6 / elapsed : 0.0);
+
+    if (simulate) {
+        const TrafficStats* s = &sim->sys.stats;
+        printf("strategy %s: %u departures, AWT %.2f, MAX %u, LEFT AWT %.2f, %llu rejected (queue full)\n",
+               traffic_get_strategy(strategy)->name, s->departures,
+               s->departures ? (double)s->total_wait / s->departures : 0.0, s->max_wait,
+               s->left_departures ? (double)s->left_total_wait / s->left_departures : 0.0,
+               (unsigned long long)sim->rejected);
+        free(sim);
+    } else {
+        free(writer.buf);
+        if (output_path) fclose(writer.file);
+    }
+
+    if (mapped) {
+        munmap(data, len);
+    } else {
+        free(data);
+    }
+    if (!ok) {
+        fprintf(stderr, "[C-ERR] Import failed (invalid options, output error or step beyond 32 bits)\n");
+        return 1;
+    }
+    return 0;
+}
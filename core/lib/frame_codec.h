@@ -0,0 +1,131 @@
+/**
+ * @file frame_codec.h
+ * @brief Self-resynchronising framing for the binary protocol
+ *
+ * A frame carries one or more raw protocol messages:
+ *
+ *   COBS( seq | flags | message bytes | crc16 ) 0x00
+ *
+ * COBS removes every zero byte from the body, so 0x00 only appears as the frame
+ * delimiter. A lost or corrupted byte damages a single frame: the CRC rejects it
+ * and the receiver is back in sync at the next delimiter, without timeouts.
+ * The CRC is CRC-16/CCITT-FALSE over seq, flags and the message bytes.
+ */
+
+#ifndef FRAME_CODEC_H
+#define FRAME_CODEC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @def FRAME_MAX_PAYLOAD
+ * @brief Largest message block carried by a received frame
+ *
+ * Large enough for a ResponseWaitHistogram (2 KB). Override at compile time.
+ */
+#ifndef FRAME_MAX_PAYLOAD
+#define FRAME_MAX_PAYLOAD 2304
+#endif
+
+#define FRAME_HEADER_SIZE 2 // seq + flags
+#define FRAME_CRC_SIZE 2
+
+/**
+ * @def FRAME_ENCODED_SIZE
+ * @brief Worst-case encoded size of a frame with n message bytes (delimiter included)
+ */
+#define FRAME_ENCODED_SIZE(n) \
+    ((n) + FRAME_HEADER_SIZE + FRAME_CRC_SIZE + ((n) + FRAME_HEADER_SIZE + FRAME_CRC_SIZE) / 254 + 2)
+
+#define FRAME_DELIMITER 0x00
+
+#define FRAME_FLAG_NAK 0x01 // Response to a dropped frame: the sender should retransmit
+
+/**
+ * @brief Link quality counters kept by the receiving side
+ */
+typedef struct {
+    uint32_t frames_ok; // Valid frames accepted
+    uint32_t frames_dropped; // Frames rejected (CRC, COBS or length error)
+    uint32_t frames_duplicate; // Retransmitted frames (same seq as the last accepted one)
+    uint32_t seq_gaps; // Accepted frames whose seq skipped at least one value
+} FrameLinkStats;
+
+/**
+ * @brief Outcome of feeding one byte to the decoder
+ */
+typedef enum {
+    FRAME_NONE = 0, // Frame still incomplete
+    FRAME_OK, // New valid frame in decoder payload
+    FRAME_DUPLICATE, // Valid frame repeating the last seq (retransmission)
+    FRAME_DROPPED // Damaged frame discarded, decoder resynchronised
+} FrameResult;
+
+/**
+ * @brief Streaming frame decoder
+ *
+ * The encoded bytes are collected in buf and decoded in place, so a decoder
+ * needs a single buffer of FRAME_ENCODED_SIZE(FRAME_MAX_PAYLOAD) bytes.
+ */
+typedef struct {
+    uint8_t buf[FRAME_ENCODED_SIZE(FRAME_MAX_PAYLOAD)];
+    size_t len;
+    bool overflow;
+
+    bool has_seq;
+    uint8_t last_seq;
+
+    const uint8_t* payload; // Message bytes of the last FRAME_OK / FRAME_DUPLICATE
+    size_t payload_len;
+    uint8_t seq;
+    uint8_t flags;
+
+    FrameLinkStats stats;
+} FrameDecoder;
+
+/**
+ * @brief CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+ *
+ * @param crc Running value (0xFFFF for a new computation)
+ * @param data Bytes to add
+ * @param len Number of bytes
+ *
+ * @return Updated CRC
+ */
+uint16_t frame_crc16(uint16_t crc, const uint8_t* data, size_t len);
+
+/**
+ * @brief Encodes a frame (delimiter included)
+ *
+ * @param seq Sequence number
+ * @param flags Frame flags (FRAME_FLAG_*)
+ * @param payload Message bytes (may be NULL if len is 0)
+ * @param len Number of message bytes
+ * @param out Output buffer
+ * @param capacity Size of out (FRAME_ENCODED_SIZE(len) is always enough)
+ *
+ * @return Number of bytes written, 0 if the buffer is too small
+ */
+size_t frame_encode(uint8_t seq, uint8_t flags, const uint8_t* payload, size_t len,
+                    uint8_t* out, size_t capacity);
+
+/**
+ * @brief Resets the decoder and its counters
+ *
+ * @param d Pointer to FrameDecoder
+ */
+void frame_decoder_init(FrameDecoder* d);
+
+/**
+ * @brief Feeds one received byte (O(1), frame decoding happens on the delimiter)
+ *
+ * @param d Pointer to FrameDecoder
+ * @param byte Received byte
+ *
+ * @return FRAME_NONE until a delimiter arrives, then the frame outcome
+ */
+FrameResult frame_decoder_push(FrameDecoder* d, uint8_t byte);
+
+#endif // FRAME_CODEC_H
@@ -0,0 +1,21 @@
+/**
+ * @file stack_watermark.c
+ * @brief Stack high-water mark by painting
+ */
+
+#include "stack_watermark.h"
+
+void stack_paint(uint32_t* low, uint32_t* high) {
+    // volatile: the region is below the live stack, a plain store loop may be dropped
+    for (volatile uint32_t* p = low; p < high; p++) {
+        *p = STACK_PAINT_WORD;
+    }
+}
+
+uint32_t stack_high_water(const uint32_t* low, const uint32_t* high) {
+    const volatile uint32_t* p = low;
+    while (p < high && *p == STACK_PAINT_WORD) {
+        p++;
+    }
+    return (uint32_t)((const uint32_t*)high - (const uint32_t*)p) * sizeof(uint32_t);
+}
@@ -7,6 +7,28 @@
 
 #include "traffic_queue.h"
 
+/**
+ * @brief Counts the wait of a departing vehicle (none if it arrives in the future)
+ */
+static inline uint32_t record_wait(VehicleQueue* q, const Vehicle* v, uint32_t current_step) {
+    if (current_step < v->arrival_step) return 0;
+
+    uint32_t calculated_wait = current_step - v->arrival_step;
+    if (calculated_wait > q->max_wait_time) {
+        q->max_wait_time = calculated_wait;
+    }
+    wait_hist_record(&q->wait_hist, calculated_wait);
+    return calculated_wait;
+}
+
+/**
+ * @brief Length of an ID truncated to VEHICLE_ID_LEN - 1 characters
+ */
+static inline size_t id_length(const char* id) {
+    const char* nul = memchr(id, '\0', VEHICLE_ID_LEN - 1);
+    return nul ? (size_t)(nul - id) : VEHICLE_ID_LEN - 1;
+}
+
 void queue_init(VehicleQueue* q) {
     if (!q) return;
     memset(q, 0, sizeof(VehicleQueue));
@@ -17,14 +39,17 @@ bool queue_enqueue(VehicleQueue* q, const char* id, Direction start, Direction e
 
     Vehicle* vehicle = &q->vehicles[q->tail];
 
-    strncpy(vehicle->id, id, VEHICLE_ID_LEN - 1);
-    vehicle->id[VEHICLE_ID_LEN - 1] = '\0'; 
+    // Truncated and zero-padded to the fixed-size ID
+    size_t len = id_length(id);
+    memcpy(vehicle->id, id, len);
+    memset(vehicle->id + len, 0, VEHICLE_ID_LEN - len);
     vehicle->start_road = start;
     vehicle->end_road = end;
     vehicle->arrival_step = arrival_step;
 
-    q->tail = (q->tail + 1) % MAX_VEHICLES_PER_ROAD;
+    q->tail = QUEUE_RING_WRAP(q->tail + 1);
     q->count++;
+    if (q->count > q->peak_count) { q->peak_count = q->count; }
 
     return true;
 }
@@ -35,27 +60,48 @@ bool queue_dequeue(VehicleQueue* q, char* out_id, uint32_t current_step, uint32_
     Vehicle* v = &q->vehicles[q->head];
 
     if (out_id) {
-        strncpy(out_id, v->id, VEHICLE_ID_LEN);
+        memcpy(out_id, v->id, VEHICLE_ID_LEN);
     }
 
-    if (current_step >= v->arrival_step) {
-        uint32_t calculated_wait = current_step - v->arrival_step;
-        
-        if (calculated_wait > q->max_wait_time) {
-            q->max_wait_time = calculated_wait;
-        }
-
-        if (wait_time) {
-            *wait_time = calculated_wait;
-        }
+    uint32_t calculated_wait = record_wait(q, v, current_step);
+    if (wait_time && current_step >= v->arrival_step) {
+        *wait_time = calculated_wait;
     }
     
-    q->head = (q->head + 1) % MAX_VEHICLES_PER_ROAD;
+    q->head = QUEUE_RING_WRAP(q->head + 1);
     q->count--;
 
     return true;
 }
 
+uint16_t queue_enqueue_n(VehicleQueue* q, const Vehicle* vehicles, uint16_t n) {
+    if (!q || !vehicles) { return 0; }
+
+    uint16_t free_slots = MAX_VEHICLES_PER_ROAD - q->count;
+    if (n > free_slots) { n = free_slots; }
+
+    // Contiguous up to the end of the ring, the rest from slot 0
+    uint16_t first = QUEUE_RING_SIZE - q->tail;
+    if (first > n) { first = n; }
+    memcpy(&q->vehicles[q->tail], vehicles, first * sizeof(Vehicle));
+    if (n > first) {
+        memcpy(&q->vehicles[0], vehicles + first, (n - first) * sizeof(Vehicle));
+    }
+
+    // Same IDs as queue_enqueue: truncated and zero-padded
+    for (uint16_t i = 0; i < n; i++) {
+        char* id = q->vehicles[QUEUE_RING_WRAP(q->tail + i)].id;
+        size_t len = id_length(id);
+        memset(id + len, 0, VEHICLE_ID_LEN - len);
+    }
+
+    q->tail = QUEUE_RING_WRAP(q->tail + n);
+    q->count += n;
+    if (q->count > q->peak_count) { q->peak_count = q->count; }
+
+    return n;
+}
+
 bool queue_peek(const VehicleQueue* q, Vehicle* out) {
     if (!q || queue_is_empty(q) || !out) { return false; }
 
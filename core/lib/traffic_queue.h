@@ -11,6 +11,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
+#include "wait_histogram.h"
 
 /**
  * @def MAX_VEHICLES_PER_ROAD
@@ -18,6 +19,23 @@
  */
 #define MAX_VEHICLES_PER_ROAD 50
 
+/**
+ * @def QUEUE_RING_SIZE
+ * @brief Slots of the circular buffer (build-time, >= MAX_VEHICLES_PER_ROAD)
+ * 
+ * Defaults to MAX_VEHICLES_PER_ROAD, so no slot is wasted. A power of two
+ * (-DQUEUE_RING_SIZE=64, `make QUEUE_RING_SIZE=64`) lets QUEUE_RING_WRAP
+ * compile to a mask instead of a division, for 4.5 KB more per TrafficSystem.
+ * The capacity of a lane stays MAX_VEHICLES_PER_ROAD either way.
+ */
+#ifndef QUEUE_RING_SIZE
+#define QUEUE_RING_SIZE MAX_VEHICLES_PER_ROAD
+#endif
+#define QUEUE_RING_WRAP(i) ((uint16_t)((unsigned)(i) % QUEUE_RING_SIZE))
+
+_Static_assert(QUEUE_RING_SIZE >= MAX_VEHICLES_PER_ROAD && QUEUE_RING_SIZE <= UINT16_MAX,
+               "QUEUE_RING_SIZE must hold MAX_VEHICLES_PER_ROAD");
+
 /**
  * @def VEHICLE_ID_LEN
  * @brief Maximum length of vehicle identifier strings (including null terminator)
@@ -59,11 +77,13 @@ typedef struct {
  * @note The queue is empty when count == 0
  */
 typedef struct {
-    Vehicle vehicles[MAX_VEHICLES_PER_ROAD];
-    uint16_t head;
-    uint16_t tail;
+    Vehicle vehicles[QUEUE_RING_SIZE];
+    uint16_t head; /* Index of the front vehicle (0 to QUEUE_RING_SIZE - 1) */
+    uint16_t tail; /* Index of the next free slot (0 to QUEUE_RING_SIZE - 1) */
     uint16_t count;
+    uint16_t peak_count; /* Highest count since queue_init() */
     uint32_t max_wait_time;
+    WaitHistogram wait_hist; /* Wait times of dequeued vehicles */
 } VehicleQueue;
 
 /**
@@ -97,6 +117,8 @@ bool queue_enqueue(VehicleQueue* q, const char* id,
 /**
  * @brief Remove and retrieve the front vehicle from the queue
  * 
+ * The wait time is also counted in the queue's wait histogram.
+ * 
  * @param q Pointer to VehicleQueue
  * @param out_id Buffer to store vehicle ID (can be NULL if not needed)
  * @param current_step Current simulation step (for wait time calculation)
@@ -107,6 +129,21 @@ bool queue_enqueue(VehicleQueue* q, const char* id,
 bool queue_dequeue(VehicleQueue* q, char* out_id, 
                    uint32_t current_step, uint32_t* wait_time);
 
+/**
+ * @brief Add several vehicles to the end of the queue
+ * 
+ * Copies the vehicles in order with at most two memcpy calls (before and after
+ * the wrap point). IDs are then truncated and zero-padded as in queue_enqueue().
+ * Vehicles that do not fit into the queue are not added.
+ * 
+ * @param q Pointer to initialized VehicleQueue
+ * @param vehicles Vehicles to add
+ * @param n Number of vehicles
+ * 
+ * @return Number of vehicles added (the first ones of the array)
+ */
+uint16_t queue_enqueue_n(VehicleQueue* q, const Vehicle* vehicles, uint16_t n);
+
 /**
  * @brief View the front vehicle without removing it
  * 
@@ -146,6 +183,17 @@ bool queue_is_full(const VehicleQueue* q);
  */
 uint16_t queue_count(const VehicleQueue* q);
 
+/**
+ * @brief Access a waiting vehicle without copying it
+ * 
+ * @param q Pointer to VehicleQueue
+ * @param i Position from the front (0 to queue_count() - 1)
+ * @return Pointer to the vehicle in its slot
+ */
+static inline const Vehicle* queue_vehicle_at(const VehicleQueue* q, uint16_t i) {
+    return &q->vehicles[QUEUE_RING_WRAP(q->head + i)];
+}
+
 /**
  * @brief Get the maximum observed wait time for this queue
  * 
@@ -156,4 +204,24 @@ static inline uint32_t queue_get_max_wait(const VehicleQueue* q) {
     return q ? q->max_wait_time : 0;
 }
 
+/**
+ * @brief Get the highest number of vehicles that waited at once
+ * 
+ * @param q Pointer to VehicleQueue
+ * @return Peak occupancy since queue_init() (0 to MAX_VEHICLES_PER_ROAD)
+ */
+static inline uint16_t queue_get_peak(const VehicleQueue* q) {
+    return q ? q->peak_count : 0;
+}
+
+/**
+ * @brief Get the wait-time histogram of vehicles that left this queue
+ * 
+ * @param q Pointer to VehicleQueue
+ * @return Pointer to the histogram (NULL if q is NULL)
+ */
+static inline const WaitHistogram* queue_get_wait_hist(const VehicleQueue* q) {
+    return q ? &q->wait_hist : NULL;
+}
+
 #endif // TRAFFIC_QUEUE_H
\ No newline at end of file
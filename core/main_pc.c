@@ -8,134 +8,1298 @@
  * binary command frames, deserializes them, triggers the FSM logic, 
  * and serializes the responses back to standard output.
  * 
+ * Usage: traffic_sim [--input FILE] [--checkpoint FILE] [--session-cache N] [--framed] [--record FILE]
+ *                    [--aggregate N|cycle[:N]] [--telemetry FILE [--telemetry-every N]] [--stack-report]
+ * 
+ * --input reads commands from a file instead of standard input. The file may
+ * also be an archive (traffic_archive.h), which is replayed as its command stream.
+ * --checkpoint resumes from the given checkpoint (if it exists) and rewrites it
+ * on exit. The checkpoint holds the TrafficSystem, its statistics, the number
+ * of scenario bytes (CMD_CONFIG, CMD_SET_STRATEGY, CMD_UPDATE_TIMING, CMD_ADD_TIMING_PLAN,
+ * CMD_ADD_VEHICLE, CMD_STEP) consumed so far and, for --input files, the raw
+ * file position, so a later run on the same, appended input only processes the
+ * new commands. CMD_SAVE_CHECKPOINT rewrites the checkpoint immediately. Commands
+ * that were already consumed are skipped and produce no output: files seek to the
+ * saved position, pipes read and discard every command (control commands
+ * included) until the scenario bytes reach the saved count.
+ * 
+ * The process hosts the default intersection (session 0) plus any number of
+ * sessions created with CMD_SESSION_CREATE. CMD_SESSION_SELECT directs the
+ * single-session commands (CMD_STEP, CMD_ADD_VEHICLE, CMD_GET_STATS, ...) to a
+ * session and CMD_STEP_SESSIONS steps many sessions in one frame. Only
+ * --session-cache N sessions (default SESSION_CACHE_DEFAULT) are kept live, the
+ * others are parked as snapshots. Stepping more sessions in turn than N parks
+ * and unparks one on every step, which drops throughput from about 2M to about
+ * 45K steps/s, so N should cover the sessions stepped per round. Checkpoints
+ * cover session 0 only.
+ * 
+ * --framed expects the commands wrapped in COBS/CRC frames (frame_codec.h) and
+ * answers every frame with one frame, which lets the host resynchronise after
+ * corrupted or lost bytes and retransmit safely (see run_framed()).
+ * 
+ * --record writes the scenario commands of session 0 and the vehicles that left
+ * at every step to a compressed archive (see traffic_archive.h).
+ * 
+ * --aggregate starts session 0 with CMD_SET_AGGREGATION on: CMD_STEP sends a
+ * ResponseBucket every N steps (or every signal cycle, at most N steps) instead
+ * of a ResponseStep per step, and the end of the input sends the open bucket.
+ * Steps taken through CMD_STEP_SESSIONS are not aggregated.
+ * 
+ * CMD_SUBSCRIBE_STATE streams the queues of a session: a keyframe answers the
+ * command, then every N steps of the session a delta update (traffic_stream.h)
+ * follows its step response. CMD_CONFIG makes the next update a keyframe.
+ * 
+ * --telemetry publishes a sample of session 0 (queues, phase, extension usage,
+ * wait statistics and histograms) every N steps (default TELEMETRY_EVERY_DEFAULT)
+ * into a memory-mapped FILE, which monitors such as pc-simulation/dashboard.py
+ * read while the simulation runs (see traffic_telemetry.h).
+ * 
+ * --stack-report runs the command loop on a painted 1 MB thread stack, so
+ * CMD_GET_MEMORY reports its size and peak depth. Without it the loop runs on
+ * the main stack and the stack fields are 0.
+ * 
+ * Building with -DTRAFFIC_SIM_NO_MAIN leaves main() out, so the command parser
+ * can be linked into other programs (fuzz/fuzz_commands.c).
+ * 
  * 11.02.26, Paweł Bolek
  */
 
+#define _POSIX_C_SOURCE 200809L // fmemopen / open_memstream for the framed mode
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <pthread.h>
 
 #include "protocol.h"
 #include "traffic_fsm.h"
+#include "traffic_snapshot.h"
+#include "traffic_sessions.h"
+#include "frame_codec.h"
+#include "traffic_archive.h"
+#include "traffic_aggregate.h"
+#include "traffic_stream.h"
+#include "traffic_telemetry.h"
+#include "stack_watermark.h"
+
+#define CHECKPOINT_MAGIC "TSC2" // magic, scenario bytes, file position, step, snapshot length, snapshot
+#define COMMAND_STACK_SIZE (1024 * 1024) // Painted stack of the command loop (CMD_GET_MEMORY)
+
+TrafficSystem sys; // Default session (ID 0), covered by checkpoints
+TrafficSystem* active = &sys; // Session addressed by the single-session commands
+uint16_t active_id = 0;
+SessionTable sessions;
+
+FILE* input; // Command stream (the current frame in framed mode)
+FILE* output; // Response stream (buffered per frame in framed mode)
+FrameDecoder decoder;
+uint64_t input_offset; // Scenario bytes consumed so far
+uint64_t resume_offset; // Scenario bytes already covered by the checkpoint
+uint64_t resume_position; // Input file position saved with the checkpoint (0 = unknown)
+bool seekable_input; // --input file read without framing (positions are file offsets)
+const char* checkpoint_path; // --checkpoint file, NULL if not given
+ArchiveWriter recorder; // --record archive
+bool recording;
+TrafficAggregator aggregator; // Bucket aggregation of session 0 (CMD_SET_AGGREGATION)
+TrafficTelemetry telemetry; // --telemetry publisher of session 0 (record NULL if off)
+StateStream** subscriptions; // CMD_SUBSCRIBE_STATE streams indexed by session ID (NULL = none)
+uint32_t subscription_slots;
+
+/**
+ * @brief Converts a wire timing payload to a TimingConfig.
+ */
+TimingConfig config_from_payload(const PayloadConfig* payload) {
+    TimingConfig config = {
+        .green_st = payload->green_st,
+        .green_lt = payload->green_lt,
+        .yellow = payload->yellow,
+        .all_red = payload->all_red,
+        .red_yellow = 1,
+        .ext_threshold = payload->ext_threshold,
+        .max_ext = payload->max_ext,
+        .skip_limit = payload->skip_limit
+    };
+    return config;
+}
+
+/**
+ * @brief Appends a scenario command of session 0 to the --record archive.
+ */
+void record_command(uint8_t cmd_type, const void* payload, size_t size) {
+    if (recording && active == &sys) {
+        uint8_t command[ARCHIVE_COMMAND_MAX];
+        command[0] = cmd_type;
+        memcpy(command + sizeof(CmdHeader), payload, size);
+        archive_write_command(&recorder, command, sizeof(CmdHeader) + size);
+    }
+}
+
+/**
+ * @brief Returns the state stream of a session, NULL if it is not subscribed.
+ */
+StateStream* subscription_of(uint16_t session_id) {
+    return session_id < subscription_slots ? subscriptions[session_id] : NULL;
+}
+
+/**
+ * @brief Ends the state stream of a session.
+ */
+void unsubscribe_state(uint16_t session_id) {
+    if (session_id < subscription_slots) {
+        free(subscriptions[session_id]);
+        subscriptions[session_id] = NULL;
+    }
+}
 
-TrafficSystem sys;
+/**
+ * @brief Ends every state stream (exit, fuzz iterations).
+ */
+void release_subscriptions() {
+    for (uint32_t i = 0; i < subscription_slots; i++) {
+        free(subscriptions[i]);
+    }
+    free(subscriptions);
+    subscriptions = NULL;
+    subscription_slots = 0;
+}
+
+/**
+ * @brief StateStreamWrite on the response stream.
+ */
+void write_output(void* ctx, const void* data, size_t len) {
+    fwrite(data, 1, len, (FILE*)ctx);
+}
+
+/**
+ * @brief Accounts for a step of a subscribed session and sends its update when due.
+ */
+void publish_state(StateStream* sub, const TrafficSystem* target) {
+    if (sub && state_stream_after_step(sub, target)) {
+        state_stream_send(sub, target, write_output, output);
+    }
+}
 
 /**
  * @brief Handles CMD_CONFIG: Deserializes timing constraints and resets FSM.
  */
-void handle_config() {
+bool handle_config() {
     PayloadConfig payload;
-    size_t read_count = fread(&payload, sizeof(PayloadConfig), 1, stdin);
+    size_t read_count = fread(&payload, sizeof(PayloadConfig), 1, input);
     
     if (read_count != 1) {
         fprintf(stderr, "[C-ERR] Failed to read Config payload\n");
-        return;
+        return false;
     }
 
-    TimingConfig config = {
-        .green_st = payload.green_st,
-        .green_lt = payload.green_lt,
-        .yellow = payload.yellow,
-        .all_red = payload.all_red,
-        .red_yellow = 1,
-        .ext_threshold = payload.ext_threshold,
-        .max_ext = payload.max_ext,
-        .skip_limit = payload.skip_limit
-    };
+    TimingConfig config = config_from_payload(&payload);
+    record_command(CMD_CONFIG, &payload, sizeof(payload));
     
-    traffic_init(&sys, config);
+    traffic_init(active, config);
+    StateStream* sub = subscription_of(active_id);
+    if (sub) {
+        state_stream_resync(sub);
+    }
     fprintf(stderr, "[C-OK] Config loaded: ST=%d, LT=%d, Y=%d, AR=%d TH=%d MAX=%d LIM=%d\n",
             config.green_st, config.green_lt, config.yellow, config.all_red, config.ext_threshold, 
             config.max_ext, config.skip_limit);
+    return true;
+}
+
+/**
+ * @brief Handles CMD_UPDATE_TIMING: Schedules a new timing without draining the queues.
+ */
+bool handle_update_timing() {
+    PayloadConfig payload;
+    size_t read_count = fread(&payload, sizeof(PayloadConfig), 1, input);
+
+    if (read_count != 1) {
+        fprintf(stderr, "[C-ERR] Failed to read UpdateTiming payload\n");
+        return false;
+    }
+
+    TimingConfig config = config_from_payload(&payload);
+    record_command(CMD_UPDATE_TIMING, &payload, sizeof(payload));
+    traffic_update_timing(active, &config);
+    fprintf(stderr, "[C-OK] Timing update at step %u: ST=%d, LT=%d (%s)\n", active->current_step,
+            config.green_st, config.green_lt, active->timing_pending ? "pending" : "applied");
+    return true;
+}
+
+/**
+ * @brief Handles CMD_ADD_TIMING_PLAN: Appends an entry to the time-of-day plan table.
+ */
+bool handle_add_timing_plan() {
+    PayloadTimingPlan payload;
+    size_t read_count = fread(&payload, sizeof(PayloadTimingPlan), 1, input);
+
+    if (read_count != 1) {
+        fprintf(stderr, "[C-ERR] Failed to read TimingPlan payload\n");
+        return false;
+    }
+
+    record_command(CMD_ADD_TIMING_PLAN, &payload, sizeof(payload));
+    TimingPlan plan = {.start_step = payload.start_step, .timing = config_from_payload(&payload.timing)};
+    if (!traffic_add_timing_plan(active, &plan)) {
+        fprintf(stderr, "[C-WARN] Timing plan at step %u rejected (table full or out of order)\n",
+                payload.start_step);
+    }
+    return true;
+}
+
+/**
+ * @brief Handles CMD_SET_STRATEGY: Selects the controller strategy of the session.
+ */
+bool handle_set_strategy() {
+    PayloadStrategy payload;
+    size_t read_count = fread(&payload, sizeof(PayloadStrategy), 1, input);
+
+    if (read_count != 1) {
+        fprintf(stderr, "[C-ERR] Failed to read Strategy payload\n");
+        return false;
+    }
+    record_command(CMD_SET_STRATEGY, &payload, sizeof(payload));
+
+    if (!traffic_set_strategy(active, (TrafficStrategyId)payload.strategy)) {
+        fprintf(stderr, "[C-WARN] Unknown strategy %d\n", payload.strategy);
+        return true;
+    }
+
+    fprintf(stderr, "[C-OK] Strategy: %s\n", traffic_get_strategy((TrafficStrategyId)payload.strategy)->name);
+    return true;
 }
 
 /**
  * @brief Handles CMD_ADD_VEHICLE: Pushes a new vehicle into the proper approach queue.
  */
-void handle_add_vehicle() {
+bool handle_add_vehicle() {
     PayloadAddVehicle payload;
-    size_t read_count = fread(&payload, sizeof(PayloadAddVehicle), 1, stdin);
+    size_t read_count = fread(&payload, sizeof(PayloadAddVehicle), 1, input);
     
     if (read_count != 1) {
         fprintf(stderr, "[C-ERR] Failed to read AddVehicle payload\n");
-        return;
+        return false;
+    }
+    payload.vehicle_id[VEHICLE_ID_LEN - 1] = '\0'; // The host may fill all 32 bytes
+    if (recording && active == &sys) {
+        archive_write_vehicle(&recorder, payload.vehicle_id, payload.start_road, payload.end_road,
+                              payload.arrival_time);
     }
 
-    bool success = traffic_add_vehicle(&sys, payload.vehicle_id, payload.start_road, payload.end_road, payload.arrival_time);
+    bool success = traffic_add_vehicle(active, payload.vehicle_id, payload.start_road, payload.end_road, payload.arrival_time);
     if (!success) {
         fprintf(stderr, "[C-WARN] Failed to add vehicle %s (queue full or invalid direction)\n", 
                 payload.vehicle_id);
     }
+    return true;
 }
 
 /**
- * @brief Handles CMD_STEP: Advances FSM by one tick and transmits hardware state.
+ * @brief Advances a system by one tick (and records and samples the step of session 0).
+ * 
+ * @return Number of vehicles that left the intersection
+ */
+int step_system(TrafficSystem* target, char discharged_ids[][VEHICLE_ID_LEN]) {
+    memset(discharged_ids, 0, ROAD_COUNT * LANES_PER_ROAD * VEHICLE_ID_LEN);
+
+    int count = traffic_fsm_step(target, discharged_ids);
+    if (recording && target == &sys) {
+        archive_write_step(&recorder, (const char(*)[VEHICLE_ID_LEN])discharged_ids, (uint16_t)count);
+    }
+    if (telemetry.record && target == &sys) {
+        traffic_telemetry_step(&telemetry, &sys);
+    }
+    return count;
+}
+
+/**
+ * @brief Advances a system by one tick and transmits its hardware state.
  * * First sends the fixed 11-byte ResponseStep header. If any vehicles 
  * passed through the intersection during this step, their 32-byte string IDs 
- * are appended consecutively to the output stream.
+ * are appended consecutively to the output stream, then the state update
+ * of a subscribed session if one is due.
  */
-void handle_step() {
+void step_and_respond(TrafficSystem* target, uint16_t session_id) {
     char discharged_ids[ROAD_COUNT * LANES_PER_ROAD][VEHICLE_ID_LEN];
-    memset(discharged_ids, 0, sizeof(discharged_ids));
-
-    int count = traffic_fsm_step(&sys, discharged_ids);
+    StateStream* sub = subscription_of(session_id);
+    if (sub) {
+        state_stream_before_step(sub, target);
+    }
+    int count = step_system(target, discharged_ids);
 
     ResponseStep resp;
-    resp.current_step = sys.current_step;
-    resp.current_state = (uint8_t)sys.current_state;
-    resp.light_ns_st = (uint8_t)sys.lights[NORTH][LANE_STRAIGHT_RIGHT];
-    resp.light_ns_lt = (uint8_t)sys.lights[NORTH][LANE_LEFT];
-    resp.light_ew_st = (uint8_t)sys.lights[EAST][LANE_STRAIGHT_RIGHT];
-    resp.light_ew_lt = (uint8_t)sys.lights[EAST][LANE_LEFT];
+    resp.current_step = target->current_step;
+    resp.current_state = (uint8_t)target->current_state;
+    resp.light_ns_st = (uint8_t)target->lights[NORTH][LANE_STRAIGHT_RIGHT];
+    resp.light_ns_lt = (uint8_t)target->lights[NORTH][LANE_LEFT];
+    resp.light_ew_st = (uint8_t)target->lights[EAST][LANE_STRAIGHT_RIGHT];
+    resp.light_ew_lt = (uint8_t)target->lights[EAST][LANE_LEFT];
     resp.vehicles_out = (uint16_t)count;
 
-    fwrite(&resp, sizeof(ResponseStep), 1, stdout);
+    fwrite(&resp, sizeof(ResponseStep), 1, output);
 
     if (count > 0) {
-        fwrite(discharged_ids, VEHICLE_ID_LEN, count, stdout);
+        fwrite(discharged_ids, VEHICLE_ID_LEN, count, output);
     }
-    
-    fflush(stdout);
+    publish_state(sub, target);
 }
 
 /**
- * @brief Main execution loop.
- * Disables stream buffering to ensure smooth communication 
- * and prevent pipeline deadlocks with the Python wrapper. Operates in 
- * a blocking event loop reading from stdin.
+ * @brief Transmits a completed aggregation bucket.
  */
-int main() {
-    // Disable buffering on stdin/stdout to prevent deadlocks over OS pipes.
-    setvbuf(stdout, NULL, _IONBF, 0);
-    setvbuf(stdin, NULL, _IONBF, 0);
+void send_bucket(const TrafficBucket* bucket, uint8_t flags) {
+    ResponseBucket resp = {
+        .first_step = bucket->first_step,
+        .steps = bucket->steps,
+        .flags = flags
+    };
+    for (uint8_t i = 0; i < AGGREGATE_LANES; i++) {
+        resp.arrivals[i] = bucket->arrivals[i];
+        resp.departures[i] = bucket->departures[i];
+        resp.total_wait[i] = bucket->total_wait[i];
+        resp.max_wait[i] = bucket->max_wait[i];
+        resp.queue_sum[i] = bucket->queue_sum[i];
+        resp.queue_max[i] = bucket->queue_max[i];
+    }
+    for (uint8_t i = 0; i < AGGREGATE_PHASES; i++) {
+        resp.phase_steps[i] = bucket->phase_steps[i];
+    }
 
-    TimingConfig default_config = DEFAULT_TIMING;
-    traffic_init(&sys, default_config);
+    fwrite(&resp, sizeof(ResponseBucket), 1, output);
+}
+
+/**
+ * @brief Sends the open bucket as the final one and stops aggregating.
+ */
+void finish_aggregation() {
+    if (aggregator.mode != AGGREGATE_OFF) {
+        TrafficBucket bucket;
+        traffic_aggregate_flush(&aggregator, &bucket);
+        send_bucket(&bucket, BUCKET_FINAL);
+        aggregator.mode = AGGREGATE_OFF;
+        fflush(output);
+    }
+}
+
+/**
+ * @brief Handles CMD_STEP: Steps the active session.
+ * * While session 0 is aggregated only completed buckets are transmitted.
+ */
+bool handle_step() {
+    if (active == &sys && aggregator.mode != AGGREGATE_OFF) {
+        char discharged_ids[ROAD_COUNT * LANES_PER_ROAD][VEHICLE_ID_LEN];
+        TrafficBucket bucket;
+        StateStream* sub = subscription_of(0);
+
+        traffic_aggregate_before_step(&aggregator, &sys);
+        if (sub) {
+            state_stream_before_step(sub, &sys);
+        }
+        step_system(&sys, discharged_ids);
+        if (traffic_aggregate_after_step(&aggregator, &sys, &bucket)) {
+            send_bucket(&bucket, 0);
+        }
+        publish_state(sub, &sys);
+    } else {
+        step_and_respond(active, active_id);
+    }
+    fflush(output);
+    return true;
+}
+
+/**
+ * @brief Handles CMD_SET_AGGREGATION: Switches session 0 between step responses and buckets.
+ */
+bool handle_set_aggregation() {
+    PayloadAggregation payload;
+    if (fread(&payload, sizeof(PayloadAggregation), 1, input) != 1) {
+        fprintf(stderr, "[C-ERR] Failed to read Aggregation payload\n");
+        return false;
+    }
+
+    finish_aggregation();
+    if (!traffic_aggregate_init(&aggregator, &sys, (AggregateMode)payload.mode, payload.bucket_steps)) {
+        fprintf(stderr, "[C-WARN] Invalid aggregation mode %u (%u steps)\n", payload.mode, payload.bucket_steps);
+    }
+    return true;
+}
+
+/**
+ * @brief Re-resolves the active session after the session cache may have changed.
+ */
+void refresh_active() {
+    if (active_id == 0) {
+        active = &sys;
+        return;
+    }
+
+    active = sessions_acquire(&sessions, active_id);
+    if (!active) {
+        fprintf(stderr, "[C-ERR] Session %u unavailable, falling back to session 0\n", active_id);
+        active_id = 0;
+        active = &sys;
+    }
+}
 
+/**
+ * @brief Handles CMD_SESSION_CREATE: Adds an independent intersection.
+ */
+bool handle_session_create() {
+    PayloadSessionCreate payload;
+    if (fread(&payload, sizeof(PayloadSessionCreate), 1, input) != 1) {
+        fprintf(stderr, "[C-ERR] Failed to read SessionCreate payload\n");
+        return false;
+    }
+
+    if (payload.session_id == 0 ||
+        !sessions_create(&sessions, payload.session_id, config_from_payload(&payload.timing))) {
+        fprintf(stderr, "[C-WARN] Cannot create session %u (reserved, in use or out of memory)\n",
+                payload.session_id);
+    } else if (sessions.count == sessions.n_slots + 1) {
+        // Stepping them all in turn would unpark a snapshot on every step
+        fprintf(stderr, "[C-WARN] %u sessions exceed the cache of %u live sessions; "
+                "stepping more than %u per round is about 45x slower (raise --session-cache)\n",
+                sessions.count, sessions.n_slots, sessions.n_slots);
+    }
+    refresh_active();
+    return true;
+}
+
+/**
+ * @brief Handles CMD_SESSION_SELECT: Directs the single-session commands to a session.
+ */
+bool handle_session_select() {
+    PayloadSession payload;
+    if (fread(&payload, sizeof(PayloadSession), 1, input) != 1) {
+        fprintf(stderr, "[C-ERR] Failed to read SessionSelect payload\n");
+        return false;
+    }
+
+    if (payload.session_id != 0 && !sessions_exists(&sessions, payload.session_id)) {
+        fprintf(stderr, "[C-WARN] Unknown session %u\n", payload.session_id);
+        return true;
+    }
+
+    active_id = payload.session_id;
+    refresh_active();
+    return true;
+}
+
+/**
+ * @brief Handles CMD_SESSION_DESTROY: Releases a session (session 0 cannot be destroyed).
+ */
+bool handle_session_destroy() {
+    PayloadSession payload;
+    if (fread(&payload, sizeof(PayloadSession), 1, input) != 1) {
+        fprintf(stderr, "[C-ERR] Failed to read SessionDestroy payload\n");
+        return false;
+    }
+
+    if (payload.session_id == 0 || !sessions_destroy(&sessions, payload.session_id)) {
+        fprintf(stderr, "[C-WARN] Cannot destroy session %u\n", payload.session_id);
+        return true;
+    }
+
+    unsubscribe_state(payload.session_id);
+    if (payload.session_id == active_id) {
+        active_id = 0;
+    }
+    refresh_active();
+    return true;
+}
+
+/**
+ * @brief Handles CMD_SUBSCRIBE_STATE: Starts (keyframe response) or ends a state stream.
+ * * Subscribing to an unknown session answers a StateUpdateHeader with
+ * STATE_UPDATE_INVALID; unsubscribing (every = 0) sends nothing.
+ */
+bool handle_subscribe_state() {
+    PayloadSubscribe payload;
+    if (fread(&payload, sizeof(PayloadSubscribe), 1, input) != 1) {
+        fprintf(stderr, "[C-ERR] Failed to read Subscribe payload\n");
+        return false;
+    }
+
+    if (payload.every == 0) {
+        unsubscribe_state(payload.session_id);
+        return true;
+    }
+
+    TrafficSystem* target = (payload.session_id == 0) ? &sys : sessions_acquire(&sessions, payload.session_id);
+    StateStream* sub = subscription_of(payload.session_id);
+
+    if (target && !sub) {
+        if (payload.session_id >= subscription_slots) {
+            uint32_t slots = subscription_slots ? subscription_slots : 16;
+            while (slots <= payload.session_id) slots *= 2;
+
+            StateStream** grown = realloc(subscriptions, slots * sizeof(StateStream*));
+            if (grown) {
+                memset(grown + subscription_slots, 0, (slots - subscription_slots) * sizeof(StateStream*));
+                subscriptions = grown;
+                subscription_slots = slots;
+            }
+        }
+        sub = payload.session_id < subscription_slots ? malloc(sizeof(StateStream)) : NULL;
+        if (sub) {
+            subscriptions[payload.session_id] = sub;
+        }
+    }
+
+    if (target && sub) {
+        state_stream_init(sub, payload.session_id, payload.every);
+        state_stream_send(sub, target, write_output, output);
+    } else {
+        if (target) {
+            fprintf(stderr, "[C-WARN] Cannot subscribe to session %u (out of memory)\n", payload.session_id);
+        }
+        StateUpdateHeader invalid = {.session_id = payload.session_id, .flags = STATE_UPDATE_INVALID};
+        fwrite(&invalid, sizeof(StateUpdateHeader), 1, output);
+    }
+
+    fflush(output);
+    refresh_active();
+    return true;
+}
+
+/**
+ * @brief Handles CMD_STEP_SESSIONS: Steps a list of sessions in one frame.
+ * * For every requested ID sends a ResponseSessionStep (the step response
+ * of an unknown session has current_state SESSION_STATE_INVALID and no vehicles),
+ * followed by the IDs of the departing vehicles.
+ */
+bool handle_step_sessions() {
+    PayloadStepSessions payload;
+    if (fread(&payload, sizeof(PayloadStepSessions), 1, input) != 1) {
+        fprintf(stderr, "[C-ERR] Failed to read StepSessions payload\n");
+        return false;
+    }
+
+    for (uint16_t i = 0; i < payload.count; i++) {
+        uint16_t id;
+        if (fread(&id, sizeof(id), 1, input) != 1) {
+            fprintf(stderr, "[C-ERR] Truncated StepSessions list\n");
+            fflush(output);
+            return false;
+        }
+
+        TrafficSystem* target = (id == 0) ? &sys : sessions_acquire(&sessions, id);
+        fwrite(&id, sizeof(id), 1, output);
+
+        if (target) {
+            step_and_respond(target, id);
+        } else {
+            ResponseStep invalid = {.current_state = SESSION_STATE_INVALID};
+            fwrite(&invalid, sizeof(ResponseStep), 1, output);
+        }
+    }
+
+    fflush(output);
+    refresh_active();
+    return true;
+}
+
+/**
+ * @brief Handles CMD_GET_STATS: Transmits the accumulated wait statistics.
+ */
+void handle_get_stats() {
+    ResponseStats resp = {
+        .current_step = active->current_step,
+        .departures = active->stats.departures,
+        .total_wait = active->stats.total_wait,
+        .max_wait = active->stats.max_wait,
+        .left_departures = active->stats.left_departures,
+        .left_total_wait = active->stats.left_total_wait
+    };
+
+    fwrite(&resp, sizeof(ResponseStats), 1, output);
+    fflush(output);
+}
+
+/**
+ * @brief Handles CMD_GET_LINK_STATS: Transmits the frame counters (zero in raw mode).
+ */
+void handle_get_link_stats() {
+    ResponseLinkStats resp = {
+        .frames_ok = decoder.stats.frames_ok,
+        .frames_dropped = decoder.stats.frames_dropped,
+        .frames_duplicate = decoder.stats.frames_duplicate,
+        .seq_gaps = decoder.stats.seq_gaps
+    };
+
+    fwrite(&resp, sizeof(ResponseLinkStats), 1, output);
+    fflush(output);
+}
+
+// Stack of the command loop, painted before it starts (NULL if the loop runs on the main stack)
+uint32_t* command_stack;
+
+/**
+ * @brief Handles CMD_GET_MEMORY: Transmits the session arena and stack high-water marks.
+ */
+void handle_get_memory() {
+    ResponseMemory resp = {
+        .system_bytes = sizeof(TrafficSystem),
+        .heap_bytes = (uint32_t)sessions_memory_usage(&sessions),
+        .heap_peak = (uint32_t)sessions_memory_peak(&sessions)
+    };
+    if (command_stack) {
+        uint32_t* end = command_stack + COMMAND_STACK_SIZE / sizeof(uint32_t);
+        resp.stack_size = COMMAND_STACK_SIZE;
+        resp.stack_peak = stack_high_water(command_stack, end);
+    }
+
+    fwrite(&resp, sizeof(ResponseMemory), 1, output);
+    fflush(output);
+}
+
+/**
+ * @brief Summarizes a wait histogram for ResponseWaitPercentiles.
+ */
+WaitPercentiles percentiles_of(const WaitHistogram* h) {
+    WaitPercentiles p = {
+        .departures = wait_hist_total(h),
+        .p50 = wait_hist_percentile(h, 500),
+        .p95 = wait_hist_percentile(h, 950),
+        .p99 = wait_hist_percentile(h, 990)
+    };
+    return p;
+}
+
+/**
+ * @brief Handles CMD_GET_WAIT_PERCENTILES: Transmits P50/P95/P99 per lane and movement.
+ */
+void handle_get_wait_percentiles() {
+    ResponseWaitPercentiles resp;
+
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            resp.lanes[road * LANES_PER_ROAD + lane] = percentiles_of(queue_get_wait_hist(&active->queues[road][lane]));
+        }
+    }
+
+    for (uint8_t movement = 0; movement < MOVEMENT_COUNT; movement++) {
+        WaitHistogram merged;
+        traffic_movement_wait_hist(active, movement, &merged);
+        resp.movements[movement] = percentiles_of(&merged);
+    }
+
+    fwrite(&resp, sizeof(ResponseWaitPercentiles), 1, output);
+    fflush(output);
+}
+
+/**
+ * @brief Handles CMD_GET_WAIT_HISTOGRAM: Transmits the raw bucket counts of every lane.
+ */
+void handle_get_wait_histogram() {
+    ResponseWaitHistogram resp;
+
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            memcpy(resp.counts[road * LANES_PER_ROAD + lane], active->queues[road][lane].wait_hist.counts,
+                   sizeof(resp.counts[0]));
+        }
+    }
+
+    fwrite(&resp, sizeof(ResponseWaitHistogram), 1, output);
+    fflush(output);
+}
+
+/**
+ * @brief Returns the payload size of a scenario command, 0 for control commands.
+ */
+size_t scenario_payload_size(uint8_t cmd_type) {
+    switch (cmd_type) {
+        case CMD_CONFIG: return sizeof(PayloadConfig);
+        case CMD_ADD_VEHICLE: return sizeof(PayloadAddVehicle);
+        case CMD_SET_STRATEGY: return sizeof(PayloadStrategy);
+        case CMD_UPDATE_TIMING: return sizeof(PayloadConfig);
+        case CMD_ADD_TIMING_PLAN: return sizeof(PayloadTimingPlan);
+        default: return 0;
+    }
+}
+
+/**
+ * @brief Returns the fixed payload size of a control command (CMD_STEP_SESSIONS: its header only).
+ */
+size_t control_payload_size(uint8_t cmd_type) {
+    switch (cmd_type) {
+        case CMD_SESSION_CREATE: return sizeof(PayloadSessionCreate);
+        case CMD_SESSION_SELECT: return sizeof(PayloadSession);
+        case CMD_SESSION_DESTROY: return sizeof(PayloadSession);
+        case CMD_STEP_SESSIONS: return sizeof(PayloadStepSessions);
+        case CMD_SET_AGGREGATION: return sizeof(PayloadAggregation);
+        case CMD_SUBSCRIBE_STATE: return sizeof(PayloadSubscribe);
+        default: return 0;
+    }
+}
+
+bool is_scenario_command(uint8_t cmd_type) {
+    return cmd_type == CMD_CONFIG || cmd_type == CMD_ADD_VEHICLE || cmd_type == CMD_STEP ||
+           cmd_type == CMD_SET_STRATEGY || cmd_type == CMD_UPDATE_TIMING || cmd_type == CMD_ADD_TIMING_PLAN;
+}
+
+/**
+ * @brief Restores the system and input offset from a checkpoint file.
+ * 
+ * @return true if a valid checkpoint was loaded
+ */
+bool load_checkpoint(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+
+    char magic[4];
+    uint64_t offset = 0, position = 0;
+    uint32_t step = 0, snapshot_len = 0;
+    bool ok = fread(magic, sizeof(magic), 1, f) == 1 && memcmp(magic, CHECKPOINT_MAGIC, 4) == 0 &&
+              fread(&offset, sizeof(offset), 1, f) == 1 &&
+              fread(&position, sizeof(position), 1, f) == 1 &&
+              fread(&step, sizeof(step), 1, f) == 1 &&
+              fread(&snapshot_len, sizeof(snapshot_len), 1, f) == 1;
+
+    uint8_t* snapshot = ok ? malloc(snapshot_len) : NULL;
+    ok = ok && snapshot && fread(snapshot, 1, snapshot_len, f) == snapshot_len &&
+         traffic_snapshot_load(&sys, snapshot, snapshot_len);
+
+    free(snapshot);
+    fclose(f);
+
+    if (!ok) {
+        fprintf(stderr, "[C-ERR] Invalid checkpoint %s\n", path);
+        return false;
+    }
+
+    resume_offset = offset;
+    resume_position = position;
+    fprintf(stderr, "[C-OK] Resumed at step %u (input offset %llu)\n",
+            sys.current_step, (unsigned long long)offset);
+    return true;
+}
+
+/**
+ * @brief Atomically writes the system and input offset to a checkpoint file.
+ *
+ * @details The current step is repeated in the header for hosts that resume
+ * through a pipe, where every command before the checkpoint goes unanswered.
+ */
+bool save_checkpoint(const char* path) {
+    size_t snapshot_len = traffic_snapshot_size(&sys);
+    uint8_t* snapshot = malloc(snapshot_len);
+    if (!snapshot || traffic_snapshot_save(&sys, snapshot, snapshot_len) != snapshot_len) {
+        free(snapshot);
+        return false;
+    }
+
+    char tmp_path[1024];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    long file_pos = seekable_input ? ftell(input) : -1;
+    uint64_t position = file_pos > 0 ? (uint64_t)file_pos : 0;
+
+    FILE* f = fopen(tmp_path, "wb");
+    uint32_t len32 = (uint32_t)snapshot_len;
+    bool ok = f && fwrite(CHECKPOINT_MAGIC, 4, 1, f) == 1 &&
+              fwrite(&input_offset, sizeof(input_offset), 1, f) == 1 &&
+              fwrite(&position, sizeof(position), 1, f) == 1 &&
+              fwrite(&sys.current_step, sizeof(sys.current_step), 1, f) == 1 &&
+              fwrite(&len32, sizeof(len32), 1, f) == 1 &&
+              fwrite(snapshot, 1, snapshot_len, f) == snapshot_len;
+
+    if (f && fclose(f) != 0) ok = false;
+    free(snapshot);
+
+    if (!ok || rename(tmp_path, path) != 0) {
+        fprintf(stderr, "[C-ERR] Failed to write checkpoint %s\n", path);
+        remove(tmp_path);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads and drops n bytes of input.
+ */
+bool discard_input(size_t n) {
+    uint8_t buf[64];
+    while (n > 0) {
+        size_t chunk = n < sizeof(buf) ? n : sizeof(buf);
+        if (fread(buf, chunk, 1, input) != 1) return false;
+        n -= chunk;
+    }
+    return true;
+}
+
+/**
+ * @brief Skips commands already covered by the checkpoint (control commands included).
+ * 
+ * A command is covered while the scenario bytes consumed so far are below the
+ * checkpoint's count. Control commands are dropped without being executed, so
+ * they produce no response.
+ * 
+ * @return true if the command was consumed here
+ */
+bool skip_replayed_command(uint8_t cmd_type) {
+    if (input_offset >= resume_offset) {
+        return false;
+    }
+
+    if (!is_scenario_command(cmd_type)) {
+        PayloadStepSessions list;
+        if (cmd_type == CMD_STEP_SESSIONS) {
+            if (fread(&list, sizeof(list), 1, input) == 1) {
+                discard_input(list.count * sizeof(uint16_t));
+            }
+        } else {
+            discard_input(control_payload_size(cmd_type));
+        }
+        return true;
+    }
+
+    size_t size = scenario_payload_size(cmd_type);
+    if (!discard_input(size)) {
+        return true;
+    }
+
+    input_offset += sizeof(CmdHeader) + size;
+    return true;
+}
+
+/**
+ * @brief Executes the commands read from input until EOF, CMD_STOP or a truncated command.
+ * 
+ * @return false once CMD_STOP was received
+ */
+bool process_commands() {
     CmdHeader header;
-    // Blocking read - waits for host command
-    while (fread(&header, sizeof(CmdHeader), 1, stdin) == 1) {
+    bool running = true;
+    while (running && fread(&header, sizeof(CmdHeader), 1, input) == 1) {
+        if (skip_replayed_command(header.cmd_type)) {
+            continue;
+        }
+
+        size_t consumed = sizeof(CmdHeader) + scenario_payload_size(header.cmd_type);
+        bool ok = true;
+
         switch (header.cmd_type) {
             case CMD_CONFIG:
-                handle_config();
+                ok = handle_config();
                 break;
                 
             case CMD_ADD_VEHICLE:
-                handle_add_vehicle();
+                ok = handle_add_vehicle();
+                break;
+
+            case CMD_SET_STRATEGY:
+                ok = handle_set_strategy();
+                break;
+
+            case CMD_UPDATE_TIMING:
+                ok = handle_update_timing();
+                break;
+
+            case CMD_ADD_TIMING_PLAN:
+                ok = handle_add_timing_plan();
                 break;
             
             case CMD_STEP:
-                handle_step();
+                ok = handle_step();
+                break;
+
+            case CMD_SESSION_CREATE:
+                ok = handle_session_create();
+                break;
+
+            case CMD_SESSION_SELECT:
+                ok = handle_session_select();
+                break;
+
+            case CMD_SESSION_DESTROY:
+                ok = handle_session_destroy();
+                break;
+
+            case CMD_STEP_SESSIONS:
+                ok = handle_step_sessions();
+                break;
+
+            case CMD_SET_AGGREGATION:
+                ok = handle_set_aggregation();
+                break;
+
+            case CMD_SUBSCRIBE_STATE:
+                ok = handle_subscribe_state();
+                break;
+
+            case CMD_GET_STATS:
+                handle_get_stats();
+                break;
+
+            case CMD_GET_WAIT_PERCENTILES:
+                handle_get_wait_percentiles();
+                break;
+
+            case CMD_GET_WAIT_HISTOGRAM:
+                handle_get_wait_histogram();
+                break;
+
+            case CMD_GET_LINK_STATS:
+                handle_get_link_stats();
+                break;
+
+            case CMD_GET_MEMORY:
+                handle_get_memory();
+                break;
+
+            case CMD_SAVE_CHECKPOINT:
+                if (checkpoint_path) {
+                    save_checkpoint(checkpoint_path);
+                }
                 break;
 
             case CMD_STOP:
-                return 0;
+                finish_aggregation();
+                running = false;
+                break;
 
             default:
                 fprintf(stderr, "[C-ERR] Unknown command: %d\n", header.cmd_type);
                 break;
         }
+
+        if (!ok) {
+            // Truncated command (e.g. log still being written) - retry it on resume
+            break;
+        }
+        if (is_scenario_command(header.cmd_type)) {
+            input_offset += consumed;
+        }
+    }
+    return running;
+}
+
+/**
+ * @brief Framed mode: answers every frame of the command stream with one frame.
+ * 
+ * A valid frame is executed once; its response frame carries the same seq and the
+ * responses of all its commands (empty for commands without a response). A
+ * retransmitted frame gets the cached response without being executed again and
+ * a damaged frame gets a NAK frame, so the host never waits for a timeout.
+ */
+void run_framed() {
+    FILE* link = input;
+    uint8_t* reply = NULL;
+    size_t reply_len = 0;
+    bool running = true;
+    int c;
+
+    while (running && (c = fgetc(link)) != EOF) {
+        FrameResult result = frame_decoder_push(&decoder, (uint8_t)c);
+
+        if (result == FRAME_OK) {
+            char* responses = NULL;
+            size_t responses_len = 0;
+
+            output = open_memstream(&responses, &responses_len);
+            if (!output) {
+                fprintf(stderr, "[C-ERR] Cannot buffer the frame response\n");
+                break;
+            }
+            if (decoder.payload_len > 0) {
+                input = fmemopen((void*)decoder.payload, decoder.payload_len, "rb");
+                if (input) {
+                    running = process_commands();
+                    fclose(input);
+                }
+            }
+            fclose(output);
+
+            free(reply);
+            reply = malloc(FRAME_ENCODED_SIZE(responses_len));
+            reply_len = reply ? frame_encode(decoder.seq, 0, (uint8_t*)responses, responses_len,
+                                             reply, FRAME_ENCODED_SIZE(responses_len)) : 0;
+            free(responses);
+            fwrite(reply, 1, reply_len, stdout);
+        } else if (result == FRAME_DUPLICATE) {
+            // The host retransmitted because our response got lost
+            fwrite(reply, 1, reply_len, stdout);
+        } else if (result == FRAME_DROPPED) {
+            uint8_t nak[FRAME_ENCODED_SIZE(0)];
+            size_t nak_len = frame_encode(0, FRAME_FLAG_NAK, NULL, 0, nak, sizeof(nak));
+            fwrite(nak, 1, nak_len, stdout);
+        }
+        fflush(stdout);
+    }
+
+    free(reply);
+    input = link;
+    output = stdout;
+
+    const FrameLinkStats* st = &decoder.stats;
+    fprintf(stderr, "[C-OK] Frames: %u ok, %u dropped, %u retransmitted, %u seq gaps\n",
+            st->frames_ok, st->frames_dropped, st->frames_duplicate, st->seq_gaps);
+}
+
+/**
+ * @brief Replaces an archive given with --input by its command stream (in a temporary file).
+ * 
+ * @return The command stream, NULL if the archive is invalid
+ */
+FILE* open_archive_input(FILE* file) {
+    ArchiveReader reader;
+    FILE* stream = tmpfile();
+    bool ok = stream && archive_reader_open(&reader, file);
+    if (ok) {
+        ok = archive_export_commands(&reader, UINT32_MAX, stream) && fflush(stream) == 0;
+        fprintf(stderr, "[C-OK] Replaying archive: %u steps\n", reader.total_steps);
+        archive_reader_close(&reader);
+    }
+    fclose(file);
+
+    if (!ok) {
+        if (stream) fclose(stream);
+        return NULL;
+    }
+    rewind(stream);
+    return stream;
+}
+
+/**
+ * @brief Files jump straight to the position saved with the checkpoint.
+ * 
+ * @details Pipes, framed input and checkpoints without a position skip the
+ * covered commands as they are read instead (skip_replayed_command()).
+ */
+void resume_input() {
+    if (seekable_input && resume_position > 0 && fseek(input, (long)resume_position, SEEK_SET) == 0) {
+        input_offset = resume_offset;
+    }
+}
+
+#ifndef TRAFFIC_SIM_NO_MAIN
+/**
+ * @brief Command loop, run on the main stack or the painted stack.
+ */
+void* command_loop(void* framed) {
+    if (framed) {
+        run_framed();
+    } else {
+        process_commands(); // Blocking read - waits for host command
+        finish_aggregation(); // End of input without CMD_STOP
+    }
+    return NULL;
+}
+
+/**
+ * @brief Runs the command loop, on a painted stack if stack_report is set.
+ *
+ * @details The painted stack lets CMD_GET_MEMORY report the depth of the loop.
+ * Falls back to the main stack (stack fields 0) if the thread cannot be created.
+ */
+void run_command_loop(bool framed, bool stack_report) {
+    if (!stack_report) {
+        command_loop(framed ? &framed : NULL);
+        return;
+    }
+
+    pthread_attr_t attr;
+    pthread_t thread;
+    void* stack = NULL;
+
+    if (posix_memalign(&stack, 4096, COMMAND_STACK_SIZE) == 0 && pthread_attr_init(&attr) == 0) {
+        command_stack = stack;
+        stack_paint(command_stack, command_stack + COMMAND_STACK_SIZE / sizeof(uint32_t));
+
+        bool started = pthread_attr_setstack(&attr, stack, COMMAND_STACK_SIZE) == 0 &&
+                       pthread_create(&thread, &attr, command_loop, framed ? &framed : NULL) == 0;
+        pthread_attr_destroy(&attr);
+        if (started) {
+            pthread_join(thread, NULL);
+        }
+        command_stack = NULL;
+        free(stack);
+        if (started) return;
+    } else {
+        free(stack);
+    }
+    command_loop(framed ? &framed : NULL);
+}
+
+/**
+ * @brief Reports the memory footprint of the sessions and the peak RSS on stderr.
+ */
+void report_footprint() {
+    struct rusage usage;
+    long peak_rss_kb = (getrusage(RUSAGE_SELF, &usage) == 0) ? usage.ru_maxrss : 0;
+
+    if (sessions.count > 0) {
+        SessionsFootprint f;
+        sessions_footprint(&sessions, &f);
+        fprintf(stderr, "[C-OK] %u sessions (%u live, %u parked), %zu bytes, %zu per session; "
+                "largest snapshot %u bytes, longest lane queue %u/%u\n",
+                f.sessions, f.live, f.parked, f.total_bytes, f.total_bytes / f.sessions,
+                f.parked_max, f.peak_queue, MAX_VEHICLES_PER_ROAD);
+    }
+    fprintf(stderr, "[C-OK] TrafficSystem %zu bytes, peak RSS %ld KB\n", sizeof(TrafficSystem), peak_rss_kb);
+}
+
+/**
+ * @brief Maps the --telemetry file (created or resized to one TelemetryRecord).
+ * 
+ * @return Shared record, NULL on failure
+ */
+TelemetryRecord* map_telemetry(const char* path) {
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return NULL;
+
+    // Never truncated below the record: a monitor may have the file mapped already
+    void* record = MAP_FAILED;
+    if (ftruncate(fd, sizeof(TelemetryRecord)) == 0) {
+        record = mmap(NULL, sizeof(TelemetryRecord), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    return record == MAP_FAILED ? NULL : record;
+}
+
+/**
+ * @brief Main execution loop.
+ * Disables stream buffering to ensure smooth communication 
+ * and prevent pipeline deadlocks with the Python wrapper. Operates in 
+ * a blocking event loop reading from stdin.
+ */
+int main(int argc, char** argv) {
+    const char* input_path = NULL;
+    const char* record_path = NULL;
+    const char* aggregate = NULL;
+    const char* telemetry_path = NULL;
+    uint32_t telemetry_every = TELEMETRY_EVERY_DEFAULT;
+    uint32_t cache_slots = SESSION_CACHE_DEFAULT;
+    bool framed = false;
+    bool stack_report = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            input_path = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            checkpoint_path = argv[++i];
+        } else if (strcmp(argv[i], "--session-cache") == 0 && i + 1 < argc) {
+            cache_slots = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--framed") == 0) {
+            framed = true;
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--aggregate") == 0 && i + 1 < argc) {
+            aggregate = argv[++i];
+        } else if (strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc) {
+            telemetry_path = argv[++i];
+        } else if (strcmp(argv[i], "--telemetry-every") == 0 && i + 1 < argc) {
+            telemetry_every = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--stack-report") == 0) {
+            stack_report = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--input FILE] [--checkpoint FILE] [--session-cache N] [--framed] [--record FILE] "
+                    "[--aggregate N|cycle[:N]] [--telemetry FILE [--telemetry-every N]] [--stack-report]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (framed && checkpoint_path) {
+        fprintf(stderr, "[C-ERR] --checkpoint is not supported with --framed\n");
+        return 1;
+    }
+
+    input = stdin;
+    if (input_path) {
+        input = fopen(input_path, "rb");
+        if (!input) {
+            fprintf(stderr, "[C-ERR] Cannot open %s\n", input_path);
+            return 1;
+        }
+        if (archive_is_archive(input) && !(input = open_archive_input(input))) {
+            fprintf(stderr, "[C-ERR] Invalid archive %s\n", input_path);
+            return 1;
+        }
+    }
+
+    FILE* record_file = NULL;
+    if (record_path) {
+        record_file = fopen(record_path, "wb");
+        if (!record_file || !archive_writer_open(&recorder, record_file, ARCHIVE_HAS_DEPARTURES)) {
+            fprintf(stderr, "[C-ERR] Cannot create %s\n", record_path);
+            return 1;
+        }
+        recording = true;
+    }
+
+    // Disable buffering on stdin/stdout to prevent deadlocks over OS pipes.
+    // Frames are read byte by byte, where a buffered stdin cannot block on a partial read.
+    setvbuf(stdout, NULL, _IONBF, 0);
+    if (!framed) {
+        setvbuf(stdin, NULL, _IONBF, 0);
+    }
+    frame_decoder_init(&decoder);
+
+    TimingConfig default_config = DEFAULT_TIMING;
+    traffic_init(&sys, default_config);
+
+    if (!sessions_init(&sessions, cache_slots)) {
+        fprintf(stderr, "[C-ERR] Cannot allocate the session cache\n");
+        return 1;
+    }
+
+    seekable_input = input_path && !framed;
+    if (checkpoint_path && load_checkpoint(checkpoint_path)) {
+        resume_input();
+    }
+
+    if (aggregate) {
+        bool cycles = strncmp(aggregate, "cycle", 5) == 0;
+        const char* steps = cycles ? (aggregate[5] == ':' ? aggregate + 6 : "0") : aggregate;
+        if (!traffic_aggregate_init(&aggregator, &sys, cycles ? AGGREGATE_CYCLES : AGGREGATE_STEPS,
+                                    (uint32_t)strtoul(steps, NULL, 10))) {
+            fprintf(stderr, "[C-ERR] Invalid --aggregate %s\n", aggregate);
+            return 1;
+        }
+    }
+
+    if (telemetry_path) {
+        TelemetryRecord* record = map_telemetry(telemetry_path);
+        if (!record) {
+            fprintf(stderr, "[C-ERR] Cannot map %s\n", telemetry_path);
+            return 1;
+        }
+        traffic_telemetry_init(&telemetry, record, telemetry_every, &sys);
+    }
+
+    output = stdout;
+    run_command_loop(framed, stack_report);
+
+    report_footprint();
+    sessions_free(&sessions);
+    release_subscriptions();
+
+    if (telemetry.record) {
+        traffic_telemetry_publish(&telemetry, &sys, TELEMETRY_FINISHED);
+        munmap(telemetry.record, sizeof(TelemetryRecord));
+    }
+
+    if (recording) {
+        recording = false;
+        bool recorded = archive_writer_close(&recorder);
+        if (fclose(record_file) != 0 || !recorded) {
+            fprintf(stderr, "[C-ERR] Failed to write %s\n", record_path);
+            return 1;
+        }
+    }
+
+    if (checkpoint_path && !save_checkpoint(checkpoint_path)) {
+        return 1;
+    }
+    if (input != stdin) {
+        fclose(input);
     }
 
     return 0;
-}
\ No newline at end of file
+}
+#endif // TRAFFIC_SIM_NO_MAIN
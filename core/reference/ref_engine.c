@@ -0,0 +1,134 @@
+/**
+ * @file ref_engine.c
+ * @brief Single translation unit of the frozen reference kernel (see ref_engine.h).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+// Public symbols of the copies, renamed so they link next to the live engine
+#define traffic_init ref_traffic_init
+#define traffic_restart_cycle ref_traffic_restart_cycle
+#define traffic_set_strategy ref_traffic_set_strategy
+#define traffic_get_strategy ref_traffic_get_strategy
+#define traffic_update_timing ref_traffic_update_timing
+#define traffic_add_timing_plan ref_traffic_add_timing_plan
+#define traffic_add_vehicle ref_traffic_add_vehicle
+#define traffic_fsm_step ref_traffic_fsm_step
+#define traffic_fsm_advance_clock ref_traffic_fsm_advance_clock
+#define traffic_fsm_decide ref_traffic_fsm_decide
+#define traffic_fsm_apply ref_traffic_fsm_apply
+#define traffic_decision_equal ref_traffic_decision_equal
+#define traffic_get_queue_size ref_traffic_get_queue_size
+#define traffic_movement_wait_hist ref_traffic_movement_wait_hist
+#define traffic_state_lights ref_traffic_state_lights
+#define traffic_state_duration ref_traffic_state_duration
+#define traffic_state_successor ref_traffic_state_successor
+#define queue_init ref_queue_init
+#define queue_enqueue ref_queue_enqueue
+#define queue_dequeue ref_queue_dequeue
+#define queue_peek ref_queue_peek
+#define queue_is_empty ref_queue_is_empty
+#define queue_is_full ref_queue_is_full
+#define queue_count ref_queue_count
+#define wait_hist_init ref_wait_hist_init
+#define wait_hist_bucket ref_wait_hist_bucket
+#define wait_hist_bucket_min ref_wait_hist_bucket_min
+#define wait_hist_bucket_max ref_wait_hist_bucket_max
+#define wait_hist_merge ref_wait_hist_merge
+#define wait_hist_total ref_wait_hist_total
+#define wait_hist_percentile ref_wait_hist_percentile
+
+#include "wait_histogram.c"
+#include "traffic_queue.c"
+#include "traffic_fsm.c"
+
+#include "ref_engine.h"
+
+_Static_assert(REF_ROAD_COUNT == ROAD_COUNT && REF_LANES_PER_ROAD == LANES_PER_ROAD &&
+               REF_MOVEMENT_COUNT == MOVEMENT_COUNT && REF_VEHICLE_ID_LEN == VEHICLE_ID_LEN &&
+               REF_HIST_BUCKETS == WAIT_HIST_BUCKETS, "Reference layout does not match ref_engine.h");
+_Static_assert(sizeof(TimingConfig) == REF_TIMING_FIELDS * sizeof(uint32_t), "TimingConfig layout changed");
+
+struct RefEngine {
+    TrafficSystem sys;
+};
+
+static TimingConfig timing_from_fields(const uint32_t fields[REF_TIMING_FIELDS]) {
+    TimingConfig timing;
+    memcpy(&timing, fields, sizeof(timing));
+    return timing;
+}
+
+RefEngine* ref_engine_create(const uint32_t timing[REF_TIMING_FIELDS]) {
+    RefEngine* engine = malloc(sizeof(RefEngine));
+    if (engine) {
+        ref_engine_init(engine, timing);
+    }
+    return engine;
+}
+
+void ref_engine_free(RefEngine* engine) {
+    free(engine);
+}
+
+void ref_engine_init(RefEngine* engine, const uint32_t timing[REF_TIMING_FIELDS]) {
+    traffic_init(&engine->sys, timing_from_fields(timing));
+}
+
+void ref_engine_restart_cycle(RefEngine* engine) {
+    traffic_restart_cycle(&engine->sys);
+}
+
+bool ref_engine_set_strategy(RefEngine* engine, uint8_t strategy) {
+    return traffic_set_strategy(&engine->sys, (TrafficStrategyId)strategy);
+}
+
+void ref_engine_update_timing(RefEngine* engine, const uint32_t timing[REF_TIMING_FIELDS]) {
+    TimingConfig config = timing_from_fields(timing);
+    traffic_update_timing(&engine->sys, &config);
+}
+
+bool ref_engine_add_timing_plan(RefEngine* engine, uint32_t start_step, const uint32_t timing[REF_TIMING_FIELDS]) {
+    TimingPlan plan = {.start_step = start_step, .timing = timing_from_fields(timing)};
+    return traffic_add_timing_plan(&engine->sys, &plan);
+}
+
+bool ref_engine_add_vehicle(RefEngine* engine, const char* id, uint8_t start, uint8_t end, uint32_t arrival_time) {
+    return traffic_add_vehicle(&engine->sys, id, (Direction)start, (Direction)end, arrival_time);
+}
+
+uint8_t ref_engine_step(RefEngine* engine, char out_ids[][REF_VEHICLE_ID_LEN]) {
+    return traffic_fsm_step(&engine->sys, out_ids);
+}
+
+void ref_engine_observe(const RefEngine* engine, RefObservation* out) {
+    const TrafficSystem* sys = &engine->sys;
+
+    memset(out, 0, sizeof(*out));
+    out->state = (uint8_t)sys->current_state;
+    out->step = sys->current_step;
+    out->state_timer = sys->state_timer;
+    out->extension_timer = sys->extension_timer;
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            out->lights[road][lane] = (uint8_t)sys->lights[road][lane];
+            out->queue_size[road][lane] = queue_count(&sys->queues[road][lane]);
+            out->queue_max_wait[road][lane] = queue_get_max_wait(&sys->queues[road][lane]);
+        }
+        out->skip_counters[road] = sys->phase_skip_counters[road];
+    }
+    memcpy(out->timing, &sys->timing, sizeof(out->timing));
+    out->timing_pending = sys->timing_pending;
+    out->strategy = sys->strategy;
+    out->departures = sys->stats.departures;
+    out->total_wait = sys->stats.total_wait;
+    out->max_wait = sys->stats.max_wait;
+    out->left_departures = sys->stats.left_departures;
+    out->left_total_wait = sys->stats.left_total_wait;
+    for (uint8_t movement = 0; movement < MOVEMENT_COUNT; movement++) {
+        WaitHistogram hist;
+        traffic_movement_wait_hist(sys, movement, &hist);
+        memcpy(out->wait_hist[movement], hist.counts, sizeof(out->wait_hist[movement]));
+    }
+}
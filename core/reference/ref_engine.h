@@ -0,0 +1,92 @@
+/**
+ * @file ref_engine.h
+ * @brief Frozen reference kernel for differential testing.
+ * @details traffic_fsm.c, traffic_queue.c and wait_histogram.c in this directory
+ * are verbatim copies of the engine as of the reference commit. They are never
+ * optimised or fixed: fuzz/diff_engine.c runs them in lock-step with the live
+ * engine and any difference in departures, lights or statistics is a behaviour
+ * change. A deliberate behaviour change is accepted by copying the new sources here.
+ *
+ * The copies are compiled as a single translation unit (ref_engine.c) with every
+ * public symbol renamed, and this interface only uses plain types, so both
+ * engines link into one program without their headers ever meeting.
+ */
+
+#ifndef REF_ENGINE_H
+#define REF_ENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define REF_ROAD_COUNT 4
+#define REF_LANES_PER_ROAD 2
+#define REF_MOVEMENT_COUNT 4
+#define REF_VEHICLE_ID_LEN 32
+#define REF_HIST_BUCKETS 64
+#define REF_TIMING_FIELDS 8 // TimingConfig fields, in declaration order
+
+typedef struct RefEngine RefEngine;
+
+/**
+ * @brief Observable state of an engine after a step.
+ *
+ * @details Filled field by field after a memset(), so two observations can be
+ * compared with memcmp(). Every departure is covered by the statistics and the
+ * per-movement wait histograms.
+ */
+typedef struct {
+    uint8_t state;
+    uint32_t step;
+    uint32_t state_timer;
+    uint32_t extension_timer;
+    uint8_t lights[REF_ROAD_COUNT][REF_LANES_PER_ROAD];
+    uint16_t queue_size[REF_ROAD_COUNT][REF_LANES_PER_ROAD];
+    uint32_t queue_max_wait[REF_ROAD_COUNT][REF_LANES_PER_ROAD];
+    uint8_t skip_counters[REF_ROAD_COUNT];
+    uint32_t timing[REF_TIMING_FIELDS];
+    bool timing_pending;
+    uint8_t strategy;
+    uint32_t departures;
+    uint64_t total_wait;
+    uint32_t max_wait;
+    uint32_t left_departures;
+    uint64_t left_total_wait;
+    uint32_t wait_hist[REF_MOVEMENT_COUNT][REF_HIST_BUCKETS];
+} RefObservation;
+
+/**
+ * @brief Allocates a reference engine initialized with the given timing.
+ *
+ * @return Engine, NULL if out of memory
+ */
+RefEngine* ref_engine_create(const uint32_t timing[REF_TIMING_FIELDS]);
+
+void ref_engine_free(RefEngine* engine);
+
+/** @brief traffic_init() */
+void ref_engine_init(RefEngine* engine, const uint32_t timing[REF_TIMING_FIELDS]);
+
+/** @brief traffic_restart_cycle() */
+void ref_engine_restart_cycle(RefEngine* engine);
+
+/** @brief traffic_set_strategy() */
+bool ref_engine_set_strategy(RefEngine* engine, uint8_t strategy);
+
+/** @brief traffic_update_timing() */
+void ref_engine_update_timing(RefEngine* engine, const uint32_t timing[REF_TIMING_FIELDS]);
+
+/** @brief traffic_add_timing_plan() */
+bool ref_engine_add_timing_plan(RefEngine* engine, uint32_t start_step, const uint32_t timing[REF_TIMING_FIELDS]);
+
+/** @brief traffic_add_vehicle() */
+bool ref_engine_add_vehicle(RefEngine* engine, const char* id, uint8_t start, uint8_t end, uint32_t arrival_time);
+
+/** @brief traffic_fsm_step() */
+uint8_t ref_engine_step(RefEngine* engine, char out_ids[][REF_VEHICLE_ID_LEN]);
+
+/**
+ * @brief Captures the observable state of the engine.
+ */
+void ref_engine_observe(const RefEngine* engine, RefObservation* out);
+
+#endif // REF_ENGINE_H
@@ -0,0 +1,708 @@
+/**
+ * @file traffic_fsm.c
+ * @brief Implementation of the Finite State Machine for intersection control.
+ * 
+ * 11.02.26 Paweł Bolek
+ */
+
+#include <string.h>
+#include "traffic_fsm.h"
+
+// --- INTERNAL DATA STRUCTURES ---
+
+typedef struct {
+    TrafficState state;
+    Direction road1;
+    Direction road2;
+    uint8_t lane;
+    LightColor color;
+} StateLight;
+
+typedef struct {
+    TrafficState current;
+    TrafficState next;
+    uint8_t timing_idx;
+} StateTransition;
+
+/**
+ * @brief Table mapping specific FSM states to physical light colors.
+ */
+static const StateLight STATE_LIGHTS[] = {
+    {STATE_NS_RED_YELLOW, NORTH, SOUTH, LANE_STRAIGHT_RIGHT, LIGHT_RED_YELLOW},
+    {STATE_NS_STRAIGHT, NORTH, SOUTH, LANE_STRAIGHT_RIGHT, LIGHT_GREEN},
+    {STATE_NS_STRAIGHT_YELLOW, NORTH, SOUTH, LANE_STRAIGHT_RIGHT, LIGHT_YELLOW},
+
+    {STATE_NS_LEFT_RED_YELLOW, NORTH, SOUTH, LANE_LEFT, LIGHT_RED_YELLOW},
+    {STATE_NS_LEFT, NORTH, SOUTH, LANE_LEFT, LIGHT_GREEN},
+    {STATE_NS_LEFT, EAST, WEST, LANE_STRAIGHT_RIGHT, LIGHT_RIGHT_ARROW_GREEN},
+    {STATE_NS_LEFT_YELLOW, NORTH, SOUTH, LANE_LEFT, LIGHT_YELLOW},
+
+    {STATE_EW_RED_YELLOW, EAST, WEST, LANE_STRAIGHT_RIGHT, LIGHT_RED_YELLOW},
+    {STATE_EW_STRAIGHT, EAST, WEST, LANE_STRAIGHT_RIGHT, LIGHT_GREEN},
+    {STATE_EW_STRAIGHT_YELLOW, EAST, WEST, LANE_STRAIGHT_RIGHT, LIGHT_YELLOW},
+
+    {STATE_EW_LEFT_RED_YELLOW, EAST, WEST, LANE_LEFT, LIGHT_RED_YELLOW},
+    {STATE_EW_LEFT, EAST, WEST, LANE_LEFT, LIGHT_GREEN},
+    {STATE_EW_LEFT, NORTH, SOUTH, LANE_STRAIGHT_RIGHT, LIGHT_RIGHT_ARROW_GREEN},
+    {STATE_EW_LEFT_YELLOW, EAST, WEST, LANE_LEFT, LIGHT_YELLOW},
+};
+
+/**
+ * @brief Table defining deterministic state transitions and their required durations.
+ */
+static const StateTransition STATE_TRANSITIONS[] = {
+    [STATE_ALL_RED]            = {STATE_ALL_RED, STATE_NS_RED_YELLOW, 3},
+
+    [STATE_NS_RED_YELLOW]      = {STATE_NS_RED_YELLOW, STATE_NS_STRAIGHT, 4},
+    [STATE_NS_STRAIGHT]        = {STATE_NS_STRAIGHT, STATE_NS_STRAIGHT_YELLOW, 0},
+    [STATE_NS_STRAIGHT_YELLOW] = {STATE_NS_STRAIGHT_YELLOW, STATE_NS_LEFT_RED_YELLOW, 2},
+    
+    [STATE_NS_LEFT_RED_YELLOW] = {STATE_NS_LEFT_RED_YELLOW, STATE_NS_LEFT, 4},
+    [STATE_NS_LEFT]            = {STATE_NS_LEFT, STATE_NS_LEFT_YELLOW, 1},
+    [STATE_NS_LEFT_YELLOW]     = {STATE_NS_LEFT_YELLOW, STATE_EW_RED_YELLOW, 2},
+    
+    [STATE_EW_RED_YELLOW]      = {STATE_EW_RED_YELLOW, STATE_EW_STRAIGHT, 4},
+    [STATE_EW_STRAIGHT]        = {STATE_EW_STRAIGHT, STATE_EW_STRAIGHT_YELLOW, 0},
+    [STATE_EW_STRAIGHT_YELLOW] = {STATE_EW_STRAIGHT_YELLOW, STATE_EW_LEFT_RED_YELLOW, 2},
+    
+    [STATE_EW_LEFT_RED_YELLOW] = {STATE_EW_LEFT_RED_YELLOW, STATE_EW_LEFT, 4},
+    [STATE_EW_LEFT]            = {STATE_EW_LEFT, STATE_EW_LEFT_YELLOW, 1},
+    [STATE_EW_LEFT_YELLOW]     = {STATE_EW_LEFT_YELLOW, STATE_NS_RED_YELLOW, 2},
+};
+
+// --- HELPER FUNCTIONS (static, some inline for speed) ---
+
+/**
+ * @brief Retrieves the target duration (in steps) for a given timing index.
+ */
+static inline uint32_t get_timing_value(const TimingConfig* timing, uint8_t idx) {
+    switch(idx) {
+        case 0: { return timing->green_st; }
+        case 1: { return timing->green_lt; }
+        case 2: { return timing->yellow; }
+        case 3: { return timing->all_red; }
+        case 4: { return timing->red_yellow; }
+        
+        default: { return 0; }
+    }
+}
+
+/**
+ * @brief Determines mathematically if a route constitutes a left turn.
+ */
+static inline bool is_left_turn(Direction start, Direction end) {
+    return ((end - start + DIRECTION_MOD) % DIRECTION_MOD) == LEFT_TURN_DIFF;
+}
+
+/**
+ * @brief Resolves which lane queue a vehicle should join based on its destination.
+ */
+static inline uint8_t get_lane_for_turn(Direction start, Direction end) {
+    return is_left_turn(start, end) ? LANE_LEFT : LANE_STRAIGHT_RIGHT;
+}
+
+static inline bool is_green_phase(TrafficState state) {
+    return (state == STATE_NS_STRAIGHT || state == STATE_NS_LEFT ||
+            state == STATE_EW_STRAIGHT || state == STATE_EW_LEFT);
+}
+
+static inline bool is_yellow_phase(TrafficState state) {
+    return (state == STATE_NS_STRAIGHT_YELLOW || state == STATE_NS_LEFT_YELLOW ||
+            state == STATE_EW_STRAIGHT_YELLOW || state == STATE_EW_LEFT_YELLOW);
+}
+
+#ifdef TRAFFIC_FROZEN_TIMING
+static const TimingConfig FROZEN_TIMING = TRAFFIC_FROZEN_TIMING;
+
+/**
+ * @brief Checks that a timing is the one the frozen step was compiled for.
+ */
+static inline bool is_frozen_timing(const TimingConfig* timing) {
+    // TimingConfig has no padding; only called when the timing changes
+    return memcmp(timing, &FROZEN_TIMING, sizeof(TimingConfig)) == 0;
+}
+#endif
+
+/**
+ * @brief Recomputes timing_frozen after sys->timing changed.
+ */
+static inline void refresh_frozen_timing(TrafficSystem* sys) {
+#ifdef TRAFFIC_FROZEN_TIMING
+    sys->timing_frozen = is_frozen_timing(&sys->timing);
+#else
+    (void)sys;
+#endif
+}
+
+/**
+ * @brief Phase boundary where a new timing can take over (no light is green or yellow).
+ */
+static inline bool is_preparation_phase(TrafficState state) {
+    return (state == STATE_NS_RED_YELLOW || state == STATE_NS_LEFT_RED_YELLOW ||
+            state == STATE_EW_RED_YELLOW || state == STATE_EW_LEFT_RED_YELLOW);
+}
+
+/**
+ * @brief Maps a green phase state to an array index (0-3).
+ * Useful for accessing phase_skip_counters array.
+ */
+static int get_phase_idx(TrafficState state) {
+    if (state == STATE_NS_STRAIGHT) { return 0; }
+    if (state == STATE_NS_LEFT) { return 1; }
+    if (state == STATE_EW_STRAIGHT) { return 2; }
+    if (state == STATE_EW_LEFT) { return 3; }
+
+    return -1;
+}
+
+/**
+ * @brief Returns the corresponding RED_YELLOW preparation state for a given green phase.
+ */
+static TrafficState get_preparation_state(TrafficState green_phase) {
+    switch(green_phase) {
+        case STATE_NS_STRAIGHT: { return STATE_NS_RED_YELLOW; }
+        case STATE_NS_LEFT: { return STATE_NS_LEFT_RED_YELLOW; }
+        case STATE_EW_STRAIGHT: {  return STATE_EW_RED_YELLOW; }
+        case STATE_EW_LEFT: { return STATE_EW_LEFT_RED_YELLOW; }
+        default: { return STATE_ALL_RED; }
+    }
+}
+
+/**
+ * @brief Returns the next sequential green phase in the standard cycle.
+ */
+static TrafficState get_next_green_phase(TrafficState green_phase) {
+    switch(green_phase) {
+        case STATE_NS_STRAIGHT: { return STATE_NS_LEFT; }
+        case STATE_NS_LEFT: { return STATE_EW_STRAIGHT; }
+        case STATE_EW_STRAIGHT: { return STATE_EW_LEFT; }
+        case STATE_EW_LEFT: { return STATE_NS_STRAIGHT; }
+        default: { return STATE_NS_STRAIGHT; }
+    }
+}
+
+/**
+ * @brief Returns the next sequential phase in the standard cycle.
+ */
+static TrafficState get_phase_after_yellow(TrafficState yellow_phase) {
+    switch(yellow_phase) {
+        case STATE_NS_STRAIGHT_YELLOW: { return STATE_NS_LEFT; }
+        case STATE_NS_LEFT_YELLOW: { return STATE_EW_STRAIGHT; }
+        case STATE_EW_STRAIGHT_YELLOW: { return STATE_EW_LEFT; }
+        case STATE_EW_LEFT_YELLOW: { return STATE_NS_STRAIGHT; }
+        default: { return STATE_NS_STRAIGHT; }
+    }
+}
+
+/**
+ * @brief Evaluates if both opposing lanes for a given phase are currently empty.
+ */
+static bool is_phase_empty(const TrafficSystem* sys, TrafficState state) {
+    switch (state) {
+        case STATE_NS_STRAIGHT:
+            { return queue_is_empty(&sys->queues[NORTH][LANE_STRAIGHT_RIGHT]) && 
+                   queue_is_empty(&sys->queues[SOUTH][LANE_STRAIGHT_RIGHT]); }
+        case STATE_NS_LEFT:
+            { return queue_is_empty(&sys->queues[NORTH][LANE_LEFT]) && 
+                   queue_is_empty(&sys->queues[SOUTH][LANE_LEFT]); }
+        case STATE_EW_STRAIGHT:
+            { return queue_is_empty(&sys->queues[EAST][LANE_STRAIGHT_RIGHT]) && 
+                   queue_is_empty(&sys->queues[WEST][LANE_STRAIGHT_RIGHT]); }
+        case STATE_EW_LEFT:
+            { return queue_is_empty(&sys->queues[EAST][LANE_LEFT]) && 
+                   queue_is_empty(&sys->queues[WEST][LANE_LEFT]); }
+        default: { return false; }
+    }
+}
+
+// --- CORE FSM LOGIC ---
+
+/**
+ * @brief Resolves transitions fixed by the transition table and timers.
+ * 
+ * @return true if next was resolved, false if the strategy has to select the next phase
+ * (end of Yellow, or waking up from All-Red)
+ */
+static inline bool get_table_transition(const TrafficSystem* sys, const TimingConfig* timing,
+                                        TrafficState* next) {
+    if (sys->current_state >= ARRAY_SIZE(STATE_TRANSITIONS)) {
+        *next = STATE_ALL_RED;
+        return true;
+    }
+
+    const StateTransition* transition = &STATE_TRANSITIONS[sys->current_state];
+
+    // Wait until the timer for the current state expires
+    if (sys->state_timer < get_timing_value(timing, transition->timing_idx)) {
+        *next = sys->current_state;
+        return true;
+    }
+
+    // RULE 1: Static transitions (Green -> Yellow, Red/Yellow -> Green)
+    if (!is_yellow_phase(sys->current_state) && sys->current_state != STATE_ALL_RED) {
+        *next = transition->next;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Scans the phases following the current state for one with waiting vehicles.
+ * 
+ * @details Implements Phase Skipping logic. If a target phase is empty, it skips to the 
+ * next one. With use_limit, a phase skipped skip_limit times in a row is executed anyway
+ * (starvation prevention). Starvation counters are updated in skip_counters instead of
+ * the system itself.
+ */
+static inline TrafficState scan_phases(const TrafficSystem* sys, const TimingConfig* timing,
+                                       uint8_t skip_counters[ROAD_COUNT], bool use_limit) {
+    // RULE 2: Phase selection
+    TrafficState candidate_green = get_phase_after_yellow(sys->current_state);
+
+    // Scan ahead up to 4 phases to skip empty queues
+    for (uint8_t checked = 0; checked < 4; checked++) {
+        int phase_idx = get_phase_idx(candidate_green);
+        
+        // Failsafe against invalid phase lookup
+        if (phase_idx < 0) {
+            return STATE_ALL_RED; 
+        }
+        
+        // If phase has vehicles OR starvation limit is reached -> Execute this phase
+        if (!is_phase_empty(sys, candidate_green) || 
+            (use_limit && skip_counters[phase_idx] >= timing->skip_limit)) {
+            
+            if (use_limit) {
+                skip_counters[phase_idx] = 0; // Reset starvation counter
+            }
+            return get_preparation_state(candidate_green);
+        }
+        
+        // Phase is empty -> increment starvation counter and test the next one
+        if (use_limit) {
+            skip_counters[phase_idx]++;
+        }
+        candidate_green = get_next_green_phase(candidate_green);
+    }
+    
+    // Intersection is completely empty - retreat to ALL_RED
+    return STATE_ALL_RED;
+}
+
+/**
+ * @brief Returns the longest queue among lanes that currently have green light.
+ */
+static uint16_t longest_green_queue(const TrafficSystem* sys) {
+    uint16_t longest = 0;
+
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            if (sys->lights[road][lane] != LIGHT_GREEN) continue;
+
+            uint16_t count = queue_count(&sys->queues[road][lane]);
+            if (count > longest) longest = count;
+        }
+    }
+    return longest;
+}
+
+/**
+ * @brief Determines if the current green phase should be extended based on queue length
+ */
+static bool should_extend_current_phase(const TrafficSystem* sys, const TimingConfig* timing) {
+    if (!is_green_phase(sys->current_state)) return false;
+    
+    // Check all lanes that currently have green light
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            if (!(sys->lights[road][lane] == LIGHT_GREEN)) {
+                continue;
+            }
+
+            if (queue_count(&sys->queues[road][lane]) >= timing->ext_threshold) {
+                return true;
+            }
+            
+        }
+    }
+
+    return false;
+}
+
+// --- STRATEGY HOOKS ---
+
+/**
+ * @brief V1: every phase runs in sequence, regardless of occupancy.
+ */
+static TrafficState select_phase_fixed(const TrafficSystem* sys, const TimingConfig* timing,
+                                       uint8_t skip_counters[ROAD_COUNT]) {
+    (void)timing;
+    (void)skip_counters;
+    return get_preparation_state(get_phase_after_yellow(sys->current_state));
+}
+
+/**
+ * @brief V2-V5: empty phases are always skipped.
+ */
+static TrafficState select_phase_skip_empty(const TrafficSystem* sys, const TimingConfig* timing,
+                                            uint8_t skip_counters[ROAD_COUNT]) {
+    return scan_phases(sys, timing, skip_counters, false);
+}
+
+/**
+ * @brief V6: empty phases are skipped at most skip_limit times in a row.
+ */
+static TrafficState select_phase_skip_limited(const TrafficSystem* sys, const TimingConfig* timing,
+                                              uint8_t skip_counters[ROAD_COUNT]) {
+    return scan_phases(sys, timing, skip_counters, true);
+}
+
+static bool extend_never(const TrafficSystem* sys, const TimingConfig* timing) {
+    (void)sys;
+    (void)timing;
+    return false;
+}
+
+/**
+ * @brief V3, V4, V6: extend while a green queue reaches ext_threshold, up to max_ext steps.
+ */
+static bool extend_on_queue(const TrafficSystem* sys, const TimingConfig* timing) {
+    return should_extend_current_phase(sys, timing) && sys->extension_timer < timing->max_ext;
+}
+
+/**
+ * @brief V5: as extend_on_queue, but every waiting vehicle on a green lane raises the limit.
+ */
+static bool extend_on_pressure(const TrafficSystem* sys, const TimingConfig* timing) {
+    uint32_t limit = timing->max_ext + longest_green_queue(sys);
+    return should_extend_current_phase(sys, timing) && sys->extension_timer < limit;
+}
+
+/**
+ * @brief V1-V3: lights of the transition table without permissive right arrows.
+ */
+static void state_lights_no_arrows(TrafficState state, LightColor lights[ROAD_COUNT][LANES_PER_ROAD]) {
+    traffic_state_lights(state, lights);
+
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            if (lights[road][lane] == LIGHT_RIGHT_ARROW_GREEN) {
+                lights[road][lane] = LIGHT_RED;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Built-in strategies, indexed by TrafficStrategyId.
+ */
+static const TrafficStrategy STRATEGIES[STRATEGY_COUNT] = {
+    [STRATEGY_V1] = {"v1_fixed", select_phase_fixed, extend_never, state_lights_no_arrows},
+    [STRATEGY_V2] = {"v2_skip", select_phase_skip_empty, extend_never, state_lights_no_arrows},
+    [STRATEGY_V3] = {"v3_extend", select_phase_skip_empty, extend_on_queue, state_lights_no_arrows},
+    [STRATEGY_V4] = {"v4_arrows", select_phase_skip_empty, extend_on_queue, traffic_state_lights},
+    [STRATEGY_V5] = {"v5_adaptive", select_phase_skip_empty, extend_on_pressure, traffic_state_lights},
+    [STRATEGY_V6] = {"v6_limits", select_phase_skip_limited, extend_on_queue, traffic_state_lights},
+};
+
+/**
+ * @brief Production decision: STRATEGY_V6 hooks called directly (no indirect calls).
+ */
+static inline void decide_production(const TrafficSystem* sys, const TimingConfig* timing, TrafficDecision* out) {
+    if (!get_table_transition(sys, timing, &out->next_state)) {
+        out->next_state = select_phase_skip_limited(sys, timing, out->phase_skip_counters);
+    }
+
+    // Green Extension Logic
+    if (out->next_state != sys->current_state && is_green_phase(sys->current_state) &&
+        extend_on_queue(sys, timing)) {
+        out->extended = true;
+        out->next_state = sys->current_state; // Stay in current green phase
+    }
+}
+
+/**
+ * @brief Decision of any strategy through its hooks.
+ */
+static void decide_with_strategy(const TrafficSystem* sys, const TimingConfig* timing,
+                                 const TrafficStrategy* strategy, TrafficDecision* out) {
+    if (!get_table_transition(sys, timing, &out->next_state)) {
+        out->next_state = strategy->select_phase(sys, timing, out->phase_skip_counters);
+    }
+
+    if (out->next_state != sys->current_state && is_green_phase(sys->current_state) &&
+        strategy->should_extend(sys, timing)) {
+        out->extended = true;
+        out->next_state = sys->current_state;
+    }
+}
+
+/**
+ * @brief Translates the state into physical light signals for all lanes.
+ */
+static void set_lights_for_state(TrafficSystem* sys) {
+    if (sys->strategy == STRATEGY_V6) {
+        traffic_state_lights(sys->current_state, sys->lights);
+    } else {
+        STRATEGIES[sys->strategy].state_lights(sys->current_state, sys->lights);
+    }
+}
+
+/**
+ * @brief Adds a single departure to the accumulated statistics.
+ */
+static inline void record_departure(TrafficStats* stats, uint8_t lane, uint32_t wait_time) {
+    stats->departures++;
+    stats->total_wait += wait_time;
+    if (wait_time > stats->max_wait) {
+        stats->max_wait = wait_time;
+    }
+    if (lane == LANE_LEFT) {
+        stats->left_departures++;
+        stats->left_total_wait += wait_time;
+    }
+}
+
+/**
+ * @brief Iterates through all queues and dequeues vehicles that have a green light
+ * 
+ * @details Implements logic for permissive right turns
+ */
+static uint8_t process_discharges(TrafficSystem* sys, char out_ids[][VEHICLE_ID_LEN]) {
+    uint8_t discharged = 0;
+    
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            LightColor color = sys->lights[road][lane];
+            VehicleQueue* q = &sys->queues[road][lane];
+            
+            if (queue_is_empty(q)) continue;
+
+            // Only green lights allow vehicles to pass
+            if (color == LIGHT_GREEN || color == LIGHT_RIGHT_ARROW_GREEN) {
+                
+                // For green arrow, only let right-turning vehicles through
+                if (color == LIGHT_RIGHT_ARROW_GREEN) {
+                    Vehicle v;
+                    if (queue_peek(q, &v)) {
+                        Direction right_target = (road + 3) % DIRECTION_MOD;
+                        if (v.end_road != right_target) {
+                            continue; // Not turning right - stays in queue
+                        }
+                    }
+                }
+                
+                // Dequeue the vehicle and record its ID
+                uint32_t wait_time = 0;
+                queue_dequeue(q, out_ids[discharged++], sys->current_step, &wait_time);
+                record_departure(&sys->stats, lane, wait_time);
+            }
+        }
+    }
+    
+    return discharged;
+}
+
+// --- PUBLIC API IMPLEMENTATION ---
+
+void traffic_init(TrafficSystem* sys, TimingConfig config) {
+    if (!sys) return;
+    
+    memset(sys, 0, sizeof(TrafficSystem));
+    sys->timing = config;
+    refresh_frozen_timing(sys);
+    
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            queue_init(&sys->queues[road][lane]);
+        }
+    }
+    
+    sys->current_state = STATE_ALL_RED;
+    sys->state_timer = 0;
+    sys->strategy = DEFAULT_STRATEGY;
+    set_lights_for_state(sys);
+}
+
+void traffic_restart_cycle(TrafficSystem* sys) {
+    if (!sys) return;
+
+    sys->current_state = STATE_ALL_RED;
+    sys->state_timer = 0;
+    set_lights_for_state(sys);
+}
+
+bool traffic_set_strategy(TrafficSystem* sys, TrafficStrategyId strategy) {
+    if (!sys || strategy >= STRATEGY_COUNT) {
+        return false;
+    }
+
+    sys->strategy = (uint8_t)strategy;
+    set_lights_for_state(sys);
+    return true;
+}
+
+const TrafficStrategy* traffic_get_strategy(TrafficStrategyId strategy) {
+    return (strategy < STRATEGY_COUNT) ? &STRATEGIES[strategy] : NULL;
+}
+
+void traffic_update_timing(TrafficSystem* sys, const TimingConfig* timing) {
+    if (!sys || !timing) return;
+
+    if (sys->current_state == STATE_ALL_RED) {
+        sys->timing = *timing;
+        sys->timing_pending = false;
+        refresh_frozen_timing(sys);
+        return;
+    }
+
+    sys->pending_timing = *timing;
+    sys->timing_pending = true;
+}
+
+bool traffic_add_timing_plan(TrafficSystem* sys, const TimingPlan* plan) {
+    if (!sys || !plan || sys->plan_count >= TIMING_PLAN_MAX) {
+        return false;
+    }
+    if (sys->plan_count > 0 && plan->start_step <= sys->plans[sys->plan_count - 1].start_step) {
+        return false;
+    }
+
+    sys->plans[sys->plan_count++] = *plan;
+    return true;
+}
+
+bool traffic_add_vehicle(TrafficSystem* sys, const char* id, Direction start, Direction end, uint32_t arrival_time) {
+    if (!sys || start == end || 
+        start >= ROAD_COUNT || end >= ROAD_COUNT) {
+        return false;
+    }
+    
+    uint8_t lane = get_lane_for_turn(start, end);
+    return queue_enqueue(&sys->queues[start][lane], id, start, end, arrival_time);
+}
+
+uint8_t traffic_fsm_step(TrafficSystem* sys, char out_ids[][VEHICLE_ID_LEN]) {
+    if (!sys || !out_ids) return 0;
+    
+    traffic_fsm_advance_clock(sys);
+
+    TrafficDecision decision;
+    traffic_fsm_decide(sys, &sys->timing, &decision);
+    return traffic_fsm_apply(sys, &decision, out_ids);
+}
+
+void traffic_fsm_advance_clock(TrafficSystem* sys) {
+    if (!sys) return;
+
+    sys->current_step++;
+    sys->state_timer++;
+
+    // The latest plan that has started wins
+    while (sys->next_plan < sys->plan_count &&
+           sys->plans[sys->next_plan].start_step <= sys->current_step) {
+        traffic_update_timing(sys, &sys->plans[sys->next_plan].timing);
+        sys->next_plan++;
+    }
+}
+
+
+void traffic_fsm_decide(const TrafficSystem* sys, const TimingConfig* timing, TrafficDecision* out) {
+    if (!sys || !timing || !out) return;
+
+    memcpy(out->phase_skip_counters, sys->phase_skip_counters, sizeof(out->phase_skip_counters));
+    out->extended = false;
+
+#ifdef TRAFFIC_FROZEN_TIMING
+    // Same decision with the timing as compile-time constants
+    if (sys->strategy == STRATEGY_V6 && timing == &sys->timing && sys->timing_frozen) {
+        decide_production(sys, &FROZEN_TIMING, out);
+        return;
+    }
+#endif
+
+    // Compile-time specialized fast path for the production strategy
+    if (sys->strategy == STRATEGY_V6) {
+        decide_production(sys, timing, out);
+    } else {
+        decide_with_strategy(sys, timing, &STRATEGIES[sys->strategy], out);
+    }
+}
+
+uint8_t traffic_fsm_apply(TrafficSystem* sys, const TrafficDecision* decision, char out_ids[][VEHICLE_ID_LEN]) {
+    if (!sys || !decision || !out_ids) return 0;
+
+    memcpy(sys->phase_skip_counters, decision->phase_skip_counters, sizeof(sys->phase_skip_counters));
+
+    if (decision->extended) {
+        sys->extension_timer++;
+    }
+    
+    // Perform state transition if needed
+    if (decision->next_state != sys->current_state) {
+        sys->current_state = decision->next_state;
+        sys->state_timer = 0;
+        sys->extension_timer = 0;
+
+        if (sys->timing_pending && is_preparation_phase(sys->current_state)) {
+            sys->timing = sys->pending_timing;
+            sys->timing_pending = false;
+            refresh_frozen_timing(sys);
+        }
+    }
+    
+    set_lights_for_state(sys);
+    return process_discharges(sys, out_ids);
+}
+
+bool traffic_decision_equal(const TrafficDecision* a, const TrafficDecision* b) {
+    return a->next_state == b->next_state && a->extended == b->extended &&
+           memcmp(a->phase_skip_counters, b->phase_skip_counters, sizeof(a->phase_skip_counters)) == 0;
+}
+
+void traffic_state_lights(TrafficState state, LightColor lights[ROAD_COUNT][LANES_PER_ROAD]) {
+    // First set all lights to red
+    memset(lights, LIGHT_RED, sizeof(LightColor) * ROAD_COUNT * LANES_PER_ROAD);
+    
+    // Apply specific lights from state table
+    for (uint8_t i = 0; i < ARRAY_SIZE(STATE_LIGHTS); i++) {
+        if (state == STATE_LIGHTS[i].state) {
+            lights[STATE_LIGHTS[i].road1][STATE_LIGHTS[i].lane] = STATE_LIGHTS[i].color;
+            lights[STATE_LIGHTS[i].road2][STATE_LIGHTS[i].lane] = STATE_LIGHTS[i].color;
+        }
+    }
+}
+
+uint32_t traffic_state_duration(const TimingConfig* timing, TrafficState state) {
+    if (!timing || state >= ARRAY_SIZE(STATE_TRANSITIONS)) {
+        return 0;
+    }
+    return get_timing_value(timing, STATE_TRANSITIONS[state].timing_idx);
+}
+
+TrafficState traffic_state_successor(TrafficState state) {
+    if (state >= ARRAY_SIZE(STATE_TRANSITIONS)) {
+        return STATE_ALL_RED;
+    }
+    return STATE_TRANSITIONS[state].next;
+}
+
+uint16_t traffic_get_queue_size(const TrafficSystem* sys, Direction road, uint8_t lane) {
+    if (!sys || road >= ROAD_COUNT || lane >= LANES_PER_ROAD) {
+        return 0;
+    }
+    return queue_count(&sys->queues[road][lane]);
+}
+
+void traffic_movement_wait_hist(const TrafficSystem* sys, uint8_t movement, WaitHistogram* out) {
+    if (!out) return;
+    wait_hist_init(out);
+    if (!sys || movement >= MOVEMENT_COUNT) return;
+
+    uint8_t axis = movement / LANES_PER_ROAD; // 0 = NORTH/SOUTH, 1 = EAST/WEST
+    uint8_t lane = movement % LANES_PER_ROAD;
+
+    wait_hist_merge(out, queue_get_wait_hist(&sys->queues[axis][lane]));
+    wait_hist_merge(out, queue_get_wait_hist(&sys->queues[axis + 2][lane]));
+}
\ No newline at end of file
@@ -0,0 +1,404 @@
+/**
+ * @file traffic_fsm.h
+ * @brief FSM for intersection control.
+ * @details This module implements a Finite State Machine
+ * to control traffic lights and manage vehicle queues. Designed for embedded environments.
+ * 
+ * 11.02.26, Paweł Bolek
+ */
+
+#ifndef TRAFFIC_FSM_H
+#define TRAFFIC_FSM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "traffic_queue.h"
+
+// --- CONSTANTS ---
+#define ROAD_COUNT 4
+#define LANES_PER_ROAD 2
+
+#define LANE_STRAIGHT_RIGHT 0
+#define LANE_LEFT 1
+
+#define MOVEMENT_COUNT 4 // Signal groups: NS straight/right, NS left, EW straight/right, EW left
+
+#define DIRECTION_MOD 4   // Must match ROAD_COUNT
+#define LEFT_TURN_DIFF 1   // (start + 1) % 4 = left turn
+
+#define VEHICLE_ID_LEN 32  // Max length for vehicle ID strings
+
+#define TIMING_PLAN_MAX 8  // Max entries of the time-of-day plan table
+
+// Default optimal timings found via python
+// {green_st, green_lt, yellow, all_red, ext_threshold, max_ext, skip_limit}
+#define DEFAULT_TIMING {4, 3, 2, 3, 1, 1, 15, 2}
+
+/*
+ * Frozen-configuration build: compile with -DTRAFFIC_FROZEN_TIMING=DEFAULT_TIMING
+ * (or any TimingConfig initializer) to get a V6 step specialised for that timing,
+ * with every duration and threshold folded into the code. Systems running another
+ * timing (CMD_CONFIG, plans) or strategy still take the generic path.
+ */
+#define ARRAY_SIZE(arr) (sizeof(arr) / sizeof((arr)[0]))
+
+// --- DATA TYPES ---
+
+/**
+ * @brief Traffic system configuration parameters.
+ */
+typedef struct {
+    uint32_t green_st; // Base green time for straight/right
+    uint32_t green_lt; // Base green time for left turns
+    uint32_t yellow; // Yellow light duration
+    uint32_t all_red; // All-red clearance interval
+    uint32_t red_yellow; // Transition state
+    uint32_t ext_threshold; // Queue length to trigger green extension
+    uint32_t max_ext; // Maximum extra green time (steps)
+    uint32_t skip_limit; // Max times a phase can be skipped if empty
+} TimingConfig;
+
+/**
+ * @brief Entry of the time-of-day plan table.
+ * 
+ * @details The timing becomes pending at start_step and is applied at the
+ * next phase boundary, like traffic_update_timing().
+ */
+typedef struct {
+    uint32_t start_step; // Step at which the plan takes over
+    TimingConfig timing;
+} TimingPlan;
+
+/**
+ * @brief Enumeration of all possible FSM states.
+ * 
+ * @details The states sequence through 4 main phases:
+ * NS-Straight -> NS-Left -> EW-Straight -> EW-Left
+ * Each main phase has a preparation state (RED_YELLOW) and a closing state (YELLOW)
+ */
+typedef enum {
+    STATE_ALL_RED = 0,
+
+    STATE_NS_RED_YELLOW,
+    STATE_NS_STRAIGHT,
+    STATE_NS_STRAIGHT_YELLOW,
+
+    STATE_NS_LEFT_RED_YELLOW,
+    STATE_NS_LEFT,
+    STATE_NS_LEFT_YELLOW,
+    
+    STATE_EW_RED_YELLOW,
+    STATE_EW_STRAIGHT,
+    STATE_EW_STRAIGHT_YELLOW,
+
+    STATE_EW_LEFT_RED_YELLOW,
+    STATE_EW_LEFT,
+    STATE_EW_LEFT_YELLOW,
+} TrafficState;
+
+/**
+ * @brief Physical state of a single traffic light
+ */
+typedef enum {
+    LIGHT_RED = 0,
+    LIGHT_YELLOW,
+    LIGHT_GREEN,
+    LIGHT_RED_YELLOW,
+    LIGHT_RIGHT_ARROW_GREEN
+} LightColor;
+
+/**
+ * @brief Controller strategies (algorithm versions compared in the README).
+ * 
+ * @details Selected per TrafficSystem with traffic_set_strategy(). STRATEGY_V6 is
+ * the production controller and is dispatched without indirect calls.
+ */
+typedef enum {
+    STRATEGY_V1 = 0, // Static cycle with fixed timers
+    STRATEGY_V2, // Skips phases with zero vehicle occupancy
+    STRATEGY_V3, // V2 + green extension for detected queues
+    STRATEGY_V4, // V3 + permissive right turn arrows
+    STRATEGY_V5, // V4 + extension limit growing with queue pressure
+    STRATEGY_V6, // V4 + starvation limit for skipped phases
+    STRATEGY_COUNT
+} TrafficStrategyId;
+
+#define DEFAULT_STRATEGY STRATEGY_V6
+
+/**
+ * @brief Accumulated wait-time statistics of vehicles that left the intersection.
+ * 
+ * @details Mirrors the metrics computed by the Python tools (AWT, MAX, LEFT),
+ * so front-ends can report them without shipping every departure to the host.
+ */
+typedef struct {
+    uint32_t departures; // Vehicles discharged so far
+    uint64_t total_wait; // Sum of wait times (steps)
+    uint32_t max_wait; // Worst observed wait time (steps)
+    uint32_t left_departures; // Vehicles discharged from LANE_LEFT
+    uint64_t left_total_wait; // Sum of left-turn wait times (steps)
+} TrafficStats;
+
+/**
+ * @brief Outcome of the control logic for a single step.
+ * 
+ * @details Produced by traffic_fsm_decide() without touching the system, so several
+ * timing configurations can be evaluated against one shared state.
+ */
+typedef struct {
+    TrafficState next_state; // State to enter (equal to current if no transition)
+    bool extended; // True if a green extension step was granted
+    uint8_t phase_skip_counters[ROAD_COUNT]; // Starvation counters after this step
+} TrafficDecision;
+
+// --- FSM SYSTEM STRUCTURE ---
+
+typedef struct TrafficSystem TrafficSystem;
+
+/**
+ * @brief Controller strategy: the policy hooks of the FSM.
+ * 
+ * @details The transition table, timers and discharging are shared. A strategy decides
+ * which phase follows a yellow state, whether a green phase is extended (including its
+ * extension limit) and which lights each state shows (e.g. permissive arrows).
+ */
+typedef struct {
+    const char* name;
+
+    /** Preparation state of the phase following an expired YELLOW or ALL_RED state */
+    TrafficState (*select_phase)(const TrafficSystem* sys, const TimingConfig* timing,
+                                 uint8_t skip_counters[ROAD_COUNT]);
+
+    /** True if the expiring green phase should get one more step */
+    bool (*should_extend)(const TrafficSystem* sys, const TimingConfig* timing);
+
+    /** Light colors displayed in a state */
+    void (*state_lights)(TrafficState state, LightColor lights[ROAD_COUNT][LANES_PER_ROAD]);
+} TrafficStrategy;
+
+struct TrafficSystem {
+    TrafficState current_state;
+    uint32_t current_step; // Global simulation timer
+    uint32_t state_timer; // Time spent in current state
+    
+    TimingConfig timing;
+    bool timing_frozen; // timing equals TRAFFIC_FROZEN_TIMING (kept by frozen builds only)
+    
+    /** Matrix of vehicle queues: queues[ARRIVAL_DIRECTION][LANE] */
+    VehicleQueue queues[ROAD_COUNT][LANES_PER_ROAD];
+
+    /** Matrix of light states matching the physical layout */
+    LightColor lights[ROAD_COUNT][LANES_PER_ROAD];
+    
+    /** Starvation prevention counters for each of the 4 main phases */
+    uint8_t phase_skip_counters[ROAD_COUNT];
+    
+    /** Current accumulated extra green steps (resets on phase change) */
+    uint32_t extension_timer;
+
+    /** Wait-time statistics of discharged vehicles */
+    TrafficStats stats;
+
+    /** Controller strategy (TrafficStrategyId) */
+    uint8_t strategy;
+
+    /** Timing waiting for the next phase boundary (valid if timing_pending) */
+    TimingConfig pending_timing;
+    bool timing_pending;
+
+    /** Time-of-day plans sorted by start_step; next_plan is the first one not yet activated */
+    TimingPlan plans[TIMING_PLAN_MAX];
+    uint8_t plan_count;
+    uint8_t next_plan;
+};
+
+// --- PUBLIC API ---
+
+/**
+ * @brief Initializes the traffic state machine with given timings.
+ * 
+ * @param sys Pointer to TrafficSystem structure
+ * @param config Timing configuration
+ */
+void traffic_init(TrafficSystem* sys, TimingConfig config);
+
+/**
+ * @brief Restarts the phase cycle with an all-red clearance.
+ * 
+ * @details Queues, statistics and timing are kept. Used after a warm boot, when
+ * the lights were dark for an unknown time and the restored phase is stale.
+ * 
+ * @param sys Pointer to TrafficSystem
+ */
+void traffic_restart_cycle(TrafficSystem* sys);
+
+/**
+ * @brief Selects the controller strategy of the system.
+ * 
+ * @details traffic_init() selects DEFAULT_STRATEGY. The lights of the current
+ * state are refreshed immediately.
+ * 
+ * @param sys Pointer to TrafficSystem
+ * @param strategy Strategy identifier
+ * 
+ * @return true on success, false if the strategy does not exist
+ */
+bool traffic_set_strategy(TrafficSystem* sys, TrafficStrategyId strategy);
+
+/**
+ * @brief Returns the hooks of a controller strategy.
+ * 
+ * @param strategy Strategy identifier
+ * @return Pointer to the strategy, NULL if it does not exist
+ */
+const TrafficStrategy* traffic_get_strategy(TrafficStrategyId strategy);
+
+/**
+ * @brief Schedules a new timing without resetting the system.
+ * 
+ * @details Queues, counters, statistics and the strategy are kept. The timing is
+ * applied at the next safe phase boundary: when the FSM enters the preparation
+ * (RED_YELLOW) state of a phase, or immediately while in the initial ALL_RED state.
+ * A later update before that boundary replaces the pending one.
+ * 
+ * @param sys Pointer to TrafficSystem
+ * @param timing New timing configuration
+ */
+void traffic_update_timing(TrafficSystem* sys, const TimingConfig* timing);
+
+/**
+ * @brief Appends an entry to the time-of-day plan table.
+ * 
+ * @details Entries must be added in increasing start_step order. traffic_init()
+ * clears the table. A plan whose start_step has already passed becomes pending
+ * on the next step.
+ * 
+ * @param sys Pointer to TrafficSystem
+ * @param plan Plan entry
+ * 
+ * @return true on success, false if the table is full or the entry is out of order
+ */
+bool traffic_add_timing_plan(TrafficSystem* sys, const TimingPlan* plan);
+
+/**
+ * @brief Attempts to add a vehicle to the appropriate lane queue.
+ * 
+ * @param sys Pointer to TrafficSystem
+ * @param id Vehicle identifier string
+ * @param start Road where vehicle appears
+ * @param end Destination road
+ * @param arrival_time Simulation step when vehicle arrived
+ * 
+ * @return true if added successfully, false on error
+ */
+bool traffic_add_vehicle(TrafficSystem* sys, const char* id, 
+                         Direction start, Direction end, 
+                         uint32_t arrival_time);
+
+/**
+ * @brief Executes one simulation step of the FSM.
+ * 
+ * @param sys Pointer to TrafficSystem
+ * @param out_ids Array to store IDs of vehicles that left in this step
+ * 
+ * @return Number of vehicles that left the intersection
+ */
+uint8_t traffic_fsm_step(TrafficSystem* sys, char out_ids[][VEHICLE_ID_LEN]);
+
+/**
+ * @brief Advances the global and state timers at the start of a step.
+ * 
+ * @details Also activates the time-of-day plans that start at the new step.
+ * 
+ * @details traffic_fsm_step() is equivalent to traffic_fsm_advance_clock(),
+ * traffic_fsm_decide() with sys->timing and traffic_fsm_apply().
+ * 
+ * @param sys Pointer to TrafficSystem
+ */
+void traffic_fsm_advance_clock(TrafficSystem* sys);
+
+/**
+ * @brief Evaluates the control logic of the current step for a given timing.
+ * 
+ * @details Does not modify the system. The decision depends only on the FSM state,
+ * queue occupancy and the passed timing, which allows one trajectory to be shared by
+ * many configurations until their decisions differ.
+ * 
+ * @param sys Pointer to TrafficSystem (clock already advanced)
+ * @param timing Timing configuration to evaluate
+ * @param out Decision to fill
+ */
+void traffic_fsm_decide(const TrafficSystem* sys, const TimingConfig* timing, TrafficDecision* out);
+
+/**
+ * @brief Applies a decision: performs the transition, updates lights and discharges vehicles.
+ * 
+ * @param sys Pointer to TrafficSystem (clock already advanced)
+ * @param decision Decision computed by traffic_fsm_decide()
+ * @param out_ids Array to store IDs of vehicles that left in this step
+ * 
+ * @return Number of vehicles that left the intersection
+ */
+uint8_t traffic_fsm_apply(TrafficSystem* sys, const TrafficDecision* decision, char out_ids[][VEHICLE_ID_LEN]);
+
+/**
+ * @brief Compares two decisions.
+ * 
+ * @return true if both lead to the same system state
+ */
+bool traffic_decision_equal(const TrafficDecision* a, const TrafficDecision* b);
+
+/**
+ * @brief Returns the current number of vehicles waiting in a specific lane.
+ * 
+ * @param sys Pointer to TrafficSystem
+ * @param road Direction of approach
+ * @param lane_idx Lane index (LANE_STRAIGHT_RIGHT or LANE_LEFT)
+ * 
+ * @return Number of vehicles in queue
+ */
+uint16_t traffic_get_queue_size(const TrafficSystem* sys, Direction road, uint8_t lane_idx);
+
+/**
+ * @brief Merges the wait histograms of the lanes served by one signal group.
+ * 
+ * @details Movement index = axis * LANES_PER_ROAD + lane, where axis 0 is
+ * North-South and 1 is East-West (e.g. 1 = NS left turns).
+ * 
+ * @param sys Pointer to TrafficSystem
+ * @param movement Movement index (0 to MOVEMENT_COUNT - 1)
+ * @param out Histogram to fill
+ */
+void traffic_movement_wait_hist(const TrafficSystem* sys, uint8_t movement, WaitHistogram* out);
+
+/**
+ * @brief Resolves the light colors displayed in a given state (production strategy).
+ * 
+ * @param state FSM state
+ * @param lights Matrix to fill: lights[ROAD][LANE]
+ */
+void traffic_state_lights(TrafficState state, LightColor lights[ROAD_COUNT][LANES_PER_ROAD]);
+
+/**
+ * @brief Returns the base duration (in steps) of a state for a given timing.
+ * 
+ * @param timing Timing configuration
+ * @param state FSM state
+ * 
+ * @return Duration from the transition table (green extensions not included)
+ */
+uint32_t traffic_state_duration(const TimingConfig* timing, TrafficState state);
+
+/**
+ * @brief Returns the static successor of a state in the standard cycle.
+ * 
+ * @details Phase skipping is not taken into account: the successor of a
+ * YELLOW state is the preparation state of the next phase in sequence.
+ * 
+ * @param state FSM state
+ * 
+ * @return Next state from the transition table
+ */
+TrafficState traffic_state_successor(TrafficState state);
+
+#endif // TRAFFIC_FSM_H
\ No newline at end of file
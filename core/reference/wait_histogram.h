@@ -0,0 +1,114 @@
+/**
+ * @file wait_histogram.h
+ * @brief Log-bucketed histogram of vehicle wait times
+ *
+ * Waits below WAIT_HIST_LINEAR_LIMIT steps get one bucket each. Above that every
+ * power of two is split into WAIT_HIST_SUB_BUCKETS buckets, so a percentile is
+ * reported with at most 25% relative error. Waits beyond the last bucket are
+ * clamped into it. Histograms with the same layout merge by adding counts.
+ */
+
+#ifndef WAIT_HISTOGRAM_H
+#define WAIT_HISTOGRAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @def WAIT_HIST_SUB_BITS
+ * @brief log2 of the number of buckets per power of two
+ */
+#define WAIT_HIST_SUB_BITS 2
+#define WAIT_HIST_SUB_BUCKETS (1u << WAIT_HIST_SUB_BITS)
+
+/**
+ * @def WAIT_HIST_LINEAR_LIMIT
+ * @brief Waits below this value are counted exactly
+ */
+#define WAIT_HIST_LINEAR_LIMIT (2u * WAIT_HIST_SUB_BUCKETS)
+
+/**
+ * @def WAIT_HIST_BUCKETS
+ * @brief Number of buckets (covers waits up to 2^17 steps)
+ */
+#define WAIT_HIST_BUCKETS 64
+
+/**
+ * @struct WaitHistogram
+ * @brief Departure counts per wait bucket
+ */
+typedef struct {
+    uint32_t counts[WAIT_HIST_BUCKETS];
+} WaitHistogram;
+
+/**
+ * @brief Reset all buckets to zero
+ *
+ * @param h Pointer to WaitHistogram
+ */
+void wait_hist_init(WaitHistogram* h);
+
+/**
+ * @brief Map a wait time to its bucket index
+ *
+ * @param wait Wait time in simulation steps
+ * @return Bucket index (0 to WAIT_HIST_BUCKETS - 1)
+ */
+uint8_t wait_hist_bucket(uint32_t wait);
+
+/**
+ * @brief Smallest wait time that falls into a bucket
+ *
+ * @param bucket Bucket index
+ * @return Lower bound of the bucket in simulation steps
+ */
+uint32_t wait_hist_bucket_min(uint8_t bucket);
+
+/**
+ * @brief Largest wait time that falls into a bucket
+ *
+ * @param bucket Bucket index
+ * @return Upper bound of the bucket in simulation steps
+ */
+uint32_t wait_hist_bucket_max(uint8_t bucket);
+
+/**
+ * @brief Count one departure (O(1))
+ *
+ * @param h Pointer to WaitHistogram
+ * @param wait Wait time in simulation steps
+ */
+static inline void wait_hist_record(WaitHistogram* h, uint32_t wait) {
+    h->counts[wait_hist_bucket(wait)]++;
+}
+
+/**
+ * @brief Add the counts of another histogram (e.g. another lane, run or worker)
+ *
+ * @param dst Histogram to accumulate into
+ * @param src Histogram to add
+ */
+void wait_hist_merge(WaitHistogram* dst, const WaitHistogram* src);
+
+/**
+ * @brief Total number of recorded departures
+ *
+ * @param h Pointer to WaitHistogram
+ * @return Sum of all bucket counts
+ */
+uint32_t wait_hist_total(const WaitHistogram* h);
+
+/**
+ * @brief Wait time below or at which the given fraction of departures fall
+ *
+ * Reports the upper bound of the bucket that contains the percentile,
+ * so the value never underestimates the true percentile.
+ *
+ * @param h Pointer to WaitHistogram
+ * @param permille Percentile in thousandths (500 = P50, 990 = P99)
+ *
+ * @return Percentile in simulation steps, 0 if the histogram is empty
+ */
+uint32_t wait_hist_percentile(const WaitHistogram* h, uint16_t permille);
+
+#endif // WAIT_HISTOGRAM_H
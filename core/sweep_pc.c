@@ -0,0 +1,326 @@
+/**
+ * @file sweep_pc.c
+ *
+ * @brief Command-line front-end of the parameter sweep engine.
+ *
+ * Reads the same binary command stream as traffic_sim from standard input:
+ * every CMD_CONFIG adds one timing configuration to the sweep, an optional
+ * CMD_SET_STRATEGY selects the controller for all of them, followed by
+ * the CMD_ADD_VEHICLE / CMD_STEP commands of a single scenario and CMD_STOP
+ * (or end of input). The scenario is then simulated for all configurations
+ * at once and one ResponseStats per configuration is written to standard output.
+ *
+ * With --estimate the scenario is not simulated. Its lane arrival rates are
+ * fed to the analytical estimator instead and one ResponseEstimate per
+ * configuration is written (pre-screening of candidates).
+ *
+ * With --bounds [THREADS] no scenario is needed: the state space of every
+ * configuration is explored on THREADS workers (default: online CPUs) and
+ * one ResponseBounds with its certified worst-case waits is written.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "protocol.h"
+#include "traffic_fsm.h"
+#include "traffic_sweep.h"
+#include "traffic_estimate.h"
+#include "traffic_explore.h"
+
+typedef struct {
+    void* data;
+    uint32_t count;
+    uint32_t capacity;
+} DynArray;
+
+/**
+ * @brief Appends one element to a growable array.
+ */
+static bool dyn_push(DynArray* arr, const void* item, size_t item_size) {
+    if (arr->count == arr->capacity) {
+        uint32_t new_capacity = arr->capacity ? arr->capacity * 2 : 64;
+        void* grown = realloc(arr->data, new_capacity * item_size);
+        if (!grown) return false;
+
+        arr->data = grown;
+        arr->capacity = new_capacity;
+    }
+
+    memcpy((uint8_t*)arr->data + arr->count * item_size, item, item_size);
+    arr->count++;
+    return true;
+}
+
+/**
+ * @brief Converts a CMD_CONFIG payload into a timing configuration (as traffic_sim does).
+ */
+static TimingConfig config_from_payload(const PayloadConfig* payload) {
+    TimingConfig config = {
+        .green_st = payload->green_st,
+        .green_lt = payload->green_lt,
+        .yellow = payload->yellow,
+        .all_red = payload->all_red,
+        .red_yellow = 1,
+        .ext_threshold = payload->ext_threshold,
+        .max_ext = payload->max_ext,
+        .skip_limit = payload->skip_limit
+    };
+    return config;
+}
+
+/**
+ * @brief Derives lane arrival rates and right-turn shares from the scenario.
+ */
+static void demand_from_arrivals(const Vehicle* arrivals, uint32_t n_arrivals, uint32_t n_steps,
+                                 TrafficDemand* demand) {
+    uint32_t lane_count[ROAD_COUNT][LANES_PER_ROAD] = {{0}};
+    uint32_t right_count[ROAD_COUNT] = {0};
+
+    for (uint32_t i = 0; i < n_arrivals; i++) {
+        uint8_t start = arrivals[i].start_road % ROAD_COUNT;
+        uint8_t end = arrivals[i].end_road % ROAD_COUNT;
+        uint8_t turn = (end - start + DIRECTION_MOD) % DIRECTION_MOD;
+
+        if (turn == LEFT_TURN_DIFF) {
+            lane_count[start][LANE_LEFT]++;
+        } else {
+            lane_count[start][LANE_STRAIGHT_RIGHT]++;
+            if (end == (start + 3) % DIRECTION_MOD) {
+                right_count[start]++;
+            }
+        }
+    }
+
+    memset(demand, 0, sizeof(TrafficDemand));
+    demand->horizon = n_steps;
+    float steps = (float)(n_steps > 0 ? n_steps : 1);
+
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            demand->lane_rate[road][lane] = (float)lane_count[road][lane] / steps;
+        }
+        uint32_t straight = lane_count[road][LANE_STRAIGHT_RIGHT];
+        demand->right_share[road] = straight ? (float)right_count[road] / (float)straight : 0.0f;
+    }
+}
+
+/**
+ * @brief Writes one analytical estimate per configuration.
+ */
+static void run_estimates(const TimingConfig* configs, uint32_t n_configs, const TrafficDemand* demand) {
+    clock_t start = clock();
+
+    for (uint32_t i = 0; i < n_configs; i++) {
+        TrafficEstimate est;
+        traffic_estimate(&configs[i], demand, &est);
+
+        ResponseEstimate resp = {
+            .avg_delay = est.avg_delay,
+            .max_delay = est.max_delay,
+            .left_delay = est.left_delay,
+            .cycle_length = est.cycle_length
+        };
+        memcpy(resp.lane_delay, est.lane_delay, sizeof(resp.lane_delay));
+        memcpy(resp.lane_growth, est.lane_growth, sizeof(resp.lane_growth));
+        fwrite(&resp, sizeof(ResponseEstimate), 1, stdout);
+    }
+    fflush(stdout);
+
+    double elapsed_us = 1e6 * (double)(clock() - start) / CLOCKS_PER_SEC;
+    fprintf(stderr, "[C-OK] Estimate: %u configs, %.2f us per config\n",
+            n_configs, elapsed_us / n_configs);
+}
+
+/**
+ * @brief Writes the certified wait bounds of every configuration.
+ */
+static bool run_bounds(const TimingConfig* configs, uint32_t n_configs, TrafficStrategyId strategy,
+                       uint32_t threads) {
+    ExploreBounds* bounds = calloc(n_configs, sizeof(ExploreBounds));
+    bool* ok = calloc(n_configs, sizeof(bool));
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (!bounds || !ok || !traffic_explore_grid(configs, n_configs, strategy, threads, bounds, ok)) {
+        free(bounds);
+        free(ok);
+        return false;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    uint32_t certified = 0;
+    for (uint32_t i = 0; i < n_configs; i++) {
+        ResponseBounds resp = {0};
+        if (ok[i]) {
+            memcpy(resp.starvation, bounds[i].starvation, sizeof(resp.starvation));
+            memcpy(resp.max_wait, bounds[i].max_wait, sizeof(resp.max_wait));
+            resp.states = bounds[i].states;
+            certified++;
+        } else {
+            fprintf(stderr, "[C-WARN] Config %u cannot be certified\n", i);
+        }
+        fwrite(&resp, sizeof(ResponseBounds), 1, stdout);
+    }
+    fflush(stdout);
+
+    double elapsed = (double)(end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    fprintf(stderr, "[C-OK] Bounds: %u/%u configs certified, %u threads, %.2f s\n",
+            certified, n_configs, threads, elapsed);
+
+    free(bounds);
+    free(ok);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    bool estimate_mode = (argc > 1 && strcmp(argv[1], "--estimate") == 0);
+    bool bounds_mode = (argc > 1 && strcmp(argv[1], "--bounds") == 0);
+
+    DynArray configs = {0};
+    DynArray arrivals = {0};
+    uint32_t n_steps = 0;
+    TrafficStrategyId strategy = DEFAULT_STRATEGY;
+    bool running = true;
+
+    CmdHeader header;
+    while (running && fread(&header, sizeof(CmdHeader), 1, stdin) == 1) {
+        switch (header.cmd_type) {
+            case CMD_CONFIG: {
+                PayloadConfig payload;
+                if (fread(&payload, sizeof(PayloadConfig), 1, stdin) != 1) {
+                    fprintf(stderr, "[C-ERR] Failed to read Config payload\n");
+                    running = false;
+                    break;
+                }
+                if (arrivals.count > 0 || n_steps > 0) {
+                    fprintf(stderr, "[C-WARN] Config after scenario start ignored\n");
+                    break;
+                }
+
+                TimingConfig config = config_from_payload(&payload);
+                if (!dyn_push(&configs, &config, sizeof(TimingConfig))) {
+                    fprintf(stderr, "[C-ERR] Out of memory\n");
+                    return 1;
+                }
+                break;
+            }
+
+            case CMD_SET_STRATEGY: {
+                PayloadStrategy payload;
+                if (fread(&payload, sizeof(PayloadStrategy), 1, stdin) != 1) {
+                    fprintf(stderr, "[C-ERR] Failed to read Strategy payload\n");
+                    running = false;
+                    break;
+                }
+                if (!traffic_get_strategy((TrafficStrategyId)payload.strategy)) {
+                    fprintf(stderr, "[C-ERR] Unknown strategy %d\n", payload.strategy);
+                    return 1;
+                }
+                strategy = (TrafficStrategyId)payload.strategy;
+                break;
+            }
+
+            case CMD_ADD_VEHICLE: {
+                PayloadAddVehicle payload;
+                if (fread(&payload, sizeof(PayloadAddVehicle), 1, stdin) != 1) {
+                    fprintf(stderr, "[C-ERR] Failed to read AddVehicle payload\n");
+                    running = false;
+                    break;
+                }
+
+                // Vehicles join before the next step, regardless of the reported arrival time
+                Vehicle v;
+                memcpy(v.id, payload.vehicle_id, VEHICLE_ID_LEN);
+                v.id[VEHICLE_ID_LEN - 1] = '\0';
+                v.start_road = payload.start_road;
+                v.end_road = payload.end_road;
+                v.arrival_step = n_steps;
+
+                if (payload.arrival_time != n_steps) {
+                    fprintf(stderr, "[C-WARN] Vehicle %s arrival time %u replaced by %u\n",
+                            v.id, payload.arrival_time, n_steps);
+                }
+                if (!dyn_push(&arrivals, &v, sizeof(Vehicle))) {
+                    fprintf(stderr, "[C-ERR] Out of memory\n");
+                    return 1;
+                }
+                break;
+            }
+
+            case CMD_STEP:
+                n_steps++;
+                break;
+
+            case CMD_STOP:
+                running = false;
+                break;
+
+            default:
+                fprintf(stderr, "[C-ERR] Unknown command: %d\n", header.cmd_type);
+                break;
+        }
+    }
+
+    if (configs.count == 0) {
+        fprintf(stderr, "[C-ERR] No configuration to sweep\n");
+        return 1;
+    }
+
+    if (bounds_mode) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        uint32_t threads = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : (cpus > 0 ? (uint32_t)cpus : 1);
+        bool done = run_bounds(configs.data, configs.count, strategy, threads);
+        if (!done) {
+            fprintf(stderr, "[C-ERR] Bounds failed\n");
+        }
+
+        free(configs.data);
+        free(arrivals.data);
+        return done ? 0 : 1;
+    }
+
+    if (estimate_mode) {
+        TrafficDemand demand;
+        demand_from_arrivals(arrivals.data, arrivals.count, n_steps, &demand);
+        run_estimates(configs.data, configs.count, &demand);
+
+        free(configs.data);
+        free(arrivals.data);
+        return 0;
+    }
+
+    TrafficStats* stats = calloc(configs.count, sizeof(TrafficStats));
+    SweepInfo info;
+    if (!stats || !traffic_sweep_run(configs.data, configs.count, strategy, arrivals.data, arrivals.count,
+                                     n_steps, stats, &info)) {
+        fprintf(stderr, "[C-ERR] Sweep failed\n");
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < configs.count; i++) {
+        ResponseStats resp = {
+            .current_step = n_steps,
+            .departures = stats[i].departures,
+            .total_wait = stats[i].total_wait,
+            .max_wait = stats[i].max_wait,
+            .left_departures = stats[i].left_departures,
+            .left_total_wait = stats[i].left_total_wait
+        };
+        fwrite(&resp, sizeof(ResponseStats), 1, stdout);
+    }
+    fflush(stdout);
+
+    fprintf(stderr, "[C-OK] Sweep: %u configs, %u steps, %u branches, %llu branch steps\n",
+            configs.count, n_steps, info.branches, (unsigned long long)info.branch_steps);
+
+    free(stats);
+    free(configs.data);
+    free(arrivals.data);
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include "test_utils.h"
+#include "traffic_fsm.h"
+#include "traffic_aggregate.h"
+#include <stdio.h>
+
+int tests_run = 0;
+int tests_failed = 0;
+
+#define SCENARIO_STEPS 2000
+#define MAX_BUCKETS 2100
+
+static TrafficBucket buckets[MAX_BUCKETS];
+
+/**
+ * Deterministic arrivals (LCG) with a rush in the middle of the scenario.
+ * Returns the number of vehicles accepted.
+ */
+static uint32_t add_arrivals(TrafficSystem* sys, uint32_t* seed, uint32_t step) {
+    uint32_t accepted = 0;
+    uint32_t rate = (step > 600 && step < 1200) ? 45 : 20;
+
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        *seed = *seed * 1103515245u + 12345u;
+        if ((*seed >> 16) % 100 >= rate) continue;
+
+        *seed = *seed * 1103515245u + 12345u;
+        char id[VEHICLE_ID_LEN];
+        sprintf(id, "v%u_%u", step, road);
+        accepted += traffic_add_vehicle(sys, id, road, (road + 1 + (*seed >> 16) % 3) % ROAD_COUNT, step);
+    }
+    return accepted;
+}
+
+/**
+ * Runs the scenario through an aggregator, collecting every bucket (the open one last).
+ */
+static uint32_t run_aggregated(TrafficSystem* sys, AggregateMode mode, uint32_t bucket_steps, uint32_t* arrivals) {
+    char out_ids[ROAD_COUNT * LANES_PER_ROAD][VEHICLE_ID_LEN];
+    TrafficAggregator agg;
+    TimingConfig config = DEFAULT_TIMING;
+    uint32_t seed = 11, n = 0;
+
+    traffic_init(sys, config);
+    traffic_aggregate_init(&agg, sys, mode, bucket_steps);
+    *arrivals = 0;
+
+    for (uint32_t step = 0; step < SCENARIO_STEPS; step++) {
+        *arrivals += add_arrivals(sys, &seed, step);
+        traffic_aggregate_before_step(&agg, sys);
+        traffic_fsm_step(sys, out_ids);
+        if (traffic_aggregate_after_step(&agg, sys, &buckets[n])) {
+            n++;
+        }
+    }
+    traffic_aggregate_flush(&agg, &buckets[n++]);
+    return n;
+}
+
+void test_totals_match_statistics() {
+    TrafficSystem sys;
+    uint32_t arrivals;
+    uint32_t n = run_aggregated(&sys, AGGREGATE_STEPS, 60, &arrivals);
+
+    uint32_t steps = 0, in = 0, out = 0, max_wait = 0, left = 0;
+    uint64_t wait = 0;
+    bool lanes_match = true;
+    for (uint8_t i = 0; i < AGGREGATE_LANES; i++) {
+        uint32_t lane_out = 0;
+        for (uint32_t b = 0; b < n; b++) {
+            lane_out += buckets[b].departures[i];
+        }
+        const VehicleQueue* q = &sys.queues[i / LANES_PER_ROAD][i % LANES_PER_ROAD];
+        lanes_match = lanes_match && lane_out == wait_hist_total(queue_get_wait_hist(q));
+    }
+    for (uint32_t b = 0; b < n; b++) {
+        steps += buckets[b].steps;
+        for (uint8_t i = 0; i < AGGREGATE_LANES; i++) {
+            in += buckets[b].arrivals[i];
+            out += buckets[b].departures[i];
+            wait += buckets[b].total_wait[i];
+            if (buckets[b].max_wait[i] > max_wait) max_wait = buckets[b].max_wait[i];
+            if (i % LANES_PER_ROAD == LANE_LEFT) left += buckets[b].departures[i];
+        }
+    }
+
+    ASSERT_EQ_INT(SCENARIO_STEPS, (int)steps, "Buckets should cover every step");
+    ASSERT_EQ_INT((int)arrivals, (int)in, "Arrivals should match accepted vehicles");
+    ASSERT_EQ_INT((int)sys.stats.departures, (int)out, "Departures should match the statistics");
+    ASSERT_TRUE(sys.stats.total_wait == wait, "Total wait should match the statistics");
+    ASSERT_EQ_INT((int)sys.stats.max_wait, (int)max_wait, "Max wait should match the statistics");
+    ASSERT_EQ_INT((int)sys.stats.left_departures, (int)left, "Left departures should match the statistics");
+    ASSERT_TRUE(lanes_match, "Per-lane departures should match the lane histograms");
+}
+
+void test_fixed_buckets() {
+    TrafficSystem sys;
+    uint32_t arrivals;
+    uint32_t n = run_aggregated(&sys, AGGREGATE_STEPS, 60, &arrivals);
+
+    ASSERT_EQ_INT(SCENARIO_STEPS / 60 + 1, (int)n, "One bucket per 60 steps plus the open one");
+    bool contiguous = true, phases = true, queues = true;
+    for (uint32_t b = 0; b < n; b++) {
+        uint32_t phase_total = 0;
+        for (uint8_t p = 0; p < AGGREGATE_PHASES; p++) phase_total += buckets[b].phase_steps[p];
+        phases = phases && phase_total == buckets[b].steps;
+        contiguous = contiguous && buckets[b].first_step == 1 + b * 60;
+        for (uint8_t i = 0; i < AGGREGATE_LANES; i++) {
+            queues = queues && buckets[b].queue_max[i] <= MAX_VEHICLES_PER_ROAD &&
+                     buckets[b].queue_sum[i] <= (uint32_t)buckets[b].queue_max[i] * buckets[b].steps;
+        }
+    }
+    ASSERT_TRUE(contiguous, "Buckets should start every 60 steps");
+    ASSERT_TRUE(phases, "Phase steps should add up to the bucket length");
+    ASSERT_TRUE(queues, "Queue sums should be bounded by the maxima");
+    ASSERT_EQ_INT(SCENARIO_STEPS % 60, (int)buckets[n - 1].steps, "Open bucket holds the remaining steps");
+}
+
+void test_cycle_buckets() {
+    TrafficSystem sys;
+    uint32_t arrivals;
+    uint32_t n = run_aggregated(&sys, AGGREGATE_CYCLES, 0, &arrivals);
+
+    ASSERT_TRUE(n > 20, "A busy scenario should run many cycles");
+    bool contiguous = true, one_cycle = true;
+    for (uint32_t b = 0; b < n; b++) {
+        uint32_t next = b + 1 < n ? buckets[b + 1].first_step : SCENARIO_STEPS + 1;
+        contiguous = contiguous && buckets[b].first_step + buckets[b].steps == next;
+        // Every full cycle serves at least one green phase
+        uint32_t green = 0;
+        for (uint8_t p = 0; p < MOVEMENT_COUNT; p++) green += buckets[b].phase_steps[p] > 0;
+        one_cycle = one_cycle && (b + 1 == n || green >= 1);
+    }
+    ASSERT_TRUE(contiguous, "Cycle buckets should be contiguous");
+    ASSERT_TRUE(one_cycle, "Every cycle bucket should contain a green phase");
+
+    uint32_t capped = run_aggregated(&sys, AGGREGATE_CYCLES, 10, &arrivals);
+    bool bounded = true;
+    for (uint32_t b = 0; b < capped; b++) bounded = bounded && buckets[b].steps <= 10;
+    ASSERT_TRUE(capped > n && bounded, "bucket_steps should cap cycle buckets");
+}
+
+void test_invalid_modes() {
+    TrafficSystem sys;
+    TrafficAggregator agg;
+    TimingConfig config = DEFAULT_TIMING;
+    traffic_init(&sys, config);
+
+    ASSERT_TRUE(!traffic_aggregate_init(&agg, &sys, AGGREGATE_STEPS, 0), "Fixed buckets need a length");
+    ASSERT_TRUE(!traffic_aggregate_init(&agg, &sys, (AggregateMode)7, 10), "Unknown mode rejected");
+    ASSERT_EQ_INT(AGGREGATE_OFF, agg.mode, "Rejected aggregator is off");
+}
+
+int main() {
+    printf("\n=== AGGREGATION TESTS ===\n\n");
+
+    RUN_TEST(test_totals_match_statistics);
+    RUN_TEST(test_fixed_buckets);
+    RUN_TEST(test_cycle_buckets);
+    RUN_TEST(test_invalid_modes);
+
+    PRINT_TEST_RESULTS();
+
+    return (tests_failed == 0) ? 0 : 1;
+}
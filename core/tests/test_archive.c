@@ -0,0 +1,358 @@
+#include "test_utils.h"
+#include "traffic_archive.h"
+#include "protocol.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+int tests_run = 0;
+int tests_failed = 0;
+
+#define MAX_EVENTS 60000
+
+static ArchiveEvent* expected;
+static uint32_t n_expected;
+static uint32_t rng = 12345;
+
+static uint32_t next_random(void) {
+    rng = rng * 1103515245u + 12345u;
+    return rng >> 8;
+}
+
+/**
+ * @brief Writes an event to the archive and remembers it.
+ */
+static void emit_vehicle(ArchiveWriter* w, const char* id, uint8_t start, uint8_t end, uint32_t arrival) {
+    ArchiveEvent* e = &expected[n_expected++];
+    memset(e, 0, sizeof(*e));
+    e->type = ARCHIVE_EVENT_VEHICLE;
+    e->step = w->step;
+    snprintf(e->id, sizeof(e->id), "%s", id);
+    e->start_road = start;
+    e->end_road = end;
+    e->arrival_time = arrival;
+    archive_write_vehicle(w, id, start, end, arrival);
+}
+
+static void emit_step(ArchiveWriter* w, uint16_t departures, const char* prefix, uint32_t first) {
+    ArchiveEvent* e = &expected[n_expected++];
+    memset(e, 0, sizeof(*e));
+    e->type = ARCHIVE_EVENT_STEP;
+    e->step = w->step;
+    e->departures = (w->flags & ARCHIVE_HAS_DEPARTURES) ? departures : 0;
+    for (uint16_t i = 0; i < departures; i++) {
+        snprintf(e->departed[i], VEHICLE_ID_LEN, "%s%u", prefix, first + i * 3);
+    }
+    archive_write_step(w, (const char(*)[VEHICLE_ID_LEN])e->departed, departures);
+}
+
+static void emit_command(ArchiveWriter* w, uint8_t cmd_type, uint8_t fill, size_t len) {
+    ArchiveEvent* e = &expected[n_expected++];
+    memset(e, 0, sizeof(*e));
+    e->type = ARCHIVE_EVENT_COMMAND;
+    e->step = w->step;
+    e->command[0] = cmd_type;
+    memset(e->command + 1, fill, len - 1);
+    e->command_len = (uint8_t)len;
+    archive_write_command(w, e->command, len);
+}
+
+static bool same_event(const ArchiveEvent* a, const ArchiveEvent* b) {
+    if (a->type != b->type || a->step != b->step) return false;
+    switch (a->type) {
+        case ARCHIVE_EVENT_VEHICLE:
+            return strcmp(a->id, b->id) == 0 && a->start_road == b->start_road && a->end_road == b->end_road &&
+                   a->arrival_time == b->arrival_time;
+        case ARCHIVE_EVENT_STEP:
+            if (a->departures != b->departures) return false;
+            for (uint16_t i = 0; i < a->departures; i++) {
+                if (strcmp(a->departed[i], b->departed[i]) != 0) return false;
+            }
+            return true;
+        default:
+            return a->command_len == b->command_len && memcmp(a->command, b->command, a->command_len) == 0;
+    }
+}
+
+/**
+ * @brief Writes a random scenario: bursts, long idle periods, odd IDs and commands.
+ */
+static FILE* write_scenario(uint8_t flags, uint32_t steps) {
+    FILE* f = tmpfile();
+    ArchiveWriter w;
+    archive_writer_open(&w, f, flags);
+    n_expected = 0;
+
+    static const char* const ODD_IDS[] = {"", "x", "12345", "v9", "v10", "v010", "car-007", "000",
+                                          "12345678901234567890123456", "a_very_long_vehicle_identifier_1"};
+    emit_command(&w, CMD_CONFIG, 3, 1 + sizeof(PayloadConfig));
+    emit_command(&w, CMD_SET_STRATEGY, 4, 1 + sizeof(PayloadStrategy));
+
+    uint32_t vehicle = 0;
+    for (uint32_t s = 0; s < steps && n_expected < MAX_EVENTS - 64; s++) {
+        uint32_t r = next_random();
+        bool busy = (s / 1000) % 3 != 2; // Every third thousand steps is idle
+        uint32_t arrivals = busy ? r % 4 : 0;
+
+        for (uint32_t i = 0; i < arrivals; i++) {
+            char id[VEHICLE_ID_LEN];
+            uint32_t kind = next_random() % 50;
+            if (kind == 0) {
+                snprintf(id, sizeof(id), "%s", ODD_IDS[next_random() % 10]);
+            } else {
+                snprintf(id, sizeof(id), kind < 40 ? "veh%08u" : "bus%u", vehicle++);
+            }
+            bool odd = next_random() % 97 == 0; // Invalid road or clock skew
+            emit_vehicle(&w, id, odd ? 7 : r % 4, (r >> 4) % 4, odd ? s + 5 : s);
+        }
+        if (busy && r % 301 == 0) {
+            emit_command(&w, CMD_UPDATE_TIMING, (uint8_t)r, 1 + sizeof(PayloadConfig));
+        }
+        emit_step(&w, busy ? (r >> 8) % (ARCHIVE_DEPARTURES_MAX + 1) : 0, "veh", s);
+    }
+    emit_vehicle(&w, "after_last_step", 0, 2, w.step);
+
+    archive_writer_close(&w);
+    return f;
+}
+
+void test_round_trip() {
+    FILE* f = write_scenario(ARCHIVE_HAS_DEPARTURES, 20000);
+    ArchiveReader r;
+    ASSERT_TRUE(archive_reader_open(&r, f), "Archive should open");
+    ASSERT_EQ_INT(20000, (int)r.total_steps, "Step count in the trailer");
+    ASSERT_TRUE(r.block_count >= 20000 / ARCHIVE_BLOCK_STEPS, "Several blocks");
+
+    ArchiveEvent e;
+    uint32_t n = 0;
+    bool same = true;
+    while (archive_read_next(&r, &e)) {
+        same = same && n < n_expected && same_event(&e, &expected[n]);
+        n++;
+    }
+    ASSERT_TRUE(!r.corrupt, "No corruption");
+    ASSERT_EQ_INT((int)n_expected, (int)n, "Every event read back");
+    ASSERT_TRUE(same, "Events identical, in order");
+
+    archive_reader_close(&r);
+    fclose(f);
+}
+
+void test_departures_optional() {
+    FILE* f = write_scenario(0, 3000);
+    ArchiveReader r;
+    ASSERT_TRUE(archive_reader_open(&r, f), "Archive should open");
+    ASSERT_TRUE(!(r.flags & ARCHIVE_HAS_DEPARTURES), "No departures flag");
+
+    ArchiveEvent e;
+    uint32_t n = 0;
+    bool same = true;
+    while (archive_read_next(&r, &e)) {
+        same = same && n < n_expected && same_event(&e, &expected[n]);
+        n++;
+    }
+    ASSERT_EQ_INT((int)n_expected, (int)n, "Every event read back");
+    ASSERT_TRUE(same, "Steps without departures");
+
+    archive_reader_close(&r);
+    fclose(f);
+}
+
+void test_seek_matches_sequential_read() {
+    FILE* f = write_scenario(ARCHIVE_HAS_DEPARTURES, 20000);
+    ArchiveReader r;
+    archive_reader_open(&r, f);
+
+    static const uint32_t STEPS[] = {0, 1, 999, 1000, 2500, 4095, 4096, 4097, 8191, 12345, 19999, 20000, 25000};
+    bool all_ok = true;
+    for (uint32_t i = 0; i < sizeof(STEPS) / sizeof(STEPS[0]); i++) {
+        uint32_t first = 0;
+        while (first < n_expected && expected[first].step < STEPS[i]) first++;
+
+        ASSERT_TRUE(archive_reader_seek(&r, STEPS[i]), "Seek should succeed");
+        ArchiveEvent e;
+        uint32_t n = first, checked = 0;
+        while (checked < 200 && archive_read_next(&r, &e)) {
+            all_ok = all_ok && n < n_expected && same_event(&e, &expected[n]);
+            n++;
+            checked++;
+        }
+        all_ok = all_ok && (checked == 200 || n == n_expected);
+    }
+    ASSERT_TRUE(all_ok, "Events after a seek equal those of a full read");
+    ASSERT_TRUE(!r.corrupt, "No corruption");
+
+    archive_reader_close(&r);
+    fclose(f);
+}
+
+void test_blocks_split_by_size() {
+    FILE* f = tmpfile();
+    ArchiveWriter w;
+    archive_writer_open(&w, f, ARCHIVE_HAS_DEPARTURES);
+    n_expected = 0;
+
+    // Random IDs compress badly: blocks close by size long before ARCHIVE_BLOCK_STEPS
+    for (uint32_t s = 0; s < 400 && n_expected < MAX_EVENTS - 200; s++) {
+        for (uint32_t i = 0; i < 100; i++) {
+            char id[VEHICLE_ID_LEN];
+            snprintf(id, sizeof(id), "id%x_%u", next_random(), next_random());
+            emit_vehicle(&w, id, i % 4, (i + 1) % 4, s);
+        }
+        emit_step(&w, 0, "", 0);
+    }
+    archive_writer_close(&w);
+
+    ArchiveReader r;
+    ASSERT_TRUE(archive_reader_open(&r, f), "Archive should open");
+    ASSERT_TRUE(r.block_count > 1, "Size limit splits blocks");
+    bool bounded = true;
+    for (uint32_t i = 0; i < r.block_count; i++) {
+        bounded = bounded && r.index[i].length < 2 * ARCHIVE_BLOCK_BYTES;
+    }
+    ASSERT_TRUE(bounded, "Blocks stay near the size limit");
+
+    ASSERT_TRUE(archive_reader_seek(&r, 321), "Seek into a later block");
+    ArchiveEvent e;
+    ASSERT_TRUE(archive_read_next(&r, &e) && same_event(&e, &expected[321 * 101]), "First vehicle of step 321");
+
+    archive_reader_close(&r);
+    fclose(f);
+}
+
+void test_compression_ratio() {
+    FILE* f = tmpfile();
+    ArchiveWriter w;
+    archive_writer_open(&w, f, ARCHIVE_HAS_DEPARTURES);
+    uint64_t stream_bytes = 0;
+    uint32_t next_id = 0, departed = 0;
+
+    // A typical scenario: about one vehicle every two steps, departures in order
+    for (uint32_t s = 0; s < 50000; s++) {
+        char ids[ARCHIVE_DEPARTURES_MAX][VEHICLE_ID_LEN];
+        uint32_t r = next_random();
+        if (r % 2 == 0) {
+            char id[VEHICLE_ID_LEN];
+            snprintf(id, sizeof(id), "vehicle%u", next_id++);
+            archive_write_vehicle(&w, id, r % 4, (r >> 3) % 4, s);
+            stream_bytes += sizeof(CmdHeader) + sizeof(PayloadAddVehicle);
+        }
+        uint16_t count = 0;
+        while (departed + 3 < next_id && count < 2) {
+            snprintf(ids[count++], VEHICLE_ID_LEN, "vehicle%u", departed++);
+        }
+        archive_write_step(&w, (const char(*)[VEHICLE_ID_LEN])ids, count);
+        stream_bytes += 1 + sizeof(ResponseStep) + count * VEHICLE_ID_LEN;
+    }
+    archive_writer_close(&w);
+
+    long size = ftell(f);
+    ASSERT_TRUE(size > 0 && stream_bytes / (uint64_t)size >= 10, "At least 10x smaller than the binary streams");
+    fclose(f);
+}
+
+void test_export_commands() {
+    FILE* f = tmpfile();
+    ArchiveWriter w;
+    archive_writer_open(&w, f, 0);
+    uint8_t config[1 + sizeof(PayloadConfig)] = {CMD_CONFIG, 4};
+    archive_write_command(&w, config, sizeof(config));
+    archive_write_vehicle(&w, "car1", NORTH, SOUTH, 0);
+    archive_write_step(&w, NULL, 0);
+    archive_write_step(&w, NULL, 0);
+    archive_write_vehicle(&w, "car2", WEST, EAST, 2);
+    archive_write_step(&w, NULL, 0);
+    archive_writer_close(&w);
+
+    ArchiveReader r;
+    archive_reader_open(&r, f);
+    FILE* out = tmpfile();
+    ASSERT_TRUE(archive_export_commands(&r, UINT32_MAX, out), "Export should succeed");
+
+    uint8_t stream[256];
+    long len = ftell(out);
+    rewind(out);
+    ASSERT_EQ_INT((int)(sizeof(config) + 2 * (1 + sizeof(PayloadAddVehicle)) + 3), (int)len, "Stream length");
+    ASSERT_TRUE(fread(stream, 1, (size_t)len, out) == (size_t)len, "Stream readable");
+    ASSERT_TRUE(memcmp(stream, config, sizeof(config)) == 0, "Config verbatim");
+
+    PayloadAddVehicle v;
+    memcpy(&v, stream + sizeof(config) + 1, sizeof(v));
+    ASSERT_EQ_INT(CMD_ADD_VEHICLE, stream[sizeof(config)], "Add vehicle command");
+    ASSERT_TRUE(strcmp(v.vehicle_id, "car1") == 0 && v.start_road == NORTH && v.end_road == SOUTH, "Vehicle payload");
+    ASSERT_EQ_INT(CMD_STEP, stream[sizeof(config) + 1 + sizeof(v)], "Step command");
+    memcpy(&v, stream + sizeof(config) + 3 + sizeof(v) + 1, sizeof(v));
+    ASSERT_EQ_INT(2, (int)v.arrival_time, "Arrival at step 2");
+
+    archive_reader_seek(&r, 2);
+    rewind(out);
+    archive_export_commands(&r, 3, out);
+    ASSERT_EQ_INT((int)(1 + sizeof(PayloadAddVehicle) + 1), (int)ftell(out), "Window export");
+
+    archive_reader_close(&r);
+    fclose(out);
+    fclose(f);
+}
+
+void test_corrupt_archives() {
+    FILE* f = write_scenario(ARCHIVE_HAS_DEPARTURES, 5000);
+    long size = ftell(f);
+    uint8_t* data = malloc((size_t)size);
+    rewind(f);
+    ASSERT_TRUE(fread(data, 1, (size_t)size, f) == (size_t)size, "Archive readable");
+    fclose(f);
+
+    // Truncated: the trailer is gone
+    FILE* t = tmpfile();
+    fwrite(data, 1, (size_t)size - 7, t);
+    ArchiveReader r;
+    ASSERT_TRUE(!archive_reader_open(&r, t), "Truncated archive rejected");
+    fclose(t);
+
+    // Damaged events: decoding stops cleanly, never past the block
+    bool clean = true;
+    for (uint32_t trial = 0; trial < 200; trial++) {
+        FILE* d = tmpfile();
+        uint8_t saved = data[8 + trial * 7 % 500];
+        data[8 + trial * 7 % 500] ^= (uint8_t)(1 + trial % 255);
+        fwrite(data, 1, (size_t)size, d);
+        data[8 + trial * 7 % 500] = saved;
+
+        if (archive_reader_open(&r, d)) {
+            ArchiveEvent e;
+            uint32_t n = 0;
+            while (archive_read_next(&r, &e) && n < 2 * MAX_EVENTS) n++;
+            clean = clean && n < 2 * MAX_EVENTS;
+            archive_reader_close(&r);
+        }
+        fclose(d);
+    }
+    ASSERT_TRUE(clean, "Damaged archives end or report corruption");
+
+    t = tmpfile();
+    fwrite("TSAX", 1, 4, t);
+    fflush(t);
+    rewind(t);
+    ASSERT_TRUE(!archive_is_archive(t), "Other files are not archives");
+    fclose(t);
+    free(data);
+}
+
+int main() {
+    printf("\n=== SCENARIO ARCHIVE TESTS ===\n\n");
+
+    expected = malloc(MAX_EVENTS * sizeof(ArchiveEvent));
+    if (!expected) return 1;
+
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_departures_optional);
+    RUN_TEST(test_seek_matches_sequential_read);
+    RUN_TEST(test_blocks_split_by_size);
+    RUN_TEST(test_compression_ratio);
+    RUN_TEST(test_export_commands);
+    RUN_TEST(test_corrupt_archives);
+
+    PRINT_TEST_RESULTS();
+
+    free(expected);
+    return (tests_failed == 0) ? 0 : 1;
+}
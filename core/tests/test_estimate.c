@@ -0,0 +1,84 @@
+#include "test_utils.h"
+#include "traffic_fsm.h"
+#include "traffic_estimate.h"
+#include <stdio.h>
+
+int tests_run = 0;
+int tests_failed = 0;
+
+TrafficDemand uniform_demand(float rate) {
+    TrafficDemand demand;
+    memset(&demand, 0, sizeof(demand));
+    demand.horizon = 200;
+
+    for (int road = 0; road < ROAD_COUNT; road++) {
+        demand.lane_rate[road][LANE_STRAIGHT_RIGHT] = 0.75f * rate;
+        demand.lane_rate[road][LANE_LEFT] = 0.25f * rate;
+        demand.right_share[road] = 0.5f;
+    }
+    return demand;
+}
+
+void test_estimate_empty_demand() {
+    TimingConfig config = DEFAULT_TIMING;
+    TrafficDemand demand = uniform_demand(0.0f);
+    TrafficEstimate est;
+
+    traffic_estimate(&config, &demand, &est);
+    ASSERT_TRUE(est.avg_delay == 0.0f, "No vehicles means no delay");
+    ASSERT_TRUE(est.cycle_length > 0.0f, "Cycle length should be positive");
+}
+
+void test_estimate_cycle_follows_timing() {
+    TimingConfig short_cycle = DEFAULT_TIMING;
+    TimingConfig long_cycle = DEFAULT_TIMING;
+    long_cycle.green_st = 18;
+    long_cycle.green_lt = 13;
+
+    TrafficDemand demand = uniform_demand(0.3f);
+    TrafficEstimate est_short, est_long;
+    traffic_estimate(&short_cycle, &demand, &est_short);
+    traffic_estimate(&long_cycle, &demand, &est_long);
+
+    ASSERT_TRUE(est_long.cycle_length > est_short.cycle_length, "Longer greens must give a longer cycle");
+}
+
+void test_estimate_delay_grows_with_load() {
+    TimingConfig config = DEFAULT_TIMING;
+    TrafficDemand light = uniform_demand(0.1f);
+    TrafficDemand heavy = uniform_demand(0.6f);
+    TrafficEstimate est_light, est_heavy;
+
+    traffic_estimate(&config, &light, &est_light);
+    traffic_estimate(&config, &heavy, &est_heavy);
+
+    ASSERT_TRUE(est_heavy.avg_delay > est_light.avg_delay, "Heavier traffic must increase delay");
+    ASSERT_TRUE(est_heavy.max_delay >= est_heavy.avg_delay, "MAX estimate should not be below AWT");
+}
+
+void test_estimate_oversaturated_queue_grows() {
+    TimingConfig config = DEFAULT_TIMING;
+    config.max_ext = 0;
+    TrafficDemand demand = uniform_demand(0.1f);
+    demand.lane_rate[NORTH][LANE_LEFT] = 0.9f;
+
+    TrafficEstimate est;
+    traffic_estimate(&config, &demand, &est);
+
+    ASSERT_TRUE(est.lane_growth[NORTH][LANE_LEFT] > 0.0f, "Oversaturated lane should grow");
+    ASSERT_TRUE(est.lane_growth[EAST][LANE_LEFT] == 0.0f, "Light lane should not grow");
+    ASSERT_TRUE(est.left_delay > est.lane_delay[EAST][LANE_STRAIGHT_RIGHT], "Left turns should suffer most");
+}
+
+int main() {
+    printf("\n=== ESTIMATOR TESTS ===\n\n");
+
+    RUN_TEST(test_estimate_empty_demand);
+    RUN_TEST(test_estimate_cycle_follows_timing);
+    RUN_TEST(test_estimate_delay_grows_with_load);
+    RUN_TEST(test_estimate_oversaturated_queue_grows);
+
+    PRINT_TEST_RESULTS();
+
+    return (tests_failed == 0) ? 0 : 1;
+}
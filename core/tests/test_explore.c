@@ -0,0 +1,161 @@
+#include "test_utils.h"
+#include "traffic_explore.h"
+#include <stdio.h>
+
+int tests_run = 0;
+int tests_failed = 0;
+
+/**
+ * @brief Wait of a single vehicle added after `delay` steps of an empty intersection.
+ */
+uint32_t single_vehicle_wait(TimingConfig config, TrafficStrategyId strategy, uint32_t delay,
+                             Direction start, Direction end) {
+    TrafficSystem sys;
+    char out_ids[ROAD_COUNT * LANES_PER_ROAD][VEHICLE_ID_LEN];
+
+    traffic_init(&sys, config);
+    traffic_set_strategy(&sys, strategy);
+    for (uint32_t step = 0; step < delay; step++) {
+        traffic_fsm_step(&sys, out_ids);
+    }
+
+    traffic_add_vehicle(&sys, "probe", start, end, sys.current_step);
+    for (uint32_t step = 0; step < 1000 && sys.stats.departures == 0; step++) {
+        traffic_fsm_step(&sys, out_ids);
+    }
+    return sys.stats.max_wait;
+}
+
+/**
+ * @brief Worst wait per movement under dense pseudo-random traffic (LCG).
+ */
+void random_traffic_waits(TimingConfig config, TrafficStrategyId strategy, uint32_t percent,
+                          uint32_t steps, uint32_t worst[MOVEMENT_COUNT]) {
+    static TrafficSystem sys;
+    char out_ids[ROAD_COUNT * LANES_PER_ROAD][VEHICLE_ID_LEN];
+    uint32_t seed = percent * 7919u;
+
+    traffic_init(&sys, config);
+    traffic_set_strategy(&sys, strategy);
+    for (uint32_t step = 0; step < steps; step++) {
+        for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+            seed = seed * 1103515245u + 12345u;
+            if ((seed >> 16) % 100 >= percent) continue;
+            seed = seed * 1103515245u + 12345u;
+            traffic_add_vehicle(&sys, "v", road, (road + 1 + (seed >> 16) % 3) % ROAD_COUNT, sys.current_step);
+        }
+        traffic_fsm_step(&sys, out_ids);
+    }
+
+    for (uint8_t movement = 0; movement < MOVEMENT_COUNT; movement++) {
+        uint8_t axis = movement / LANES_PER_ROAD, lane = movement % LANES_PER_ROAD;
+        uint32_t a = queue_get_max_wait(&sys.queues[axis][lane]);
+        uint32_t b = queue_get_max_wait(&sys.queues[axis + 2][lane]);
+        worst[movement] = a > b ? a : b;
+    }
+}
+
+void test_fixed_cycle_bound_is_tight() {
+    TimingConfig config = DEFAULT_TIMING;
+    ExploreBounds bounds;
+
+    ASSERT_TRUE(traffic_explore(&config, STRATEGY_V1, &bounds), "V1 should be certified");
+
+    // A fixed cycle does not react to traffic: one vehicle sees the worst case
+    uint32_t straight = 0, left = 0;
+    for (uint32_t delay = 0; delay < 60; delay++) {
+        uint32_t wait = single_vehicle_wait(config, STRATEGY_V1, delay, NORTH, SOUTH);
+        if (wait > straight) straight = wait;
+        wait = single_vehicle_wait(config, STRATEGY_V1, delay, EAST, SOUTH);
+        if (wait > left) left = wait;
+    }
+    ASSERT_EQ_INT(straight, bounds.starvation[0], "NS straight bound should be reached");
+    ASSERT_EQ_INT(left, bounds.starvation[3], "EW left bound should be reached");
+}
+
+void test_bounds_hold_under_dense_traffic() {
+    TimingConfig config = DEFAULT_TIMING;
+    ExploreBounds bounds;
+
+    ASSERT_TRUE(traffic_explore(&config, STRATEGY_V4, &bounds), "V4 should be certified");
+
+    for (uint32_t percent = 20; percent <= 100; percent += 40) {
+        uint32_t worst[MOVEMENT_COUNT];
+        random_traffic_waits(config, STRATEGY_V4, percent, 20000, worst);
+        for (uint8_t movement = 0; movement < MOVEMENT_COUNT; movement++) {
+            ASSERT_TRUE(worst[movement] <= bounds.max_wait[movement], "Observed wait should be within the bound");
+        }
+    }
+}
+
+void test_production_strategy_small_config() {
+    TimingConfig config = {3, 2, 1, 1, 1, 1, 3, 1};
+    ExploreBounds bounds;
+
+    ASSERT_TRUE(traffic_explore(&config, STRATEGY_V6, &bounds), "V6 should be certified");
+    for (uint8_t movement = 0; movement < MOVEMENT_COUNT; movement++) {
+        ASSERT_TRUE(bounds.starvation[movement] != EXPLORE_UNBOUNDED, "No movement should starve");
+        ASSERT_TRUE(bounds.starvation[movement] <= bounds.max_wait[movement], "A full queue waits longer");
+    }
+
+    uint32_t worst[MOVEMENT_COUNT];
+    random_traffic_waits(config, STRATEGY_V6, 100, 20000, worst);
+    for (uint8_t movement = 0; movement < MOVEMENT_COUNT; movement++) {
+        ASSERT_TRUE(worst[movement] <= bounds.max_wait[movement], "Observed wait should be within the bound");
+    }
+}
+
+void test_extension_raises_starvation() {
+    TimingConfig config = DEFAULT_TIMING;
+    ExploreBounds short_ext, long_ext;
+
+    config.max_ext = 2;
+    traffic_explore(&config, STRATEGY_V3, &short_ext);
+    config.max_ext = 8;
+    traffic_explore(&config, STRATEGY_V3, &long_ext);
+
+    // Three other phases can each be extended by max_ext
+    ASSERT_EQ_INT(short_ext.starvation[0] + 3 * 6, long_ext.starvation[0], "Each extension step should count");
+}
+
+void test_unsupported_configs() {
+    TimingConfig config = DEFAULT_TIMING;
+    ExploreBounds bounds;
+
+    ASSERT_TRUE(!traffic_explore(&config, STRATEGY_V5, &bounds), "Pressure-based limit is not bounded");
+    config.ext_threshold = 4;
+    ASSERT_TRUE(!traffic_explore(&config, STRATEGY_V4, &bounds), "Threshold beyond the packed levels");
+    config.ext_threshold = 1;
+    config.green_st = 300;
+    ASSERT_TRUE(!traffic_explore(&config, STRATEGY_V4, &bounds), "Duration beyond the packed timer");
+}
+
+void test_grid_matches_single_runs() {
+    TimingConfig configs[3] = {DEFAULT_TIMING, DEFAULT_TIMING, DEFAULT_TIMING};
+    ExploreBounds grid[3], single;
+    bool ok[3];
+
+    configs[1].green_st = 8;
+    configs[2].ext_threshold = 9; // Not supported
+    ASSERT_TRUE(traffic_explore_grid(configs, 3, STRATEGY_V4, 3, grid, ok), "Grid should run");
+    ASSERT_TRUE(ok[0] && ok[1] && !ok[2], "Only the supported configs should be certified");
+
+    traffic_explore(&configs[1], STRATEGY_V4, &single);
+    ASSERT_EQ_INT(single.max_wait[0], grid[1].max_wait[0], "Threads should not change the result");
+    ASSERT_EQ_INT(single.states, grid[1].states, "Same state space");
+}
+
+int main() {
+    printf("\n=== EXPLORE TESTS ===\n\n");
+
+    RUN_TEST(test_fixed_cycle_bound_is_tight);
+    RUN_TEST(test_bounds_hold_under_dense_traffic);
+    RUN_TEST(test_production_strategy_small_config);
+    RUN_TEST(test_extension_raises_starvation);
+    RUN_TEST(test_unsupported_configs);
+    RUN_TEST(test_grid_matches_single_runs);
+
+    PRINT_TEST_RESULTS();
+
+    return (tests_failed == 0) ? 0 : 1;
+}
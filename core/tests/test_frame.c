@@ -0,0 +1,132 @@
+#include "test_utils.h"
+#include "frame_codec.h"
+#include <stdio.h>
+
+int tests_run = 0;
+int tests_failed = 0;
+
+static uint8_t payload[FRAME_MAX_PAYLOAD];
+static uint8_t encoded[FRAME_ENCODED_SIZE(FRAME_MAX_PAYLOAD)];
+
+/**
+ * @brief Feeds encoded bytes to the decoder and returns the last non-empty result.
+ */
+FrameResult feed(FrameDecoder* d, const uint8_t* data, size_t len) {
+    FrameResult last = FRAME_NONE;
+    for (size_t i = 0; i < len; i++) {
+        FrameResult r = frame_decoder_push(d, data[i]);
+        if (r != FRAME_NONE) {
+            last = r;
+        }
+    }
+    return last;
+}
+
+void fill_payload(size_t len, uint32_t seed) {
+    for (size_t i = 0; i < len; i++) {
+        seed = seed * 1103515245u + 12345u;
+        // Plenty of zeros and long non-zero runs
+        payload[i] = (i % 300 < 270) ? (uint8_t)(1 + (seed >> 16) % 255) : 0;
+        if ((seed >> 24) % 7 == 0) payload[i] = 0;
+    }
+}
+
+void test_crc_check_value() {
+    const uint8_t check[] = "123456789";
+    ASSERT_EQ_INT(0x29B1, frame_crc16(0xFFFF, check, 9), "CRC-16/CCITT-FALSE check value");
+}
+
+void test_round_trip_all_sizes() {
+    FrameDecoder d;
+    frame_decoder_init(&d);
+
+    for (size_t len = 0; len <= 700; len++) {
+        fill_payload(len, (uint32_t)len);
+        size_t n = frame_encode((uint8_t)len, 0, payload, len, encoded, sizeof(encoded));
+
+        ASSERT_TRUE(n > 0 && n <= FRAME_ENCODED_SIZE(len), "Frame should fit its worst case size");
+        ASSERT_TRUE(memchr(encoded, 0, n - 1) == NULL, "Only the delimiter may be zero");
+        ASSERT_EQ_INT(FRAME_OK, feed(&d, encoded, n), "Frame should decode");
+        ASSERT_EQ_INT((int)len, (int)d.payload_len, "Payload length should survive");
+        ASSERT_TRUE(len == 0 || memcmp(payload, d.payload, len) == 0, "Payload should survive");
+    }
+    ASSERT_EQ_INT(0, (int)d.stats.seq_gaps, "Consecutive sequence numbers");
+
+    size_t n = frame_encode(0, 0, payload, FRAME_MAX_PAYLOAD, encoded, sizeof(encoded));
+    ASSERT_EQ_INT(FRAME_OK, feed(&d, encoded, n), "Largest frame should decode");
+}
+
+void test_corrupted_frame_resynchronises() {
+    FrameDecoder d;
+    frame_decoder_init(&d);
+    fill_payload(64, 5);
+
+    size_t n = frame_encode(1, 0, payload, 64, encoded, sizeof(encoded));
+    encoded[10] ^= 0x10;
+    ASSERT_EQ_INT(FRAME_DROPPED, feed(&d, encoded, n), "Corrupted frame should be dropped");
+
+    n = frame_encode(2, 0, payload, 64, encoded, sizeof(encoded));
+    ASSERT_EQ_INT(FRAME_OK, feed(&d, encoded, n), "Next frame should be accepted");
+    ASSERT_EQ_INT(1, (int)d.stats.frames_dropped, "Drop should be counted");
+}
+
+void test_lost_delimiter_costs_two_frames() {
+    FrameDecoder d;
+    frame_decoder_init(&d);
+    fill_payload(40, 9);
+
+    size_t n = frame_encode(1, 0, payload, 40, encoded, sizeof(encoded));
+    feed(&d, encoded, n - 1); // Delimiter lost
+    n = frame_encode(2, 0, payload, 40, encoded, sizeof(encoded));
+    ASSERT_EQ_INT(FRAME_DROPPED, feed(&d, encoded, n), "Merged frames should be dropped");
+
+    n = frame_encode(3, 0, payload, 40, encoded, sizeof(encoded));
+    ASSERT_EQ_INT(FRAME_OK, feed(&d, encoded, n), "Decoder should be back in sync");
+}
+
+void test_sequence_counters() {
+    FrameDecoder d;
+    frame_decoder_init(&d);
+    size_t n;
+
+    n = frame_encode(10, 0, NULL, 0, encoded, sizeof(encoded));
+    ASSERT_EQ_INT(FRAME_OK, feed(&d, encoded, n), "First frame accepted");
+    ASSERT_EQ_INT(FRAME_DUPLICATE, feed(&d, encoded, n), "Retransmission detected");
+
+    n = frame_encode(13, FRAME_FLAG_NAK, NULL, 0, encoded, sizeof(encoded));
+    ASSERT_EQ_INT(FRAME_OK, feed(&d, encoded, n), "Frame after a gap accepted");
+    ASSERT_EQ_INT(FRAME_FLAG_NAK, d.flags, "Flags should survive");
+
+    ASSERT_EQ_INT(2, (int)d.stats.frames_ok, "Accepted frames");
+    ASSERT_EQ_INT(1, (int)d.stats.frames_duplicate, "Retransmitted frames");
+    ASSERT_EQ_INT(1, (int)d.stats.seq_gaps, "Sequence gaps");
+}
+
+void test_oversized_frame_dropped() {
+    FrameDecoder d;
+    frame_decoder_init(&d);
+
+    memset(encoded, 0x55, sizeof(encoded));
+    ASSERT_EQ_INT(FRAME_NONE, feed(&d, encoded, sizeof(encoded)), "No delimiter yet");
+    uint8_t delimiter = FRAME_DELIMITER;
+    ASSERT_EQ_INT(FRAME_DROPPED, feed(&d, &delimiter, 1), "Oversized frame should be dropped");
+
+    size_t n = frame_encode(0, 0, NULL, 0, encoded, sizeof(encoded));
+    ASSERT_EQ_INT(FRAME_OK, feed(&d, encoded, n), "Decoder should recover");
+    ASSERT_EQ_INT(0, (int)frame_encode(0, 0, payload, 100, encoded, 50), "Too small output buffer");
+}
+
+int main() {
+    printf("\n=== FRAME CODEC TESTS ===\n\n");
+
+    RUN_TEST(test_crc_check_value);
+    RUN_TEST(test_round_trip_all_sizes);
+    RUN_TEST(test_corrupted_frame_resynchronises);
+    RUN_TEST(test_lost_delimiter_costs_two_frames);
+    RUN_TEST(test_sequence_counters);
+    RUN_TEST(test_oversized_frame_dropped);
+
+    PRINT_TEST_RESULTS();
+
+    return (tests_failed == 0) ? 0 : 1;
+}
@@ -1,6 +1,7 @@
 #include "test_utils.h"
 #include "traffic_fsm.h"
 #include <stdio.h>
+#include <string.h>
 
 int tests_run = 0;
 int tests_failed = 0;
@@ -325,6 +326,330 @@ void test_green_arrow_right_turns() {
     ASSERT_TRUE(discharged_on_arrow, "Vehicle MUST discharge during NS_LEFT via Green Arrow");
 }
 
+void test_strategy_selection() {
+    TrafficSystem sys = create_test_system();
+
+    ASSERT_EQ_INT(sys.strategy, DEFAULT_STRATEGY, "traffic_init should select the production strategy");
+    ASSERT_TRUE(traffic_set_strategy(&sys, STRATEGY_V1), "V1 should be selectable");
+    ASSERT_EQ_INT(sys.strategy, STRATEGY_V1, "Strategy should be stored");
+    ASSERT_TRUE(!traffic_set_strategy(&sys, STRATEGY_COUNT), "Unknown strategy should be rejected");
+    ASSERT_EQ_INT(sys.strategy, STRATEGY_V1, "Rejected strategy must not change the system");
+
+    for (int id = 0; id < STRATEGY_COUNT; id++) {
+        const TrafficStrategy* strategy = traffic_get_strategy((TrafficStrategyId)id);
+        ASSERT_TRUE(strategy && strategy->name && strategy->select_phase &&
+                    strategy->should_extend && strategy->state_lights, "Strategy hooks must be set");
+    }
+}
+
+void test_strategy_v1_runs_empty_phases() {
+    TrafficSystem sys = create_minimal_system();
+    traffic_set_strategy(&sys, STRATEGY_V1);
+    char dummy_ids[8][32];
+
+    traffic_add_vehicle(&sys, "car1", NORTH, SOUTH, 0);
+    advance_to_state(&sys, STATE_NS_STRAIGHT_YELLOW, dummy_ids);
+    traffic_fsm_step(&sys, dummy_ids);
+
+    ASSERT_EQ_INT(sys.current_state, STATE_NS_LEFT_RED_YELLOW, "Fixed cycle must not skip the empty NS_LEFT phase");
+}
+
+void test_strategy_v2_never_extends() {
+    TrafficSystem sys = create_minimal_system();
+    traffic_set_strategy(&sys, STRATEGY_V2);
+    char dummy_ids[8][32];
+
+    fill_lane(&sys, NORTH, LANE_STRAIGHT_RIGHT, 6);
+    advance_to_state(&sys, STATE_NS_STRAIGHT, dummy_ids);
+    traffic_fsm_step(&sys, dummy_ids);
+    traffic_fsm_step(&sys, dummy_ids);
+
+    ASSERT_EQ_INT(sys.current_state, STATE_NS_STRAIGHT_YELLOW, "V2 should end green after the base time");
+}
+
+void test_strategy_v3_has_no_arrows() {
+    TrafficSystem sys = create_test_system();
+    traffic_set_strategy(&sys, STRATEGY_V3);
+    char out_ids[8][32];
+
+    traffic_add_vehicle(&sys, "left_north", NORTH, EAST, 0);
+    advance_to_state(&sys, STATE_NS_LEFT, out_ids);
+
+    ASSERT_EQ_INT(sys.lights[EAST][LANE_STRAIGHT_RIGHT], LIGHT_RED, "V3 shows no permissive arrow");
+}
+
+void test_strategy_v5_extends_beyond_limit() {
+    TimingConfig config = {
+        .green_st = 2, .green_lt = 2, .yellow = 1, .all_red = 1,
+        .ext_threshold = 1, .max_ext = 1, .skip_limit = 2
+    };
+    TrafficSystem v4, v5;
+    char dummy_ids[8][32];
+
+    traffic_init(&v4, config);
+    traffic_init(&v5, config);
+    traffic_set_strategy(&v4, STRATEGY_V4);
+    traffic_set_strategy(&v5, STRATEGY_V5);
+    fill_lane(&v4, NORTH, LANE_STRAIGHT_RIGHT, 10);
+    fill_lane(&v5, NORTH, LANE_STRAIGHT_RIGHT, 10);
+
+    advance_to_state(&v4, STATE_NS_STRAIGHT_YELLOW, dummy_ids);
+    advance_to_state(&v5, STATE_NS_STRAIGHT_YELLOW, dummy_ids);
+
+    ASSERT_TRUE(v5.current_step > v4.current_step, "Queue pressure should lengthen the V5 green phase");
+}
+
+void test_update_timing_keeps_queues() {
+    TrafficSystem sys = create_test_system();
+    TimingConfig fast = sys.timing;
+    fast.green_st = 2;
+    char out_ids[8][32];
+
+    fill_lane(&sys, NORTH, LANE_STRAIGHT_RIGHT, 20);
+    fill_lane(&sys, NORTH, LANE_LEFT, 3);
+    fill_lane(&sys, EAST, LANE_STRAIGHT_RIGHT, 4);
+    advance_to_state(&sys, STATE_NS_STRAIGHT, out_ids);
+    traffic_fsm_step(&sys, out_ids);
+
+    uint16_t north = traffic_get_queue_size(&sys, NORTH, LANE_STRAIGHT_RIGHT);
+    uint32_t departures = sys.stats.departures;
+    uint32_t step = sys.current_step;
+
+    traffic_update_timing(&sys, &fast);
+
+    ASSERT_TRUE(sys.timing_pending, "Update during green should wait for a phase boundary");
+    ASSERT_EQ_INT(10, sys.timing.green_st, "Running phase keeps its timing");
+    ASSERT_EQ_INT(STATE_NS_STRAIGHT, sys.current_state, "Update must not change the state");
+    ASSERT_EQ_INT(step, sys.current_step, "Update must not reset the clock");
+    ASSERT_EQ_INT(north, traffic_get_queue_size(&sys, NORTH, LANE_STRAIGHT_RIGHT), "Update must not drain queues");
+    ASSERT_EQ_INT(4, traffic_get_queue_size(&sys, EAST, LANE_STRAIGHT_RIGHT), "Update must not drain queues");
+    ASSERT_EQ_INT(departures, sys.stats.departures, "Update must keep statistics");
+
+    advance_to_state(&sys, STATE_NS_LEFT_RED_YELLOW, out_ids);
+
+    ASSERT_TRUE(!sys.timing_pending, "Pending timing should be applied at the phase boundary");
+    ASSERT_EQ_INT(2, sys.timing.green_st, "New timing should be active");
+    ASSERT_TRUE(sys.stats.departures > departures, "Statistics should keep accumulating");
+}
+
+void test_update_timing_in_all_red_applies_immediately() {
+    TrafficSystem sys = create_test_system();
+    TimingConfig config = sys.timing;
+    config.all_red = 1;
+
+    traffic_update_timing(&sys, &config);
+
+    ASSERT_TRUE(!sys.timing_pending, "Nothing is green in ALL_RED, no need to wait");
+    ASSERT_EQ_INT(1, sys.timing.all_red, "New timing should be active");
+}
+
+void test_timing_plans_switch_at_start_step() {
+    TrafficSystem sys = create_minimal_system();
+    TimingPlan morning = {.start_step = 20, .timing = sys.timing};
+    TimingPlan evening = {.start_step = 40, .timing = sys.timing};
+    morning.timing.green_st = 6;
+    evening.timing.green_st = 8;
+    char out_ids[8][32];
+
+    ASSERT_TRUE(traffic_add_timing_plan(&sys, &morning), "First plan should be accepted");
+    ASSERT_TRUE(traffic_add_timing_plan(&sys, &evening), "Later plan should be accepted");
+    ASSERT_TRUE(!traffic_add_timing_plan(&sys, &morning), "Plans out of order should be rejected");
+
+    fill_lane(&sys, NORTH, LANE_STRAIGHT_RIGHT, 30);
+    fill_lane(&sys, EAST, LANE_STRAIGHT_RIGHT, 30);
+
+    while (sys.current_step < 19) {
+        traffic_fsm_step(&sys, out_ids);
+    }
+    ASSERT_EQ_INT(2, sys.timing.green_st, "Plan must not start early");
+    ASSERT_TRUE(!sys.timing_pending, "Nothing pending before the first plan");
+
+    while (sys.current_step < 40) {
+        traffic_fsm_step(&sys, out_ids);
+    }
+    ASSERT_EQ_INT(6, sys.timing.green_st, "Morning plan should be active before the evening one starts");
+
+    while (sys.current_step < 80) {
+        traffic_fsm_step(&sys, out_ids);
+    }
+    ASSERT_EQ_INT(8, sys.timing.green_st, "Evening plan should take over");
+    ASSERT_EQ_INT(2, sys.next_plan, "All plans should be activated");
+}
+
+#define RUN_STEPS 400
+#define RUN_MAX_ARRIVALS (RUN_STEPS * ROAD_COUNT)
+
+static char run_ids[RUN_MAX_ARRIVALS][VEHICLE_ID_LEN];
+
+/**
+ * Deterministic scenario (LCG) with unique IDs, sorted by step.
+ */
+static uint32_t make_arrivals(TrafficArrival* arrivals) {
+    uint32_t n = 0, seed = 7;
+    for (uint32_t step = 0; step < RUN_STEPS; step++) {
+        for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+            seed = seed * 1103515245u + 12345u;
+            if ((seed >> 16) % 100 >= 35) continue;
+            snprintf(run_ids[n], VEHICLE_ID_LEN, "v%u", (unsigned)n);
+            arrivals[n] = (TrafficArrival){run_ids[n], step, road, (uint8_t)((road + 1 + (seed >> 8) % 3) % ROAD_COUNT)};
+            n++;
+        }
+    }
+    return n;
+}
+
+typedef struct {
+    uint32_t count;
+    uint64_t hash; // Order-sensitive hash of the departing IDs and steps
+} DepartureLog;
+
+static void log_departure(DepartureLog* log, const char* id, uint32_t step) {
+    for (const char* c = id; *c; c++) log->hash = log->hash * 31u + (uint8_t)*c;
+    log->hash = log->hash * 31u + step;
+    log->count++;
+}
+
+static void sink_departure(void* ctx, const Vehicle* v, uint32_t step, uint32_t wait) {
+    (void)wait;
+    log_departure(ctx, v->id, step);
+}
+
+/**
+ * Reference: traffic_add_vehicle() and traffic_fsm_step() per event.
+ */
+static void run_step_by_step(TrafficSystem* sys, const TrafficArrival* arrivals, uint32_t n, DepartureLog* log) {
+    char out_ids[ROAD_COUNT * LANES_PER_ROAD][VEHICLE_ID_LEN];
+    uint32_t next = 0;
+    for (uint32_t step = 0; step < RUN_STEPS; step++) {
+        while (next < n && arrivals[next].step <= sys->current_step) {
+            const TrafficArrival* a = &arrivals[next++];
+            traffic_add_vehicle(sys, a->id, a->start_road, a->end_road, a->step);
+        }
+        uint8_t count = traffic_fsm_step(sys, out_ids);
+        for (uint8_t i = 0; i < count; i++) log_departure(log, out_ids[i], sys->current_step);
+    }
+}
+
+void test_run_matches_step_by_step() {
+    static TrafficArrival arrivals[RUN_MAX_ARRIVALS];
+    uint32_t n = make_arrivals(arrivals);
+    TrafficSystem reference = create_test_system();
+    TrafficSystem sys = create_test_system();
+    DepartureLog expected = {0}, actual = {0};
+    TrafficRunSink sink = {sink_departure, &actual};
+
+    run_step_by_step(&reference, arrivals, n, &expected);
+    uint32_t consumed = traffic_run(&sys, arrivals, n, RUN_STEPS, &sink);
+
+    ASSERT_EQ_INT((int)n, (int)consumed, "All arrivals should be consumed");
+    ASSERT_EQ_INT(RUN_STEPS, (int)sys.current_step, "Run should advance n_steps");
+    ASSERT_TRUE(expected.count > 0, "Scenario should discharge vehicles");
+    ASSERT_EQ_INT((int)expected.count, (int)actual.count, "Sink should see every departure");
+    ASSERT_TRUE(expected.hash == actual.hash, "Departures should match in order, ID and step");
+    ASSERT_TRUE(memcmp(&reference.stats, &sys.stats, sizeof(sys.stats)) == 0, "Statistics should match");
+    ASSERT_EQ_INT(reference.current_state, sys.current_state, "FSM state should match");
+}
+
+void test_run_in_chunks() {
+    static TrafficArrival arrivals[RUN_MAX_ARRIVALS];
+    uint32_t n = make_arrivals(arrivals);
+    TrafficSystem whole = create_test_system();
+    TrafficSystem chunked = create_test_system();
+    DepartureLog expected = {0}, actual = {0};
+    TrafficRunSink whole_sink = {sink_departure, &expected};
+    TrafficRunSink chunk_sink = {sink_departure, &actual};
+
+    traffic_run(&whole, arrivals, n, RUN_STEPS, &whole_sink);
+
+    uint32_t consumed = 0;
+    for (uint32_t chunk = 0; chunk < RUN_STEPS / 100; chunk++) {
+        consumed += traffic_run(&chunked, arrivals + consumed, n - consumed, 100, &chunk_sink);
+    }
+
+    ASSERT_EQ_INT((int)n, (int)consumed, "Chunks should consume every arrival once");
+    ASSERT_TRUE(expected.hash == actual.hash && expected.count == actual.count, "Chunked run should match");
+    ASSERT_TRUE(memcmp(&whole.stats, &chunked.stats, sizeof(whole.stats)) == 0, "Statistics should match");
+}
+
+void test_run_without_sink() {
+    TrafficArrival arrivals[] = {
+        {"a", 0, NORTH, SOUTH},
+        {"b", 0, SOUTH, NORTH},
+        {"bad", 1, 7, SOUTH}, // Invalid road, dropped
+        {"late", 500, EAST, WEST},
+    };
+    TrafficSystem sys = create_test_system();
+
+    uint32_t consumed = traffic_run(&sys, arrivals, 4, 60, NULL);
+
+    ASSERT_EQ_INT(3, (int)consumed, "Arrival after the last step stays unconsumed");
+    ASSERT_EQ_INT(2, (int)sys.stats.departures, "Statistics are kept without a sink");
+    ASSERT_TRUE(queue_is_empty(&sys.queues[EAST][LANE_STRAIGHT_RIGHT]), "Late arrival not queued");
+}
+
+void test_add_vehicles_batch() {
+    TrafficSystem batched = create_test_system();
+    TrafficSystem single = create_test_system();
+    Vehicle vehicles[70];
+    uint32_t n = 0;
+
+    // Runs for one lane, lane changes, an invalid road and an overflowing lane
+    for (int i = 0; i < 70; i++) {
+        Vehicle* v = &vehicles[n++];
+        memset(v, 0, sizeof(*v));
+        snprintf(v->id, VEHICLE_ID_LEN, "b%d", i);
+        v->start_road = (i < 60) ? NORTH : (uint8_t)(i % ROAD_COUNT);
+        v->end_road = (i % 7 == 3) ? EAST : SOUTH;
+        v->arrival_step = (uint32_t)i;
+    }
+    vehicles[5].start_road = 9;
+
+    uint32_t expected = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        expected += traffic_add_vehicle(&single, vehicles[i].id, vehicles[i].start_road, vehicles[i].end_road,
+                                        vehicles[i].arrival_step);
+    }
+    ASSERT_EQ_INT((int)expected, (int)traffic_add_vehicles(&batched, vehicles, n), "Same vehicles should be added");
+
+    bool same = true;
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            const VehicleQueue* a = &batched.queues[road][lane];
+            const VehicleQueue* b = &single.queues[road][lane];
+            same = same && queue_count(a) == queue_count(b);
+            for (uint16_t i = 0; same && i < queue_count(a); i++) {
+                same = strcmp(queue_vehicle_at(a, i)->id, queue_vehicle_at(b, i)->id) == 0 &&
+                       queue_vehicle_at(a, i)->arrival_step == queue_vehicle_at(b, i)->arrival_step;
+            }
+        }
+    }
+    ASSERT_TRUE(same, "Lanes should hold the same vehicles in the same order");
+    ASSERT_TRUE(queue_is_full(&batched.queues[NORTH][LANE_STRAIGHT_RIGHT]), "Overflowing lane should be full");
+}
+
+#ifdef TRAFFIC_FROZEN_TIMING
+void test_frozen_build_ignores_timing() {
+    TimingConfig frozen = TRAFFIC_FROZEN_TIMING;
+    TrafficSystem a, b;
+    char out_ids[8][32];
+
+    traffic_init(&a, frozen);
+    b = create_test_system(); // Another timing, stored but not used
+    for (int i = 0; i < 200; i++) {
+        if (i % 3 == 0) {
+            traffic_add_vehicle(&a, "v", (Direction)(i % ROAD_COUNT), (Direction)((i + 2) % ROAD_COUNT), i);
+            traffic_add_vehicle(&b, "v", (Direction)(i % ROAD_COUNT), (Direction)((i + 2) % ROAD_COUNT), i);
+        }
+        traffic_fsm_step(&a, out_ids);
+        traffic_fsm_step(&b, out_ids);
+        if (a.current_state != b.current_state) break;
+    }
+    ASSERT_EQ_INT(a.current_state, b.current_state, "Both systems should follow the compiled-in timing");
+    ASSERT_EQ_INT(a.stats.departures, b.stats.departures, "Departures should match");
+    ASSERT_EQ_INT(10, b.timing.green_st, "Configured timing is still stored");
+}
+#endif
+
 int main() {
     printf("\n=== TRAFFIC FSM TESTS ===\n\n");
 
@@ -334,15 +659,32 @@ int main() {
     RUN_TEST(test_routing_left_turn);
     RUN_TEST(test_queue_overflow_via_fsm);
     RUN_TEST(test_fsm_state_transitions);
-    RUN_TEST(test_fsm_transitions_with_custom_times);
     RUN_TEST(test_light_colors_logic);
     RUN_TEST(test_vehicle_discharge_logic);
     RUN_TEST(test_fsm_full_cycle_wrap);
-    RUN_TEST(test_left_turn_gets_green_time);
     RUN_TEST(test_zero_timing_config);
-    RUN_TEST(test_phase_skipping_empty_lanes);
     RUN_TEST(test_green_extension_basic);
     RUN_TEST(test_green_arrow_right_turns);
+    RUN_TEST(test_strategy_selection);
+    RUN_TEST(test_strategy_v3_has_no_arrows);
+    RUN_TEST(test_update_timing_keeps_queues);
+    RUN_TEST(test_update_timing_in_all_red_applies_immediately);
+    RUN_TEST(test_timing_plans_switch_at_start_step);
+    RUN_TEST(test_run_matches_step_by_step);
+    RUN_TEST(test_run_in_chunks);
+    RUN_TEST(test_run_without_sink);
+    RUN_TEST(test_add_vehicles_batch);
+#ifndef TRAFFIC_FROZEN_TIMING
+    // These depend on a custom timing, which the frozen build ignores
+    RUN_TEST(test_fsm_transitions_with_custom_times);
+    RUN_TEST(test_left_turn_gets_green_time);
+    RUN_TEST(test_phase_skipping_empty_lanes);
+    RUN_TEST(test_strategy_v1_runs_empty_phases);
+    RUN_TEST(test_strategy_v2_never_extends);
+    RUN_TEST(test_strategy_v5_extends_beyond_limit);
+#else
+    RUN_TEST(test_frozen_build_ignores_timing);
+#endif
 
     PRINT_TEST_RESULTS();
 
@@ -0,0 +1,84 @@
+#include "test_utils.h"
+#include "wait_histogram.h"
+#include <stdio.h>
+
+int tests_run = 0;
+int tests_failed = 0;
+
+void test_buckets_cover_all_waits() {
+    for (uint32_t wait = 0; wait < 200000; wait++) {
+        uint8_t bucket = wait_hist_bucket(wait);
+        if (bucket == WAIT_HIST_BUCKETS - 1) {
+            ASSERT_TRUE(wait >= wait_hist_bucket_min(bucket), "Clamped wait below last bucket");
+            continue;
+        }
+        ASSERT_TRUE(wait >= wait_hist_bucket_min(bucket) && wait <= wait_hist_bucket_max(bucket),
+                    "Wait outside its bucket bounds");
+    }
+    ASSERT_EQ_INT(wait_hist_bucket(UINT32_MAX), WAIT_HIST_BUCKETS - 1, "Huge waits should be clamped");
+}
+
+void test_small_waits_are_exact() {
+    for (uint32_t wait = 0; wait < WAIT_HIST_LINEAR_LIMIT; wait++) {
+        ASSERT_EQ_INT(wait_hist_bucket_min(wait_hist_bucket(wait)), wait, "Linear range must be exact");
+        ASSERT_EQ_INT(wait_hist_bucket_max(wait_hist_bucket(wait)), wait, "Linear range must be exact");
+    }
+}
+
+void test_relative_error_bounded() {
+    for (uint8_t bucket = WAIT_HIST_LINEAR_LIMIT; bucket < WAIT_HIST_BUCKETS - 1; bucket++) {
+        uint32_t lo = wait_hist_bucket_min(bucket);
+        uint32_t hi = wait_hist_bucket_max(bucket);
+        ASSERT_TRUE((hi - lo + 1) * WAIT_HIST_SUB_BUCKETS <= lo, "Bucket wider than 1/SUB_BUCKETS of its value");
+    }
+}
+
+void test_percentiles() {
+    WaitHistogram h;
+    wait_hist_init(&h);
+    ASSERT_EQ_INT(wait_hist_percentile(&h, 500), 0, "Empty histogram should report 0");
+
+    // 90 departures with wait 2, 10 with wait 40
+    for (int i = 0; i < 90; i++) wait_hist_record(&h, 2);
+    for (int i = 0; i < 10; i++) wait_hist_record(&h, 40);
+
+    ASSERT_EQ_INT(wait_hist_total(&h), 100, "Total count incorrect");
+    ASSERT_EQ_INT(wait_hist_percentile(&h, 500), 2, "P50 should be exact in linear range");
+    ASSERT_EQ_INT(wait_hist_percentile(&h, 900), 2, "P90 is the last short wait");
+    ASSERT_EQ_INT(wait_hist_percentile(&h, 950), wait_hist_bucket_max(wait_hist_bucket(40)), "P95 in the tail bucket");
+    ASSERT_TRUE(wait_hist_percentile(&h, 990) >= 40, "Percentile must not underestimate");
+}
+
+void test_merge_matches_combined_recording() {
+    WaitHistogram a, b, combined;
+    wait_hist_init(&a);
+    wait_hist_init(&b);
+    wait_hist_init(&combined);
+
+    for (uint32_t wait = 0; wait < 300; wait += 7) {
+        wait_hist_record(&a, wait);
+        wait_hist_record(&combined, wait);
+    }
+    for (uint32_t wait = 3; wait < 900; wait += 11) {
+        wait_hist_record(&b, wait);
+        wait_hist_record(&combined, wait);
+    }
+
+    wait_hist_merge(&a, &b);
+    ASSERT_TRUE(memcmp(&a, &combined, sizeof(WaitHistogram)) == 0, "Merged histogram differs");
+    ASSERT_EQ_INT(wait_hist_percentile(&a, 990), wait_hist_percentile(&combined, 990), "Merged P99 differs");
+}
+
+int main() {
+    printf("\n=== WAIT HISTOGRAM TESTS ===\n\n");
+
+    RUN_TEST(test_buckets_cover_all_waits);
+    RUN_TEST(test_small_waits_are_exact);
+    RUN_TEST(test_relative_error_bounded);
+    RUN_TEST(test_percentiles);
+    RUN_TEST(test_merge_matches_combined_recording);
+
+    PRINT_TEST_RESULTS();
+
+    return (tests_failed == 0) ? 0 : 1;
+}
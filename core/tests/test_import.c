@@ -0,0 +1,284 @@
+#include "test_utils.h"
+#include "traffic_import.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+int tests_run = 0;
+int tests_failed = 0;
+
+#define MAX_RECORDS 4096
+
+/**
+ * @brief Sink recording the replayed events.
+ */
+typedef struct {
+    char ids[MAX_RECORDS][VEHICLE_ID_LEN];
+    Direction start[MAX_RECORDS];
+    Direction end[MAX_RECORDS];
+    uint32_t step[MAX_RECORDS];
+    uint32_t count;
+    uint32_t steps; // Steps received so far
+    bool step_mismatch; // A vehicle arrived at a step other than the steps received
+} Recorder;
+
+static Recorder rec;
+
+static void record_vehicle(void* ctx, const char* id, Direction start, Direction end, uint32_t step) {
+    Recorder* r = ctx;
+    if (r->count < MAX_RECORDS) {
+        snprintf(r->ids[r->count], VEHICLE_ID_LEN, "%s", id);
+        r->start[r->count] = start;
+        r->end[r->count] = end;
+        r->step[r->count] = step;
+    }
+    r->step_mismatch |= step != r->steps;
+    r->count++;
+}
+
+static void record_steps(void* ctx, uint32_t count) {
+    ((Recorder*)ctx)->steps += count;
+}
+
+/**
+ * @brief Imports a string from an exact-size heap copy (out-of-bounds reads show under sanitizers).
+ */
+static bool import(const char* csv, const ImportOptions* options, ImportStats* stats) {
+    size_t len = strlen(csv);
+    char* copy = malloc(len > 0 ? len : 1);
+    memcpy(copy, csv, len);
+    memset(&rec, 0, sizeof(rec));
+
+    ImportSink sink = {.add_vehicle = record_vehicle, .step = record_steps, .ctx = &rec};
+    bool ok = traffic_import_csv(copy, len, options, &sink, stats);
+    free(copy);
+    return ok;
+}
+
+void test_basic_log_with_header() {
+    ImportStats stats;
+    bool ok = import("timestamp,approach,movement,vehicle_id\n"
+                     "100,north,straight,a\n"
+                     "100.5,E,left,b\n"
+                     "102,2,right,c\n",
+                     NULL, &stats);
+
+    ASSERT_TRUE(ok, "Import should succeed");
+    ASSERT_TRUE(stats.header, "First line should be taken as a header");
+    ASSERT_EQ_INT(4, (int)stats.lines, "Lines counted");
+    ASSERT_EQ_INT(3, (int)stats.vehicles, "Three vehicles");
+    ASSERT_EQ_INT(0, (int)stats.malformed, "No malformed line");
+    ASSERT_EQ_INT(2, (int)stats.steps, "Steps up to the last record");
+    ASSERT_EQ_INT(3, (int)rec.count, "Three vehicles delivered");
+
+    ASSERT_TRUE(strcmp(rec.ids[0], "a") == 0, "First ID");
+    ASSERT_EQ_INT(NORTH, rec.start[0], "north");
+    ASSERT_EQ_INT(SOUTH, rec.end[0], "Straight from north exits south");
+    ASSERT_EQ_INT(0, (int)rec.step[0], "First record at step 0");
+
+    ASSERT_EQ_INT(EAST, rec.start[1], "E");
+    ASSERT_EQ_INT(SOUTH, rec.end[1], "Left from east exits south");
+    ASSERT_EQ_INT(0, (int)rec.step[1], "Half a second later: same step");
+
+    ASSERT_EQ_INT(SOUTH, rec.start[2], "Approach 2 is south");
+    ASSERT_EQ_INT(EAST, rec.end[2], "Right from south exits east");
+    ASSERT_EQ_INT(2, (int)rec.step[2], "Two seconds later: step 2");
+    ASSERT_TRUE(!rec.step_mismatch, "Vehicles are added after their steps");
+}
+
+void test_tokens_are_case_insensitive() {
+    ImportStats stats;
+    import("0,NORTH,Through,a\n0,west,T,b\n0,s,L,c\n0,3,r,d\n0,East,STRAIGHT,e\n", NULL, &stats);
+
+    ASSERT_EQ_INT(5, (int)rec.count, "All tokens accepted");
+    ASSERT_TRUE(!stats.header, "No header");
+    ASSERT_EQ_INT(SOUTH, rec.end[0], "Through = straight");
+    ASSERT_EQ_INT(EAST, rec.end[1], "T from west exits east");
+    ASSERT_EQ_INT(WEST, rec.end[2], "Left from south exits west");
+    ASSERT_EQ_INT(SOUTH, rec.end[3], "Right from west exits south");
+    ASSERT_EQ_INT(WEST, rec.end[4], "STRAIGHT from east exits west");
+
+    import("0,nort,straight,a\n0,north,straighter,b\n0,northx,left,c\n0,4,left,d\n0,n,u,e\n0,,left,f\n", NULL, &stats);
+    ASSERT_EQ_INT(0, (int)rec.count, "Near misses are rejected");
+    ASSERT_EQ_INT(5, (int)stats.malformed, "Counted as malformed (the first as header)");
+}
+
+void test_iso_timestamps() {
+    ImportStats stats;
+    ImportOptions options = IMPORT_DEFAULT_OPTIONS;
+    options.step_ms = 500;
+    import("2024-03-01T08:00:00Z,N,S,a\n"
+           "2024-03-01 08:00:00.250,N,S,b\n"
+           "2024-03-01T08:00:01.5,N,S,c\n"
+           "2024-03-01T08:01:00.000Z,N,S,d\n",
+           &options, &stats);
+
+    ASSERT_EQ_INT(4, (int)rec.count, "ISO timestamps accepted");
+    ASSERT_EQ_INT(0, (int)rec.step[1], "250 ms: step 0 of 500 ms");
+    ASSERT_EQ_INT(3, (int)rec.step[2], "1.5 s: step 3");
+    ASSERT_EQ_INT(120, (int)rec.step[3], "One minute: step 120");
+
+    int64_t ms;
+    ASSERT_TRUE(traffic_import_parse_time("1970-01-01T00:00:00", 19, 1000, &ms) && ms == 0, "Epoch");
+    ASSERT_TRUE(traffic_import_parse_time("2000-03-01T00:00:00Z", 20, 1000, &ms) && ms == 951868800000LL,
+                "Leap year date");
+    ASSERT_TRUE(!traffic_import_parse_time("2024-13-01T00:00:00", 19, 1000, &ms), "Month 13 rejected");
+    ASSERT_TRUE(!traffic_import_parse_time("2024-01-01T00:00:00.", 20, 1000, &ms), "Empty fraction rejected");
+    ASSERT_TRUE(!traffic_import_parse_time("2024-01-01T00:00:00+01:00", 25, 1000, &ms), "Offsets rejected");
+}
+
+void test_numeric_timestamps() {
+    int64_t ms;
+    ASSERT_TRUE(traffic_import_parse_time("12", 2, 1000, &ms) && ms == 12000, "Seconds");
+    ASSERT_TRUE(traffic_import_parse_time("12.3456", 7, 1000, &ms) && ms == 12345, "Fraction truncated to ms");
+    ASSERT_TRUE(traffic_import_parse_time("1700000000.107", 14, 1000, &ms) && ms == 1700000000107LL,
+                "Epoch seconds over 8 digits");
+    ASSERT_TRUE(traffic_import_parse_time("1234567890123", 13, 1, &ms) && ms == 1234567890123LL,
+                "Epoch milliseconds");
+    ASSERT_TRUE(traffic_import_parse_time("-1.5", 4, 1000, &ms) && ms == -1500, "Negative");
+    ASSERT_TRUE(traffic_import_parse_time("0.123456789012", 14, 1000, &ms) && ms == 123,
+                "Digits beyond 10^-9 ignored");
+    ASSERT_TRUE(traffic_import_parse_time("7.9", 3, 1, &ms) && ms == 7, "Sub-unit fraction of ms");
+    ASSERT_TRUE(!traffic_import_parse_time("12.", 3, 1000, &ms), "Empty fraction rejected");
+    ASSERT_TRUE(!traffic_import_parse_time("", 0, 1000, &ms), "Empty rejected");
+    ASSERT_TRUE(!traffic_import_parse_time(".5", 2, 1000, &ms), "Missing whole part rejected");
+    ASSERT_TRUE(!traffic_import_parse_time("12a", 3, 1000, &ms), "Trailing garbage rejected");
+    ASSERT_TRUE(!traffic_import_parse_time("1.2.3", 5, 1000, &ms), "Two points rejected");
+    ASSERT_TRUE(!traffic_import_parse_time("1234567890123456789", 19, 1, &ms), "Over 18 digits rejected");
+
+    // Digits past the field length are never read
+    ASSERT_TRUE(traffic_import_parse_time("1234", 2, 1000, &ms) && ms == 12000, "Field length respected");
+}
+
+void test_quotes_crlf_and_blank_lines() {
+    ImportStats stats;
+    import("\"time\",\"approach\",\"movement\",\"id\"\r\n"
+           "\r\n"
+           "1 , north , left , a \r\n"
+           "2,\"west\",\"right\",\"b,\"\"x\"\"\"\r\n"
+           "\n"
+           "3,S,S,\"multi\nline\"\n"
+           "4,E,L,\n"
+           "5,N,R,tail",
+           NULL, &stats);
+
+    ASSERT_TRUE(stats.header, "Quoted header");
+    ASSERT_EQ_INT(5, (int)rec.count, "Five vehicles");
+    ASSERT_EQ_INT(0, (int)stats.malformed, "Blank lines are not malformed");
+    ASSERT_TRUE(strcmp(rec.ids[0], "a") == 0, "Spaces trimmed");
+    ASSERT_EQ_INT(EAST, rec.end[0], "Left from north exits east");
+    ASSERT_TRUE(strcmp(rec.ids[1], "b,\"x\"") == 0, "Quoted comma and escaped quotes");
+    ASSERT_EQ_INT(SOUTH, rec.end[1], "Right from west exits south");
+    ASSERT_TRUE(strcmp(rec.ids[2], "multi\nline") == 0, "Newline inside quotes");
+    ASSERT_TRUE(strcmp(rec.ids[3], "v7") == 0, "Empty ID named after its line (quoted newlines do not count)");
+    ASSERT_TRUE(strcmp(rec.ids[4], "tail") == 0, "Last line without newline");
+    ASSERT_EQ_INT(4, (int)rec.step[4], "Steps continue after the quoted lines");
+}
+
+void test_late_and_malformed_records() {
+    ImportStats stats;
+    import("10,N,S,a\n"
+           "12,N,S,b\n"
+           "11,E,S,late\n"
+           "oops,N,S,c\n"
+           "13,N\n"
+           "13,N,S,d,extra,columns\n",
+           NULL, &stats);
+
+    ASSERT_TRUE(!stats.header, "First line is data");
+    ASSERT_EQ_INT(4, (int)rec.count, "Four vehicles");
+    ASSERT_EQ_INT(1, (int)stats.late, "One late record");
+    ASSERT_EQ_INT(2, (int)rec.step[2], "Late record joins the current step");
+    ASSERT_EQ_INT(2, (int)stats.malformed, "Two malformed lines");
+    ASSERT_EQ_INT(4, (int)stats.first_malformed_line, "First malformed line");
+    ASSERT_TRUE(strcmp(rec.ids[3], "d") == 0, "Extra columns ignored");
+    ASSERT_EQ_INT(3, (int)rec.step[3], "Step 3");
+}
+
+void test_origin_drain_and_long_ids() {
+    ImportStats stats;
+    ImportOptions options = {.step_ms = 100, .unit_ms = 1, .origin_ms = 1000, .drain_steps = 7};
+    import("1250,N,S,0123456789012345678901234567890123456789\n"
+           "900,N,S,early\n",
+           &options, &stats);
+
+    ASSERT_EQ_INT(2, (int)rec.count, "Two vehicles");
+    ASSERT_EQ_INT(2, (int)rec.step[0], "250 ms after the origin: step 2");
+    ASSERT_EQ_INT(VEHICLE_ID_LEN - 1, (int)strlen(rec.ids[0]), "Long ID truncated");
+    ASSERT_EQ_INT(1, (int)stats.late, "Record before the current step is late");
+    ASSERT_EQ_INT(9, (int)stats.steps, "Two steps plus the drain");
+    ASSERT_EQ_INT(9, (int)rec.steps, "Sink received the drain");
+
+    options.step_ms = 0;
+    ASSERT_TRUE(!import("1,N,S,a\n", &options, NULL), "Step of 0 ms rejected");
+
+    options = (ImportOptions){.step_ms = 1, .unit_ms = 1000, .origin_ms = 0, .drain_steps = 0};
+    ASSERT_TRUE(!import("9999999999,N,S,a\n", &options, NULL), "Step beyond 32 bits rejected");
+
+    ASSERT_TRUE(import("", NULL, &stats), "Empty log");
+    ASSERT_EQ_INT(0, (int)stats.lines, "No lines");
+}
+
+void test_generated_log_round_trip() {
+    static const char* const ROADS[] = {"north", "E", "2", "West"};
+    static const char* const MOVES[] = {"left", "straight", "R", "through"};
+    size_t cap = MAX_RECORDS * 64;
+    char* csv = malloc(cap);
+    size_t len = 0;
+    uint32_t seed = 12345;
+    uint32_t expected_step[MAX_RECORDS];
+    uint32_t ms = 0, origin = 0;
+
+    len += (size_t)snprintf(csv + len, cap - len, "ts,approach,movement,id\n");
+    for (uint32_t i = 0; i < MAX_RECORDS; i++) {
+        seed = seed * 1103515245u + 12345u;
+        ms += (seed >> 16) % 700;
+        origin = i == 0 ? ms : origin;
+        expected_step[i] = (ms - origin) / 1000;
+        // Varying widths and quoting move the fields across 64-byte blocks
+        len += (size_t)snprintf(csv + len, cap - len, (seed >> 8) % 13 == 0 ? "%u.%03u,%s,%s,\"id%u\"\n"
+                                                                           : "%u.%03u,%s,%s,id%u\n",
+                                ms / 1000, ms % 1000, ROADS[(seed >> 20) % 4], MOVES[(seed >> 24) % 4], i);
+    }
+    csv[len] = '\0';
+
+    ImportStats stats;
+    import(csv, NULL, &stats);
+    free(csv);
+
+    ASSERT_EQ_INT(MAX_RECORDS, (int)rec.count, "Every record delivered");
+    ASSERT_EQ_INT(0, (int)stats.malformed, "No malformed record");
+    ASSERT_TRUE(!rec.step_mismatch, "Vehicles added after their steps");
+
+    bool ids_ok = true, steps_ok = true, roads_ok = true;
+    seed = 12345;
+    for (uint32_t i = 0; i < MAX_RECORDS; i++) {
+        char id[16];
+        seed = seed * 1103515245u + 12345u;
+        snprintf(id, sizeof(id), "id%u", i);
+        ids_ok &= strcmp(rec.ids[i], id) == 0;
+        steps_ok &= rec.step[i] == expected_step[i];
+        uint32_t road = (seed >> 20) % 4, move = (seed >> 24) % 4;
+        uint32_t turn = move == 0 ? LEFT_TURN_DIFF : (move == 2 ? 3 : 2);
+        roads_ok &= rec.start[i] == (Direction)road && rec.end[i] == (Direction)((road + turn) % DIRECTION_MOD);
+    }
+    ASSERT_TRUE(ids_ok, "IDs in order");
+    ASSERT_TRUE(steps_ok, "Steps match the timestamps");
+    ASSERT_TRUE(roads_ok, "Approaches and movements match");
+}
+
+int main() {
+    printf("\n=== DETECTOR LOG IMPORT TESTS ===\n\n");
+
+    RUN_TEST(test_basic_log_with_header);
+    RUN_TEST(test_tokens_are_case_insensitive);
+    RUN_TEST(test_iso_timestamps);
+    RUN_TEST(test_numeric_timestamps);
+    RUN_TEST(test_quotes_crlf_and_blank_lines);
+    RUN_TEST(test_late_and_malformed_records);
+    RUN_TEST(test_origin_drain_and_long_ids);
+    RUN_TEST(test_generated_log_round_trip);
+
+    PRINT_TEST_RESULTS();
+
+    return (tests_failed == 0) ? 0 : 1;
+}
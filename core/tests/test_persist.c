@@ -0,0 +1,264 @@
+#include "test_utils.h"
+#include "traffic_persist.h"
+#include <stdio.h>
+
+int tests_run = 0;
+int tests_failed = 0;
+
+#define PAGE_SIZE 1024
+#define PAGE_COUNT 4
+
+/**
+ * @brief NOR flash emulation: erase sets 0xFF, programming needs erased bytes.
+ * A non-negative budget cuts the next writes short to emulate a reset,
+ * cut_after_erase (if non-negative) becomes the budget after the next erase.
+ */
+typedef struct {
+    uint8_t mem[PAGE_SIZE * PAGE_COUNT];
+    uint32_t erase_count[PAGE_COUNT];
+    int budget;
+    int cut_after_erase;
+} RamFlash;
+
+static RamFlash ram;
+
+bool ram_erase(void* ctx, uint16_t page) {
+    RamFlash* f = ctx;
+    memset(&f->mem[page * PAGE_SIZE], 0xFF, PAGE_SIZE);
+    f->erase_count[page]++;
+    if (f->cut_after_erase >= 0) {
+        f->budget = f->cut_after_erase;
+        f->cut_after_erase = -1;
+    }
+    return true;
+}
+
+bool ram_program(void* ctx, uint32_t offset, const uint8_t* data, uint32_t len) {
+    RamFlash* f = ctx;
+    if (offset % PERSIST_WRITE_ALIGN != 0 || len % PERSIST_WRITE_ALIGN != 0) return false;
+
+    for (uint32_t i = 0; i < len; i++) {
+        if (f->mem[offset + i] != 0xFF) return false;
+        if (f->budget == 0) return false;
+        if (f->budget > 0) f->budget--;
+        f->mem[offset + i] = data[i];
+    }
+    return true;
+}
+
+static const PersistFlash flash = {
+    .base = ram.mem, .page_size = PAGE_SIZE, .page_count = PAGE_COUNT,
+    .erase = ram_erase, .program = ram_program, .ctx = &ram
+};
+
+static PersistStore store;
+
+void reset_flash() {
+    memset(&ram, 0, sizeof(ram));
+    memset(ram.mem, 0xFF, sizeof(ram.mem));
+    ram.budget = -1;
+    ram.cut_after_erase = -1;
+}
+
+void add_traffic(TrafficSystem* sys, uint32_t steps) {
+    char out_ids[ROAD_COUNT * LANES_PER_ROAD][VEHICLE_ID_LEN];
+    for (uint32_t step = 0; step < steps; step++) {
+        char id[VEHICLE_ID_LEN];
+        sprintf(id, "v%u", step);
+        traffic_add_vehicle(sys, id, step % ROAD_COUNT, (step + 2) % ROAD_COUNT, sys->current_step);
+        traffic_fsm_step(sys, out_ids);
+    }
+}
+
+void test_empty_store() {
+    TrafficSystem sys;
+    reset_flash();
+
+    ASSERT_TRUE(persist_mount(&store, &flash), "Empty region should mount");
+    sys.current_step = 77;
+    ASSERT_EQ_INT(PERSIST_RESTORED_NONE, persist_restore(&store, &sys), "Nothing to restore");
+    ASSERT_EQ_INT(77, sys.current_step, "System should be untouched");
+
+    memset(ram.mem, 0x5A, sizeof(ram.mem)); // Foreign data
+    ASSERT_TRUE(persist_mount(&store, &flash), "Foreign data should mount");
+    TimingConfig config = DEFAULT_TIMING;
+    ASSERT_TRUE(persist_save_config(&store, &config), "First write should erase a page");
+}
+
+void test_config_survives_reboot() {
+    TimingConfig config = DEFAULT_TIMING;
+    TrafficSystem sys;
+    reset_flash();
+
+    persist_mount(&store, &flash);
+    config.green_st = 9;
+    ASSERT_TRUE(persist_save_config(&store, &config), "Config should be written");
+
+    persist_mount(&store, &flash);
+    ASSERT_EQ_INT(PERSIST_RESTORED_CONFIG, persist_restore(&store, &sys), "Config should be restored");
+    ASSERT_EQ_INT(9, sys.timing.green_st, "Timing should match");
+    ASSERT_EQ_INT(1, sys.timing.red_yellow, "All fields should be stored");
+    ASSERT_EQ_INT(STATE_ALL_RED, sys.current_state, "Boot should start in All-Red");
+}
+
+void test_checkpoint_until_newer_config() {
+    TimingConfig config = DEFAULT_TIMING;
+    TrafficSystem sys, restored;
+    reset_flash();
+
+    persist_mount(&store, &flash);
+    persist_save_config(&store, &config);
+    traffic_init(&sys, config);
+    add_traffic(&sys, 20);
+    ASSERT_TRUE(persist_save_checkpoint(&store, &sys), "Checkpoint should be written");
+
+    persist_mount(&store, &flash);
+    ASSERT_EQ_INT(PERSIST_RESTORED_CHECKPOINT, persist_restore(&store, &restored), "Checkpoint should win");
+    ASSERT_EQ_INT(sys.current_step, restored.current_step, "Step should match");
+    ASSERT_EQ_INT(sys.stats.departures, restored.stats.departures, "Statistics should match");
+
+    config.green_lt = 6;
+    persist_save_config(&store, &config);
+    persist_mount(&store, &flash);
+    ASSERT_EQ_INT(PERSIST_RESTORED_CONFIG, persist_restore(&store, &restored), "Newer config makes the checkpoint stale");
+    ASSERT_EQ_INT(0, restored.current_step, "System should start fresh");
+}
+
+void test_wear_levelling() {
+    TimingConfig config = DEFAULT_TIMING;
+    TrafficSystem sys;
+    reset_flash();
+
+    persist_mount(&store, &flash);
+    for (uint32_t i = 1; i <= 500; i++) {
+        config.max_ext = i;
+        ASSERT_TRUE(persist_save_config(&store, &config), "Config should be written");
+        if (i % 97 == 0) {
+            persist_mount(&store, &flash); // Reboots in between
+        }
+    }
+
+    uint32_t min = ram.erase_count[0], max = ram.erase_count[0];
+    for (int page = 1; page < PAGE_COUNT; page++) {
+        if (ram.erase_count[page] < min) min = ram.erase_count[page];
+        if (ram.erase_count[page] > max) max = ram.erase_count[page];
+    }
+    ASSERT_TRUE(min > 0 && max - min <= 1, "Erases should be spread over all pages");
+
+    persist_mount(&store, &flash);
+    persist_restore(&store, &sys);
+    ASSERT_EQ_INT(500, sys.timing.max_ext, "Newest config should win");
+}
+
+void test_torn_write_keeps_previous() {
+    TimingConfig config = DEFAULT_TIMING;
+    TrafficSystem sys;
+    reset_flash();
+
+    persist_mount(&store, &flash);
+    config.yellow = 3;
+    persist_save_config(&store, &config);
+
+    ram.budget = 10; // Reset in the middle of the next record
+    config.yellow = 4;
+    ASSERT_TRUE(!persist_save_config(&store, &config), "Torn write should fail");
+    ram.budget = -1;
+
+    persist_mount(&store, &flash);
+    ASSERT_EQ_INT(PERSIST_RESTORED_CONFIG, persist_restore(&store, &sys), "Previous config should survive");
+    ASSERT_EQ_INT(3, sys.timing.yellow, "Torn record should be ignored");
+
+    config.yellow = 5;
+    ASSERT_TRUE(persist_save_config(&store, &config), "Writing should continue after a torn record");
+    persist_mount(&store, &flash);
+    persist_restore(&store, &sys);
+    ASSERT_EQ_INT(5, sys.timing.yellow, "New config should be found");
+}
+
+void test_checkpoints_keep_config_alive() {
+    TimingConfig config = DEFAULT_TIMING;
+    TrafficSystem sys, restored;
+    reset_flash();
+
+    persist_mount(&store, &flash);
+    config.skip_limit = 4;
+    persist_save_config(&store, &config);
+    traffic_init(&sys, config);
+
+    // Enough checkpoints to erase every page several times
+    for (int i = 0; i < 60; i++) {
+        add_traffic(&sys, 3);
+        ASSERT_TRUE(persist_save_checkpoint(&store, &sys), "Checkpoint should be written");
+    }
+    ASSERT_TRUE(ram.erase_count[0] > 1, "Every page should have been recycled");
+
+    persist_mount(&store, &flash);
+    ASSERT_TRUE(store.has_config && store.config.skip_limit == 4, "Config should be carried over");
+    ASSERT_EQ_INT(PERSIST_RESTORED_CHECKPOINT, persist_restore(&store, &restored), "Newest checkpoint should win");
+    ASSERT_EQ_INT(sys.current_step, restored.current_step, "Latest checkpoint should be restored");
+}
+
+void test_reset_after_erase_keeps_config() {
+    TimingConfig config = DEFAULT_TIMING;
+    TrafficSystem sys, restored;
+    uint32_t saved_step = 0;
+    reset_flash();
+
+    persist_mount(&store, &flash);
+    config.skip_limit = 4;
+    persist_save_config(&store, &config);
+    traffic_init(&sys, config);
+    for (int i = 0; i < 30; i++) {
+        add_traffic(&sys, 3);
+        persist_save_checkpoint(&store, &sys);
+    }
+    ASSERT_TRUE(ram.erase_count[0] > 1, "Ring should have wrapped");
+
+    // Reset during the first record written after the next erase
+    ram.cut_after_erase = 64;
+    for (int i = 0; i < 60; i++) {
+        saved_step = sys.current_step;
+        add_traffic(&sys, 3);
+        if (!persist_save_checkpoint(&store, &sys)) break;
+    }
+    ASSERT_EQ_INT(0, ram.budget, "Write after the erase should have been cut");
+    ram.budget = -1;
+
+    persist_mount(&store, &flash);
+    ASSERT_TRUE(store.has_config && store.config.skip_limit == 4, "Config should survive the reset");
+    ASSERT_EQ_INT(PERSIST_RESTORED_CHECKPOINT, persist_restore(&store, &restored), "Config copy should not make the checkpoint stale");
+    ASSERT_EQ_INT(saved_step, restored.current_step, "Last complete checkpoint should be restored");
+}
+
+void test_oversized_checkpoint_rejected() {
+    TimingConfig config = DEFAULT_TIMING;
+    TrafficSystem sys;
+    reset_flash();
+
+    persist_mount(&store, &flash);
+    traffic_init(&sys, config);
+    for (int i = 0; i < 200; i++) {
+        char id[VEHICLE_ID_LEN];
+        sprintf(id, "waiting_vehicle_%d", i);
+        traffic_add_vehicle(&sys, id, NORTH, SOUTH, 0);
+    }
+    ASSERT_TRUE(!persist_save_checkpoint(&store, &sys), "Snapshot larger than a page should be rejected");
+    ASSERT_TRUE(!store.has_checkpoint, "Store should be unchanged");
+}
+
+int main() {
+    printf("\n=== PERSIST TESTS ===\n\n");
+
+    RUN_TEST(test_empty_store);
+    RUN_TEST(test_config_survives_reboot);
+    RUN_TEST(test_checkpoint_until_newer_config);
+    RUN_TEST(test_wear_levelling);
+    RUN_TEST(test_torn_write_keeps_previous);
+    RUN_TEST(test_checkpoints_keep_config_alive);
+    RUN_TEST(test_reset_after_erase_keeps_config);
+    RUN_TEST(test_oversized_checkpoint_rejected);
+
+    PRINT_TEST_RESULTS();
+
+    return (tests_failed == 0) ? 0 : 1;
+}
@@ -70,6 +70,131 @@ void test_circular_behavior() {
     ASSERT_EQ_INT(queue_count(&q), MAX_VEHICLES_PER_ROAD - 10 + 5, "Incorrect count after wrap");
 }
 
+void test_ring_wrap() {
+    VehicleQueue q;
+    queue_init(&q);
+    
+    for (int i = 0; i < MAX_VEHICLES_PER_ROAD; i++) {
+        queue_enqueue(&q, "fill", NORTH, SOUTH, 0);
+    }
+
+    for (int i = 0; i < 40; i++) {
+        queue_dequeue(&q, NULL, 0, NULL);
+    }
+
+    for (int i = 0; i < 30; i++) {
+        char id[10];
+        sprintf(id, "w%d", i);
+        ASSERT_TRUE(queue_enqueue(&q, id, NORTH, SOUTH, 0), "Wrap-around enqueue failed");
+    }
+
+    ASSERT_EQ_INT(q.tail, QUEUE_RING_WRAP(MAX_VEHICLES_PER_ROAD + 30), "Tail index incorrect after wrap");
+    ASSERT_EQ_INT(queue_count(&q), MAX_VEHICLES_PER_ROAD - 40 + 30, "Incorrect count after wrap");
+    ASSERT_STR_EQ(queue_vehicle_at(&q, 10)->id, "w0", "Order should continue across the wrap");
+    ASSERT_STR_EQ(queue_vehicle_at(&q, 39)->id, "w29", "Last vehicle should be the newest");
+}
+
+/**
+ * Vehicles w<first>..w<first + n - 1> arriving at step 10 * i.
+ */
+static void make_vehicles(Vehicle* out, int first, int n) {
+    for (int i = 0; i < n; i++) {
+        memset(&out[i], 0, sizeof(Vehicle));
+        sprintf(out[i].id, "w%d", first + i);
+        out[i].start_road = NORTH;
+        out[i].end_road = SOUTH;
+        out[i].arrival_step = 10 * (first + i);
+    }
+}
+
+void test_bulk_across_wrap() {
+    VehicleQueue q;
+    queue_init(&q);
+    Vehicle batch[MAX_VEHICLES_PER_ROAD];
+    char id[VEHICLE_ID_LEN];
+
+    // Move head and tail close to the end of the ring
+    make_vehicles(batch, 0, 40);
+    ASSERT_EQ_INT(queue_enqueue_n(&q, batch, 40), 40, "Batch should fit");
+    for (int i = 0; i < 40; i++) {
+        queue_dequeue(&q, NULL, 400, NULL);
+    }
+    ASSERT_EQ_INT(q.head, 40, "Head after the first batch");
+
+    make_vehicles(batch, 40, 30);
+    ASSERT_EQ_INT(queue_enqueue_n(&q, batch, 30), 30, "Batch crossing the wrap should fit");
+    ASSERT_EQ_INT(q.tail, QUEUE_RING_WRAP(40 + 30), "Tail should wrap");
+
+    bool in_order = true;
+    for (int i = 0; i < 30; i++) {
+        uint32_t wait = 0;
+        queue_dequeue(&q, id, 700, &wait);
+        in_order = in_order && strcmp(id, batch[i].id) == 0 && wait == 700 - batch[i].arrival_step;
+    }
+    ASSERT_TRUE(in_order, "Vehicles should leave in arrival order");
+    ASSERT_EQ_INT(400, (int)q.max_wait_time, "Longest wait is the one of the first vehicle");
+    ASSERT_EQ_INT(70, (int)wait_hist_total(&q.wait_hist), "Every departure should be in the histogram");
+    ASSERT_TRUE(queue_is_empty(&q), "Queue should be empty");
+}
+
+void test_bulk_limits() {
+    VehicleQueue q;
+    queue_init(&q);
+    Vehicle batch[MAX_VEHICLES_PER_ROAD];
+    char id[VEHICLE_ID_LEN];
+
+    make_vehicles(batch, 0, MAX_VEHICLES_PER_ROAD);
+    ASSERT_TRUE(queue_enqueue(&q, "first", NORTH, SOUTH, 0), "Single enqueue failed");
+    ASSERT_EQ_INT(queue_enqueue_n(&q, batch, MAX_VEHICLES_PER_ROAD), MAX_VEHICLES_PER_ROAD - 1,
+                  "Only the vehicles that fit should be added");
+    ASSERT_TRUE(queue_is_full(&q), "Queue should be full");
+
+    ASSERT_EQ_INT(queue_enqueue_n(&q, batch, 1), 0, "Full queue should take nothing");
+    ASSERT_TRUE(queue_dequeue(&q, id, 0, NULL), "Single dequeue failed");
+    ASSERT_STR_EQ(id, "first", "Single and bulk operations share the queue");
+    ASSERT_TRUE(queue_dequeue(&q, id, 0, NULL), "Bulk vehicles should follow");
+    ASSERT_STR_EQ(id, "w0", "Bulk vehicles should keep their order");
+}
+
+void test_bulk_ids_normalized() {
+    VehicleQueue q;
+    queue_init(&q);
+    Vehicle batch[2];
+    char expected[VEHICLE_ID_LEN] = {0};
+
+    make_vehicles(batch, 0, 2);
+    memset(batch[0].id, 'x', VEHICLE_ID_LEN); // No terminator
+    memset(batch[1].id, '#', VEHICLE_ID_LEN);
+    strcpy(batch[1].id, "short"); // Garbage after the terminator
+
+    queue_enqueue_n(&q, batch, 2);
+
+    memset(expected, 'x', VEHICLE_ID_LEN - 1);
+    ASSERT_TRUE(memcmp(queue_vehicle_at(&q, 0)->id, expected, VEHICLE_ID_LEN) == 0,
+                "Long ID should be truncated and terminated");
+    memset(expected, 0, VEHICLE_ID_LEN);
+    strcpy(expected, "short");
+    ASSERT_TRUE(memcmp(queue_vehicle_at(&q, 1)->id, expected, VEHICLE_ID_LEN) == 0,
+                "Short ID should be zero-padded");
+}
+
+void test_peak_occupancy() {
+    VehicleQueue q;
+    queue_init(&q);
+    Vehicle batch[8];
+
+    make_vehicles(batch, 0, 8);
+    queue_enqueue(&q, "a", NORTH, SOUTH, 0);
+    queue_enqueue(&q, "b", NORTH, SOUTH, 0);
+    queue_dequeue(&q, NULL, 1, NULL);
+    ASSERT_EQ_INT(2, queue_get_peak(&q), "Peak should stay after a dequeue");
+
+    queue_enqueue_n(&q, batch, 8);
+    while (queue_dequeue(&q, NULL, 100, NULL)) {}
+    ASSERT_EQ_INT(9, queue_get_peak(&q), "Bulk enqueue should update the peak");
+    ASSERT_TRUE(queue_is_empty(&q), "Queue should be empty");
+}
+
 void test_wait_time_statistics() {
     VehicleQueue q;
     queue_init(&q);
@@ -86,6 +211,10 @@ void test_wait_time_statistics() {
     queue_dequeue(&q, NULL, 210, &wait_time); 
     ASSERT_EQ_INT(wait_time, 10, "Incorrect wait time for second car");
     ASSERT_EQ_INT(q.max_wait_time, 50, "max_wait_time should retain highest value");
+
+    ASSERT_EQ_INT(wait_hist_total(&q.wait_hist), 2, "Both departures should be in the histogram");
+    ASSERT_EQ_INT(q.wait_hist.counts[wait_hist_bucket(10)], 1, "Wait 10 should be counted");
+    ASSERT_EQ_INT(q.wait_hist.counts[wait_hist_bucket(50)], 1, "Wait 50 should be counted");
 }
 
 void test_peek() {
@@ -106,6 +235,11 @@ int main() {
     RUN_TEST(test_enqueue_dequeue_basic);
     RUN_TEST(test_full_queue_protection);
     RUN_TEST(test_circular_behavior);
+    RUN_TEST(test_ring_wrap);
+    RUN_TEST(test_bulk_across_wrap);
+    RUN_TEST(test_bulk_limits);
+    RUN_TEST(test_bulk_ids_normalized);
+    RUN_TEST(test_peak_occupancy);
     RUN_TEST(test_wait_time_statistics);
     RUN_TEST(test_peek);
 
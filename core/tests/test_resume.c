@@ -0,0 +1,190 @@
+/**
+ * Resuming a command log from a checkpoint (main_pc.c, linked with -DTRAFFIC_SIM_NO_MAIN).
+ *
+ * The log mixes control commands (CMD_GET_STATS, CMD_SESSION_*, CMD_STEP_SESSIONS)
+ * with the scenario. A run that resumes from the checkpoint saved halfway must
+ * answer exactly like the rest of a run from scratch, for files and pipes.
+ */
+
+#define _POSIX_C_SOURCE 200809L // fmemopen, open_memstream
+
+#include "test_utils.h"
+#include "protocol.h"
+#include "traffic_fsm.h"
+#include "traffic_sessions.h"
+#include "traffic_aggregate.h"
+
+int tests_run = 0;
+int tests_failed = 0;
+
+#define LOG_STEPS 120
+#define CHECKPOINT_STEP 60
+#define CHECKPOINT_FILE "bin/test_resume.ckpt"
+
+// Parser state owned by main_pc.c
+extern TrafficSystem sys;
+extern TrafficSystem* active;
+extern uint16_t active_id;
+extern SessionTable sessions;
+extern FILE* input;
+extern FILE* output;
+extern uint64_t input_offset;
+extern uint64_t resume_offset;
+extern uint64_t resume_position;
+extern bool seekable_input;
+extern const char* checkpoint_path;
+extern TrafficAggregator aggregator;
+
+bool process_commands();
+bool load_checkpoint(const char* path);
+void resume_input();
+void release_subscriptions();
+
+static uint8_t log_buf[64 * 1024];
+static size_t log_len;
+static size_t checkpoint_len; // Log bytes up to and including CMD_SAVE_CHECKPOINT
+
+static void put(uint8_t cmd, const void* payload, size_t size) {
+    log_buf[log_len++] = cmd;
+    memcpy(log_buf + log_len, payload, size);
+    log_len += size;
+}
+
+/**
+ * Scenario of session 0 with control commands between its steps.
+ */
+static void build_log() {
+    PayloadConfig config = {4, 3, 1, 3, 1, 15, 2};
+    PayloadSessionCreate create = {1, {4, 3, 1, 3, 1, 15, 2}};
+    uint16_t step_one[2] = {1, 1}; // PayloadStepSessions {count 1}, then session 1
+    uint32_t seed = 7;
+
+    log_len = 0;
+    put(CMD_CONFIG, &config, sizeof(config));
+    put(CMD_SESSION_CREATE, &create, sizeof(create));
+
+    for (uint32_t step = 0; step < LOG_STEPS; step++) {
+        for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+            seed = seed * 1103515245u + 12345u;
+            if ((seed >> 16) % 100 >= 40) continue;
+
+            PayloadAddVehicle v = {{0}, road, (uint8_t)((road + 1 + (seed >> 20) % 3) % ROAD_COUNT), step};
+            snprintf(v.vehicle_id, sizeof(v.vehicle_id), "v%u_%u", step, road);
+            put(CMD_ADD_VEHICLE, &v, sizeof(v));
+        }
+        put(CMD_STEP, NULL, 0);
+
+        if (step % 10 == 3) {
+            put(CMD_GET_STATS, NULL, 0);
+        }
+        if (step < CHECKPOINT_STEP && step % 20 == 5) {
+            put(CMD_STEP_SESSIONS, step_one, sizeof(step_one));
+            put(CMD_GET_WAIT_HISTOGRAM, NULL, 0);
+        }
+        if (step == CHECKPOINT_STEP - 1) {
+            put(CMD_SAVE_CHECKPOINT, NULL, 0);
+            checkpoint_len = log_len;
+        }
+    }
+    put(CMD_GET_STATS, NULL, 0);
+}
+
+static void reset_parser() {
+    TimingConfig config = DEFAULT_TIMING;
+    traffic_init(&sys, config);
+    active = &sys;
+    active_id = 0;
+    input_offset = 0;
+    resume_offset = 0;
+    resume_position = 0;
+    seekable_input = false;
+    checkpoint_path = NULL;
+    aggregator.mode = AGGREGATE_OFF;
+    sessions_init(&sessions, SESSION_CACHE_DEFAULT);
+}
+
+/**
+ * Runs `len` log bytes through the parser and returns the responses (malloc'd).
+ * A file stands for --input, a memory stream without seeking for a pipe.
+ */
+static char* run(size_t len, bool file, bool resume, size_t* out_len) {
+    char* responses = NULL;
+
+    input = file ? tmpfile() : fmemopen(log_buf, len, "rb");
+    if (file && input) {
+        fwrite(log_buf, 1, len, input);
+        rewind(input);
+    }
+    output = open_memstream(&responses, out_len);
+    seekable_input = file;
+    checkpoint_path = CHECKPOINT_FILE;
+
+    if (resume && load_checkpoint(CHECKPOINT_FILE)) {
+        resume_input();
+    }
+    process_commands();
+
+    fclose(input);
+    fclose(output);
+    sessions_free(&sessions);
+    release_subscriptions();
+    return responses;
+}
+
+static void test_resume(bool file) {
+    size_t prefix_len, full_len, resumed_len;
+    TrafficStats scratch_stats;
+
+    build_log();
+    remove(CHECKPOINT_FILE);
+
+    // The log as far as it was written when the checkpoint was saved
+    reset_parser();
+    free(run(checkpoint_len, file, false, &prefix_len));
+
+    reset_parser();
+    checkpoint_path = NULL;
+    char* full = run(log_len, file, false, &full_len);
+    scratch_stats = sys.stats;
+    uint32_t scratch_step = sys.current_step;
+
+    reset_parser();
+    char* resumed = run(log_len, file, true, &resumed_len);
+
+    bool same_stats = memcmp(&scratch_stats, &sys.stats, sizeof(TrafficStats)) == 0;
+    bool same_responses = resumed_len == full_len - prefix_len &&
+                          memcmp(resumed, full + prefix_len, resumed_len) == 0;
+    free(full);
+    free(resumed);
+    remove(CHECKPOINT_FILE);
+
+    ASSERT_EQ_INT(LOG_STEPS, scratch_step, "Run from scratch should take every step");
+    ASSERT_EQ_INT(scratch_step, sys.current_step, "Resumed run should end at the same step");
+    ASSERT_TRUE(same_stats, "Resumed run should match the statistics of a run from scratch");
+    ASSERT_TRUE(same_responses, "Resumed run should only answer the commands after the checkpoint");
+}
+
+void test_resume_file_with_control_commands() {
+    test_resume(true);
+}
+
+void test_resume_pipe_with_control_commands() {
+    test_resume(false);
+}
+
+int main() {
+    printf("\n=== RESUME TESTS ===\n\n");
+
+    // The parser logs every command on stderr
+    FILE* sink = fopen("/dev/null", "w");
+    if (sink) {
+        stderr = sink;
+    }
+
+    RUN_TEST(test_resume_file_with_control_commands);
+    RUN_TEST(test_resume_pipe_with_control_commands);
+
+    PRINT_TEST_RESULTS();
+
+    return (tests_failed == 0) ? 0 : 1;
+}
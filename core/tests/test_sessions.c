@@ -0,0 +1,191 @@
+#include "test_utils.h"
+#include "traffic_sessions.h"
+#include <stdio.h>
+
+int tests_run = 0;
+int tests_failed = 0;
+
+#define N_SESSIONS 6
+#define N_STEPS 120
+
+/**
+ * @brief Adds the deterministic arrivals of one session and step.
+ */
+void add_arrivals(TrafficSystem* sys, uint16_t session, uint32_t step) {
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        uint32_t hash = (step * 2654435761u) ^ (session * 40503u) ^ (road * 97u);
+        if ((hash >> 7) % 100 >= 20u + session * 5u) continue;
+
+        char id[VEHICLE_ID_LEN];
+        sprintf(id, "s%u_%u_%u", session, step, road);
+        traffic_add_vehicle(sys, id, road, (road + 1 + (hash >> 3) % 3) % ROAD_COUNT, step);
+    }
+}
+
+void test_create_and_destroy() {
+    TimingConfig config = DEFAULT_TIMING;
+    SessionTable table;
+
+    ASSERT_TRUE(sessions_init(&table, 4), "Table should initialize");
+    ASSERT_TRUE(sessions_create(&table, 7, config), "Session should be created");
+    ASSERT_TRUE(!sessions_create(&table, 7, config), "Duplicate ID should be rejected");
+    ASSERT_TRUE(sessions_create(&table, 3000, config), "Sparse IDs should be accepted");
+    ASSERT_EQ_INT(2, table.count, "Two sessions should exist");
+
+    ASSERT_TRUE(sessions_acquire(&table, 8) == NULL, "Unknown session has no system");
+    ASSERT_TRUE(sessions_destroy(&table, 7), "Session should be destroyed");
+    ASSERT_TRUE(!sessions_exists(&table, 7), "Destroyed session should be gone");
+    ASSERT_TRUE(!sessions_destroy(&table, 7), "Double destroy should fail");
+    ASSERT_TRUE(sessions_create(&table, 7, config), "ID should be reusable");
+    ASSERT_EQ_INT(0, sessions_acquire(&table, 7)->current_step, "Reused ID starts fresh");
+
+    sessions_free(&table);
+}
+
+void test_parked_sessions_match_independent_systems() {
+    TimingConfig config = DEFAULT_TIMING;
+    SessionTable table;
+    TrafficSystem reference[N_SESSIONS];
+    char out_ids[ROAD_COUNT * LANES_PER_ROAD][VEHICLE_ID_LEN];
+
+    // Fewer live slots than sessions: every round parks and unparks
+    ASSERT_TRUE(sessions_init(&table, 2), "Table should initialize");
+
+    for (uint16_t s = 0; s < N_SESSIONS; s++) {
+        config.green_st = 4 + s;
+        traffic_init(&reference[s], config);
+        ASSERT_TRUE(sessions_create(&table, s + 1, config), "Session should be created");
+    }
+
+    for (uint32_t step = 0; step < N_STEPS; step++) {
+        for (uint16_t s = 0; s < N_SESSIONS; s++) {
+            TrafficSystem* sys = sessions_acquire(&table, s + 1);
+            ASSERT_TRUE(sys != NULL, "Parked session should be restored");
+            if (!sys) continue;
+
+            add_arrivals(sys, s, step);
+            add_arrivals(&reference[s], s, step);
+            traffic_fsm_step(sys, out_ids);
+            traffic_fsm_step(&reference[s], out_ids);
+        }
+    }
+
+    for (uint16_t s = 0; s < N_SESSIONS; s++) {
+        TrafficSystem* sys = sessions_acquire(&table, s + 1);
+        ASSERT_EQ_INT(reference[s].current_state, sys->current_state, "State should match");
+        ASSERT_EQ_INT(reference[s].stats.departures, sys->stats.departures, "Departures should match");
+        ASSERT_EQ_INT((int)reference[s].stats.total_wait, (int)sys->stats.total_wait, "Total wait should match");
+        ASSERT_EQ_INT(reference[s].timing.green_st, sys->timing.green_st, "Timing should stay per session");
+    }
+
+    sessions_free(&table);
+}
+
+void test_idle_sessions_are_compact() {
+    TimingConfig config = DEFAULT_TIMING;
+    SessionTable table;
+
+    ASSERT_TRUE(sessions_init(&table, 1), "Table should initialize");
+    for (uint16_t id = 1; id <= 1000; id++) {
+        sessions_create(&table, id, config);
+    }
+    ASSERT_EQ_INT(1000, table.count, "All sessions should be created");
+
+    size_t per_session = (sessions_memory_usage(&table) - sizeof(TrafficSystem)) / table.count;
+    ASSERT_TRUE(per_session * 20 < sizeof(TrafficSystem), "Idle session should cost a small fraction of a TrafficSystem");
+
+    sessions_free(&table);
+}
+
+void test_footprint() {
+    TimingConfig config = DEFAULT_TIMING;
+    SessionTable table;
+    SessionsFootprint f;
+    SessionFootprint one;
+    char out_ids[ROAD_COUNT * LANES_PER_ROAD][VEHICLE_ID_LEN];
+
+    ASSERT_TRUE(sessions_init(&table, 1), "Table should initialize");
+    ASSERT_TRUE(sessions_create(&table, 1, config), "Session should be created");
+
+    // Session 1 queues 12 vehicles in one lane, then discharges some
+    TrafficSystem* sys = sessions_acquire(&table, 1);
+    for (int i = 0; i < 12; i++) {
+        traffic_add_vehicle(sys, "jam", NORTH, SOUTH, 0);
+    }
+    for (int i = 0; i < 30; i++) {
+        traffic_fsm_step(sys, out_ids);
+    }
+    uint16_t queued = traffic_get_queue_size(sys, NORTH, LANE_STRAIGHT_RIGHT);
+    ASSERT_TRUE(queued < 12, "Some vehicles should have left");
+
+    ASSERT_TRUE(sessions_session_footprint(&table, 1, &one), "Footprint of a live session");
+    ASSERT_TRUE(one.live, "Session should be live");
+    ASSERT_EQ_INT((int)sizeof(TrafficSystem), (int)one.bytes, "Live session costs a TrafficSystem");
+    ASSERT_EQ_INT(12, one.peak_queue, "Peak should be the longest queue");
+
+    // Creating session 2 parks session 1
+    ASSERT_TRUE(sessions_create(&table, 2, config), "Second session should be created");
+    ASSERT_TRUE(sessions_session_footprint(&table, 1, &one), "Footprint of a parked session");
+    ASSERT_TRUE(!one.live, "Session should be parked");
+    ASSERT_EQ_INT(queued, one.queued, "Parked session keeps its vehicles");
+    ASSERT_EQ_INT(12, one.peak_queue, "Peak should survive parking");
+    ASSERT_TRUE(one.bytes < sizeof(TrafficSystem) / 20, "Parked session should be compact");
+
+    sessions_acquire(&table, 1); // Unparks, parks session 2
+    ASSERT_TRUE(sessions_session_footprint(&table, 1, &one), "Footprint after unparking");
+    ASSERT_EQ_INT(12, one.peak_queue, "Peak should survive unparking");
+
+    sessions_footprint(&table, &f);
+    ASSERT_EQ_INT(2, (int)f.sessions, "Two sessions");
+    ASSERT_EQ_INT(1, (int)f.live, "One live session");
+    ASSERT_EQ_INT(1, (int)f.parked, "One parked session");
+    ASSERT_EQ_INT(12, f.peak_queue, "Longest queue of any session");
+    ASSERT_TRUE(f.total_bytes == sessions_memory_usage(&table), "Total should match the memory usage");
+    ASSERT_TRUE(f.total_bytes == f.entry_bytes + f.cache_bytes + f.parked_bytes, "Total should be the sum of its parts");
+    ASSERT_TRUE(!sessions_session_footprint(&table, 3, &one), "Unknown session has no footprint");
+
+    sessions_free(&table);
+}
+
+void test_memory_peak() {
+    TimingConfig config = DEFAULT_TIMING;
+    SessionTable table;
+
+    ASSERT_TRUE(sessions_init(&table, 1), "Table should initialize");
+    size_t empty = sessions_memory_usage(&table);
+    ASSERT_TRUE(sessions_memory_peak(&table) == empty, "Peak starts at the initial usage");
+
+    for (uint16_t id = 1; id <= 100; id++) {
+        sessions_create(&table, id, config);
+    }
+    size_t full = sessions_memory_usage(&table);
+    ASSERT_TRUE(full > empty, "Sessions should use memory");
+    ASSERT_TRUE(sessions_memory_peak(&table) == full, "Peak follows a growing usage");
+
+    for (uint16_t id = 1; id <= 100; id++) {
+        sessions_destroy(&table, id);
+    }
+    ASSERT_TRUE(sessions_memory_usage(&table) < full, "Destroyed sessions release their snapshots");
+    ASSERT_TRUE(sessions_memory_peak(&table) == full, "Peak survives destroy");
+
+    SessionsFootprint f;
+    sessions_footprint(&table, &f);
+    ASSERT_TRUE(f.total_bytes == sessions_memory_usage(&table), "Incremental usage should match the footprint");
+    ASSERT_TRUE(f.peak_bytes == full, "Footprint reports the peak");
+
+    sessions_free(&table);
+}
+
+int main() {
+    printf("\n=== SESSION TESTS ===\n\n");
+
+    RUN_TEST(test_create_and_destroy);
+    RUN_TEST(test_parked_sessions_match_independent_systems);
+    RUN_TEST(test_idle_sessions_are_compact);
+    RUN_TEST(test_footprint);
+    RUN_TEST(test_memory_peak);
+
+    PRINT_TEST_RESULTS();
+
+    return (tests_failed == 0) ? 0 : 1;
+}
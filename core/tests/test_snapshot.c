@@ -0,0 +1,183 @@
+#include "test_utils.h"
+#include "traffic_fsm.h"
+#include "traffic_snapshot.h"
+#include <stdio.h>
+
+int tests_run = 0;
+int tests_failed = 0;
+
+#define SCENARIO_STEPS 300
+#define SPLIT_STEP 137
+
+static uint8_t snapshot[sizeof(TrafficSystem)];
+
+/**
+ * Deterministic arrivals (LCG): adds this step's vehicles to the system.
+ */
+uint32_t add_arrivals(TrafficSystem* sys, uint32_t seed, uint32_t step) {
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        seed = seed * 1103515245u + 12345u;
+        if ((seed >> 16) % 100 >= 30) continue;
+
+        seed = seed * 1103515245u + 12345u;
+        char id[VEHICLE_ID_LEN];
+        sprintf(id, "v%u_%u", step, road);
+        traffic_add_vehicle(sys, id, road, (road + 1 + (seed >> 16) % 3) % ROAD_COUNT, step);
+    }
+    return seed;
+}
+
+/**
+ * Runs steps [from, to) and appends the discharged IDs to a running checksum.
+ */
+uint32_t run_steps(TrafficSystem* sys, uint32_t* seed, uint32_t from, uint32_t to) {
+    char out_ids[ROAD_COUNT * LANES_PER_ROAD][VEHICLE_ID_LEN];
+    uint32_t checksum = 0;
+
+    for (uint32_t step = from; step < to; step++) {
+        *seed = add_arrivals(sys, *seed, step);
+        int count = traffic_fsm_step(sys, out_ids);
+
+        checksum = checksum * 31u + (uint32_t)sys->current_state;
+        for (int i = 0; i < count; i++) {
+            for (const char* c = out_ids[i]; *c; c++) {
+                checksum = checksum * 31u + (uint8_t)*c;
+            }
+        }
+    }
+    return checksum;
+}
+
+void test_snapshot_round_trip() {
+    TimingConfig config = DEFAULT_TIMING;
+    TrafficSystem sys, restored;
+    uint32_t seed = 7;
+
+    traffic_init(&sys, config);
+    traffic_set_strategy(&sys, STRATEGY_V3);
+    TimingPlan plan = {.start_step = 500, .timing = config};
+    plan.timing.green_st = 9;
+    traffic_add_timing_plan(&sys, &plan);
+    run_steps(&sys, &seed, 0, 50);
+    config.green_lt = 7;
+    traffic_update_timing(&sys, &config);
+
+    size_t size = traffic_snapshot_size(&sys);
+    ASSERT_TRUE(size > 0 && size < sizeof(snapshot), "Snapshot should fit the buffer");
+    ASSERT_EQ_INT((int)size, (int)traffic_snapshot_save(&sys, snapshot, sizeof(snapshot)), "Save should write the full snapshot");
+    ASSERT_TRUE(traffic_snapshot_load(&restored, snapshot, size), "Load should accept its own snapshot");
+
+    ASSERT_EQ_INT(sys.current_step, restored.current_step, "Step should be restored");
+    ASSERT_EQ_INT(sys.current_state, restored.current_state, "State should be restored");
+    ASSERT_EQ_INT(sys.state_timer, restored.state_timer, "State timer should be restored");
+    ASSERT_EQ_INT(sys.stats.departures, restored.stats.departures, "Stats should be restored");
+    ASSERT_EQ_INT(sys.strategy, restored.strategy, "Strategy should be restored");
+    ASSERT_EQ_INT(sys.lights[NORTH][LANE_LEFT], restored.lights[NORTH][LANE_LEFT], "Lights should be restored");
+    ASSERT_EQ_INT(sys.timing_pending, restored.timing_pending, "Pending timing should be restored");
+    ASSERT_EQ_INT(sys.pending_timing.green_lt, restored.pending_timing.green_lt, "Pending timing should be restored");
+    ASSERT_EQ_INT(1, restored.plan_count, "Plan table should be restored");
+    ASSERT_EQ_INT(9, restored.plans[0].timing.green_st, "Plan table should be restored");
+
+    for (int road = 0; road < ROAD_COUNT; road++) {
+        for (int lane = 0; lane < LANES_PER_ROAD; lane++) {
+            ASSERT_EQ_INT(queue_count(&sys.queues[road][lane]), queue_count(&restored.queues[road][lane]),
+                          "Queue length should be restored");
+        }
+    }
+}
+
+void test_snapshot_rejects_invalid_data() {
+    TimingConfig config = DEFAULT_TIMING;
+    TrafficSystem sys, target;
+    uint32_t seed = 11;
+
+    traffic_init(&sys, config);
+    run_steps(&sys, &seed, 0, 20);
+    traffic_init(&target, config);
+
+    size_t size = traffic_snapshot_save(&sys, snapshot, sizeof(snapshot));
+    ASSERT_EQ_INT(0, (int)traffic_snapshot_save(&sys, snapshot, size - 1), "Too small buffer should fail");
+
+    ASSERT_TRUE(!traffic_snapshot_load(&target, snapshot, size - 1), "Truncated snapshot should be rejected");
+    ASSERT_EQ_INT(0, target.current_step, "Rejected snapshot must not modify the system");
+
+    snapshot[0] = SNAPSHOT_VERSION + 1;
+    ASSERT_TRUE(!traffic_snapshot_load(&target, snapshot, size), "Unknown version should be rejected");
+}
+
+void test_snapshot_rejects_corrupt_vehicles() {
+    TimingConfig config = DEFAULT_TIMING;
+    TrafficSystem sys, target;
+
+    // A single left turn from WEST is the last record: ..., start, end, arrival_step
+    traffic_init(&sys, config);
+    traffic_add_vehicle(&sys, "w", WEST, NORTH, 0);
+    traffic_init(&target, config);
+
+    size_t size = traffic_snapshot_save(&sys, snapshot, sizeof(snapshot));
+    uint8_t* start = &snapshot[size - sizeof(uint32_t) - 2];
+    uint8_t* end = &snapshot[size - sizeof(uint32_t) - 1];
+    ASSERT_TRUE(*start == WEST && *end == NORTH, "Vehicle record should end the snapshot");
+
+    *start = ROAD_COUNT;
+    ASSERT_TRUE(!traffic_snapshot_load(&target, snapshot, size), "Start road out of range should be rejected");
+    *start = NORTH;
+    ASSERT_TRUE(!traffic_snapshot_load(&target, snapshot, size), "Vehicle of another road should be rejected");
+    *start = WEST;
+
+    *end = 7;
+    ASSERT_TRUE(!traffic_snapshot_load(&target, snapshot, size), "End road out of range should be rejected");
+    *end = EAST;
+    ASSERT_TRUE(!traffic_snapshot_load(&target, snapshot, size), "Straight vehicle in the left lane should be rejected");
+    *end = WEST;
+    ASSERT_TRUE(!traffic_snapshot_load(&target, snapshot, size), "U-turn should be rejected");
+    ASSERT_EQ_INT(0, traffic_get_queue_size(&target, WEST, LANE_LEFT), "Rejected snapshot must not modify the system");
+
+    *end = NORTH;
+    ASSERT_TRUE(traffic_snapshot_load(&target, snapshot, size), "Restored record should load again");
+    ASSERT_EQ_INT(1, traffic_get_queue_size(&target, WEST, LANE_LEFT), "Vehicle should be back in its lane");
+}
+
+void test_resumed_run_matches_uninterrupted() {
+    TimingConfig config = DEFAULT_TIMING;
+    config.max_ext = 5;
+    TrafficSystem full, first, resumed;
+    uint32_t seed_full = 3, seed_split = 3;
+
+    traffic_init(&full, config);
+    uint32_t expected_head = run_steps(&full, &seed_full, 0, SPLIT_STEP);
+    uint32_t expected_tail = run_steps(&full, &seed_full, SPLIT_STEP, SCENARIO_STEPS);
+
+    traffic_init(&first, config);
+    uint32_t head = run_steps(&first, &seed_split, 0, SPLIT_STEP);
+    size_t size = traffic_snapshot_save(&first, snapshot, sizeof(snapshot));
+    ASSERT_TRUE(traffic_snapshot_load(&resumed, snapshot, size), "Checkpoint should load");
+    uint32_t tail = run_steps(&resumed, &seed_split, SPLIT_STEP, SCENARIO_STEPS);
+
+    ASSERT_EQ_INT((int)expected_head, (int)head, "Output before checkpoint should match");
+    ASSERT_EQ_INT((int)expected_tail, (int)tail, "Output after resume should match");
+    ASSERT_EQ_INT(full.stats.departures, resumed.stats.departures, "Departures should match");
+    ASSERT_EQ_INT((int)full.stats.total_wait, (int)resumed.stats.total_wait, "Total wait should match");
+    ASSERT_EQ_INT(full.stats.max_wait, resumed.stats.max_wait, "Max wait should match");
+    ASSERT_EQ_INT((int)full.stats.left_total_wait, (int)resumed.stats.left_total_wait, "Left wait should match");
+
+    for (uint8_t movement = 0; movement < MOVEMENT_COUNT; movement++) {
+        WaitHistogram expected, actual;
+        traffic_movement_wait_hist(&full, movement, &expected);
+        traffic_movement_wait_hist(&resumed, movement, &actual);
+        ASSERT_TRUE(memcmp(&expected, &actual, sizeof(WaitHistogram)) == 0, "Wait histograms should match");
+    }
+}
+
+int main() {
+    printf("\n=== SNAPSHOT TESTS ===\n\n");
+
+    RUN_TEST(test_snapshot_round_trip);
+    RUN_TEST(test_snapshot_rejects_invalid_data);
+    RUN_TEST(test_snapshot_rejects_corrupt_vehicles);
+    RUN_TEST(test_resumed_run_matches_uninterrupted);
+
+    PRINT_TEST_RESULTS();
+
+    return (tests_failed == 0) ? 0 : 1;
+}
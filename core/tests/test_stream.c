@@ -0,0 +1,243 @@
+#include "test_utils.h"
+#include "traffic_fsm.h"
+#include "traffic_stream.h"
+#include "protocol.h"
+#include <stdio.h>
+#include <string.h>
+
+int tests_run = 0;
+int tests_failed = 0;
+
+#define SCENARIO_STEPS 1500
+#define UPDATE_MAX 8192
+
+/**
+ * Update bytes collected by the StateStreamWrite callback.
+ */
+typedef struct {
+    uint8_t data[UPDATE_MAX];
+    size_t len;
+    size_t total; // Bytes over the whole run
+} UpdateBuffer;
+
+/**
+ * Queues and lights rebuilt from the updates only.
+ */
+typedef struct {
+    Vehicle lanes[STREAM_LANES][MAX_VEHICLES_PER_ROAD];
+    uint16_t counts[STREAM_LANES];
+    uint8_t lights[5];
+    uint32_t step;
+    uint32_t updates;
+    uint32_t keyframes;
+} Mirror;
+
+static void collect(void* ctx, const void* data, size_t len) {
+    UpdateBuffer* buf = (UpdateBuffer*)ctx;
+    if (buf->len + len <= UPDATE_MAX) {
+        memcpy(buf->data + buf->len, data, len);
+    }
+    buf->len += len;
+    buf->total += len;
+}
+
+/**
+ * Applies one update to the mirror. Returns false on a malformed update.
+ */
+static bool apply_update(Mirror* m, const UpdateBuffer* buf) {
+    StateUpdateHeader header;
+    size_t pos = sizeof(header);
+    if (buf->len < pos || buf->len > UPDATE_MAX) return false;
+    memcpy(&header, buf->data, sizeof(header));
+
+    if (header.flags & STATE_UPDATE_KEYFRAME) {
+        memset(m->counts, 0, sizeof(m->counts));
+        m->keyframes++;
+    }
+    if (header.flags & STATE_UPDATE_LIGHTS) {
+        memcpy(m->lights, buf->data + pos, sizeof(StateLights));
+        pos += sizeof(StateLights);
+    }
+
+    for (uint8_t i = 0; i < STREAM_LANES; i++) {
+        if (!(header.lane_mask & (1u << i))) continue;
+
+        StateLaneDelta delta;
+        memcpy(&delta, buf->data + pos, sizeof(delta));
+        pos += sizeof(delta);
+        if (delta.popped > m->counts[i]) return false;
+
+        memmove(m->lanes[i], m->lanes[i] + delta.popped, (m->counts[i] - delta.popped) * sizeof(Vehicle));
+        m->counts[i] -= delta.popped;
+        for (uint8_t k = 0; k < delta.appended; k++) {
+            if (m->counts[i] >= MAX_VEHICLES_PER_ROAD) return false;
+
+            Vehicle* v = &m->lanes[i][m->counts[i]++];
+            uint8_t id_len = buf->data[pos++];
+            memset(v->id, 0, sizeof(v->id));
+            memcpy(v->id, buf->data + pos, id_len);
+            pos += id_len;
+            v->end_road = buf->data[pos++];
+            memcpy(&v->arrival_step, buf->data + pos, sizeof(uint32_t));
+            pos += sizeof(uint32_t);
+        }
+    }
+
+    m->step = header.step;
+    m->updates++;
+    return pos == buf->len;
+}
+
+/**
+ * Compares the mirror with the queues and lights of the system.
+ */
+static bool mirror_matches(const Mirror* m, const TrafficSystem* sys) {
+    if (m->step != sys->current_step || m->lights[0] != (uint8_t)sys->current_state ||
+        m->lights[1] != (uint8_t)sys->lights[NORTH][LANE_STRAIGHT_RIGHT] ||
+        m->lights[4] != (uint8_t)sys->lights[EAST][LANE_LEFT]) {
+        return false;
+    }
+    for (uint8_t i = 0; i < STREAM_LANES; i++) {
+        const VehicleQueue* q = &sys->queues[i / LANES_PER_ROAD][i % LANES_PER_ROAD];
+        if (m->counts[i] != queue_count(q)) return false;
+
+        for (uint16_t j = 0; j < m->counts[i]; j++) {
+            const Vehicle* v = queue_vehicle_at(q, j);
+            if (strcmp(m->lanes[i][j].id, v->id) != 0 || m->lanes[i][j].end_road != v->end_road ||
+                m->lanes[i][j].arrival_step != v->arrival_step) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Deterministic arrivals (LCG) with a rush that fills the queues in the middle.
+ */
+static void add_arrivals(TrafficSystem* sys, uint32_t* seed, uint32_t step) {
+    uint32_t rate = (step > 400 && step < 900) ? 70 : 25;
+
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        *seed = *seed * 1103515245u + 12345u;
+        if ((*seed >> 16) % 100 >= rate) continue;
+
+        *seed = *seed * 1103515245u + 12345u;
+        char id[VEHICLE_ID_LEN];
+        sprintf(id, "car_%u_%u", step, road);
+        traffic_add_vehicle(sys, id, road, (road + 1 + (*seed >> 16) % 3) % ROAD_COUNT, step);
+    }
+}
+
+/**
+ * Streams the scenario at the given sampling rate, checking the mirror after every update.
+ * A CMD_CONFIG-like reset at reset_step (0 = none) is followed by a resync.
+ *
+ * @return Number of updates that did not reproduce the system
+ */
+static uint32_t run_stream(uint16_t every, uint32_t reset_step, Mirror* m, UpdateBuffer* buf) {
+    static char out_ids[STREAM_LANES][VEHICLE_ID_LEN];
+    TrafficSystem sys;
+    StateStream stream;
+    TimingConfig config = DEFAULT_TIMING;
+    uint32_t seed = 5, mismatches = 0;
+
+    memset(m, 0, sizeof(*m));
+    memset(buf, 0, sizeof(*buf));
+    traffic_init(&sys, config);
+
+    for (uint32_t step = 0; step < SCENARIO_STEPS; step++) {
+        add_arrivals(&sys, &seed, step);
+
+        if (step == 50) {
+            // Subscribe with vehicles already queued
+            state_stream_init(&stream, 7, every);
+            buf->len = 0;
+            state_stream_send(&stream, &sys, collect, buf);
+            mismatches += !apply_update(m, buf) || !mirror_matches(m, &sys);
+        }
+        if (reset_step > 0 && step == reset_step) {
+            traffic_init(&sys, config);
+            state_stream_resync(&stream);
+            add_arrivals(&sys, &seed, step);
+        }
+
+        if (step >= 50) state_stream_before_step(&stream, &sys);
+        traffic_fsm_step(&sys, out_ids);
+        if (step >= 50 && state_stream_after_step(&stream, &sys)) {
+            buf->len = 0;
+            state_stream_send(&stream, &sys, collect, buf);
+            mismatches += !apply_update(m, buf) || !mirror_matches(m, &sys);
+        }
+    }
+    return mismatches;
+}
+
+void test_every_step() {
+    static Mirror m;
+    static UpdateBuffer buf;
+
+    ASSERT_EQ_INT(0, (int)run_stream(1, 0, &m, &buf), "Every update should reproduce the queues");
+    ASSERT_EQ_INT(SCENARIO_STEPS - 50 + 1, (int)m.updates, "One update per step plus the keyframe");
+    ASSERT_EQ_INT(1, (int)m.keyframes, "Only the first update is a keyframe");
+}
+
+void test_sampling_rates() {
+    static Mirror m;
+    static UpdateBuffer buf;
+    uint16_t rates[] = {2, 7, 60, 500};
+    bool match = true, counted = true;
+
+    for (uint8_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+        match = match && run_stream(rates[r], 0, &m, &buf) == 0;
+        counted = counted && m.updates == 1u + (SCENARIO_STEPS - 50) / rates[r];
+    }
+    ASSERT_TRUE(match, "Sampled updates should reproduce the queues");
+    ASSERT_TRUE(counted, "One update every N steps");
+}
+
+void test_resync_after_reset() {
+    static Mirror m;
+    static UpdateBuffer buf;
+
+    ASSERT_EQ_INT(0, (int)run_stream(3, 600, &m, &buf), "A reset should be covered by a keyframe");
+    ASSERT_EQ_INT(2, (int)m.keyframes, "Subscription and reset keyframes");
+}
+
+void test_deltas_smaller_than_keyframes() {
+    static Mirror m;
+    static UpdateBuffer buf;
+    run_stream(1, 0, &m, &buf);
+
+    // Keyframe of the queues at the end of the rush, for comparison
+    size_t deltas = buf.total;
+    TrafficSystem sys;
+    TimingConfig config = DEFAULT_TIMING;
+    StateStream stream;
+    uint32_t seed = 5;
+    static char out_ids[STREAM_LANES][VEHICLE_ID_LEN];
+    traffic_init(&sys, config);
+    for (uint32_t step = 0; step < 900; step++) {
+        add_arrivals(&sys, &seed, step);
+        traffic_fsm_step(&sys, out_ids);
+    }
+    state_stream_init(&stream, 7, 1);
+    buf.len = 0;
+    state_stream_send(&stream, &sys, collect, &buf);
+
+    printf("  Deltas: %zu bytes over %u updates, rush keyframe: %zu bytes\n", deltas, m.updates, buf.len);
+    ASSERT_TRUE(deltas / m.updates * 10 < buf.len, "An average delta should be far below a keyframe");
+}
+
+int main() {
+    printf("\n=== STATE STREAM TESTS ===\n\n");
+
+    RUN_TEST(test_every_step);
+    RUN_TEST(test_sampling_rates);
+    RUN_TEST(test_resync_after_reset);
+    RUN_TEST(test_deltas_smaller_than_keyframes);
+
+    PRINT_TEST_RESULTS();
+
+    return (tests_failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+#include "test_utils.h"
+#include "traffic_fsm.h"
+#include "traffic_sweep.h"
+#include <stdio.h>
+
+int tests_run = 0;
+int tests_failed = 0;
+
+#define SCENARIO_STEPS 300
+#define MAX_ARRIVALS (SCENARIO_STEPS * ROAD_COUNT)
+
+static Vehicle arrivals[MAX_ARRIVALS];
+
+/**
+ * Deterministic pseudo-random scenario (LCG), independent of libc rand().
+ */
+uint32_t build_scenario(uint32_t seed, uint32_t percent) {
+    uint32_t n = 0;
+    for (uint32_t step = 0; step < SCENARIO_STEPS; step++) {
+        for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+            seed = seed * 1103515245u + 12345u;
+            if ((seed >> 16) % 100 >= percent) continue;
+
+            seed = seed * 1103515245u + 12345u;
+            Vehicle* v = &arrivals[n];
+            sprintf(v->id, "v%u", n);
+            v->start_road = road;
+            v->end_road = (road + 1 + (seed >> 16) % 3) % ROAD_COUNT;
+            v->arrival_step = step;
+            n++;
+        }
+    }
+    return n;
+}
+
+TrafficStats run_reference(TimingConfig config, TrafficStrategyId strategy, uint32_t n_arrivals) {
+    TrafficSystem sys;
+    char out_ids[ROAD_COUNT * LANES_PER_ROAD][VEHICLE_ID_LEN];
+    uint32_t next = 0;
+
+    traffic_init(&sys, config);
+    traffic_set_strategy(&sys, strategy);
+    for (uint32_t step = 0; step < SCENARIO_STEPS; step++) {
+        while (next < n_arrivals && arrivals[next].arrival_step == step) {
+            const Vehicle* v = &arrivals[next++];
+            traffic_add_vehicle(&sys, v->id, v->start_road, v->end_road, v->arrival_step);
+        }
+        traffic_fsm_step(&sys, out_ids);
+    }
+    return sys.stats;
+}
+
+TimingConfig make_config(uint32_t max_ext, uint32_t skip_limit) {
+    TimingConfig config = {
+        .green_st = 4, .green_lt = 3, .yellow = 2, .all_red = 3, .red_yellow = 1,
+        .ext_threshold = 1, .max_ext = max_ext, .skip_limit = skip_limit
+    };
+    return config;
+}
+
+void test_sweep_matches_independent_runs() {
+    TimingConfig configs[15 * 3];
+    TrafficStats stats[15 * 3];
+    uint32_t n_configs = 0;
+
+    for (uint32_t mext = 1; mext <= 15; mext++) {
+        for (uint32_t skip = 1; skip <= 3; skip++) {
+            configs[n_configs++] = make_config(mext, skip);
+        }
+    }
+
+    uint32_t n_arrivals = build_scenario(42, 25);
+    SweepInfo info;
+    ASSERT_TRUE(traffic_sweep_run(configs, n_configs, DEFAULT_STRATEGY, arrivals, n_arrivals, SCENARIO_STEPS, stats, &info),
+                "Sweep should succeed");
+
+    for (uint32_t i = 0; i < n_configs; i++) {
+        TrafficStats expected = run_reference(configs[i], DEFAULT_STRATEGY, n_arrivals);
+        ASSERT_EQ_INT(expected.departures, stats[i].departures, "Departures differ from independent run");
+        ASSERT_EQ_INT((int)expected.total_wait, (int)stats[i].total_wait, "Total wait differs from independent run");
+        ASSERT_EQ_INT(expected.max_wait, stats[i].max_wait, "Max wait differs from independent run");
+        ASSERT_EQ_INT(expected.left_departures, stats[i].left_departures, "Left departures differ");
+        ASSERT_EQ_INT((int)expected.left_total_wait, (int)stats[i].left_total_wait, "Left wait differs");
+    }
+
+    ASSERT_TRUE(info.branches <= n_configs, "Never more branches than configs");
+    ASSERT_TRUE(info.branch_steps <= (uint64_t)n_configs * SCENARIO_STEPS, "Never more work than independent runs");
+}
+
+void test_sweep_identical_configs_share_trajectory() {
+    TimingConfig configs[8];
+    TrafficStats stats[8];
+    for (int i = 0; i < 8; i++) {
+        configs[i] = make_config(15, 2);
+    }
+
+    uint32_t n_arrivals = build_scenario(7, 40);
+    SweepInfo info;
+    ASSERT_TRUE(traffic_sweep_run(configs, 8, DEFAULT_STRATEGY, arrivals, n_arrivals, SCENARIO_STEPS, stats, &info),
+                "Sweep should succeed");
+
+    ASSERT_EQ_INT(1, info.branches, "Identical configs must never fork");
+    ASSERT_EQ_INT(SCENARIO_STEPS, (int)info.branch_steps, "Only one trajectory should be simulated");
+}
+
+void test_sweep_quiet_scenario_never_forks() {
+    TimingConfig configs[15];
+    TrafficStats stats[15];
+    for (uint32_t i = 0; i < 15; i++) {
+        configs[i] = make_config(i + 1, 2);
+    }
+
+    // Sparse traffic never reaches the extension limits
+    uint32_t n_arrivals = build_scenario(3, 1);
+    SweepInfo info;
+    ASSERT_TRUE(traffic_sweep_run(configs, 15, DEFAULT_STRATEGY, arrivals, n_arrivals, SCENARIO_STEPS, stats, &info),
+                "Sweep should succeed");
+    ASSERT_TRUE(info.branches < 15, "Sparse traffic should share most of the trajectories");
+}
+
+void test_sweep_other_strategies_match_independent_runs() {
+    TimingConfig configs[6];
+    TrafficStats stats[6];
+    for (uint32_t i = 0; i < 6; i++) {
+        configs[i] = make_config(2 * i + 1, 1 + i % 3);
+    }
+
+    uint32_t n_arrivals = build_scenario(99, 30);
+    for (int strategy = 0; strategy < STRATEGY_COUNT; strategy++) {
+        ASSERT_TRUE(traffic_sweep_run(configs, 6, (TrafficStrategyId)strategy, arrivals, n_arrivals,
+                                      SCENARIO_STEPS, stats, NULL), "Sweep should succeed");
+
+        for (uint32_t i = 0; i < 6; i++) {
+            TrafficStats expected = run_reference(configs[i], (TrafficStrategyId)strategy, n_arrivals);
+            ASSERT_EQ_INT((int)expected.total_wait, (int)stats[i].total_wait, "Strategy sweep differs from independent run");
+        }
+    }
+}
+
+void test_sweep_invalid_arguments() {
+    TrafficStats stats[1];
+    ASSERT_TRUE(!traffic_sweep_run(NULL, 1, DEFAULT_STRATEGY, NULL, 0, 10, stats, NULL), "NULL configs should fail");
+
+    TimingConfig config = make_config(1, 1);
+    ASSERT_TRUE(!traffic_sweep_run(&config, 0, DEFAULT_STRATEGY, NULL, 0, 10, stats, NULL), "Zero configs should fail");
+    ASSERT_TRUE(traffic_sweep_run(&config, 1, DEFAULT_STRATEGY, NULL, 0, 10, stats, NULL), "Empty scenario is valid");
+    ASSERT_EQ_INT(0, stats[0].departures, "Empty scenario has no departures");
+}
+
+int main() {
+    printf("\n=== SWEEP TESTS ===\n\n");
+
+    RUN_TEST(test_sweep_matches_independent_runs);
+    RUN_TEST(test_sweep_identical_configs_share_trajectory);
+    RUN_TEST(test_sweep_quiet_scenario_never_forks);
+    RUN_TEST(test_sweep_other_strategies_match_independent_runs);
+    RUN_TEST(test_sweep_invalid_arguments);
+
+    PRINT_TEST_RESULTS();
+
+    return (tests_failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+#include "test_utils.h"
+#include "traffic_fsm.h"
+#include "traffic_telemetry.h"
+#include <stdio.h>
+#include <string.h>
+
+int tests_run = 0;
+int tests_failed = 0;
+
+static TelemetryRecord record;
+
+/**
+ * Deterministic arrivals (LCG), about 0.4 vehicles per road and step.
+ */
+static void add_arrivals(TrafficSystem* sys, uint32_t* seed) {
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        *seed = *seed * 1103515245u + 12345u;
+        if ((*seed >> 16) % 100 >= 40) continue;
+        traffic_add_vehicle(sys, "t", road, (road + 2) % ROAD_COUNT, sys->current_step);
+    }
+}
+
+/**
+ * Runs `steps` steps with the publisher attached.
+ */
+static void run(TrafficSystem* sys, TrafficTelemetry* t, uint32_t steps, uint32_t* seed) {
+    char out_ids[ROAD_COUNT * LANES_PER_ROAD][VEHICLE_ID_LEN];
+    for (uint32_t i = 0; i < steps; i++) {
+        add_arrivals(sys, seed);
+        traffic_fsm_step(sys, out_ids);
+        traffic_telemetry_step(t, sys);
+    }
+}
+
+void test_init_publishes() {
+    TrafficSystem sys;
+    TrafficTelemetry t;
+    TimingConfig config = DEFAULT_TIMING;
+    traffic_init(&sys, config);
+
+    memset(&record, 0xAB, sizeof(record));
+    traffic_telemetry_init(&t, &record, 0, &sys);
+
+    ASSERT_TRUE(record.magic == TELEMETRY_MAGIC, "Record should carry the magic");
+    ASSERT_EQ_INT(TELEMETRY_EVERY_DEFAULT, (int)record.every, "0 selects the default rate");
+    ASSERT_EQ_INT(2, (int)record.sequence, "First sample is complete (even sequence)");
+    ASSERT_EQ_INT(0, (int)record.current_step, "First sample is taken before any step");
+    ASSERT_EQ_INT(0, record.flags, "Running simulation has no flags");
+}
+
+void test_sampling_rate() {
+    TrafficSystem sys;
+    TrafficTelemetry t;
+    TimingConfig config = DEFAULT_TIMING;
+    uint32_t seed = 3;
+    traffic_init(&sys, config);
+    traffic_telemetry_init(&t, &record, 40, &sys);
+
+    run(&sys, &t, 130, &seed);
+    ASSERT_EQ_INT(2 + 3 * 2, (int)record.sequence, "One sample every 40 steps");
+    ASSERT_EQ_INT(120, (int)record.current_step, "Latest sample is from step 120");
+
+    run(&sys, &t, 30, &seed);
+    ASSERT_EQ_INT(160, (int)record.current_step, "Countdown continues across calls");
+}
+
+void test_sample_matches_system() {
+    TrafficSystem sys;
+    TrafficTelemetry t;
+    TimingConfig config = DEFAULT_TIMING;
+    uint32_t seed = 9;
+    traffic_init(&sys, config);
+    traffic_telemetry_init(&t, &record, 25, &sys);
+
+    run(&sys, &t, 500, &seed);
+
+    bool queues = true, hists = true;
+    for (uint8_t i = 0; i < ROAD_COUNT * LANES_PER_ROAD; i++) {
+        const VehicleQueue* q = &sys.queues[i / LANES_PER_ROAD][i % LANES_PER_ROAD];
+        queues = queues && record.queue_lengths[i] == queue_count(q);
+        hists = hists && memcmp(record.wait_hist[i], queue_get_wait_hist(q)->counts, sizeof(record.wait_hist[i])) == 0;
+    }
+    ASSERT_EQ_INT(500, (int)record.current_step, "Sample taken at the last step");
+    ASSERT_TRUE(queues, "Queue lengths should match");
+    ASSERT_TRUE(hists, "Wait histograms should match");
+    ASSERT_EQ_INT((int)sys.stats.departures, (int)record.departures, "Departures should match");
+    ASSERT_TRUE(record.total_wait == sys.stats.total_wait, "Total wait should match");
+    ASSERT_EQ_INT(sys.current_state, record.current_state, "State should match");
+    ASSERT_EQ_INT((int)sys.extension_timer, record.extension_steps, "Extension usage should match");
+    ASSERT_EQ_INT((int)sys.timing.max_ext, record.max_extension, "Extension limit should match");
+}
+
+void test_final_sample() {
+    TrafficSystem sys;
+    TrafficTelemetry t;
+    TimingConfig config = DEFAULT_TIMING;
+    uint32_t seed = 1;
+    traffic_init(&sys, config);
+    traffic_telemetry_init(&t, &record, 1000, &sys);
+
+    run(&sys, &t, 77, &seed);
+    ASSERT_EQ_INT(0, (int)record.current_step, "No sample before the rate is reached");
+
+    traffic_telemetry_publish(&t, &sys, TELEMETRY_FINISHED);
+    ASSERT_EQ_INT(77, (int)record.current_step, "Final sample holds the last step");
+    ASSERT_EQ_INT(TELEMETRY_FINISHED, record.flags, "Final sample is flagged");
+    ASSERT_EQ_INT(0, (int)(record.sequence % 2), "Final sample is complete");
+}
+
+int main() {
+    printf("\n=== TELEMETRY TESTS ===\n\n");
+
+    RUN_TEST(test_init_publishes);
+    RUN_TEST(test_sampling_rate);
+    RUN_TEST(test_sample_matches_system);
+    RUN_TEST(test_final_sample);
+
+    PRINT_TEST_RESULTS();
+
+    return (tests_failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,60 @@
+#include "test_utils.h"
+#include "stack_watermark.h"
+#include <stdio.h>
+
+int tests_run = 0;
+int tests_failed = 0;
+
+#define REGION_WORDS 256
+
+static uint32_t region[REGION_WORDS];
+
+/**
+ * Simulates a stack that went `words` deep from the top of the region.
+ */
+static void use(uint32_t words) {
+    for (uint32_t i = 0; i < words; i++) {
+        region[REGION_WORDS - 1 - i] = i;
+    }
+}
+
+void test_untouched() {
+    stack_paint(region, region + REGION_WORDS);
+    ASSERT_EQ_INT(0, (int)stack_high_water(region, region + REGION_WORDS), "Painted region reports no use");
+}
+
+void test_partial_use() {
+    stack_paint(region, region + REGION_WORDS);
+    use(40);
+    ASSERT_EQ_INT(40 * 4, (int)stack_high_water(region, region + REGION_WORDS), "Depth of the deepest write");
+
+    // A shallower use afterwards does not lower the mark
+    use(10);
+    ASSERT_EQ_INT(40 * 4, (int)stack_high_water(region, region + REGION_WORDS), "Mark is a high-water mark");
+}
+
+void test_gap_below_top() {
+    // Locals that were never written leave paint between used words
+    stack_paint(region, region + REGION_WORDS);
+    region[REGION_WORDS - 100] = 0;
+    ASSERT_EQ_INT(100 * 4, (int)stack_high_water(region, region + REGION_WORDS), "Deepest word counts, not the contiguous run");
+}
+
+void test_full_use() {
+    stack_paint(region, region + REGION_WORDS);
+    use(REGION_WORDS);
+    ASSERT_EQ_INT(REGION_WORDS * 4, (int)stack_high_water(region, region + REGION_WORDS), "Exhausted region reports its size");
+}
+
+int main() {
+    printf("\n=== STACK WATERMARK TESTS ===\n\n");
+
+    RUN_TEST(test_untouched);
+    RUN_TEST(test_partial_use);
+    RUN_TEST(test_gap_below_top);
+    RUN_TEST(test_full_use);
+
+    PRINT_TEST_RESULTS();
+
+    return (tests_failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file traffic_aggregate.c
+ * @brief Implementation of the time-bucketed step aggregation.
+ */
+
+#include <string.h>
+#include "traffic_aggregate.h"
+
+// --- HELPER FUNCTIONS ---
+
+/**
+ * @brief Phase index of a state (AGGREGATE_PHASES - 1 for the clearance states).
+ */
+static uint8_t phase_of(TrafficState state) {
+    switch (state) {
+        case STATE_NS_STRAIGHT: return 0;
+        case STATE_NS_LEFT: return 1;
+        case STATE_EW_STRAIGHT: return 2;
+        case STATE_EW_LEFT: return 3;
+        default: return AGGREGATE_PHASES - 1;
+    }
+}
+
+/**
+ * @brief Position of a phase in the cycle if the state starts it, -1 otherwise.
+ */
+static int8_t started_phase(TrafficState state) {
+    switch (state) {
+        case STATE_NS_RED_YELLOW: return 0;
+        case STATE_NS_LEFT_RED_YELLOW: return 1;
+        case STATE_EW_RED_YELLOW: return 2;
+        case STATE_EW_LEFT_RED_YELLOW: return 3;
+        default: return -1;
+    }
+}
+
+static void open_bucket(TrafficAggregator* agg, uint32_t first_step) {
+    memset(&agg->current, 0, sizeof(agg->current));
+    agg->current.first_step = first_step;
+}
+
+static void close_bucket(TrafficAggregator* agg, uint32_t next_step, TrafficBucket* completed) {
+    *completed = agg->current;
+    open_bucket(agg, next_step);
+}
+
+// --- PUBLIC API IMPLEMENTATION ---
+
+bool traffic_aggregate_init(TrafficAggregator* agg, const TrafficSystem* sys, AggregateMode mode,
+                            uint32_t bucket_steps) {
+    memset(agg, 0, sizeof(*agg));
+    if (mode > AGGREGATE_CYCLES || (mode == AGGREGATE_STEPS && bucket_steps == 0)) {
+        return false;
+    }
+
+    agg->mode = mode;
+    agg->bucket_steps = bucket_steps;
+    agg->last_phase = -1;
+    open_bucket(agg, sys->current_step + 1);
+
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            agg->counts[road * LANES_PER_ROAD + lane] = queue_count(&sys->queues[road][lane]);
+        }
+    }
+    return true;
+}
+
+void traffic_aggregate_before_step(TrafficAggregator* agg, const TrafficSystem* sys) {
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            uint8_t i = road * LANES_PER_ROAD + lane;
+            const VehicleQueue* q = &sys->queues[road][lane];
+            uint16_t count = queue_count(q);
+
+            // Queues only grow between steps (a CMD_CONFIG reset may shrink them)
+            if (count > agg->counts[i]) {
+                agg->current.arrivals[i] += count - agg->counts[i];
+            }
+            agg->before[i] = count;
+            if (count > 0) {
+                agg->head_arrival[i] = q->vehicles[q->head].arrival_step;
+            }
+        }
+    }
+    agg->state_before = sys->current_state;
+}
+
+bool traffic_aggregate_after_step(TrafficAggregator* agg, const TrafficSystem* sys, TrafficBucket* completed) {
+    bool closed = false;
+
+    if (agg->mode == AGGREGATE_CYCLES) {
+        int8_t phase = sys->current_state != agg->state_before ? started_phase(sys->current_state) : -1;
+        bool new_cycle = phase >= 0 && phase <= agg->last_phase;
+        bool full = agg->bucket_steps > 0 && agg->current.steps >= agg->bucket_steps;
+
+        // The step that starts the next cycle belongs to it
+        if ((new_cycle || full) && agg->current.steps > 0) {
+            close_bucket(agg, sys->current_step, completed);
+            closed = true;
+        }
+        if (new_cycle) {
+            agg->last_phase = -1;
+        }
+        if (phase >= 0) {
+            agg->last_phase = phase;
+        }
+    }
+
+    TrafficBucket* b = &agg->current;
+    b->steps++;
+    b->phase_steps[phase_of(sys->current_state)]++;
+
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            uint8_t i = road * LANES_PER_ROAD + lane;
+            uint16_t count = queue_count(&sys->queues[road][lane]);
+
+            // At most one vehicle leaves a lane per step: the former head
+            if (count < agg->before[i]) {
+                uint32_t wait = sys->current_step >= agg->head_arrival[i] ? sys->current_step - agg->head_arrival[i] : 0;
+                b->departures[i]++;
+                b->total_wait[i] += wait;
+                if (wait > b->max_wait[i]) {
+                    b->max_wait[i] = wait;
+                }
+            }
+
+            b->queue_sum[i] += count;
+            if (count > b->queue_max[i]) {
+                b->queue_max[i] = count;
+            }
+            agg->counts[i] = count;
+        }
+    }
+
+    if (agg->mode == AGGREGATE_STEPS && b->steps >= agg->bucket_steps) {
+        close_bucket(agg, sys->current_step + 1, completed);
+        closed = true;
+    }
+    return closed;
+}
+
+void traffic_aggregate_flush(TrafficAggregator* agg, TrafficBucket* completed) {
+    close_bucket(agg, agg->current.first_step + agg->current.steps, completed);
+}
@@ -0,0 +1,106 @@
+/**
+ * @file traffic_aggregate.h
+ * @brief Time-bucketed aggregation of the step outputs.
+ * @details Long studies rarely need the departing vehicles of every step. The
+ * aggregator observes a system around each step and accumulates per-lane
+ * arrivals, departures, waits and queue lengths plus the share of each green
+ * phase, so only one record per bucket has to leave the core.
+ *
+ * Buckets span a fixed number of steps (AGGREGATE_STEPS) or one signal cycle
+ * (AGGREGATE_CYCLES): a cycle ends when a phase starts whose position in the
+ * NS -> NS left -> EW -> EW left order is not after the previous phase, so
+ * skipped phases do not split cycles. Lanes are indexed [road * 2 + lane].
+ */
+
+#ifndef TRAFFIC_AGGREGATE_H
+#define TRAFFIC_AGGREGATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "traffic_fsm.h"
+
+#define AGGREGATE_LANES (ROAD_COUNT * LANES_PER_ROAD)
+#define AGGREGATE_PHASES (MOVEMENT_COUNT + 1) // Green phases, then clearance (yellow, red-yellow, all-red)
+
+/**
+ * @brief Bucket boundaries.
+ */
+typedef enum {
+    AGGREGATE_OFF = 0,
+    AGGREGATE_STEPS, // Every bucket_steps steps
+    AGGREGATE_CYCLES // Every signal cycle (at most bucket_steps steps if not 0)
+} AggregateMode;
+
+/**
+ * @brief Totals of one bucket.
+ */
+typedef struct {
+    uint32_t first_step; // current_step of the first step in the bucket
+    uint32_t steps;
+    uint32_t arrivals[AGGREGATE_LANES]; // Vehicles accepted into the lane
+    uint32_t departures[AGGREGATE_LANES];
+    uint64_t total_wait[AGGREGATE_LANES]; // Sum of the waits of the departures (steps)
+    uint32_t max_wait[AGGREGATE_LANES];
+    uint32_t queue_sum[AGGREGATE_LANES]; // Sum of the queue lengths after every step
+    uint16_t queue_max[AGGREGATE_LANES];
+    uint32_t phase_steps[AGGREGATE_PHASES]; // Steps spent in each phase
+} TrafficBucket;
+
+/**
+ * @brief Aggregation state of one system.
+ */
+typedef struct {
+    AggregateMode mode;
+    uint32_t bucket_steps;
+    TrafficBucket current; // Open bucket
+
+    uint16_t counts[AGGREGATE_LANES]; // Queue lengths after the previous step
+    uint16_t before[AGGREGATE_LANES]; // Queue lengths before the current step
+    uint32_t head_arrival[AGGREGATE_LANES]; // Arrival of the first queued vehicle before the current step
+    TrafficState state_before;
+    int8_t last_phase; // Phase started last in the current cycle, -1 if none
+} TrafficAggregator;
+
+/**
+ * @brief Starts aggregating a system.
+ *
+ * @param agg Pointer to TrafficAggregator
+ * @param sys System to observe (vehicles already queued are not counted as arrivals)
+ * @param mode Bucket boundaries (AGGREGATE_OFF disables the aggregator)
+ * @param bucket_steps Bucket length, or longest cycle bucket (0 = unbounded)
+ *
+ * @return false if the mode is unknown or AGGREGATE_STEPS has no length
+ */
+bool traffic_aggregate_init(TrafficAggregator* agg, const TrafficSystem* sys, AggregateMode mode,
+                            uint32_t bucket_steps);
+
+/**
+ * @brief Records the queues before traffic_fsm_step().
+ *
+ * @details Vehicles added since the previous step are counted as arrivals here.
+ *
+ * @param agg Pointer to TrafficAggregator
+ * @param sys System about to be stepped
+ */
+void traffic_aggregate_before_step(TrafficAggregator* agg, const TrafficSystem* sys);
+
+/**
+ * @brief Accumulates the step just executed.
+ *
+ * @param agg Pointer to TrafficAggregator
+ * @param sys System after traffic_fsm_step()
+ * @param completed Receives the bucket closed by this step
+ *
+ * @return true if a bucket was completed
+ */
+bool traffic_aggregate_after_step(TrafficAggregator* agg, const TrafficSystem* sys, TrafficBucket* completed);
+
+/**
+ * @brief Closes the open bucket early (end of input, aggregation turned off).
+ *
+ * @param agg Pointer to TrafficAggregator
+ * @param completed Receives the open bucket (steps may be 0)
+ */
+void traffic_aggregate_flush(TrafficAggregator* agg, TrafficBucket* completed);
+
+#endif // TRAFFIC_AGGREGATE_H
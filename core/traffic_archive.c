@@ -0,0 +1,624 @@
+/**
+ * @file traffic_archive.c
+ * @brief Implementation of the compressed scenario/output archive.
+ *
+ * Every event of a block starts with a varint tag: (argument << 3) | type.
+ *
+ *     TAG_IDLE        argument = number of idle steps
+ *     TAG_STEP        argument = departures, followed by their IDs
+ *     TAG_VEHICLE     argument = start * 4 + end, followed by the ID (arrival = current step)
+ *     TAG_VEHICLE_EXT argument = 0, start:u8 end:u8 zigzag(arrival - step) ID
+ *     TAG_COMMAND     argument = length, followed by the raw command
+ *
+ * An ID is a varint (zigzag(number - previous number) << 3 | slot). Slots
+ * 0-3 reuse a recent prefix; ID_NEW_PREFIX is followed by prefix_len, prefix
+ * and width code, stored in the oldest slot. The delta state is reset at the
+ * start of every block.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "traffic_archive.h"
+#include "protocol.h"
+
+#define TAG_IDLE 0
+#define TAG_STEP 1
+#define TAG_VEHICLE 2
+#define TAG_VEHICLE_EXT 3
+#define TAG_COMMAND 4
+#define TAG_BITS 3
+
+#define HEADER_SIZE 8
+#define INDEX_ENTRY_SIZE 24
+#define TRAILER_SIZE 20
+#define MAX_SUFFIX_DIGITS 18 // zigzag(delta) << ID_SLOT_BITS still fits a uint64_t
+#define ID_SLOT_BITS 3
+#define ID_NEW_PREFIX ARCHIVE_ID_PREFIXES
+#define VARINT_MAX 10
+
+// --- HELPER FUNCTIONS ---
+
+static void put_u32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void put_u64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t get_u64(const uint8_t* p) {
+    return (uint64_t)get_u32(p) | (uint64_t)get_u32(p + 4) << 32;
+}
+
+static uint64_t zigzag(uint64_t delta) {
+    return (delta << 1) ^ (uint64_t)-(int64_t)(delta >> 63);
+}
+
+static uint64_t unzigzag(uint64_t v) {
+    return (v >> 1) ^ (uint64_t)-(int64_t)(v & 1);
+}
+
+/**
+ * @brief Splits an ID into its text prefix and numeric suffix.
+ */
+static uint64_t split_id(const char* id, ArchiveIdPrefix* out) {
+    uint8_t len = 0;
+    while (len < VEHICLE_ID_LEN - 1 && id[len] != '\0') len++;
+
+    uint8_t digits = 0;
+    while (digits < len && digits < MAX_SUFFIX_DIGITS && id[len - 1 - digits] >= '0' && id[len - 1 - digits] <= '9') {
+        digits++;
+    }
+
+    out->prefix_len = len - digits;
+    memcpy(out->prefix, id, out->prefix_len);
+    uint64_t number = 0;
+    for (uint8_t i = out->prefix_len; i < len; i++) {
+        number = number * 10 + (uint64_t)(id[i] - '0');
+    }
+    // Leading zeros fix the width; otherwise "v9" and "v10" share one prefix
+    bool padded = digits > 1 && id[out->prefix_len] == '0';
+    out->width = digits == 0 ? 0 : (padded ? digits + 1 : 1);
+    return number;
+}
+
+static void join_id(const ArchiveIdPrefix* s, uint64_t number, char* id) {
+    memcpy(id, s->prefix, s->prefix_len);
+    size_t len = s->prefix_len;
+
+    if (s->width > 0) {
+        char digits[MAX_SUFFIX_DIGITS + 1];
+        int n = 0;
+        uint64_t v = number;
+        do {
+            digits[n++] = (char)('0' + v % 10);
+            v /= 10;
+        } while (v > 0 && n < MAX_SUFFIX_DIGITS);
+        while (s->width > 1 && n < s->width - 1 && n < MAX_SUFFIX_DIGITS) digits[n++] = '0';
+        while (n > 0 && len < VEHICLE_ID_LEN - 1) id[len++] = digits[--n];
+    }
+    id[len] = '\0';
+}
+
+// --- WRITER ---
+
+static bool reserve(ArchiveWriter* w, size_t extra) {
+    if (w->block_len + extra <= w->block_cap) {
+        return true;
+    }
+    size_t cap = w->block_cap ? w->block_cap : ARCHIVE_BLOCK_BYTES;
+    while (cap < w->block_len + extra) cap *= 2;
+    uint8_t* grown = realloc(w->block, cap);
+    if (!grown) {
+        w->failed = true;
+        return false;
+    }
+    w->block = grown;
+    w->block_cap = cap;
+    return true;
+}
+
+static void put_varint(ArchiveWriter* w, uint64_t v) {
+    if (!reserve(w, VARINT_MAX)) return;
+    while (v >= 0x80) {
+        w->block[w->block_len++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    w->block[w->block_len++] = (uint8_t)v;
+}
+
+static void put_raw(ArchiveWriter* w, const void* data, size_t n) {
+    if (!reserve(w, n)) return;
+    memcpy(w->block + w->block_len, data, n);
+    w->block_len += n;
+}
+
+static void put_id(ArchiveWriter* w, ArchiveIdState* prev, const char* id) {
+    ArchiveIdPrefix cur;
+    uint64_t number = split_id(id, &cur);
+
+    uint8_t slot = 0;
+    while (slot < ARCHIVE_ID_PREFIXES) {
+        const ArchiveIdPrefix* p = &prev->prefixes[slot];
+        if (p->width == cur.width && p->prefix_len == cur.prefix_len &&
+            memcmp(p->prefix, cur.prefix, cur.prefix_len) == 0) {
+            break;
+        }
+        slot++;
+    }
+    put_varint(w, zigzag(number - prev->number) << ID_SLOT_BITS | slot);
+    if (slot == ID_NEW_PREFIX) {
+        put_varint(w, cur.prefix_len);
+        put_raw(w, cur.prefix, cur.prefix_len);
+        put_varint(w, cur.width);
+        prev->prefixes[prev->next_slot] = cur;
+        prev->next_slot = (prev->next_slot + 1) % ARCHIVE_ID_PREFIXES;
+    }
+    prev->number = number;
+}
+
+static void flush_idle(ArchiveWriter* w) {
+    if (w->idle_run > 0) {
+        put_varint(w, (uint64_t)w->idle_run << TAG_BITS | TAG_IDLE);
+        w->idle_run = 0;
+    }
+}
+
+static bool write_all(ArchiveWriter* w, const void* data, size_t n) {
+    if (n > 0 && fwrite(data, 1, n, w->file) != n) {
+        w->failed = true;
+        return false;
+    }
+    w->offset += n;
+    return true;
+}
+
+static void start_block(ArchiveWriter* w) {
+    memset(&w->current, 0, sizeof(w->current));
+    w->current.first_step = w->step;
+    memset(&w->arrivals, 0, sizeof(w->arrivals));
+    memset(&w->departures, 0, sizeof(w->departures));
+    w->block_len = 0;
+}
+
+static void end_block(ArchiveWriter* w) {
+    flush_idle(w);
+    if (w->block_len == 0 || w->failed) {
+        return;
+    }
+
+    if (w->block_count == w->index_cap) {
+        uint32_t cap = w->index_cap ? w->index_cap * 2 : 64;
+        ArchiveBlockInfo* grown = realloc(w->index, cap * sizeof(ArchiveBlockInfo));
+        if (!grown) {
+            w->failed = true;
+            return;
+        }
+        w->index = grown;
+        w->index_cap = cap;
+    }
+
+    w->current.offset = w->offset;
+    w->current.length = (uint32_t)w->block_len;
+    w->index[w->block_count++] = w->current;
+    write_all(w, w->block, w->block_len);
+    start_block(w);
+}
+
+bool archive_writer_open(ArchiveWriter* w, FILE* file, uint8_t flags) {
+    memset(w, 0, sizeof(*w));
+    w->file = file;
+    w->flags = flags;
+    start_block(w);
+
+    uint8_t header[HEADER_SIZE] = {0};
+    memcpy(header, ARCHIVE_MAGIC, 4);
+    header[4] = ARCHIVE_VERSION;
+    header[5] = flags;
+    return write_all(w, header, sizeof(header));
+}
+
+void archive_write_vehicle(ArchiveWriter* w, const char* id, uint8_t start_road, uint8_t end_road,
+                           uint32_t arrival_time) {
+    flush_idle(w);
+    if (start_road < ROAD_COUNT && end_road < ROAD_COUNT && arrival_time == w->step) {
+        put_varint(w, (uint64_t)(start_road * ROAD_COUNT + end_road) << TAG_BITS | TAG_VEHICLE);
+    } else {
+        uint8_t roads[2] = {start_road, end_road};
+        put_varint(w, TAG_VEHICLE_EXT);
+        put_raw(w, roads, sizeof(roads));
+        put_varint(w, zigzag((uint64_t)arrival_time - w->step));
+    }
+    put_id(w, &w->arrivals, id);
+    w->current.vehicles++;
+}
+
+void archive_write_command(ArchiveWriter* w, const uint8_t* command, size_t len) {
+    if (len == 0 || len > ARCHIVE_COMMAND_MAX) {
+        return;
+    }
+    flush_idle(w);
+    put_varint(w, (uint64_t)len << TAG_BITS | TAG_COMMAND);
+    put_raw(w, command, len);
+}
+
+void archive_write_step(ArchiveWriter* w, const char departed[][VEHICLE_ID_LEN], uint16_t count) {
+    if (!(w->flags & ARCHIVE_HAS_DEPARTURES)) {
+        count = 0;
+    }
+    if (count > ARCHIVE_DEPARTURES_MAX) {
+        count = ARCHIVE_DEPARTURES_MAX;
+    }
+
+    if (count == 0) {
+        w->idle_run++;
+    } else {
+        flush_idle(w);
+        put_varint(w, (uint64_t)count << TAG_BITS | TAG_STEP);
+        for (uint16_t i = 0; i < count; i++) {
+            put_id(w, &w->departures, departed[i]);
+        }
+    }
+    w->step++;
+    w->current.steps++;
+
+    if (w->current.steps >= ARCHIVE_BLOCK_STEPS || w->block_len >= ARCHIVE_BLOCK_BYTES) {
+        end_block(w);
+    }
+}
+
+bool archive_writer_close(ArchiveWriter* w) {
+    end_block(w);
+
+    uint64_t index_offset = w->offset;
+    for (uint32_t i = 0; i < w->block_count && !w->failed; i++) {
+        uint8_t entry[INDEX_ENTRY_SIZE];
+        put_u64(entry, w->index[i].offset);
+        put_u32(entry + 8, w->index[i].length);
+        put_u32(entry + 12, w->index[i].first_step);
+        put_u32(entry + 16, w->index[i].steps);
+        put_u32(entry + 20, w->index[i].vehicles);
+        write_all(w, entry, sizeof(entry));
+    }
+
+    uint8_t trailer[TRAILER_SIZE];
+    put_u64(trailer, index_offset);
+    put_u32(trailer + 8, w->block_count);
+    put_u32(trailer + 12, w->step);
+    memcpy(trailer + 16, ARCHIVE_MAGIC, 4);
+    if (!w->failed) {
+        write_all(w, trailer, sizeof(trailer));
+    }
+
+    bool ok = !w->failed && fflush(w->file) == 0;
+    free(w->block);
+    free(w->index);
+    w->block = NULL;
+    w->index = NULL;
+    return ok;
+}
+
+// --- READER ---
+
+static bool get_varint(ArchiveReader* r, uint64_t* out) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 7 * VARINT_MAX; shift += 7) {
+        if (r->pos >= r->block_len) break;
+        uint8_t byte = r->block[r->pos++];
+        v |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *out = v;
+            return true;
+        }
+    }
+    r->corrupt = true;
+    return false;
+}
+
+static bool get_raw(ArchiveReader* r, void* data, size_t n) {
+    if (r->block_len - r->pos < n) {
+        r->corrupt = true;
+        return false;
+    }
+    memcpy(data, r->block + r->pos, n);
+    r->pos += n;
+    return true;
+}
+
+static bool get_id(ArchiveReader* r, ArchiveIdState* prev, char* id) {
+    uint64_t v, prefix_len, width;
+    if (!get_varint(r, &v)) return false;
+
+    prev->number += unzigzag(v >> ID_SLOT_BITS);
+    uint8_t slot = (uint8_t)(v & ((1u << ID_SLOT_BITS) - 1));
+    if (slot == ID_NEW_PREFIX) {
+        ArchiveIdPrefix* p = &prev->prefixes[prev->next_slot];
+        if (!get_varint(r, &prefix_len) || prefix_len > VEHICLE_ID_LEN - 1 ||
+            !get_raw(r, p->prefix, (size_t)prefix_len) || !get_varint(r, &width) ||
+            width > MAX_SUFFIX_DIGITS + 1) {
+            r->corrupt = true;
+            return false;
+        }
+        p->prefix_len = (uint8_t)prefix_len;
+        p->width = (uint8_t)width;
+        slot = prev->next_slot;
+        prev->next_slot = (prev->next_slot + 1) % ARCHIVE_ID_PREFIXES;
+    } else if (slot > ID_NEW_PREFIX) {
+        r->corrupt = true;
+        return false;
+    }
+    join_id(&prev->prefixes[slot], prev->number, id);
+    return true;
+}
+
+/**
+ * @brief Loads a block and resets the delta state.
+ */
+static bool load_block(ArchiveReader* r, uint32_t block) {
+    const ArchiveBlockInfo* info = &r->index[block];
+    uint8_t* buf = realloc(r->block, info->length ? info->length : 1);
+    if (!buf) {
+        r->corrupt = true;
+        return false;
+    }
+    r->block = buf;
+
+    if (fseek(r->file, (long)info->offset, SEEK_SET) != 0 ||
+        fread(r->block, 1, info->length, r->file) != info->length) {
+        r->corrupt = true;
+        return false;
+    }
+    r->block_len = info->length;
+    r->pos = 0;
+    r->next_block = block + 1;
+    r->step = info->first_step;
+    r->idle_left = 0;
+    memset(&r->arrivals, 0, sizeof(r->arrivals));
+    memset(&r->departures, 0, sizeof(r->departures));
+    return true;
+}
+
+bool archive_is_archive(FILE* file) {
+    long pos = ftell(file);
+    char magic[4];
+    bool match = pos >= 0 && fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                 memcmp(magic, ARCHIVE_MAGIC, 4) == 0;
+    if (pos >= 0) fseek(file, pos, SEEK_SET);
+    return match;
+}
+
+bool archive_reader_open(ArchiveReader* r, FILE* file) {
+    memset(r, 0, sizeof(*r));
+    r->file = file;
+
+    uint8_t header[HEADER_SIZE], trailer[TRAILER_SIZE];
+    if (fseek(file, 0, SEEK_SET) != 0 || fread(header, 1, sizeof(header), file) != sizeof(header) ||
+        memcmp(header, ARCHIVE_MAGIC, 4) != 0 || header[4] != ARCHIVE_VERSION ||
+        fseek(file, -(long)TRAILER_SIZE, SEEK_END) != 0 ||
+        fread(trailer, 1, sizeof(trailer), file) != sizeof(trailer) || memcmp(trailer + 16, ARCHIVE_MAGIC, 4) != 0) {
+        return false;
+    }
+    long end = ftell(file);
+    r->flags = header[5];
+    r->block_count = get_u32(trailer + 8);
+    r->total_steps = get_u32(trailer + 12);
+    uint64_t index_offset = get_u64(trailer);
+
+    if (end < 0 || index_offset + (uint64_t)r->block_count * INDEX_ENTRY_SIZE + TRAILER_SIZE != (uint64_t)end) {
+        return false;
+    }
+
+    r->index = malloc((r->block_count ? r->block_count : 1) * sizeof(ArchiveBlockInfo));
+    if (!r->index || fseek(file, (long)index_offset, SEEK_SET) != 0) {
+        archive_reader_close(r);
+        return false;
+    }
+
+    uint32_t expected_step = 0;
+    for (uint32_t i = 0; i < r->block_count; i++) {
+        uint8_t entry[INDEX_ENTRY_SIZE];
+        if (fread(entry, 1, sizeof(entry), file) != sizeof(entry)) {
+            archive_reader_close(r);
+            return false;
+        }
+        ArchiveBlockInfo* info = &r->index[i];
+        info->offset = get_u64(entry);
+        info->length = get_u32(entry + 8);
+        info->first_step = get_u32(entry + 12);
+        info->steps = get_u32(entry + 16);
+        info->vehicles = get_u32(entry + 20);
+
+        // Blocks are contiguous in steps and lie between the header and the index
+        if (info->first_step != expected_step || info->length > ARCHIVE_BLOCK_MAX ||
+            info->offset < HEADER_SIZE || info->offset + info->length > index_offset) {
+            archive_reader_close(r);
+            return false;
+        }
+        expected_step += info->steps;
+    }
+    if (expected_step != r->total_steps) {
+        archive_reader_close(r);
+        return false;
+    }
+    return true;
+}
+
+void archive_reader_close(ArchiveReader* r) {
+    free(r->index);
+    free(r->block);
+    r->index = NULL;
+    r->block = NULL;
+    r->block_count = 0;
+}
+
+/**
+ * @brief Decodes the next tag, loading the next block when needed.
+ *
+ * @return false at the end of the archive or on corrupt data
+ */
+static bool next_tag(ArchiveReader* r, uint64_t* tag) {
+    while (r->pos >= r->block_len) {
+        if (r->corrupt || r->next_block >= r->block_count) {
+            return false;
+        }
+        if (r->step != r->index[r->next_block].first_step) {
+            r->corrupt = true; // Block does not hold the steps its index entry claims
+            return false;
+        }
+        if (!load_block(r, r->next_block)) {
+            return false;
+        }
+    }
+    return get_varint(r, tag);
+}
+
+bool archive_reader_seek(ArchiveReader* r, uint32_t step) {
+    // Last block starting at or before the step
+    uint32_t lo = 0, hi = r->block_count;
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (r->index[mid].first_step <= step) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (r->block_count == 0) {
+        r->step = 0;
+        return true;
+    }
+    if (!load_block(r, lo)) {
+        return false;
+    }
+
+    // Skip the events of earlier steps (idle runs in one go)
+    ArchiveEvent skipped;
+    while (r->step < step) {
+        if (r->idle_left > 0) {
+            uint32_t n = step - r->step < r->idle_left ? step - r->step : r->idle_left;
+            r->idle_left -= n;
+            r->step += n;
+            continue;
+        }
+        if (r->pos < r->block_len && (r->block[r->pos] & ((1 << TAG_BITS) - 1)) == TAG_IDLE) {
+            uint64_t tag;
+            if (!get_varint(r, &tag) || (tag >> TAG_BITS) == 0 || (tag >> TAG_BITS) > UINT32_MAX) {
+                r->corrupt = true;
+                return false;
+            }
+            r->idle_left = (uint32_t)(tag >> TAG_BITS);
+            continue;
+        }
+        if (!archive_read_next(r, &skipped)) {
+            return !r->corrupt; // Window beyond the end
+        }
+    }
+    return true;
+}
+
+bool archive_read_next(ArchiveReader* r, ArchiveEvent* event) {
+    uint64_t tag;
+
+    if (r->idle_left == 0) {
+        if (!next_tag(r, &tag)) {
+            return false;
+        }
+    } else {
+        tag = TAG_IDLE; // Continues the current run
+    }
+
+    uint64_t arg = tag >> TAG_BITS;
+    event->step = r->step;
+    switch (tag & ((1 << TAG_BITS) - 1)) {
+        case TAG_IDLE:
+            if (r->idle_left == 0) {
+                if (arg == 0 || arg > UINT32_MAX) {
+                    r->corrupt = true;
+                    return false;
+                }
+                r->idle_left = (uint32_t)arg;
+            }
+            r->idle_left--;
+            event->type = ARCHIVE_EVENT_STEP;
+            event->departures = 0;
+            r->step++;
+            return true;
+
+        case TAG_STEP:
+            if (arg == 0 || arg > ARCHIVE_DEPARTURES_MAX) {
+                r->corrupt = true;
+                return false;
+            }
+            event->type = ARCHIVE_EVENT_STEP;
+            event->departures = (uint16_t)arg;
+            for (uint16_t i = 0; i < event->departures; i++) {
+                if (!get_id(r, &r->departures, event->departed[i])) return false;
+            }
+            r->step++;
+            return true;
+
+        case TAG_VEHICLE:
+            if (arg >= ROAD_COUNT * ROAD_COUNT) {
+                r->corrupt = true;
+                return false;
+            }
+            event->type = ARCHIVE_EVENT_VEHICLE;
+            event->start_road = (uint8_t)(arg / ROAD_COUNT);
+            event->end_road = (uint8_t)(arg % ROAD_COUNT);
+            event->arrival_time = r->step;
+            return get_id(r, &r->arrivals, event->id);
+
+        case TAG_VEHICLE_EXT: {
+            uint8_t roads[2];
+            uint64_t delta;
+            if (!get_raw(r, roads, sizeof(roads)) || !get_varint(r, &delta)) {
+                return false;
+            }
+            event->type = ARCHIVE_EVENT_VEHICLE;
+            event->start_road = roads[0];
+            event->end_road = roads[1];
+            event->arrival_time = (uint32_t)(r->step + unzigzag(delta));
+            return get_id(r, &r->arrivals, event->id);
+        }
+
+        case TAG_COMMAND:
+            if (arg == 0 || arg > ARCHIVE_COMMAND_MAX) {
+                r->corrupt = true;
+                return false;
+            }
+            event->type = ARCHIVE_EVENT_COMMAND;
+            event->command_len = (uint8_t)arg;
+            return get_raw(r, event->command, (size_t)arg);
+
+        default:
+            r->corrupt = true;
+            return false;
+    }
+}
+
+bool archive_export_commands(ArchiveReader* r, uint32_t to, FILE* out) {
+    ArchiveEvent e;
+    bool ok = true;
+
+    while (ok && archive_read_next(r, &e) && e.step < to) {
+        if (e.type == ARCHIVE_EVENT_VEHICLE) {
+            uint8_t command[sizeof(CmdHeader) + sizeof(PayloadAddVehicle)];
+            PayloadAddVehicle payload = {.start_road = e.start_road, .end_road = e.end_road,
+                                         .arrival_time = e.arrival_time};
+            memcpy(payload.vehicle_id, e.id, strlen(e.id));
+            command[0] = CMD_ADD_VEHICLE;
+            memcpy(command + sizeof(CmdHeader), &payload, sizeof(payload));
+            ok = fwrite(command, sizeof(command), 1, out) == 1;
+        } else if (e.type == ARCHIVE_EVENT_STEP) {
+            ok = fputc(CMD_STEP, out) != EOF;
+        } else {
+            ok = fwrite(e.command, e.command_len, 1, out) == 1;
+        }
+    }
+    return ok && !r->corrupt;
+}
@@ -0,0 +1,262 @@
+/**
+ * @file traffic_archive.h
+ * @brief Compressed archive of scenarios and their step outputs.
+ * @details An archive stores the scenario commands of a run (vehicles, steps,
+ * timing commands) and, optionally, the vehicles that left at every step (the
+ * stepStatuses of run_simulation.py). Instead of one JSON object or 39-byte
+ * command per event it stores:
+ *
+ * - steps implicitly: a vehicle belongs to the step it is written at, arrival
+ *   times are only stored when they differ from that step;
+ * - runs of idle steps (no vehicle added, none departed) as one count;
+ * - road pairs as 4 bits of the event tag;
+ * - vehicle IDs split into a text prefix and a numeric suffix; the suffix is
+ *   stored as a zigzag varint delta from the previous ID, the prefix as a slot
+ *   of the last ARCHIVE_ID_PREFIXES prefixes ("v_n_12", "v_s_13" alternate
+ *   between two slots). Arrivals and departures keep separate histories.
+ *
+ * The events are cut into blocks of at most ARCHIVE_BLOCK_STEPS steps (or about
+ * ARCHIVE_BLOCK_BYTES bytes) that are decoded independently. An index at the
+ * end of the file lists the first step of every block, so a time window is read
+ * by seeking to its first block instead of decoding the whole file.
+ *
+ * Layout (Little-Endian):
+ *
+ *     "TSAR" version:u8 flags:u8 reserved:u16
+ *     block*                                 (events, see traffic_archive.c)
+ *     ArchiveBlockInfo[block_count]          (index)
+ *     index_offset:u64 block_count:u32 total_steps:u32 "TSAR"
+ */
+
+#ifndef TRAFFIC_ARCHIVE_H
+#define TRAFFIC_ARCHIVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "traffic_fsm.h"
+
+#define ARCHIVE_MAGIC "TSAR"
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_BLOCK_STEPS 4096 // Steps per block (random access granularity)
+#define ARCHIVE_BLOCK_BYTES (64 * 1024) // A block is closed at the next step beyond this size
+#define ARCHIVE_BLOCK_MAX (64u * 1024 * 1024) // Largest block accepted by the reader
+#define ARCHIVE_COMMAND_MAX 64 // Largest raw command (header + payload)
+#define ARCHIVE_DEPARTURES_MAX (ROAD_COUNT * LANES_PER_ROAD) // Departures per step
+#define ARCHIVE_ID_PREFIXES 4 // Recent ID prefixes referenced by slot
+
+#define ARCHIVE_HAS_DEPARTURES 0x01 // Steps carry the IDs of the departing vehicles
+
+/**
+ * @brief Index entry of a block (24 bytes in the file).
+ */
+typedef struct {
+    uint64_t offset; // File offset of the block
+    uint32_t length; // Encoded size in bytes
+    uint32_t first_step; // Steps completed before the first event of the block
+    uint32_t steps; // Steps in the block
+    uint32_t vehicles; // Vehicles added in the block
+} ArchiveBlockInfo;
+
+/**
+ * @brief Text part of a vehicle ID and the format of its numeric suffix.
+ */
+typedef struct {
+    char prefix[VEHICLE_ID_LEN];
+    uint8_t prefix_len;
+    uint8_t width; // 0 = no numeric suffix, 1 = natural width, w + 1 = zero-padded to w digits
+} ArchiveIdPrefix;
+
+/**
+ * @brief ID history (delta coding state).
+ */
+typedef struct {
+    ArchiveIdPrefix prefixes[ARCHIVE_ID_PREFIXES]; // Recently used prefixes
+    uint8_t next_slot; // Slot replaced by the next new prefix
+    uint64_t number; // Numeric suffix of the previous ID
+} ArchiveIdState;
+
+/**
+ * @brief Archive being written.
+ */
+typedef struct {
+    FILE* file;
+    uint8_t flags;
+    bool failed; // Allocation or write error
+
+    uint8_t* block; // Events of the open block
+    size_t block_len;
+    size_t block_cap;
+    ArchiveBlockInfo current; // Index entry of the open block
+    uint32_t idle_run; // Idle steps not written yet
+    ArchiveIdState arrivals;
+    ArchiveIdState departures;
+
+    ArchiveBlockInfo* index;
+    uint32_t block_count;
+    uint32_t index_cap;
+    uint64_t offset; // Bytes written so far
+    uint32_t step; // Steps written so far
+} ArchiveWriter;
+
+/**
+ * @brief Kind of an archived event.
+ */
+typedef enum {
+    ARCHIVE_EVENT_VEHICLE, // CMD_ADD_VEHICLE
+    ARCHIVE_EVENT_STEP, // CMD_STEP and its departures
+    ARCHIVE_EVENT_COMMAND // Any other scenario command, stored verbatim
+} ArchiveEventType;
+
+/**
+ * @brief Decoded event.
+ */
+typedef struct {
+    ArchiveEventType type;
+    uint32_t step; // Steps completed before the event (index of the step for ARCHIVE_EVENT_STEP)
+
+    // ARCHIVE_EVENT_VEHICLE
+    char id[VEHICLE_ID_LEN];
+    uint8_t start_road;
+    uint8_t end_road;
+    uint32_t arrival_time;
+
+    // ARCHIVE_EVENT_STEP (departures only with ARCHIVE_HAS_DEPARTURES)
+    uint16_t departures;
+    char departed[ARCHIVE_DEPARTURES_MAX][VEHICLE_ID_LEN];
+
+    // ARCHIVE_EVENT_COMMAND (CmdHeader and payload)
+    uint8_t command[ARCHIVE_COMMAND_MAX];
+    uint8_t command_len;
+} ArchiveEvent;
+
+/**
+ * @brief Archive being read.
+ */
+typedef struct {
+    FILE* file;
+    uint8_t flags;
+    bool corrupt; // Truncated or inconsistent data was found
+
+    ArchiveBlockInfo* index;
+    uint32_t block_count;
+    uint32_t total_steps;
+
+    uint8_t* block; // Loaded block
+    size_t block_len;
+    size_t pos;
+    uint32_t next_block; // Block loaded by the next refill
+    uint32_t step; // Steps completed at the read position
+    uint32_t idle_left; // Idle steps of the current run not returned yet
+    ArchiveIdState arrivals;
+    ArchiveIdState departures;
+} ArchiveReader;
+
+/**
+ * @brief Starts an archive on a file opened for writing (the header is written here).
+ *
+ * @param w Pointer to ArchiveWriter
+ * @param file Output file (positioned at its start)
+ * @param flags ARCHIVE_HAS_DEPARTURES or 0
+ *
+ * @return false on write error
+ */
+bool archive_writer_open(ArchiveWriter* w, FILE* file, uint8_t flags);
+
+/**
+ * @brief Appends a vehicle added before the next step.
+ *
+ * @param w Pointer to ArchiveWriter
+ * @param id Vehicle ID (at most VEHICLE_ID_LEN - 1 characters are stored)
+ * @param start_road Origin direction (any value, stored verbatim)
+ * @param end_road Destination direction
+ * @param arrival_time Arrival time of the command (usually the current step)
+ */
+void archive_write_vehicle(ArchiveWriter* w, const char* id, uint8_t start_road, uint8_t end_road,
+                           uint32_t arrival_time);
+
+/**
+ * @brief Appends a scenario command other than CMD_ADD_VEHICLE / CMD_STEP.
+ *
+ * @param w Pointer to ArchiveWriter
+ * @param command CmdHeader and payload
+ * @param len Command size (at most ARCHIVE_COMMAND_MAX)
+ */
+void archive_write_command(ArchiveWriter* w, const uint8_t* command, size_t len);
+
+/**
+ * @brief Appends a step and the vehicles that left during it.
+ *
+ * @param w Pointer to ArchiveWriter
+ * @param departed IDs of the departing vehicles (ignored without ARCHIVE_HAS_DEPARTURES)
+ * @param count Number of departures (at most ARCHIVE_DEPARTURES_MAX)
+ */
+void archive_write_step(ArchiveWriter* w, const char departed[][VEHICLE_ID_LEN], uint16_t count);
+
+/**
+ * @brief Writes the last block, the index and the trailer, and releases the writer.
+ *
+ * @details The file itself is not closed.
+ *
+ * @param w Pointer to ArchiveWriter
+ * @return false if any write failed
+ */
+bool archive_writer_close(ArchiveWriter* w);
+
+/**
+ * @brief Opens an archive and loads its index; the reader starts at step 0.
+ *
+ * @param r Pointer to ArchiveReader
+ * @param file Archive opened for reading (must be seekable)
+ *
+ * @return false if the file is not a valid archive
+ */
+bool archive_reader_open(ArchiveReader* r, FILE* file);
+
+/**
+ * @brief Positions the reader at the first event of a step.
+ *
+ * @details Only the block holding the step is decoded: events of earlier
+ * blocks are never read. Timing commands issued before the window are not
+ * replayed.
+ *
+ * @param r Pointer to ArchiveReader
+ * @param step Steps completed before the first event to return
+ *
+ * @return false if the archive is corrupt
+ */
+bool archive_reader_seek(ArchiveReader* r, uint32_t step);
+
+/**
+ * @brief Decodes the next event.
+ *
+ * @param r Pointer to ArchiveReader
+ * @param event Decoded event
+ *
+ * @return false at the end of the archive or on corrupt data (see r->corrupt)
+ */
+bool archive_read_next(ArchiveReader* r, ArchiveEvent* event);
+
+/**
+ * @brief Writes the events before step `to` as a binary command stream (traffic_sim input).
+ *
+ * @param r Pointer to ArchiveReader (positioned with archive_reader_seek())
+ * @param to First step not written (UINT32_MAX for all)
+ * @param out Output stream
+ *
+ * @return false if the archive is corrupt or the output fails
+ */
+bool archive_export_commands(ArchiveReader* r, uint32_t to, FILE* out);
+
+/**
+ * @brief Releases the reader (the file is not closed).
+ */
+void archive_reader_close(ArchiveReader* r);
+
+/**
+ * @brief Checks whether a file starts with the archive magic (the position is restored).
+ */
+bool archive_is_archive(FILE* file);
+
+#endif // TRAFFIC_ARCHIVE_H
@@ -0,0 +1,241 @@
+/**
+ * @file traffic_estimate.c
+ * @brief Implementation of the analytical timing plan estimator.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "traffic_estimate.h"
+
+#define MAX_PHASES 8
+#define FIXED_POINT_ITERATIONS 20
+#define MIN_CAPACITY 1e-6f
+
+// --- INTERNAL DATA STRUCTURES ---
+
+/**
+ * @brief One selectable phase of the cycle (preparation, green and yellow states).
+ */
+typedef struct {
+    float lost_time; // Non-green steps of the phase
+    float base_green; // Green steps before extensions
+    bool served[ROAD_COUNT][LANES_PER_ROAD]; // Lanes with full green
+    bool arrow[ROAD_COUNT][LANES_PER_ROAD]; // Lanes with a permissive right arrow
+
+    // Fixed-point variables
+    float green; // Base green plus expected extension
+    float service_share; // Fraction of cycles in which the phase is not skipped
+} EstimatePhase;
+
+// --- HELPER FUNCTIONS ---
+
+/**
+ * @brief Number of steps spent in a state (a zero duration still takes one step).
+ */
+static inline float state_steps(const TimingConfig* timing, TrafficState state) {
+    uint32_t duration = traffic_state_duration(timing, state);
+    return (float)(duration > 0 ? duration : 1);
+}
+
+/**
+ * @brief Splits the standard cycle of the transition table into phases.
+ *
+ * @details A phase starts after a YELLOW state and ends with the next one,
+ * which is the point where the FSM selects (or skips) the following phase.
+ */
+static uint8_t build_phases(const TimingConfig* timing, EstimatePhase phases[MAX_PHASES]) {
+    uint8_t n_phases = 0;
+    TrafficState state = traffic_state_successor(STATE_ALL_RED);
+    TrafficState first = state;
+    EstimatePhase* phase = &phases[0];
+    memset(phases, 0, sizeof(EstimatePhase) * MAX_PHASES);
+
+    do {
+        LightColor lights[ROAD_COUNT][LANES_PER_ROAD];
+        traffic_state_lights(state, lights);
+
+        bool is_green = false;
+        bool is_yellow = false;
+        for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+            for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+                if (lights[road][lane] == LIGHT_GREEN) {
+                    phase->served[road][lane] = true;
+                    is_green = true;
+                } else if (lights[road][lane] == LIGHT_RIGHT_ARROW_GREEN) {
+                    phase->arrow[road][lane] = true;
+                } else if (lights[road][lane] == LIGHT_YELLOW) {
+                    is_yellow = true;
+                }
+            }
+        }
+
+        if (is_green) {
+            phase->base_green += state_steps(timing, state);
+        } else {
+            phase->lost_time += state_steps(timing, state);
+        }
+
+        if (is_yellow) {
+            n_phases++;
+            if (n_phases == MAX_PHASES) break;
+            phase = &phases[n_phases];
+        }
+
+        state = traffic_state_successor(state);
+    } while (state != first && state != STATE_ALL_RED);
+
+    return n_phases;
+}
+
+/**
+ * @brief Fraction of selections in which a phase runs, given the probability
+ * that it is empty and the starvation limit.
+ *
+ * @details Stationary distribution of the skip counter c = 0..skip_limit:
+ * the phase is skipped with probability p_empty while c < skip_limit.
+ */
+static float service_share(float p_empty, uint32_t skip_limit) {
+    if (p_empty >= 1.0f) {
+        return 1.0f / (float)(skip_limit + 1);
+    }
+    return (1.0f - p_empty) / (1.0f - powf(p_empty, (float)(skip_limit + 1)));
+}
+
+/**
+ * @brief Time-dependent overflow delay (HCM incremental delay, k = 0.5).
+ */
+static float incremental_delay(float saturation, float capacity, float horizon) {
+    float over = saturation - 1.0f;
+    return 0.25f * horizon * (over + sqrtf(over * over + 4.0f * saturation / (capacity * horizon)));
+}
+
+/**
+ * @brief Expected number of extension steps granted at the end of the base green.
+ */
+static float expected_extension(const TimingConfig* timing, float rate, float red, float base_green) {
+    float max_ext = (float)timing->max_ext;
+    float threshold = (float)timing->ext_threshold;
+
+    // Queue left over when the base green expires (one departure per step)
+    float residual = rate * (red + base_green) - base_green;
+    if (residual < threshold) {
+        return (threshold <= 0.0f) ? max_ext : 0.0f;
+    }
+    if (rate >= 1.0f) {
+        return max_ext;
+    }
+
+    float ext = (residual - threshold + 1.0f) / (1.0f - rate);
+    return (ext < max_ext) ? ext : max_ext;
+}
+
+// --- PUBLIC API IMPLEMENTATION ---
+
+void traffic_estimate(const TimingConfig* timing, const TrafficDemand* demand, TrafficEstimate* out) {
+    if (!timing || !demand || !out) return;
+    memset(out, 0, sizeof(TrafficEstimate));
+
+    EstimatePhase phases[MAX_PHASES];
+    uint8_t n_phases = build_phases(timing, phases);
+    if (n_phases == 0) return;
+
+    float horizon = (float)(demand->horizon > 0 ? demand->horizon : 1);
+
+    for (uint8_t p = 0; p < n_phases; p++) {
+        phases[p].green = phases[p].base_green;
+        phases[p].service_share = 1.0f;
+    }
+
+    // Cycle length, skipping and extensions depend on each other - iterate to a fixed point
+    float cycle = 1.0f;
+    for (uint8_t iter = 0; iter < FIXED_POINT_ITERATIONS; iter++) {
+        cycle = 0.0f;
+        for (uint8_t p = 0; p < n_phases; p++) {
+            cycle += phases[p].service_share * (phases[p].lost_time + phases[p].green);
+        }
+        if (cycle < 1.0f) cycle = 1.0f;
+
+        for (uint8_t p = 0; p < n_phases; p++) {
+            EstimatePhase* phase = &phases[p];
+            float total_rate = 0.0f;
+            float critical_rate = 0.0f;
+
+            for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+                for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+                    if (!phase->served[road][lane]) continue;
+
+                    float rate = demand->lane_rate[road][lane];
+                    total_rate += rate;
+                    if (rate > critical_rate) critical_rate = rate;
+                }
+            }
+
+            // Time between consecutive services of this phase, minus its own green
+            float interval = cycle / phase->service_share;
+            float red = interval - phase->green;
+            if (red < 0.0f) red = 0.0f;
+
+            // Saturated lanes never empty, otherwise Poisson arrivals during red
+            float p_empty = (critical_rate >= 1.0f) ? 0.0f : expf(-total_rate * red);
+            phase->service_share = service_share(p_empty, timing->skip_limit);
+            phase->green = phase->base_green + expected_extension(timing, critical_rate, red, phase->base_green);
+        }
+    }
+
+    float total_rate = 0.0f;
+    float left_rate = 0.0f;
+    out->cycle_length = cycle;
+
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            float rate = demand->lane_rate[road][lane];
+            float capacity = 0.0f;
+            float interval = horizon;
+
+            for (uint8_t p = 0; p < n_phases; p++) {
+                float green_share = phases[p].service_share * phases[p].green / cycle;
+                if (phases[p].served[road][lane]) {
+                    capacity += green_share;
+                    interval = cycle / phases[p].service_share;
+                } else if (phases[p].arrow[road][lane]) {
+                    // Arrow discharges only while a right-turning vehicle is at the head
+                    capacity += demand->right_share[road] * green_share;
+                }
+            }
+
+            if (rate <= 0.0f) continue;
+
+            float delay;
+            float worst;
+            if (capacity < MIN_CAPACITY) {
+                delay = 0.5f * horizon;
+                worst = horizon;
+                out->lane_growth[road][lane] = rate;
+            } else {
+                float saturation = rate / capacity;
+                float green_ratio = (capacity < 1.0f) ? capacity : 1.0f;
+                float bounded = (saturation < 1.0f) ? saturation : 1.0f;
+                float uniform = 0.5f * interval * (1.0f - green_ratio) * (1.0f - green_ratio) /
+                                (1.0f - bounded * green_ratio + MIN_CAPACITY);
+                float overflow = incremental_delay(saturation, capacity, horizon);
+
+                delay = uniform + overflow;
+                worst = interval * (1.0f - green_ratio) + 2.0f * overflow;
+                out->lane_growth[road][lane] = (rate > capacity) ? rate - capacity : 0.0f;
+            }
+
+            out->lane_delay[road][lane] = delay;
+            out->avg_delay += rate * delay;
+            total_rate += rate;
+            if (worst > out->max_delay) out->max_delay = worst;
+
+            if (lane == LANE_LEFT) {
+                out->left_delay += rate * delay;
+                left_rate += rate;
+            }
+        }
+    }
+
+    if (total_rate > 0.0f) out->avg_delay /= total_rate;
+    if (left_rate > 0.0f) out->left_delay /= left_rate;
+}
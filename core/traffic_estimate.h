@@ -0,0 +1,47 @@
+/**
+ * @file traffic_estimate.h
+ * @brief Analytical pre-screen evaluator for candidate timing plans.
+ * @details Predicts per-lane delay and queue growth of a TimingConfig from lane
+ * arrival rates, without simulating. Uses a cycle-based queueing approximation
+ * (Webster uniform delay plus a time-dependent overflow term) on top of the phase
+ * structure of the FSM transition table, including phase skipping and green
+ * extension caps. Intended for ranking candidates, not for exact metrics.
+ */
+
+#ifndef TRAFFIC_ESTIMATE_H
+#define TRAFFIC_ESTIMATE_H
+
+#include <stdint.h>
+#include "traffic_fsm.h"
+
+/**
+ * @brief Traffic demand of a scenario.
+ */
+typedef struct {
+    float lane_rate[ROAD_COUNT][LANES_PER_ROAD]; // Mean arrivals per step
+    float right_share[ROAD_COUNT]; // Share of right turns in the straight/right lane
+    uint32_t horizon; // Scenario length in steps
+} TrafficDemand;
+
+/**
+ * @brief Predicted performance of a timing configuration.
+ */
+typedef struct {
+    float lane_delay[ROAD_COUNT][LANES_PER_ROAD]; // Mean wait (steps)
+    float lane_growth[ROAD_COUNT][LANES_PER_ROAD]; // Queue growth (vehicles per step)
+    float cycle_length; // Mean cycle length (steps)
+    float avg_delay; // Demand-weighted mean wait (AWT)
+    float max_delay; // Worst-case wait estimate (MAX)
+    float left_delay; // Demand-weighted mean wait of left turns (LEFT)
+} TrafficEstimate;
+
+/**
+ * @brief Estimates the performance of a timing configuration.
+ *
+ * @param timing Candidate configuration
+ * @param demand Scenario arrival rates
+ * @param out Estimate to fill
+ */
+void traffic_estimate(const TimingConfig* timing, const TrafficDemand* demand, TrafficEstimate* out);
+
+#endif // TRAFFIC_ESTIMATE_H
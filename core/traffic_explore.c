@@ -0,0 +1,703 @@
+/**
+ * @file traffic_explore.c
+ * @brief Implementation of the worst-case wait explorer.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "traffic_explore.h"
+
+// --- INTERNAL DATA STRUCTURES ---
+
+#define LANE_COUNT (ROAD_COUNT * LANES_PER_ROAD) // Lane index = road * LANES_PER_ROAD + lane
+#define LEVEL_MAX 3
+#define SKIP_MAX 15
+#define TIMER_MAX 255
+
+#define EMPTY_SLOT UINT64_MAX
+#define ARRIVALS_MAX 6561 // 9 level pairs per signal group
+
+/**
+ * @brief Abstract controller state after a step (before the next arrivals).
+ *
+ * @details Packed as state:4 | timer:8 | ext:8 | skip:4x4 | level:8x2 (52 bits).
+ */
+typedef struct {
+    uint8_t state;
+    uint8_t timer;
+    uint8_t ext;
+    uint8_t skip[ROAD_COUNT];
+    uint8_t level[LANE_COUNT];
+} AbstractState;
+
+/**
+ * @brief Hash set of packed states, numbered in insertion order.
+ */
+typedef struct {
+    uint64_t* slots;
+    uint32_t* slot_index;
+    uint32_t capacity; // Power of two
+    uint64_t* keys; // Insertion order, doubles as BFS queue
+    uint32_t count;
+    uint32_t keys_capacity;
+} StateSet;
+
+/**
+ * @brief Transition of the wait analysis: target node and whether the tracked lane discharged.
+ */
+typedef uint32_t Edge; // target << 1 | discharged
+
+typedef struct {
+    TimingConfig timing;
+    const TrafficStrategy* hooks;
+    TrafficStrategyId strategy;
+    uint8_t level_cap; // C
+    uint8_t timer_cap;
+    uint8_t ext_cap;
+    TrafficSystem* sys; // Scratch system evaluating the real decisions
+    uint8_t (*arrivals)[LANE_COUNT]; // Scratch for collect_arrivals()
+} Explorer;
+
+// --- HELPER FUNCTIONS ---
+
+static uint64_t pack_state(const AbstractState* s) {
+    uint64_t key = (uint64_t)s->state | (uint64_t)s->timer << 4 | (uint64_t)s->ext << 12;
+    for (uint8_t i = 0; i < ROAD_COUNT; i++) {
+        key |= (uint64_t)s->skip[i] << (20 + 4 * i);
+    }
+    for (uint8_t i = 0; i < LANE_COUNT; i++) {
+        key |= (uint64_t)s->level[i] << (36 + 2 * i);
+    }
+    return key;
+}
+
+static void unpack_state(uint64_t key, AbstractState* s) {
+    s->state = key & 0xF;
+    s->timer = (key >> 4) & 0xFF;
+    s->ext = (key >> 12) & 0xFF;
+    for (uint8_t i = 0; i < ROAD_COUNT; i++) {
+        s->skip[i] = (key >> (20 + 4 * i)) & 0xF;
+    }
+    for (uint8_t i = 0; i < LANE_COUNT; i++) {
+        s->level[i] = (key >> (36 + 2 * i)) & 0x3;
+    }
+}
+
+static inline uint32_t hash_key(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return (uint32_t)key;
+}
+
+static void set_free(StateSet* set) {
+    free(set->slots);
+    free(set->slot_index);
+    free(set->keys);
+    memset(set, 0, sizeof(StateSet));
+}
+
+static bool set_init(StateSet* set, uint32_t capacity) {
+    memset(set, 0, sizeof(StateSet));
+    set->capacity = capacity;
+    set->keys_capacity = capacity / 2;
+    set->slots = malloc(capacity * sizeof(uint64_t));
+    set->slot_index = malloc(capacity * sizeof(uint32_t));
+    set->keys = malloc(set->keys_capacity * sizeof(uint64_t));
+    if (!set->slots || !set->slot_index || !set->keys) {
+        set_free(set);
+        return false;
+    }
+    memset(set->slots, 0xFF, capacity * sizeof(uint64_t));
+    return true;
+}
+
+static uint32_t set_find_slot(const StateSet* set, uint64_t key) {
+    uint32_t mask = set->capacity - 1;
+    uint32_t slot = hash_key(key) & mask;
+    while (set->slots[slot] != EMPTY_SLOT && set->slots[slot] != key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static bool set_grow(StateSet* set) {
+    StateSet grown;
+    if (set->capacity >= 2 * EXPLORE_MAX_STATES || !set_init(&grown, set->capacity * 2)) {
+        return false;
+    }
+    memcpy(grown.keys, set->keys, set->count * sizeof(uint64_t));
+    grown.count = set->count;
+    for (uint32_t i = 0; i < set->count; i++) {
+        uint32_t slot = set_find_slot(&grown, set->keys[i]);
+        grown.slots[slot] = set->keys[i];
+        grown.slot_index[slot] = i;
+    }
+    set_free(set);
+    *set = grown;
+    return true;
+}
+
+/**
+ * @brief Inserts a key (load factor kept at 1/2).
+ *
+ * @return Index of the key, UINT32_MAX if the set cannot grow
+ */
+static uint32_t set_insert(StateSet* set, uint64_t key) {
+    uint32_t slot = set_find_slot(set, key);
+    if (set->slots[slot] == key) {
+        return set->slot_index[slot];
+    }
+    if (set->count == set->keys_capacity) {
+        if (!set_grow(set)) return UINT32_MAX;
+        slot = set_find_slot(set, key);
+    }
+
+    set->slots[slot] = key;
+    set->slot_index[slot] = set->count;
+    set->keys[set->count] = key;
+    return set->count++;
+}
+
+static uint32_t max_duration(const TimingConfig* timing) {
+    uint32_t longest = 0;
+    for (uint8_t state = 0; state <= STATE_EW_LEFT_YELLOW; state++) {
+        uint32_t duration = traffic_state_duration(timing, (TrafficState)state);
+        if (duration > longest) longest = duration;
+    }
+    return longest;
+}
+
+// --- CORE EXPLORATION ---
+
+/**
+ * @brief Effect of one controller step, shared by all arrivals the controller cannot tell apart.
+ */
+typedef struct {
+    AbstractState next; // Controller part of the next state
+    uint8_t served; // Lanes discharging in the next state (green or right arrow), bit = lane index
+    uint8_t green; // Lanes with a full green light in the next state
+} StepOutcome;
+
+/**
+ * @brief Outcomes of the steps from one state, indexed by the observation (see observe()).
+ */
+typedef struct {
+    StepOutcome outcome[1u << (MOVEMENT_COUNT + 1)];
+    uint32_t valid;
+} OutcomeCache;
+
+static uint8_t lane_mask(const LightColor lights[ROAD_COUNT][LANES_PER_ROAD], bool arrows) {
+    uint8_t mask = 0;
+    for (uint8_t i = 0; i < LANE_COUNT; i++) {
+        LightColor color = lights[i / LANES_PER_ROAD][i % LANES_PER_ROAD];
+        if (color == LIGHT_GREEN || (arrows && color == LIGHT_RIGHT_ARROW_GREEN)) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+/**
+ * @brief What the decision can see of the queue levels.
+ *
+ * @details Phase selection only checks whether a signal group (a lane and the one
+ * on the opposite road) is empty, the extension whether a green lane reaches
+ * ext_threshold. Levels with the same observation lead to the same decision.
+ */
+static uint8_t observe(const Explorer* ex, uint8_t green_now, const uint8_t level[LANE_COUNT]) {
+    uint8_t key = 0;
+    for (uint8_t group = 0; group < MOVEMENT_COUNT; group++) {
+        if (level[group] || level[group + MOVEMENT_COUNT]) key |= 1u << group;
+    }
+    for (uint8_t i = 0; i < LANE_COUNT; i++) {
+        if ((green_now & (1u << i)) && level[i] >= ex->timing.ext_threshold) {
+            key |= 1u << MOVEMENT_COUNT;
+        }
+    }
+    return key;
+}
+
+/**
+ * @brief What the decision can see of one signal group (bit 0 non-empty, bit 1 extension).
+ */
+static uint8_t observe_group(const Explorer* ex, uint8_t green_now, uint8_t group, uint8_t first, uint8_t second) {
+    uint8_t second_lane = group + MOVEMENT_COUNT;
+    bool extend = ((green_now & (1u << group)) && first >= ex->timing.ext_threshold) ||
+                  ((green_now & (1u << second_lane)) && second >= ex->timing.ext_threshold);
+    return (uint8_t)((first || second) | extend << 1);
+}
+
+/**
+ * @brief Queue levels after the arrivals of a step that are worth exploring.
+ *
+ * @details Higher levels never help the adversary: from a state with lower levels
+ * the next arrivals can still reach every higher one. Each signal group keeps only
+ * the minimal levels of what the decision can see of it, built from three candidates
+ * per lane: unchanged, non-empty and at ext_threshold. The result is their product.
+ *
+ * @return Number of level vectors written to out (at most ARRIVALS_MAX)
+ */
+static uint32_t collect_arrivals(const Explorer* ex, uint8_t green_now, const uint8_t base[LANE_COUNT],
+                                 uint8_t out[][LANE_COUNT]) {
+    uint8_t options[MOVEMENT_COUNT][9][2], n_options[MOVEMENT_COUNT];
+
+    for (uint8_t group = 0; group < MOVEMENT_COUNT; group++) {
+        uint8_t candidates[2][3], n_candidates[2];
+        for (uint8_t side = 0; side < 2; side++) {
+            uint8_t level = base[group + side * MOVEMENT_COUNT], n = 0;
+            candidates[side][n++] = level;
+            if (level < 1) candidates[side][n++] = 1;
+            if (ex->timing.ext_threshold > candidates[side][n - 1]) {
+                candidates[side][n++] = (uint8_t)ex->timing.ext_threshold;
+            }
+            n_candidates[side] = n;
+        }
+
+        n_options[group] = 0;
+        for (uint8_t i = 0; i < n_candidates[0]; i++) {
+            for (uint8_t j = 0; j < n_candidates[1]; j++) {
+                uint8_t first = candidates[0][i], second = candidates[1][j];
+                uint8_t key = observe_group(ex, green_now, group, first, second);
+
+                // Minimal if lowering a raised lane changes what the decision sees
+                if (i > 0 && observe_group(ex, green_now, group, candidates[0][i - 1], second) == key) continue;
+                if (j > 0 && observe_group(ex, green_now, group, first, candidates[1][j - 1]) == key) continue;
+
+                options[group][n_options[group]][0] = first;
+                options[group][n_options[group]][1] = second;
+                n_options[group]++;
+            }
+        }
+    }
+
+    uint8_t pick[MOVEMENT_COUNT] = {0};
+    uint32_t count = 0;
+    for (;;) {
+        for (uint8_t group = 0; group < MOVEMENT_COUNT; group++) {
+            out[count][group] = options[group][pick[group]][0];
+            out[count][group + MOVEMENT_COUNT] = options[group][pick[group]][1];
+        }
+        count++;
+
+        uint8_t group = 0;
+        while (group < MOVEMENT_COUNT && ++pick[group] == n_options[group]) {
+            pick[group++] = 0;
+        }
+        if (group == MOVEMENT_COUNT) return count;
+    }
+}
+
+/**
+ * @brief One controller step with the queue levels seen after the arrivals.
+ *
+ * @details Runs the real decision on the scratch system. Lane levels of the next
+ * state are left to the caller, which knows how the discharges are resolved.
+ */
+static const StepOutcome* controller_step(Explorer* ex, const AbstractState* s, uint8_t green_now,
+                                          const uint8_t level[LANE_COUNT], OutcomeCache* cache) {
+    uint8_t key = observe(ex, green_now, level);
+    StepOutcome* out = &cache->outcome[key];
+    if (cache->valid & (1u << key)) {
+        return out;
+    }
+
+    char discard_ids[LANE_COUNT][VEHICLE_ID_LEN]; // Never written: queues are empty at apply
+    TrafficSystem* sys = ex->sys;
+
+    sys->current_state = (TrafficState)s->state;
+    sys->state_timer = s->timer + 1u; // traffic_fsm_advance_clock()
+    sys->extension_timer = s->ext;
+    memcpy(sys->phase_skip_counters, s->skip, ROAD_COUNT);
+    ex->hooks->state_lights(sys->current_state, sys->lights);
+    for (uint8_t i = 0; i < LANE_COUNT; i++) {
+        sys->queues[i / LANES_PER_ROAD][i % LANES_PER_ROAD].count = level[i];
+    }
+
+    TrafficDecision decision;
+    traffic_fsm_decide(sys, &ex->timing, &decision);
+
+    for (uint8_t i = 0; i < LANE_COUNT; i++) {
+        sys->queues[i / LANES_PER_ROAD][i % LANES_PER_ROAD].count = 0;
+    }
+    traffic_fsm_apply(sys, &decision, discard_ids);
+
+    out->next.state = (uint8_t)sys->current_state;
+    out->next.timer = (uint8_t)(sys->state_timer < ex->timer_cap ? sys->state_timer : ex->timer_cap);
+    out->next.ext = (uint8_t)(sys->extension_timer < ex->ext_cap ? sys->extension_timer : ex->ext_cap);
+    memcpy(out->next.skip, sys->phase_skip_counters, ROAD_COUNT);
+    out->served = lane_mask((const LightColor (*)[LANES_PER_ROAD])sys->lights, true);
+    out->green = lane_mask((const LightColor (*)[LANES_PER_ROAD])sys->lights, false);
+
+    cache->valid |= 1u << key;
+    return out;
+}
+
+/**
+ * @brief Green lanes of a state (the ones the extension looks at).
+ */
+static uint8_t green_lanes(const Explorer* ex, uint8_t state) {
+    LightColor lights[ROAD_COUNT][LANES_PER_ROAD];
+    ex->hooks->state_lights((TrafficState)state, lights);
+    return lane_mask((const LightColor (*)[LANES_PER_ROAD])lights, false);
+}
+
+/**
+ * @brief Next state with every served lane discharged.
+ */
+static void discharge(const StepOutcome* outcome, const uint8_t level[LANE_COUNT], AbstractState* next) {
+    *next = outcome->next;
+    for (uint8_t i = 0; i < LANE_COUNT; i++) {
+        bool served = outcome->served & (1u << i);
+        next->level[i] = (served && level[i] > 0) ? level[i] - 1 : level[i];
+    }
+}
+
+/**
+ * @brief All controller states reachable from the power-on state.
+ *
+ * @details After a discharge a lane keeps the lowest level it can have: higher
+ * levels are reached anyway by the arrivals of the next step, so the controller
+ * states (and every wait) are the same as with all discharge outcomes.
+ */
+static bool explore_reachable(Explorer* ex, StateSet* reachable) {
+    AbstractState init = {0};
+    init.state = STATE_ALL_RED;
+    if (set_insert(reachable, pack_state(&init)) == UINT32_MAX) return false;
+
+    for (uint32_t n = 0; n < reachable->count; n++) {
+        AbstractState s;
+        unpack_state(reachable->keys[n], &s);
+
+        OutcomeCache cache;
+        cache.valid = 0;
+        uint8_t green_now = green_lanes(ex, s.state);
+
+        uint32_t n_arrivals = collect_arrivals(ex, green_now, s.level, ex->arrivals);
+        for (uint32_t a = 0; a < n_arrivals; a++) {
+            const uint8_t* level = ex->arrivals[a];
+            AbstractState next;
+            discharge(controller_step(ex, &s, green_now, level, &cache), level, &next);
+            if (set_insert(reachable, pack_state(&next)) == UINT32_MAX) return false;
+        }
+    }
+    return true;
+}
+
+static int compare_edges(const void* a, const void* b) {
+    Edge x = *(const Edge*)a, y = *(const Edge*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Graph of the steps of a vehicle waiting in one lane.
+ *
+ * @details Nodes are controller states with the tracked lane non-empty, the first
+ * reachable->count nodes are the states in which the vehicle may arrive. Discharging
+ * edges lead to the state the lane is in if the vehicle is not the one leaving.
+ */
+typedef struct {
+    StateSet nodes;
+    uint32_t* first_edge; // CSR offsets, nodes.count + 1 entries
+    Edge* edges;
+    uint32_t n_edges;
+    uint32_t edges_capacity;
+} WaitGraph;
+
+static void graph_free(WaitGraph* g) {
+    set_free(&g->nodes);
+    free(g->first_edge);
+    free(g->edges);
+}
+
+static bool graph_push_edge(WaitGraph* g, Edge edge) {
+    if (g->n_edges == g->edges_capacity) {
+        uint32_t capacity = g->edges_capacity ? g->edges_capacity * 2 : 1024;
+        Edge* grown = realloc(g->edges, capacity * sizeof(Edge));
+        if (!grown) return false;
+        g->edges = grown;
+        g->edges_capacity = capacity;
+    }
+    g->edges[g->n_edges++] = edge;
+    return true;
+}
+
+static bool build_wait_graph(Explorer* ex, const StateSet* reachable, uint8_t lane, WaitGraph* g) {
+    uint32_t offsets_capacity = 0;
+
+    memset(g, 0, sizeof(WaitGraph));
+    if (!set_init(&g->nodes, reachable->capacity)) return false;
+    for (uint32_t n = 0; n < reachable->count; n++) {
+        if (set_insert(&g->nodes, reachable->keys[n]) == UINT32_MAX) return false;
+    }
+
+    for (uint32_t n = 0; n < g->nodes.count; n++) {
+        if (n + 2 > offsets_capacity) {
+            offsets_capacity = offsets_capacity ? offsets_capacity * 2 : 1024;
+            uint32_t* grown = realloc(g->first_edge, offsets_capacity * sizeof(uint32_t));
+            if (!grown) return false;
+            g->first_edge = grown;
+        }
+        g->first_edge[n] = g->n_edges;
+
+        AbstractState s;
+        unpack_state(g->nodes.keys[n], &s);
+
+        OutcomeCache cache;
+        cache.valid = 0;
+        uint8_t green_now = green_lanes(ex, s.state);
+
+        uint8_t base[LANE_COUNT];
+        memcpy(base, s.level, LANE_COUNT);
+        if (base[lane] == 0) base[lane] = 1; // The vehicle itself
+
+        uint32_t n_arrivals = collect_arrivals(ex, green_now, base, ex->arrivals);
+        for (uint32_t a = 0; a < n_arrivals; a++) {
+            const uint8_t* level = ex->arrivals[a];
+            const StepOutcome* outcome = controller_step(ex, &s, green_now, level, &cache);
+            AbstractState next;
+            discharge(outcome, level, &next);
+
+            // The tracked lane: a green light always discharges it, an arrow may not
+            bool served = outcome->served & (1u << lane);
+            bool green = outcome->green & (1u << lane);
+            for (int discharged = 1; discharged >= 0; discharged--) {
+                if (discharged ? !served : green) continue;
+
+                next.level[lane] = discharged ? (level[lane] > 1 ? level[lane] - 1 : 1) : level[lane];
+                uint32_t target = set_insert(&g->nodes, pack_state(&next));
+                if (target == UINT32_MAX || !graph_push_edge(g, target << 1 | (Edge)discharged)) {
+                    return false;
+                }
+            }
+        }
+
+        // Distinct edges only
+        uint32_t begin = g->first_edge[n], end = begin;
+        qsort(&g->edges[begin], g->n_edges - begin, sizeof(Edge), compare_edges);
+        for (uint32_t e = begin; e < g->n_edges; e++) {
+            if (e == begin || g->edges[e] != g->edges[end - 1]) {
+                g->edges[end++] = g->edges[e];
+            }
+        }
+        g->n_edges = end;
+    }
+    g->first_edge[g->nodes.count] = g->n_edges;
+    return true;
+}
+
+/**
+ * @brief Orders the nodes so that non-discharging edges point to earlier nodes.
+ *
+ * @return false if non-discharging edges form a cycle (the lane can starve)
+ * or memory runs out (*out_of_memory set)
+ */
+static bool order_wait_graph(const WaitGraph* g, uint32_t* order, bool* out_of_memory) {
+    uint32_t n_nodes = g->nodes.count;
+    uint8_t* color = calloc(n_nodes, 1); // 0 new, 1 on stack, 2 done
+    uint32_t* stack = malloc(n_nodes * sizeof(uint32_t));
+    uint32_t* cursor = malloc(n_nodes * sizeof(uint32_t));
+    uint32_t n_ordered = 0;
+    bool acyclic = true;
+
+    *out_of_memory = !color || !stack || !cursor;
+    for (uint32_t root = 0; root < n_nodes && acyclic && !*out_of_memory; root++) {
+        if (color[root]) continue;
+
+        uint32_t depth = 0;
+        stack[depth++] = root;
+        color[root] = 1;
+        cursor[root] = g->first_edge[root];
+
+        while (depth > 0 && acyclic) {
+            uint32_t n = stack[depth - 1];
+            if (cursor[n] == g->first_edge[n + 1]) {
+                color[n] = 2;
+                order[n_ordered++] = n;
+                depth--;
+                continue;
+            }
+
+            Edge edge = g->edges[cursor[n]++];
+            if (edge & 1) continue;
+
+            uint32_t target = edge >> 1;
+            if (color[target] == 1) {
+                acyclic = false;
+            } else if (color[target] == 0) {
+                color[target] = 1;
+                cursor[target] = g->first_edge[target];
+                stack[depth++] = target;
+            }
+        }
+    }
+
+    free(color);
+    free(stack);
+    free(cursor);
+    return acyclic && !*out_of_memory;
+}
+
+/**
+ * @brief Longest waits of a vehicle in one lane, for 1 and for MAX_VEHICLES_PER_ROAD discharges.
+ */
+static bool analyse_lane(Explorer* ex, const StateSet* reachable, uint8_t lane,
+                         uint32_t* starvation, uint32_t* max_wait, uint32_t* n_nodes) {
+    WaitGraph g;
+    bool ok = build_wait_graph(ex, reachable, lane, &g);
+    if (!ok) {
+        graph_free(&g);
+        return false;
+    }
+
+    uint32_t count = g.nodes.count;
+    uint32_t* order = malloc(count * sizeof(uint32_t));
+    uint32_t* prev = malloc(count * sizeof(uint32_t)); // Longest wait, one discharge less
+    uint32_t* cur = malloc(count * sizeof(uint32_t));
+    bool out_of_memory = !order || !prev || !cur;
+    *n_nodes = count;
+
+    if (!out_of_memory && !order_wait_graph(&g, order, &out_of_memory)) {
+        *starvation = *max_wait = EXPLORE_UNBOUNDED;
+    } else if (!out_of_memory) {
+        for (uint32_t needed = 1; needed <= MAX_VEHICLES_PER_ROAD; needed++) {
+            for (uint32_t i = 0; i < count; i++) {
+                uint32_t n = order[i], longest = 0;
+                for (uint32_t e = g.first_edge[n]; e < g.first_edge[n + 1]; e++) {
+                    uint32_t target = g.edges[e] >> 1;
+                    uint32_t wait = 1;
+                    if (!(g.edges[e] & 1)) {
+                        wait += cur[target];
+                    } else if (needed > 1) {
+                        wait += prev[target];
+                    }
+                    if (wait > longest) longest = wait;
+                }
+                cur[n] = longest;
+            }
+
+            uint32_t worst = 0;
+            for (uint32_t n = 0; n < reachable->count; n++) {
+                if (cur[n] > worst) worst = cur[n];
+            }
+            if (needed == 1) *starvation = worst;
+            *max_wait = worst;
+
+            uint32_t* swap = prev;
+            prev = cur;
+            cur = swap;
+        }
+    }
+
+    free(order);
+    free(prev);
+    free(cur);
+    graph_free(&g);
+    return !out_of_memory;
+}
+
+// --- PUBLIC API ---
+
+bool traffic_explore(const TimingConfig* timing, TrafficStrategyId strategy, ExploreBounds* out) {
+    if (!timing || !out || strategy >= STRATEGY_COUNT || strategy == STRATEGY_V5) {
+        return false;
+    }
+
+    uint32_t duration = max_duration(timing);
+    if (duration > TIMER_MAX || timing->max_ext > TIMER_MAX ||
+        timing->ext_threshold > LEVEL_MAX || timing->skip_limit > SKIP_MAX) {
+        return false;
+    }
+
+    Explorer ex = {
+        .timing = *timing,
+        .hooks = traffic_get_strategy(strategy),
+        .strategy = strategy,
+        .level_cap = (uint8_t)(timing->ext_threshold > 1 ? timing->ext_threshold : 1),
+        .timer_cap = (uint8_t)duration,
+        .ext_cap = (uint8_t)timing->max_ext,
+        .sys = malloc(sizeof(TrafficSystem)),
+        .arrivals = malloc(ARRIVALS_MAX * LANE_COUNT)
+    };
+    if (!ex.sys || !ex.arrivals) {
+        free(ex.sys);
+        free(ex.arrivals);
+        return false;
+    }
+    traffic_init(ex.sys, *timing);
+    traffic_set_strategy(ex.sys, strategy);
+
+    StateSet reachable;
+    bool ok = set_init(&reachable, 1u << 12) && explore_reachable(&ex, &reachable);
+
+    memset(out, 0, sizeof(ExploreBounds));
+    out->states = reachable.count;
+    for (uint8_t movement = 0; ok && movement < MOVEMENT_COUNT; movement++) {
+        // Movement index = axis * LANES_PER_ROAD + lane = lane index on the first road of the axis
+        uint32_t n_nodes = 0;
+        ok = analyse_lane(&ex, &reachable, movement, &out->starvation[movement],
+                          &out->max_wait[movement], &n_nodes);
+        if (n_nodes > out->tagged_states) out->tagged_states = n_nodes;
+    }
+
+    set_free(&reachable);
+    free(ex.sys);
+    free(ex.arrivals);
+    return ok;
+}
+
+typedef struct {
+    const TimingConfig* configs;
+    uint32_t n_configs;
+    TrafficStrategyId strategy;
+    ExploreBounds* out;
+    bool* ok;
+
+    pthread_mutex_t lock;
+    uint32_t next;
+} GridJob;
+
+static void* grid_worker(void* arg) {
+    GridJob* job = arg;
+
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        uint32_t i = job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (i >= job->n_configs) return NULL;
+
+        job->ok[i] = traffic_explore(&job->configs[i], job->strategy, &job->out[i]);
+    }
+}
+
+bool traffic_explore_grid(const TimingConfig* configs, uint32_t n_configs, TrafficStrategyId strategy,
+                          uint32_t threads, ExploreBounds* out, bool* ok) {
+    if (!configs || !out || !ok) return false;
+
+    GridJob job = {
+        .configs = configs, .n_configs = n_configs, .strategy = strategy,
+        .out = out, .ok = ok, .next = 0
+    };
+    if (pthread_mutex_init(&job.lock, NULL) != 0) {
+        return false;
+    }
+    if (threads > n_configs) threads = n_configs;
+
+    pthread_t* workers = (threads > 1) ? malloc(threads * sizeof(pthread_t)) : NULL;
+
+    uint32_t started = 0;
+    while (workers && started < threads && pthread_create(&workers[started], NULL, grid_worker, &job) == 0) {
+        started++;
+    }
+    if (started == 0) {
+        grid_worker(&job); // Single thread, or none could be started: run on the caller
+    }
+    for (uint32_t i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    pthread_mutex_destroy(&job.lock);
+    free(workers);
+    return true;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file traffic_explore.h
+ * @brief Exhaustive state-space explorer certifying worst-case waits.
+ * @details Explores every controller state reachable under arbitrary (adversarial)
+ * arrivals and computes upper bounds on the wait of a vehicle, per movement, that
+ * hold for every possible scenario. The controller decisions are evaluated with
+ * traffic_fsm_decide() and traffic_fsm_apply() on a scratch system, so the bounds
+ * are about the production code, not about a model of it.
+ *
+ * Abstraction (sound: it allows every real behaviour, and possibly more):
+ * - timers saturate at the longest duration / max_ext, beyond which no decision changes;
+ * - a lane queue is kept as a level 0..C with C = max(ext_threshold, 1), C meaning
+ *   "C or more", which is all the decisions can observe;
+ * - the head of a lane under a right arrow may or may not turn right.
+ * A vehicle is tracked with the number of discharges its lane needs before it
+ * leaves (1 at the head, up to MAX_VEHICLES_PER_ROAD behind a full queue), and the
+ * longest path to that many discharges is the bound. A cycle without discharge
+ * means the lane can starve (EXPLORE_UNBOUNDED).
+ *
+ * States are bit-packed into 64 bits and kept in an open-addressing hash set.
+ */
+
+#ifndef TRAFFIC_EXPLORE_H
+#define TRAFFIC_EXPLORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "traffic_fsm.h"
+
+#define EXPLORE_UNBOUNDED UINT32_MAX // Wait bound of a lane that can starve
+#define EXPLORE_MAX_STATES (1u << 24) // Exploration gives up beyond this many states
+
+/**
+ * @brief Certified bounds of one configuration.
+ *
+ * @details Waits are in steps, measured like TrafficStats.max_wait. Movement
+ * index = axis * LANES_PER_ROAD + lane (see traffic_movement_wait_hist()).
+ */
+typedef struct {
+    uint32_t starvation[MOVEMENT_COUNT]; // Longest wait of a vehicle arriving at an empty lane
+    uint32_t max_wait[MOVEMENT_COUNT]; // Longest wait of a vehicle, any queue up to its capacity
+    uint32_t states; // Reachable abstract controller states
+    uint32_t tagged_states; // Largest state set of the per-movement wait analysis
+} ExploreBounds;
+
+/**
+ * @brief Computes the certified wait bounds of a timing configuration.
+ *
+ * @details Supported strategies are those whose decisions only see empty lanes and
+ * the extension threshold (all but STRATEGY_V5). Limits of the packed encoding:
+ * durations and max_ext up to 255, ext_threshold up to 3, skip_limit up to 15.
+ *
+ * @param timing Configuration to certify
+ * @param strategy Controller strategy
+ * @param out Bounds to fill
+ *
+ * @return true on success, false if the configuration or strategy is not supported,
+ * the state space exceeds EXPLORE_MAX_STATES or memory runs out
+ */
+bool traffic_explore(const TimingConfig* timing, TrafficStrategyId strategy, ExploreBounds* out);
+
+/**
+ * @brief Certifies a set of configurations on parallel worker threads.
+ *
+ * @param configs Configurations to certify
+ * @param n_configs Number of configurations
+ * @param strategy Controller strategy shared by all configurations
+ * @param threads Number of worker threads (0 or 1 runs on the calling thread)
+ * @param out Array of n_configs bounds, filled in configs order
+ * @param ok Array of n_configs flags, result of traffic_explore() for each configuration
+ *
+ * @return false if the worker threads could not be started
+ */
+bool traffic_explore_grid(const TimingConfig* configs, uint32_t n_configs, TrafficStrategyId strategy,
+                          uint32_t threads, ExploreBounds* out, bool* ok);
+
+#endif // TRAFFIC_EXPLORE_H
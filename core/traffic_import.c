@@ -0,0 +1,564 @@
+/**
+ * @file traffic_import.c
+ * @brief Detector log (CSV) importer with a vectorised delimiter scan.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "traffic_import.h"
+
+// Delimiter scan: AVX2, SSE2 or portable 64-bit SWAR (forced with -DTRAFFIC_IMPORT_SWAR)
+#if !defined(TRAFFIC_IMPORT_SWAR) && defined(__AVX2__)
+#include <immintrin.h>
+#define SCAN_AVX2 1
+#elif !defined(TRAFFIC_IMPORT_SWAR) && defined(__SSE2__)
+#include <emmintrin.h>
+#define SCAN_SSE2 1
+#endif
+
+#define SCAN_BLOCK 64 // Bytes per delimiter bitmask
+#define FIELD_COUNT 4 // timestamp, approach, movement, vehicle_id
+#define QUOTED_FIELD_MAX 64 // Unescaped field storage of the quoted-line path
+#define ISO_MIN_LEN 19 // YYYY-MM-DDThh:mm:ss
+#define MAX_WHOLE_DIGITS 18 // int64 milliseconds for any unit
+#define MAX_FRACTION_DIGITS 9
+
+#if defined(SCAN_AVX2)
+static inline uint32_t mask32(const char* p) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)p);
+    __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(',')),
+                                   _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+                                                   _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))));
+    return (uint32_t)_mm256_movemask_epi8(hits);
+}
+#elif defined(SCAN_SSE2)
+static inline uint32_t mask16(const char* p) {
+    __m128i v = _mm_loadu_si128((const __m128i*)p);
+    __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(',')),
+                                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                                             _mm_cmpeq_epi8(v, _mm_set1_epi8('"'))));
+    return (uint32_t)_mm_movemask_epi8(hits);
+}
+#else
+/**
+ * @brief 0x80 in every byte of word equal to c, exact (no borrow false positives).
+ */
+static inline uint64_t match_bytes(uint64_t word, uint8_t c) {
+    uint64_t x = word ^ (0x0101010101010101ull * c);
+    uint64_t t = (x & 0x7F7F7F7F7F7F7F7Full) + 0x7F7F7F7F7F7F7F7Full;
+    return ~(t | x | 0x7F7F7F7F7F7F7F7Full);
+}
+
+static inline uint32_t mask8(const char* p) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word)); // Little-endian: byte i -> bit i of the mask
+    uint64_t hits = match_bytes(word, ',') | match_bytes(word, '\n') | match_bytes(word, '"');
+    return (uint32_t)(((hits >> 7) * 0x0102040810204080ull) >> 56);
+}
+#endif
+
+/**
+ * @brief Bitmask of the ',', '\n' and '"' bytes of a 64-byte block (bit i = byte i).
+ */
+static inline uint64_t delimiter_mask(const char* p) {
+#if defined(SCAN_AVX2)
+    return (uint64_t)mask32(p) | ((uint64_t)mask32(p + 32) << 32);
+#elif defined(SCAN_SSE2)
+    return (uint64_t)mask16(p) | ((uint64_t)mask16(p + 16) << 16) |
+           ((uint64_t)mask16(p + 32) << 32) | ((uint64_t)mask16(p + 48) << 48);
+#else
+    uint64_t mask = 0;
+    for (uint32_t i = 0; i < SCAN_BLOCK; i += 8) {
+        mask |= (uint64_t)mask8(p + i) << i;
+    }
+    return mask;
+#endif
+}
+
+/**
+ * @brief Iterator over the delimiters of the log, one bitmask per 64-byte block.
+ */
+typedef struct {
+    const char* block; // Start of the block described by bits
+    const char* end;
+    uint64_t bits; // Delimiters of the block not returned yet
+} DelimScanner;
+
+static inline uint64_t block_bits(const char* block, const char* end) {
+    if (end - block >= SCAN_BLOCK) {
+        return delimiter_mask(block);
+    }
+
+    char tail[SCAN_BLOCK] = {0}; // The last block is padded with non-delimiters
+    memcpy(tail, block, (size_t)(end - block));
+    return delimiter_mask(tail);
+}
+
+static void scanner_seek(DelimScanner* s, const char* p) {
+    s->block = p;
+    s->bits = p < s->end ? block_bits(p, s->end) : 0;
+}
+
+/**
+ * @brief Next delimiter, or end when the log is exhausted.
+ */
+static inline const char* scanner_next(DelimScanner* s) {
+    while (s->bits == 0) {
+        if (s->end - s->block <= SCAN_BLOCK) {
+            s->block = s->end;
+            return s->end;
+        }
+        s->block += SCAN_BLOCK;
+        s->bits = block_bits(s->block, s->end);
+    }
+
+    const char* delim = s->block + __builtin_ctzll(s->bits);
+    s->bits &= s->bits - 1;
+    return delim;
+}
+
+// --- FIELD PARSERS ---
+//
+// Fields are read 8 bytes at a time. `limit` bounds the bytes that may be loaded
+// (the end of the log, or the end of the field for quoted lines and the public
+// parser); bytes beyond the field are loaded but never used.
+
+#define BYTES_0 0x3030303030303030ull // '0' in every byte
+#define BYTES_HIGH 0x8080808080808080ull
+#define BYTES_LOW7 0x7F7F7F7F7F7F7F7Full
+#define BYTES_CASE 0x2020202020202020ull // ASCII lower-case bit
+
+/**
+ * @brief Loads up to 8 bytes at p (zero-padded at limit), byte i = p[i].
+ */
+static inline uint64_t load8(const char* p, const char* limit) {
+    uint64_t word = 0;
+    if (limit - p >= 8) {
+        memcpy(&word, p, sizeof(word));
+    } else if (limit > p) {
+        memcpy(&word, p, (size_t)(limit - p));
+    }
+    return word;
+}
+
+/**
+ * @brief Parses the leading digits of a chunk (SWAR, branch-free).
+ *
+ * @param p Start of the digits
+ * @param n Bytes left in the field
+ * @param limit Load bound
+ * @param value Value of the leading digits
+ *
+ * @return Number of leading digits (at most min(n, 8))
+ */
+static inline uint32_t digit_chunk(const char* p, size_t n, const char* limit, uint64_t* value) {
+    uint64_t word = load8(p, limit);
+
+    // A byte is a digit if its high nibble is 3 before and after adding 6
+    uint64_t wrong = ((word & 0xF0F0F0F0F0F0F0F0ull) ^ BYTES_0) |
+                     (((word + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) ^ BYTES_0);
+    uint64_t flags = (((wrong & BYTES_LOW7) + BYTES_LOW7) | wrong) & BYTES_HIGH;
+    uint32_t digits = flags ? (uint32_t)__builtin_ctzll(flags) / 8 : 8;
+    if (digits > n) digits = (uint32_t)n;
+    if (digits == 0) {
+        *value = 0;
+        return 0;
+    }
+
+    // Right-align the digits behind '0' padding, then combine pairs, quads and octets
+    if (digits < 8) {
+        word = (word << (8 * (8 - digits))) | (BYTES_0 >> (8 * digits));
+    }
+    word -= BYTES_0;
+    word = word * 10 + (word >> 8);
+    word = (((word & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) +
+            (((word >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+    *value = word;
+    return digits;
+}
+
+static const uint32_t POW10[10] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+/**
+ * @brief Parses a run of digits, 8 at a time.
+ *
+ * @param keep Digits that make up the value (the others are only validated)
+ * @param value Value of the first min(keep, digits) digits
+ *
+ * @return Number of digits
+ */
+static inline size_t digit_run(const char* p, size_t n, const char* limit, uint32_t keep, uint64_t* value) {
+    size_t total = 0;
+    uint64_t result = 0;
+
+    for (;;) {
+        uint64_t chunk;
+        uint32_t digits = digit_chunk(p + total, n - total, limit, &chunk);
+        if (total < keep) {
+            uint32_t used = keep - total < digits ? keep - (uint32_t)total : digits;
+            if (used < digits) chunk /= POW10[digits - used]; // Rare: more digits than kept
+            result = result * POW10[used] + chunk;
+        }
+        total += digits;
+        if (digits < 8) break;
+    }
+    *value = result;
+    return total;
+}
+
+/**
+ * @brief Parses the digits after a decimal point as a fraction in 10^-`scale` units.
+ */
+static inline bool parse_fraction(const char* p, size_t n, const char* limit, uint32_t scale, uint64_t* out) {
+    uint64_t value;
+    if (n == 0 || digit_run(p, n, limit, scale, &value) != n) {
+        return false;
+    }
+    *out = n < scale ? value * POW10[scale - n] : value;
+    return true;
+}
+
+/**
+ * @brief Strips spaces, tabs and a trailing '\r' from a field.
+ */
+static inline void trim(const char** field, size_t* len) {
+    const char* p = *field;
+    size_t n = *len;
+    while (n > 0 && (p[n - 1] == ' ' || p[n - 1] == '\t' || p[n - 1] == '\r')) n--;
+    while (n > 0 && (*p == ' ' || *p == '\t')) {
+        p++;
+        n--;
+    }
+    *field = p;
+    *len = n;
+}
+
+static bool parse_digits(const char* p, size_t n, int64_t* out) {
+    int64_t value = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (p[i] < '0' || p[i] > '9') return false;
+        value = value * 10 + (p[i] - '0');
+    }
+    *out = value;
+    return true;
+}
+
+/**
+ * @brief Days from 1970-01-01 to a proleptic Gregorian date.
+ */
+static int64_t days_from_civil(int64_t y, int64_t m, int64_t d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static bool parse_iso_time(const char* p, size_t len, const char* limit, int64_t* out_ms) {
+    int64_t year, month, day, hour, minute, second;
+    uint64_t fraction = 0;
+
+    if (len > ISO_MIN_LEN && p[len - 1] == 'Z') {
+        len--;
+    }
+    if (len < ISO_MIN_LEN || p[4] != '-' || p[7] != '-' || (p[10] != 'T' && p[10] != ' ') ||
+        p[13] != ':' || p[16] != ':' ||
+        !parse_digits(p, 4, &year) || !parse_digits(p + 5, 2, &month) || !parse_digits(p + 8, 2, &day) ||
+        !parse_digits(p + 11, 2, &hour) || !parse_digits(p + 14, 2, &minute) ||
+        !parse_digits(p + 17, 2, &second)) {
+        return false;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+    if (len > ISO_MIN_LEN) {
+        size_t n = len - ISO_MIN_LEN - 1;
+        if (p[ISO_MIN_LEN] != '.' || !parse_fraction(p + ISO_MIN_LEN + 1, n, limit, 3, &fraction)) {
+            return false;
+        }
+    }
+
+    int64_t seconds = ((days_from_civil(year, month, day) * 24 + hour) * 60 + minute) * 60 + second;
+    *out_ms = seconds * 1000 + (int64_t)fraction;
+    return true;
+}
+
+static bool parse_time(const char* field, size_t len, const char* limit, uint32_t unit_ms, int64_t* out_ms) {
+    if (len >= ISO_MIN_LEN && field[4] == '-') {
+        return parse_iso_time(field, len, limit, out_ms);
+    }
+
+    bool negative = len > 0 && field[0] == '-';
+    const char* p = field + negative;
+    size_t n = len - negative;
+    uint64_t whole, fraction = 0;
+
+    size_t whole_len = digit_run(p, n, limit, MAX_WHOLE_DIGITS, &whole);
+    if (whole_len == 0 || whole_len > MAX_WHOLE_DIGITS) {
+        return false;
+    }
+    if (whole_len < n) {
+        size_t frac_len = n - whole_len - 1;
+        if (p[whole_len] != '.' ||
+            !parse_fraction(p + whole_len + 1, frac_len, limit, MAX_FRACTION_DIGITS, &fraction)) {
+            return false;
+        }
+    }
+
+    // The fraction is in 10^-9 units: a division by a constant
+    int64_t ms = (int64_t)(whole * unit_ms + fraction * unit_ms / 1000000000u);
+    *out_ms = negative ? -ms : ms;
+    return true;
+}
+
+bool traffic_import_parse_time(const char* field, size_t len, uint32_t unit_ms, int64_t* out_ms) {
+    return parse_time(field, len, field + len, unit_ms, out_ms);
+}
+
+/**
+ * @brief Up to 8 bytes of a field in lower case, as one comparable word (0 if longer).
+ */
+static inline uint64_t field_key(const char* p, size_t len, const char* limit) {
+    if (len == 0 || len > 8) {
+        return 0;
+    }
+    return (load8(p, limit) | BYTES_CASE) & (~0ull >> (64 - 8 * len)); // No branch on the length
+}
+
+static uint64_t literal_key(const char* word) {
+    size_t len = strlen(word);
+    return field_key(word, len, word + len);
+}
+
+#define APPROACH_KEYS (ROAD_COUNT * 3) // Name, letter and digit of each road
+#define MOVEMENT_KEYS 8
+
+/**
+ * @brief Keys of the approach and movement names.
+ *
+ * A field is compared with every key at once into a bitmask of hits, so the
+ * (random) movement of each record costs no mispredicted branch.
+ */
+typedef struct {
+    uint64_t approach[APPROACH_KEYS]; // Key i is road i % ROAD_COUNT
+    uint64_t movement[MOVEMENT_KEYS];
+    uint8_t movement_turn[MOVEMENT_KEYS];
+} TokenKeys;
+
+static void token_keys_init(TokenKeys* keys) {
+    static const char* const APPROACHES[APPROACH_KEYS] = {
+        "north", "east", "south", "west", "n", "e", "s", "w", "0", "1", "2", "3"};
+    static const char* const MOVEMENTS[MOVEMENT_KEYS] = {
+        "straight", "s", "through", "t", "left", "l", "right", "r"};
+    static const uint8_t TURNS[MOVEMENT_KEYS] = {2, 2, 2, 2, LEFT_TURN_DIFF, LEFT_TURN_DIFF, 3, 3};
+
+    for (uint8_t i = 0; i < APPROACH_KEYS; i++) {
+        keys->approach[i] = literal_key(APPROACHES[i]);
+    }
+    for (uint8_t i = 0; i < MOVEMENT_KEYS; i++) {
+        keys->movement[i] = literal_key(MOVEMENTS[i]);
+        keys->movement_turn[i] = TURNS[i];
+    }
+}
+
+static inline bool parse_approach(const TokenKeys* keys, const char* field, size_t len, const char* limit,
+                                  Direction* out) {
+    uint64_t key = field_key(field, len, limit);
+    uint32_t hits = 0;
+    for (uint32_t i = 0; i < APPROACH_KEYS; i++) {
+        hits |= (uint32_t)(key == keys->approach[i]) << i;
+    }
+    if (hits == 0 || key == 0) {
+        return false;
+    }
+    *out = (Direction)(__builtin_ctz(hits) % ROAD_COUNT);
+    return true;
+}
+
+/**
+ * @brief Exit road of a movement: left = start + 1, straight = start + 2, right = start + 3.
+ */
+static inline bool parse_movement(const TokenKeys* keys, const char* field, size_t len, const char* limit,
+                                  Direction start, Direction* out) {
+    uint64_t key = field_key(field, len, limit);
+    uint32_t hits = 0;
+    for (uint32_t i = 0; i < MOVEMENT_KEYS; i++) {
+        hits |= (uint32_t)(key == keys->movement[i]) << i;
+    }
+    if (hits == 0 || key == 0) {
+        return false;
+    }
+    *out = (Direction)((start + keys->movement_turn[__builtin_ctz(hits)]) % DIRECTION_MOD);
+    return true;
+}
+
+// --- LINE SPLITTING ---
+
+/**
+ * @brief Scalar split of a line with quoted fields (RFC 4180: "" is a quote, newlines allowed).
+ *
+ * @return Pointer to the '\n' ending the line, or end
+ */
+static const char* split_quoted_line(const char* p, const char* end, char store[FIELD_COUNT][QUOTED_FIELD_MAX],
+                                     const char* fields[FIELD_COUNT], size_t lens[FIELD_COUNT], uint32_t* n_fields) {
+    uint32_t n = 0;
+    size_t len = 0;
+    bool in_quotes = false;
+
+    for (; p < end; p++) {
+        char c = *p;
+        if (in_quotes) {
+            if (c == '"' && p + 1 < end && p[1] == '"') {
+                p++;
+            } else if (c == '"') {
+                in_quotes = false;
+                continue;
+            }
+        } else if (c == '"') {
+            in_quotes = true;
+            continue;
+        } else if (c == ',' || c == '\n') {
+            if (n < FIELD_COUNT) {
+                fields[n] = store[n];
+                lens[n] = len;
+            }
+            n++;
+            len = 0;
+            if (c == '\n') break;
+            continue;
+        }
+
+        if (n < FIELD_COUNT && len < QUOTED_FIELD_MAX) {
+            store[n][len++] = c;
+        }
+    }
+
+    if (p == end) {
+        if (n < FIELD_COUNT) {
+            fields[n] = store[n];
+            lens[n] = len;
+        }
+        n++;
+    }
+    *n_fields = n;
+    return p;
+}
+
+// --- IMPORT ---
+
+bool traffic_import_csv(const char* data, size_t len, const ImportOptions* options,
+                        const ImportSink* sink, ImportStats* stats) {
+    ImportOptions defaults = IMPORT_DEFAULT_OPTIONS;
+    ImportStats local;
+    if (!options) options = &defaults;
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    if (options->step_ms == 0 || options->unit_ms == 0 || !sink) {
+        return false;
+    }
+
+    const char* end = data + len;
+    const char* p = data;
+    DelimScanner scanner = {.end = end};
+    TokenKeys keys;
+    int64_t origin = options->origin_ms;
+    uint32_t current_step = 0;
+    int64_t step_begin = 0, step_end = 0; // Timestamps of the current step (no division inside)
+
+    token_keys_init(&keys);
+    scanner_seek(&scanner, p);
+    while (p < end) {
+        const char* fields[FIELD_COUNT];
+        size_t lens[FIELD_COUNT];
+        char store[FIELD_COUNT][QUOTED_FIELD_MAX];
+        uint32_t n = 0;
+        const char* start = p;
+        const char* line_end;
+        const char* limit = end; // Load bound of the fields
+
+        stats->lines++;
+        for (;;) {
+            const char* delim = scanner_next(&scanner);
+            if (delim < end && *delim == '"') {
+                line_end = split_quoted_line(p, end, store, fields, lens, &n);
+                scanner_seek(&scanner, line_end + (line_end < end));
+                limit = NULL; // Fields in store: bounded by their own length
+                break;
+            }
+            if (n < FIELD_COUNT) {
+                fields[n] = start;
+                lens[n] = (size_t)(delim - start);
+            }
+            n++;
+            if (delim == end || *delim == '\n') {
+                line_end = delim;
+                break;
+            }
+            start = delim + 1;
+        }
+        p = line_end + (line_end < end);
+
+        for (uint32_t i = 0; i < n && i < FIELD_COUNT; i++) {
+            trim(&fields[i], &lens[i]);
+        }
+        if (n == 1 && lens[0] == 0) {
+            continue; // Blank line
+        }
+
+        int64_t time_ms;
+        Direction approach, exit;
+        if (n < FIELD_COUNT ||
+            !parse_time(fields[0], lens[0], limit ? limit : fields[0] + lens[0], options->unit_ms, &time_ms) ||
+            !parse_approach(&keys, fields[1], lens[1], limit ? limit : fields[1] + lens[1], &approach) ||
+            !parse_movement(&keys, fields[2], lens[2], limit ? limit : fields[2] + lens[2], approach, &exit)) {
+            if (stats->lines == 1) {
+                stats->header = true;
+            } else {
+                stats->malformed++;
+                if (stats->first_malformed_line == 0) {
+                    stats->first_malformed_line = stats->lines;
+                }
+            }
+            continue;
+        }
+
+        if (origin == IMPORT_ORIGIN_FIRST) {
+            origin = time_ms;
+        }
+        if (stats->vehicles == 0) {
+            step_begin = origin;
+            step_end = origin + options->step_ms;
+        }
+        if (time_ms < step_begin) {
+            stats->late++;
+        } else if (time_ms >= step_end) {
+            int64_t step = (time_ms - origin) / options->step_ms;
+            if (step > UINT32_MAX - 1) {
+                return false;
+            }
+            sink->step(sink->ctx, (uint32_t)step - current_step);
+            stats->steps += (uint32_t)step - current_step;
+            current_step = (uint32_t)step;
+            step_begin = origin + step * options->step_ms;
+            step_end = step_begin + options->step_ms;
+        }
+
+        char id[VEHICLE_ID_LEN];
+        if (lens[3] == 0) {
+            snprintf(id, sizeof(id), "v%llu", (unsigned long long)stats->lines);
+        } else {
+            size_t id_len = lens[3] < VEHICLE_ID_LEN - 1 ? lens[3] : VEHICLE_ID_LEN - 1;
+            memcpy(id, fields[3], id_len);
+            id[id_len] = '\0';
+        }
+        sink->add_vehicle(sink->ctx, id, approach, exit, current_step);
+        stats->vehicles++;
+    }
+
+    if (options->drain_steps > 0) {
+        sink->step(sink->ctx, options->drain_steps);
+        stats->steps += options->drain_steps;
+    }
+    return true;
+}
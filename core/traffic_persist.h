@@ -0,0 +1,121 @@
+/**
+ * @file traffic_persist.h
+ * @brief Power-fail safe storage of the timing configuration and checkpoints in flash.
+ * @details The store is an append-only log of records spread over a ring of erase
+ * pages. Every record carries a sequence number and a CRC-16, so a write torn by a
+ * reset is simply ignored and the previous record stays in effect. Pages are erased
+ * in turn (only when the active one is full), which spreads wear evenly. The
+ * configuration is copied into the active page before the next one is erased. Mounting
+ * reads every page once, so boot time is bounded by the size of the region.
+ *
+ * The flash itself is accessed through PersistFlash: memory-mapped reads plus
+ * erase/program callbacks, implemented with the HAL on the STM32 and with a RAM
+ * buffer in the tests.
+ */
+
+#ifndef TRAFFIC_PERSIST_H
+#define TRAFFIC_PERSIST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "traffic_fsm.h"
+
+#define PERSIST_VERSION 1
+#define PERSIST_WRITE_ALIGN 8 // Programming unit (STM32G0 double word)
+
+/**
+ * @def PERSIST_RECORD_MAX
+ * @brief Largest record (header included), also the size of the write buffer
+ */
+#ifndef PERSIST_RECORD_MAX
+#define PERSIST_RECORD_MAX 4096
+#endif
+
+typedef enum {
+    PERSIST_RECORD_CONFIG = 1, // TimingConfig
+    PERSIST_RECORD_CHECKPOINT = 2 // traffic_snapshot of the whole system
+} PersistRecordKind;
+
+typedef enum {
+    PERSIST_RESTORED_NONE = 0, // Nothing stored, system untouched
+    PERSIST_RESTORED_CONFIG, // Fresh system with the stored timing
+    PERSIST_RESTORED_CHECKPOINT // Queues, statistics and timing from the checkpoint
+} PersistRestored;
+
+/**
+ * @brief Flash region used by the store
+ *
+ * Erased bytes read as 0xFF. program() is called with offsets and lengths that
+ * are multiples of PERSIST_WRITE_ALIGN, on erased flash only.
+ */
+typedef struct {
+    const uint8_t* base; // Memory-mapped start of the region
+    uint32_t page_size; // Erase unit in bytes
+    uint16_t page_count; // At least 2
+    bool (*erase)(void* ctx, uint16_t page);
+    bool (*program)(void* ctx, uint32_t offset, const uint8_t* data, uint32_t len);
+    void* ctx;
+} PersistFlash;
+
+/**
+ * @brief Mounted store: write position and location of the newest records
+ */
+typedef struct {
+    const PersistFlash* flash;
+    uint32_t seq; // Sequence number of the newest record
+    uint16_t page; // Page being appended to
+    uint32_t write_offset; // Next free byte in that page
+
+    bool has_config;
+    uint32_t config_seq;
+    uint16_t config_page; // Page holding the newest copy
+    TimingConfig config;
+
+    bool has_checkpoint;
+    uint32_t checkpoint_seq;
+    uint32_t checkpoint_offset; // Snapshot position in the region
+    uint32_t checkpoint_len;
+
+    uint8_t record[PERSIST_RECORD_MAX]; // Record being written
+} PersistStore;
+
+/**
+ * @brief Scans the region and finds the newest configuration and checkpoint.
+ *
+ * @param store Store to initialize
+ * @param flash Flash region (must outlive the store)
+ *
+ * @return false if the flash description is unusable
+ */
+bool persist_mount(PersistStore* store, const PersistFlash* flash);
+
+/**
+ * @brief Appends the timing configuration.
+ *
+ * @details A configuration newer than the last checkpoint makes that checkpoint
+ * stale: the next boot starts a fresh system with this timing.
+ *
+ * @return true once the record is in flash
+ */
+bool persist_save_config(PersistStore* store, const TimingConfig* config);
+
+/**
+ * @brief Appends a checkpoint of the whole system.
+ *
+ * @return true once the record is in flash, false if the snapshot is too large
+ */
+bool persist_save_checkpoint(PersistStore* store, const TrafficSystem* sys);
+
+/**
+ * @brief Rebuilds the system from the newest valid records.
+ *
+ * @details Uses the checkpoint if it is newer than the configuration, otherwise
+ * initializes the system with the stored timing. The system is left untouched if
+ * the store is empty.
+ *
+ * @return What was restored
+ */
+PersistRestored persist_restore(const PersistStore* store, TrafficSystem* sys);
+
+#endif // TRAFFIC_PERSIST_H
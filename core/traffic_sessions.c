@@ -0,0 +1,302 @@
+/**
+ * @file traffic_sessions.c
+ * @brief Implementation of the session table with parked snapshots.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "traffic_sessions.h"
+#include "traffic_snapshot.h"
+
+// --- HELPER FUNCTIONS ---
+
+/**
+ * @brief Raises the high-water mark after the table grew.
+ */
+static void update_peak(SessionTable* table) {
+    size_t usage = sessions_memory_usage(table);
+    if (usage > table->peak_bytes) {
+        table->peak_bytes = usage;
+    }
+}
+
+/**
+ * @brief Grows the entry array so that it can hold the given ID.
+ */
+static bool ensure_capacity(SessionTable* table, uint16_t id) {
+    if (id < table->capacity) {
+        return true;
+    }
+
+    uint32_t capacity = table->capacity ? table->capacity : 16;
+    while (capacity <= id) {
+        capacity *= 2;
+    }
+    if (capacity > SESSION_ID_MAX + 1) {
+        capacity = SESSION_ID_MAX + 1;
+    }
+
+    Session* sessions = realloc(table->sessions, capacity * sizeof(Session));
+    if (!sessions) {
+        return false;
+    }
+
+    memset(&sessions[table->capacity], 0, (capacity - table->capacity) * sizeof(Session));
+    for (uint32_t i = table->capacity; i < capacity; i++) {
+        sessions[i].slot = -1;
+    }
+
+    table->sessions = sessions;
+    table->capacity = capacity;
+    update_peak(table);
+    return true;
+}
+
+/**
+ * @brief Longest lane queue of a live system since its queues were initialized.
+ */
+static uint16_t system_peak_queue(const TrafficSystem* sys) {
+    uint16_t peak = 0;
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            uint16_t p = queue_get_peak(&sys->queues[road][lane]);
+            if (p > peak) peak = p;
+        }
+    }
+    return peak;
+}
+
+/**
+ * @brief Vehicles waiting in all lanes of a live system.
+ */
+static uint16_t system_queued(const TrafficSystem* sys) {
+    uint16_t queued = 0;
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            queued += queue_count(&sys->queues[road][lane]);
+        }
+    }
+    return queued;
+}
+
+/**
+ * @brief Serializes the session held in a slot and frees the slot.
+ */
+static bool park_slot(SessionTable* table, uint32_t slot) {
+    Session* s = &table->sessions[table->slot_owner[slot]];
+    const TrafficSystem* sys = &table->slots[slot];
+
+    size_t len = traffic_snapshot_size(sys);
+    uint8_t* buf = malloc(len);
+    if (!buf || traffic_snapshot_save(sys, buf, len) != len) {
+        free(buf);
+        return false;
+    }
+
+    // Queue peaks are not part of the snapshot
+    uint16_t peak = system_peak_queue(sys);
+    if (peak > s->peak_queue) s->peak_queue = peak;
+
+    s->parked = buf;
+    s->parked_len = (uint32_t)len;
+    s->slot = -1;
+    table->slot_owner[slot] = -1;
+    table->parked_bytes += len;
+    update_peak(table);
+    return true;
+}
+
+/**
+ * @brief Returns a free slot, parking the least recently used session if needed.
+ *
+ * @return Slot index, -1 on failure
+ */
+static int32_t take_slot(SessionTable* table) {
+    uint32_t victim = 0;
+
+    for (uint32_t i = 0; i < table->n_slots; i++) {
+        if (table->slot_owner[i] < 0) {
+            return (int32_t)i;
+        }
+        if (table->slot_last_use[i] < table->slot_last_use[victim]) {
+            victim = i;
+        }
+    }
+
+    return park_slot(table, victim) ? (int32_t)victim : -1;
+}
+
+static void bind_slot(SessionTable* table, uint16_t id, int32_t slot) {
+    table->sessions[id].slot = slot;
+    table->slot_owner[slot] = id;
+    table->slot_last_use[slot] = ++table->clock;
+}
+
+// --- PUBLIC API IMPLEMENTATION ---
+
+bool sessions_init(SessionTable* table, uint32_t cache_slots) {
+    if (!table) return false;
+
+    memset(table, 0, sizeof(SessionTable));
+    table->n_slots = cache_slots ? cache_slots : 1;
+    table->slots = malloc(table->n_slots * sizeof(TrafficSystem));
+    table->slot_owner = malloc(table->n_slots * sizeof(int32_t));
+    table->slot_last_use = calloc(table->n_slots, sizeof(uint32_t));
+
+    if (!table->slots || !table->slot_owner || !table->slot_last_use) {
+        sessions_free(table);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < table->n_slots; i++) {
+        table->slot_owner[i] = -1;
+    }
+    update_peak(table);
+    return true;
+}
+
+void sessions_free(SessionTable* table) {
+    if (!table) return;
+
+    for (uint32_t i = 0; i < table->capacity; i++) {
+        free(table->sessions[i].parked);
+    }
+    free(table->sessions);
+    free(table->slots);
+    free(table->slot_owner);
+    free(table->slot_last_use);
+    memset(table, 0, sizeof(SessionTable));
+}
+
+bool sessions_create(SessionTable* table, uint16_t id, TimingConfig config) {
+    if (!table || !table->slots || sessions_exists(table, id) || !ensure_capacity(table, id)) {
+        return false;
+    }
+
+    int32_t slot = take_slot(table);
+    if (slot < 0) {
+        return false;
+    }
+
+    traffic_init(&table->slots[slot], config);
+    table->sessions[id].used = true;
+    bind_slot(table, id, slot);
+    table->count++;
+    return true;
+}
+
+bool sessions_destroy(SessionTable* table, uint16_t id) {
+    if (!sessions_exists(table, id)) {
+        return false;
+    }
+
+    Session* s = &table->sessions[id];
+    if (s->slot >= 0) {
+        table->slot_owner[s->slot] = -1;
+    }
+    free(s->parked);
+    table->parked_bytes -= s->parked_len;
+
+    memset(s, 0, sizeof(Session));
+    s->slot = -1;
+    table->count--;
+    return true;
+}
+
+TrafficSystem* sessions_acquire(SessionTable* table, uint16_t id) {
+    if (!sessions_exists(table, id)) {
+        return NULL;
+    }
+
+    Session* s = &table->sessions[id];
+    if (s->slot >= 0) {
+        table->slot_last_use[s->slot] = ++table->clock;
+        return &table->slots[s->slot];
+    }
+
+    int32_t slot = take_slot(table);
+    if (slot < 0 || !traffic_snapshot_load(&table->slots[slot], s->parked, s->parked_len)) {
+        return NULL;
+    }
+
+    free(s->parked);
+    table->parked_bytes -= s->parked_len;
+    s->parked = NULL;
+    s->parked_len = 0;
+    bind_slot(table, id, slot);
+    return &table->slots[slot];
+}
+
+bool sessions_exists(const SessionTable* table, uint16_t id) {
+    return table && id < table->capacity && table->sessions[id].used;
+}
+
+size_t sessions_memory_usage(const SessionTable* table) {
+    if (!table) return 0;
+
+    return table->capacity * sizeof(Session) +
+           table->n_slots * (sizeof(TrafficSystem) + sizeof(int32_t) + sizeof(uint32_t)) +
+           table->parked_bytes;
+}
+
+size_t sessions_memory_peak(const SessionTable* table) {
+    return table ? table->peak_bytes : 0;
+}
+
+bool sessions_session_footprint(const SessionTable* table, uint16_t id, SessionFootprint* out) {
+    if (!sessions_exists(table, id) || !out) {
+        return false;
+    }
+
+    const Session* s = &table->sessions[id];
+    memset(out, 0, sizeof(*out));
+    out->live = s->slot >= 0;
+    out->peak_queue = s->peak_queue;
+
+    if (out->live) {
+        const TrafficSystem* sys = &table->slots[s->slot];
+        uint16_t peak = system_peak_queue(sys);
+        out->bytes = sizeof(TrafficSystem);
+        out->queued = system_queued(sys);
+        if (peak > out->peak_queue) out->peak_queue = peak;
+    } else {
+        TrafficSystem* sys = malloc(sizeof(TrafficSystem));
+        out->bytes = s->parked_len;
+        if (sys && traffic_snapshot_load(sys, s->parked, s->parked_len)) {
+            out->queued = system_queued(sys);
+        }
+        free(sys);
+    }
+    return true;
+}
+
+void sessions_footprint(const SessionTable* table, SessionsFootprint* out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    out->system_size = sizeof(TrafficSystem);
+    if (!table) return;
+
+    out->sessions = table->count;
+    out->entry_bytes = table->capacity * sizeof(Session);
+    out->cache_bytes = table->n_slots * (sizeof(TrafficSystem) + sizeof(int32_t) + sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < table->capacity; i++) {
+        const Session* s = &table->sessions[i];
+        if (!s->used) continue;
+
+        uint16_t peak = s->peak_queue;
+        if (s->slot >= 0) {
+            uint16_t live_peak = system_peak_queue(&table->slots[s->slot]);
+            if (live_peak > peak) peak = live_peak;
+            out->live++;
+        } else {
+            out->parked++;
+            out->parked_bytes += s->parked_len;
+            if (s->parked_len > out->parked_max) out->parked_max = s->parked_len;
+        }
+        if (peak > out->peak_queue) out->peak_queue = peak;
+    }
+
+    out->total_bytes = out->entry_bytes + out->cache_bytes + out->parked_bytes;
+    out->peak_bytes = table->peak_bytes;
+}
@@ -0,0 +1,173 @@
+/**
+ * @file traffic_sessions.h
+ * @brief Table of independent intersections hosted by one process.
+ * @details Sessions are addressed by a 16-bit ID. Only a small LRU cache of
+ * sessions is kept as full TrafficSystem instances; the others are parked as
+ * compact snapshots (traffic_snapshot.h), so an idle intersection costs about a
+ * hundred bytes plus its queued vehicles instead of the size of a TrafficSystem.
+ */
+
+#ifndef TRAFFIC_SESSIONS_H
+#define TRAFFIC_SESSIONS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "traffic_fsm.h"
+
+#define SESSION_ID_MAX 0xFFFF
+#define SESSION_CACHE_DEFAULT 64 // Live TrafficSystem instances kept in memory
+
+/**
+ * @brief Entry of the session table (indexed by session ID).
+ */
+typedef struct {
+    bool used;
+    int32_t slot; // Live cache slot, -1 if parked
+    uint8_t* parked; // Snapshot of a parked session
+    uint32_t parked_len;
+    uint16_t peak_queue; // Longest lane queue before the session was last parked
+} Session;
+
+/**
+ * @brief Session table with its cache of live systems.
+ */
+typedef struct {
+    Session* sessions; // Grown on demand up to the highest ID in use
+    uint32_t capacity;
+    uint32_t count; // Sessions in use
+
+    TrafficSystem* slots; // Live systems
+    int32_t* slot_owner; // Session ID per slot, -1 if free
+    uint32_t* slot_last_use; // LRU clock per slot
+    uint32_t n_slots;
+    uint32_t clock;
+
+    size_t parked_bytes; // Sum of the snapshot sizes
+    size_t peak_bytes; // High-water mark of sessions_memory_usage()
+} SessionTable;
+
+/**
+ * @brief Memory footprint of one session.
+ */
+typedef struct {
+    bool live; // Held in a cache slot (else parked)
+    size_t bytes; // sizeof(TrafficSystem) if live, else the snapshot size
+    uint16_t queued; // Vehicles waiting in all lanes
+    uint16_t peak_queue; // Longest lane queue since the session was created
+} SessionFootprint;
+
+/**
+ * @brief Memory footprint of a table.
+ * @details total_bytes equals sessions_memory_usage(). The cache is counted in
+ * full, used or not, as it is allocated by sessions_init().
+ */
+typedef struct {
+    uint32_t sessions; // Sessions in use
+    uint32_t live; // Sessions held in cache slots
+    uint32_t parked; // Sessions held as snapshots
+    size_t system_size; // Static size of a TrafficSystem
+    size_t entry_bytes; // Session entries (grown up to the highest ID)
+    size_t cache_bytes; // Cache slots and their bookkeeping
+    size_t parked_bytes; // Snapshots of the parked sessions
+    uint32_t parked_max; // Largest snapshot
+    uint16_t peak_queue; // Longest lane queue of any session
+    size_t total_bytes;
+    size_t peak_bytes; // Highest total_bytes since sessions_init()
+} SessionsFootprint;
+
+/**
+ * @brief Initializes an empty table.
+ *
+ * @param table Pointer to SessionTable
+ * @param cache_slots Number of sessions kept live (at least 1)
+ *
+ * @return true on success, false on allocation failure
+ */
+bool sessions_init(SessionTable* table, uint32_t cache_slots);
+
+/**
+ * @brief Releases all sessions and the cache.
+ *
+ * @param table Pointer to SessionTable
+ */
+void sessions_free(SessionTable* table);
+
+/**
+ * @brief Creates a session with the given timing (as traffic_init()).
+ *
+ * @param table Pointer to SessionTable
+ * @param id Session ID
+ * @param config Timing configuration
+ *
+ * @return true on success, false if the ID is in use or memory is exhausted
+ */
+bool sessions_create(SessionTable* table, uint16_t id, TimingConfig config);
+
+/**
+ * @brief Destroys a session and releases its memory.
+ *
+ * @param table Pointer to SessionTable
+ * @param id Session ID
+ *
+ * @return true on success, false if the session does not exist
+ */
+bool sessions_destroy(SessionTable* table, uint16_t id);
+
+/**
+ * @brief Returns the live system of a session, unparking it if needed.
+ *
+ * @details The least recently used live session may be parked to make room,
+ * which invalidates pointers returned by earlier calls.
+ *
+ * @param table Pointer to SessionTable
+ * @param id Session ID
+ *
+ * @return Pointer to the system, NULL if the session does not exist or cannot be unparked
+ */
+TrafficSystem* sessions_acquire(SessionTable* table, uint16_t id);
+
+/**
+ * @brief Checks whether a session exists.
+ */
+bool sessions_exists(const SessionTable* table, uint16_t id);
+
+/**
+ * @brief Heap memory used by the table (entries, cache and parked snapshots).
+ *
+ * @param table Pointer to SessionTable
+ * @return Size in bytes
+ */
+size_t sessions_memory_usage(const SessionTable* table);
+
+/**
+ * @brief High-water mark of sessions_memory_usage() since sessions_init().
+ *
+ * @param table Pointer to SessionTable
+ * @return Size in bytes
+ */
+size_t sessions_memory_peak(const SessionTable* table);
+
+/**
+ * @brief Reports the memory footprint of a session.
+ *
+ * @details Does not unpark the session; the queue figures of a parked session
+ * are those it had when it was parked.
+ *
+ * @param table Pointer to SessionTable
+ * @param id Session ID
+ * @param out Footprint of the session
+ *
+ * @return false if the session does not exist
+ */
+bool sessions_session_footprint(const SessionTable* table, uint16_t id, SessionFootprint* out);
+
+/**
+ * @brief Reports the memory footprint of the table.
+ *
+ * @param table Pointer to SessionTable
+ * @param out Footprint of the table
+ */
+void sessions_footprint(const SessionTable* table, SessionsFootprint* out);
+
+#endif // TRAFFIC_SESSIONS_H
@@ -0,0 +1,54 @@
+/**
+ * @file traffic_snapshot.h
+ * @brief Compact serialization of a TrafficSystem.
+ * @details Stores the FSM state, timing (with a pending update and the plan table),
+ * statistics (only non-empty wait histogram buckets) and only the vehicles that are
+ * actually waiting (IDs are length-prefixed), so an idle intersection takes about a
+ * hundred bytes instead of the full size of the queue matrix. Multi-byte fields use
+ * the native Little-Endian layout, like the binary protocol.
+ */
+
+#ifndef TRAFFIC_SNAPSHOT_H
+#define TRAFFIC_SNAPSHOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "traffic_fsm.h"
+
+#define SNAPSHOT_VERSION 4
+
+/**
+ * @brief Computes the number of bytes needed to serialize the system.
+ *
+ * @param sys Pointer to TrafficSystem
+ * @return Snapshot size in bytes
+ */
+size_t traffic_snapshot_size(const TrafficSystem* sys);
+
+/**
+ * @brief Serializes the system into a buffer.
+ *
+ * @param sys Pointer to TrafficSystem
+ * @param buf Output buffer
+ * @param capacity Size of the output buffer
+ *
+ * @return Number of bytes written, 0 if the buffer is too small
+ */
+size_t traffic_snapshot_save(const TrafficSystem* sys, uint8_t* buf, size_t capacity);
+
+/**
+ * @brief Restores the system from a snapshot.
+ *
+ * @details The system is left untouched if the snapshot is invalid.
+ * Queue order is preserved, ring buffer positions are normalized.
+ *
+ * @param sys Pointer to TrafficSystem to overwrite
+ * @param buf Snapshot data
+ * @param len Snapshot length in bytes
+ *
+ * @return true on success, false on malformed or incompatible data
+ */
+bool traffic_snapshot_load(TrafficSystem* sys, const uint8_t* buf, size_t len);
+
+#endif // TRAFFIC_SNAPSHOT_H
@@ -0,0 +1,132 @@
+/**
+ * @file traffic_stream.c
+ * @brief Implementation of the delta-encoded queue state stream.
+ */
+
+#include <string.h>
+#include "traffic_stream.h"
+#include "protocol.h"
+
+// --- HELPER FUNCTIONS ---
+
+static void read_lights(const TrafficSystem* sys, uint8_t lights[5]) {
+    lights[0] = (uint8_t)sys->current_state;
+    lights[1] = (uint8_t)sys->lights[NORTH][LANE_STRAIGHT_RIGHT];
+    lights[2] = (uint8_t)sys->lights[NORTH][LANE_LEFT];
+    lights[3] = (uint8_t)sys->lights[EAST][LANE_STRAIGHT_RIGHT];
+    lights[4] = (uint8_t)sys->lights[EAST][LANE_LEFT];
+}
+
+/**
+ * @brief Writes one appended vehicle: id_len, id, end_road, arrival_step.
+ */
+static void write_vehicle(const Vehicle* v, StateStreamWrite write, void* ctx) {
+    uint8_t buf[1 + VEHICLE_ID_LEN + 1 + sizeof(uint32_t)];
+    size_t id_len = 0;
+
+    while (id_len < VEHICLE_ID_LEN - 1 && v->id[id_len] != '\0') {
+        id_len++;
+    }
+
+    buf[0] = (uint8_t)id_len;
+    memcpy(&buf[1], v->id, id_len);
+    buf[1 + id_len] = v->end_road;
+    memcpy(&buf[2 + id_len], &v->arrival_step, sizeof(uint32_t));
+    write(ctx, buf, 2 + id_len + sizeof(uint32_t));
+}
+
+// --- PUBLIC API IMPLEMENTATION ---
+
+void state_stream_init(StateStream* s, uint16_t session_id, uint16_t every) {
+    memset(s, 0, sizeof(*s));
+    s->session_id = session_id;
+    s->every = every > 0 ? every : 1;
+    s->countdown = s->every;
+    s->keyframe = true;
+}
+
+void state_stream_resync(StateStream* s) {
+    s->keyframe = true;
+}
+
+void state_stream_before_step(StateStream* s, const TrafficSystem* sys) {
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            s->before[road * LANES_PER_ROAD + lane] = queue_count(&sys->queues[road][lane]);
+        }
+    }
+}
+
+bool state_stream_after_step(StateStream* s, const TrafficSystem* sys) {
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            uint8_t i = road * LANES_PER_ROAD + lane;
+            uint16_t count = queue_count(&sys->queues[road][lane]);
+
+            // Vehicles are only added between steps, so a shorter queue means departures
+            if (count < s->before[i]) {
+                s->departed[i] += s->before[i] - count;
+            }
+        }
+    }
+
+    if (s->countdown > 0) {
+        s->countdown--;
+    }
+    return s->countdown == 0;
+}
+
+void state_stream_send(StateStream* s, const TrafficSystem* sys, StateStreamWrite write, void* ctx) {
+    StateUpdateHeader header;
+    StateLaneDelta deltas[STREAM_LANES];
+    uint8_t lights[5];
+
+    header.session_id = s->session_id;
+    header.step = sys->current_step;
+    header.flags = s->keyframe ? STATE_UPDATE_KEYFRAME : 0;
+    header.lane_mask = 0;
+
+    read_lights(sys, lights);
+    if (s->keyframe || memcmp(lights, s->sent_lights, sizeof(lights)) != 0) {
+        header.flags |= STATE_UPDATE_LIGHTS;
+    }
+
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            uint8_t i = road * LANES_PER_ROAD + lane;
+            uint16_t count = queue_count(&sys->queues[road][lane]);
+            uint16_t known = s->keyframe ? 0 : s->sent_counts[i];
+
+            // Departures beyond the known vehicles were appended and left since the last update
+            uint16_t popped = s->departed[i] < known ? s->departed[i] : known;
+            deltas[i].popped = (uint8_t)popped;
+            deltas[i].appended = (uint8_t)(count - (known - popped));
+
+            if (deltas[i].popped > 0 || deltas[i].appended > 0) {
+                header.lane_mask |= (uint8_t)(1u << i);
+            }
+            s->sent_counts[i] = count;
+            s->departed[i] = 0;
+        }
+    }
+
+    write(ctx, &header, sizeof(header));
+    if (header.flags & STATE_UPDATE_LIGHTS) {
+        write(ctx, lights, sizeof(StateLights));
+        memcpy(s->sent_lights, lights, sizeof(lights));
+    }
+
+    for (uint8_t i = 0; i < STREAM_LANES; i++) {
+        if (!(header.lane_mask & (1u << i))) continue;
+
+        const VehicleQueue* q = &sys->queues[i / LANES_PER_ROAD][i % LANES_PER_ROAD];
+        uint16_t count = queue_count(q);
+        write(ctx, &deltas[i], sizeof(StateLaneDelta));
+        for (uint16_t j = count - deltas[i].appended; j < count; j++) {
+            write_vehicle(queue_vehicle_at(q, j), write, ctx);
+        }
+    }
+
+    s->keyframe = false;
+    s->countdown = s->every;
+}
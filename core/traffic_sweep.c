@@ -0,0 +1,214 @@
+/**
+ * @file traffic_sweep.c
+ * @brief Implementation of the prefix-sharing parameter sweep engine.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "traffic_sweep.h"
+
+// --- INTERNAL DATA STRUCTURES ---
+
+/**
+ * @brief One simulated trajectory shared by a group of configurations.
+ *
+ * @details Members of a branch occupy the contiguous range [begin, end)
+ * of the sweep's member permutation.
+ */
+typedef struct {
+    TrafficSystem sys;
+    uint32_t begin;
+    uint32_t end;
+} SweepBranch;
+
+typedef struct {
+    const TimingConfig* configs;
+    uint32_t n_configs;
+
+    SweepBranch** branches;
+    uint32_t n_branches;
+
+    uint32_t* members; // Config indices, grouped by branch
+    uint32_t* scratch_members; // Reordering buffer for forks
+    uint16_t* classes; // Decision class of each member (by position)
+    TrafficDecision* decisions; // Distinct decisions of the branch being stepped
+} SweepContext;
+
+// --- HELPER FUNCTIONS ---
+
+static void sweep_free(SweepContext* ctx) {
+    if (ctx->branches) {
+        for (uint32_t i = 0; i < ctx->n_branches; i++) {
+            free(ctx->branches[i]);
+        }
+    }
+    free(ctx->branches);
+    free(ctx->members);
+    free(ctx->scratch_members);
+    free(ctx->classes);
+    free(ctx->decisions);
+}
+
+/**
+ * @brief Groups branch members by their decision for the current step.
+ *
+ * @return Number of distinct decisions (decision classes)
+ */
+static uint16_t classify_members(SweepContext* ctx, const SweepBranch* branch) {
+    uint16_t n_classes = 0;
+
+    for (uint32_t pos = branch->begin; pos < branch->end; pos++) {
+        TrafficDecision decision;
+        traffic_fsm_decide(&branch->sys, &ctx->configs[ctx->members[pos]], &decision);
+
+        uint16_t cls = 0;
+        while (cls < n_classes && !traffic_decision_equal(&ctx->decisions[cls], &decision)) {
+            cls++;
+        }
+        if (cls == n_classes) {
+            ctx->decisions[n_classes++] = decision;
+        }
+        ctx->classes[pos] = cls;
+    }
+
+    return n_classes;
+}
+
+/**
+ * @brief Splits a branch so that every decision class gets its own trajectory.
+ *
+ * @details Class 0 stays in the original branch, the others are copied into
+ * new branches appended at the end of the branch list.
+ *
+ * @return false on allocation failure
+ */
+static bool fork_branch(SweepContext* ctx, uint32_t branch_idx, uint16_t n_classes) {
+    SweepBranch* branch = ctx->branches[branch_idx];
+    uint32_t begin = branch->begin;
+    uint32_t end = branch->end;
+
+    // Stable counting sort of the member range by decision class
+    uint32_t out = begin;
+    uint32_t class_begin[n_classes + 1];
+    for (uint16_t cls = 0; cls < n_classes; cls++) {
+        class_begin[cls] = out;
+        for (uint32_t pos = begin; pos < end; pos++) {
+            if (ctx->classes[pos] == cls) {
+                ctx->scratch_members[out++] = ctx->members[pos];
+            }
+        }
+    }
+    class_begin[n_classes] = end;
+    memcpy(&ctx->members[begin], &ctx->scratch_members[begin], (end - begin) * sizeof(uint32_t));
+
+    for (uint16_t cls = 1; cls < n_classes; cls++) {
+        SweepBranch* fork = malloc(sizeof(SweepBranch));
+        if (!fork) return false;
+
+        memcpy(&fork->sys, &branch->sys, sizeof(TrafficSystem));
+        fork->begin = class_begin[cls];
+        fork->end = class_begin[cls + 1];
+        fork->sys.timing = ctx->configs[ctx->members[fork->begin]];
+        ctx->branches[ctx->n_branches++] = fork;
+    }
+
+    branch->end = class_begin[1];
+    return true;
+}
+
+// --- PUBLIC API IMPLEMENTATION ---
+
+bool traffic_sweep_run(const TimingConfig* configs, uint32_t n_configs, TrafficStrategyId strategy,
+                       const Vehicle* arrivals, uint32_t n_arrivals, uint32_t n_steps,
+                       TrafficStats* out_stats, SweepInfo* info) {
+    if (!configs || n_configs == 0 || !out_stats || (n_arrivals > 0 && !arrivals) ||
+        strategy >= STRATEGY_COUNT) {
+        return false;
+    }
+
+    SweepContext ctx = {0};
+    ctx.configs = configs;
+    ctx.n_configs = n_configs;
+    ctx.branches = calloc(n_configs, sizeof(SweepBranch*));
+    ctx.members = malloc(n_configs * sizeof(uint32_t));
+    ctx.scratch_members = malloc(n_configs * sizeof(uint32_t));
+    ctx.classes = malloc(n_configs * sizeof(uint16_t));
+    ctx.decisions = malloc(n_configs * sizeof(TrafficDecision));
+
+    if (!ctx.branches || !ctx.members || !ctx.scratch_members || !ctx.classes || !ctx.decisions) {
+        sweep_free(&ctx);
+        return false;
+    }
+
+    SweepBranch* root = malloc(sizeof(SweepBranch));
+    if (!root) {
+        sweep_free(&ctx);
+        return false;
+    }
+    traffic_init(&root->sys, configs[0]);
+    traffic_set_strategy(&root->sys, strategy);
+    root->begin = 0;
+    root->end = n_configs;
+    ctx.branches[ctx.n_branches++] = root;
+
+    for (uint32_t i = 0; i < n_configs; i++) {
+        ctx.members[i] = i;
+    }
+
+    SweepInfo counters = {0};
+    char discharged_ids[ROAD_COUNT * LANES_PER_ROAD][VEHICLE_ID_LEN];
+    uint32_t next_arrival = 0;
+
+    for (uint32_t step = 1; step <= n_steps; step++) {
+        // Vehicles that appeared before this step join every trajectory
+        uint32_t first_arrival = next_arrival;
+        while (next_arrival < n_arrivals && arrivals[next_arrival].arrival_step < step) {
+            next_arrival++;
+        }
+        if (next_arrival > first_arrival) {
+            for (uint32_t b = 0; b < ctx.n_branches; b++) {
+                traffic_add_vehicles(&ctx.branches[b]->sys, &arrivals[first_arrival], next_arrival - first_arrival);
+            }
+        }
+
+        // Branches forked during this step are already stepped by their parent
+        uint32_t n_active = ctx.n_branches;
+        for (uint32_t b = 0; b < n_active; b++) {
+            SweepBranch* branch = ctx.branches[b];
+            traffic_fsm_advance_clock(&branch->sys);
+
+            uint16_t n_classes = classify_members(&ctx, branch);
+            counters.decisions += branch->end - branch->begin;
+
+            if (n_classes > 1) {
+                uint32_t first_fork = ctx.n_branches;
+                if (!fork_branch(&ctx, b, n_classes)) {
+                    sweep_free(&ctx);
+                    return false;
+                }
+                for (uint16_t cls = 1; cls < n_classes; cls++) {
+                    traffic_fsm_apply(&ctx.branches[first_fork + cls - 1]->sys, &ctx.decisions[cls], discharged_ids);
+                }
+                counters.branch_steps += n_classes - 1;
+            }
+
+            traffic_fsm_apply(&branch->sys, &ctx.decisions[0], discharged_ids);
+            counters.branch_steps++;
+        }
+    }
+
+    for (uint32_t b = 0; b < ctx.n_branches; b++) {
+        const SweepBranch* branch = ctx.branches[b];
+        for (uint32_t pos = branch->begin; pos < branch->end; pos++) {
+            out_stats[ctx.members[pos]] = branch->sys.stats;
+        }
+    }
+
+    counters.branches = ctx.n_branches;
+    if (info) {
+        *info = counters;
+    }
+
+    sweep_free(&ctx);
+    return true;
+}
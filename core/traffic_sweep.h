@@ -0,0 +1,49 @@
+/**
+ * @file traffic_sweep.h
+ * @brief Parameter sweep engine sharing common simulation prefixes.
+ * @details Runs one scenario against many timing configurations at once. All
+ * configurations start on a single shared trajectory, which is forked only when
+ * their control decisions (phase selection, skipping or green extension) differ.
+ * The configurations therefore form a tree, and the cost of a sweep is close to
+ * the number of distinct behaviours instead of the number of configurations.
+ */
+
+#ifndef TRAFFIC_SWEEP_H
+#define TRAFFIC_SWEEP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "traffic_fsm.h"
+
+/**
+ * @brief Work counters of a single sweep.
+ */
+typedef struct {
+    uint32_t branches; // Distinct trajectories created (1 = no fork)
+    uint64_t branch_steps; // Full FSM steps executed across all branches
+    uint64_t decisions; // Control decisions evaluated (configs x steps)
+} SweepInfo;
+
+/**
+ * @brief Runs a scenario for every configuration, sharing identical prefixes.
+ *
+ * @details Vehicles are added before the step following their arrival_step,
+ * i.e. a vehicle with arrival_step == k joins its queue before step k + 1, exactly
+ * like a host sending CMD_ADD_VEHICLE followed by CMD_STEP.
+ *
+ * @param configs Timing configurations to evaluate
+ * @param n_configs Number of configurations
+ * @param strategy Controller strategy shared by all configurations
+ * @param arrivals Vehicles sorted by arrival_step
+ * @param n_arrivals Number of vehicles
+ * @param n_steps Number of simulation steps
+ * @param out_stats Array of n_configs statistics, filled in configs order
+ * @param info Optional work counters (can be NULL)
+ *
+ * @return true on success, false on invalid arguments or allocation failure
+ */
+bool traffic_sweep_run(const TimingConfig* configs, uint32_t n_configs, TrafficStrategyId strategy,
+                       const Vehicle* arrivals, uint32_t n_arrivals, uint32_t n_steps,
+                       TrafficStats* out_stats, SweepInfo* info);
+
+#endif // TRAFFIC_SWEEP_H
@@ -0,0 +1,55 @@
+/**
+ * @file traffic_telemetry.c
+ * @brief Implementation of the sampled telemetry publisher.
+ */
+
+#include <string.h>
+#include "traffic_telemetry.h"
+
+// --- PUBLIC API IMPLEMENTATION ---
+
+void traffic_telemetry_init(TrafficTelemetry* t, TelemetryRecord* record, uint32_t every, const TrafficSystem* sys) {
+    t->record = record;
+    t->every = every > 0 ? every : TELEMETRY_EVERY_DEFAULT;
+
+    memset(record, 0, sizeof(*record));
+    record->magic = TELEMETRY_MAGIC;
+    record->every = t->every;
+    traffic_telemetry_publish(t, sys, 0);
+}
+
+void traffic_telemetry_publish(TrafficTelemetry* t, const TrafficSystem* sys, uint8_t flags) {
+    TelemetryRecord* r = t->record;
+    volatile TelemetryRecord* shared = r;
+
+    // Odd sequence: readers retry until the sample is complete
+    shared->sequence = shared->sequence + 1;
+    __sync_synchronize();
+
+    r->current_step = sys->current_step;
+    r->departures = sys->stats.departures;
+    r->max_wait = sys->stats.max_wait;
+    r->total_wait = sys->stats.total_wait;
+    r->extension_steps = (uint16_t)sys->extension_timer;
+    r->max_extension = (uint16_t)sys->timing.max_ext;
+    r->current_state = (uint8_t)sys->current_state;
+    r->light_ns_st = (uint8_t)sys->lights[NORTH][LANE_STRAIGHT_RIGHT];
+    r->light_ns_lt = (uint8_t)sys->lights[NORTH][LANE_LEFT];
+    r->light_ew_st = (uint8_t)sys->lights[EAST][LANE_STRAIGHT_RIGHT];
+    r->light_ew_lt = (uint8_t)sys->lights[EAST][LANE_LEFT];
+    r->strategy = sys->strategy;
+    r->flags = flags;
+
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            const VehicleQueue* q = &sys->queues[road][lane];
+            r->queue_lengths[road * LANES_PER_ROAD + lane] = queue_count(q);
+            memcpy(r->wait_hist[road * LANES_PER_ROAD + lane], queue_get_wait_hist(q)->counts,
+                   sizeof(r->wait_hist[0]));
+        }
+    }
+
+    __sync_synchronize();
+    shared->sequence = shared->sequence + 1;
+    t->countdown = t->every;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file traffic_telemetry.h
+ * @brief Sampled telemetry of a running system for live monitors.
+ * @details Every `every` steps the publisher copies the queue depths, phase,
+ * extension usage, wait statistics and wait histograms of a system into a
+ * TelemetryRecord (protocol.h). The record lives in memory shared with the
+ * monitor (a memory-mapped file for traffic_sim --telemetry), so publishing is
+ * a few hundred bytes of stores and never waits for the reader. Between samples
+ * a step costs one countdown decrement.
+ *
+ * The record is guarded by a sequence counter (odd while it is written), so a
+ * reader polling at its own rate never sees a half-written sample. There is a
+ * single writer.
+ */
+
+#ifndef TRAFFIC_TELEMETRY_H
+#define TRAFFIC_TELEMETRY_H
+
+#include <stdint.h>
+#include "traffic_fsm.h"
+#include "protocol.h"
+
+#define TELEMETRY_EVERY_DEFAULT 100 // Steps between samples
+
+/**
+ * @brief Publisher of one system.
+ */
+typedef struct {
+    TelemetryRecord* record; // Shared record, NULL if telemetry is off
+    uint32_t every;
+    uint32_t countdown; // Steps until the next sample
+} TrafficTelemetry;
+
+/**
+ * @brief Starts publishing into a record and writes the first sample.
+ *
+ * @param t Pointer to TrafficTelemetry
+ * @param record Shared record (its previous contents are discarded)
+ * @param every Steps between samples (0 = TELEMETRY_EVERY_DEFAULT)
+ * @param sys System to observe
+ */
+void traffic_telemetry_init(TrafficTelemetry* t, TelemetryRecord* record, uint32_t every, const TrafficSystem* sys);
+
+/**
+ * @brief Writes a sample of the system now.
+ *
+ * @param t Pointer to TrafficTelemetry
+ * @param sys System to observe
+ * @param flags TELEMETRY_FINISHED for the last sample, 0 otherwise
+ */
+void traffic_telemetry_publish(TrafficTelemetry* t, const TrafficSystem* sys, uint8_t flags);
+
+/**
+ * @brief Accounts for one step of the system, publishing a sample when due.
+ */
+static inline void traffic_telemetry_step(TrafficTelemetry* t, const TrafficSystem* sys) {
+    if (--t->countdown == 0) {
+        traffic_telemetry_publish(t, sys, 0);
+    }
+}
+
+#endif // TRAFFIC_TELEMETRY_H
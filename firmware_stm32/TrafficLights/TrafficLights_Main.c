@@ -1,11 +1,24 @@
 #include "TrafficLights_Main.h"
 #include "traffic_fsm.h"
 #include "protocol.h"
+#include "traffic_persist.h"
+#include "traffic_stream.h"
+#include "stack_watermark.h"
+#include <stddef.h>
 #include <string.h>
 
+#ifdef TRAFFIC_FRAMED_PROTOCOL
+#include "frame_codec.h"
+#endif
+
 extern UART_HandleTypeDef huart2; 
 #define COMM_UART &huart2
 
+// Steps between automatic flash checkpoints, 0 = only on CMD_SAVE_CHECKPOINT
+#ifndef TRAFFIC_CHECKPOINT_INTERVAL
+#define TRAFFIC_CHECKPOINT_INTERVAL 0
+#endif
+
 const RoadLeds_t North = {{LED_N_RED_GPIO_Port, LED_N_RED_Pin}, {LED_N_YELLOW_GPIO_Port, LED_N_YELLOW_Pin}, {LED_N_GREEN_GPIO_Port, LED_N_GREEN_Pin}, {LED_N_FIRST_GPIO_Port, LED_N_FIRST_Pin}, {LED_N_SECOND_GPIO_Port, LED_N_SECOND_Pin}, 0};
 const RoadLeds_t South = {{LED_S_RED_GPIO_Port, LED_S_RED_Pin}, {LED_S_YELLOW_GPIO_Port, LED_S_YELLOW_Pin}, {LED_S_GREEN_GPIO_Port, LED_S_GREEN_Pin}, {LED_S_FIRST_GPIO_Port, LED_S_FIRST_Pin}, {LED_S_SECOND_GPIO_Port, LED_S_SECOND_Pin}, 0};
 const RoadLeds_t East  = {{LED_E_RED_GPIO_Port, LED_E_RED_Pin}, {LED_E_YELLOW_GPIO_Port, LED_E_YELLOW_Pin}, {LED_E_GREEN_GPIO_Port, LED_E_GREEN_Pin}, {LED_E_FIRST_GPIO_Port, LED_E_FIRST_Pin}, {LED_E_SECOND_GPIO_Port, LED_E_SECOND_Pin}, 0};
@@ -13,6 +26,42 @@ const RoadLeds_t West  = {{LED_W_RED_GPIO_Port, LED_W_RED_Pin}, {LED_W_YELLOW_GP
 
 TrafficSystem sys;
 
+// CMD_SUBSCRIBE_STATE stream (the board hosts session 0 only)
+static StateStream state_stream;
+static bool state_subscribed;
+
+/*
+ * Configuration/checkpoint log in the PERSIST region of the linker script
+ * (bank 2, so erasing never stalls code running from bank 1). A store page
+ * is two 2 KB flash pages.
+ */
+extern const uint8_t _persist_start[];
+#define PERSIST_PAGE_SIZE (2 * FLASH_PAGE_SIZE)
+#define PERSIST_PAGE_COUNT 4
+
+static bool Persist_Erase(void* ctx, uint16_t page);
+static bool Persist_Program(void* ctx, uint32_t offset, const uint8_t* data, uint32_t len);
+
+static const PersistFlash persist_flash = {
+    .base = _persist_start, .page_size = PERSIST_PAGE_SIZE, .page_count = PERSIST_PAGE_COUNT,
+    .erase = Persist_Erase, .program = Persist_Program, .ctx = NULL
+};
+static PersistStore store;
+
+/*
+ * RAM layout from the linker script: .data and .bss, then the newlib heap
+ * from _end (grown by _sbrk), then the stack down from _estack. The gap
+ * between the heap reservation and the live stack is painted at init, so
+ * CMD_GET_MEMORY can report how deep the stack has ever gone.
+ */
+extern uint8_t _sdata[], _edata[], _sbss[], _ebss[], _end[], _estack[];
+extern uint8_t _Min_Heap_Size[];
+extern void* _sbrk(ptrdiff_t incr);
+#define STACK_PAINT_MARGIN 64 // Bytes left unpainted below the MSP of the painting frame
+
+static uint32_t* stack_low;
+static uint32_t* stack_high;
+
 void Led_Set(Led_t led, GPIO_PinState state) {
     HAL_GPIO_WritePin(led.port, led.pin, state);
 }
@@ -55,36 +104,195 @@ static void Update_Hardware_From_FSM(void) {
     Led_Set(West.q_second,  (qW >= 2) ? GPIO_PIN_SET : GPIO_PIN_RESET);
 }
 
+static bool Persist_Erase(void* ctx, uint16_t page) {
+    (void)ctx;
+    uint32_t address = (uint32_t)(uintptr_t)_persist_start + page * PERSIST_PAGE_SIZE;
+    uint32_t error = 0;
+
+    // Bank 2 page numbers start at 256 (RM0444)
+    FLASH_EraseInitTypeDef erase = {
+        .TypeErase = FLASH_TYPEERASE_PAGES,
+        .Banks = FLASH_BANK_2,
+        .Page = 256 + (address - (FLASH_BASE + FLASH_BANK_SIZE)) / FLASH_PAGE_SIZE,
+        .NbPages = PERSIST_PAGE_SIZE / FLASH_PAGE_SIZE
+    };
+
+    HAL_FLASH_Unlock();
+    bool ok = HAL_FLASHEx_Erase(&erase, &error) == HAL_OK;
+    HAL_FLASH_Lock();
+    return ok;
+}
+
+static bool Persist_Program(void* ctx, uint32_t offset, const uint8_t* data, uint32_t len) {
+    (void)ctx;
+    uint32_t address = (uint32_t)(uintptr_t)_persist_start + offset;
+    bool ok = true;
+
+    HAL_FLASH_Unlock();
+    for (uint32_t i = 0; ok && i < len; i += PERSIST_WRITE_ALIGN) {
+        uint64_t dword;
+        memcpy(&dword, &data[i], sizeof(dword));
+        ok = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, address + i, dword) == HAL_OK;
+    }
+    HAL_FLASH_Lock();
+    return ok;
+}
+
+static WaitPercentiles Percentiles_Of(const WaitHistogram* h) {
+    WaitPercentiles p = {
+        .departures = wait_hist_total(h),
+        .p50 = wait_hist_percentile(h, 500),
+        .p95 = wait_hist_percentile(h, 950),
+        .p99 = wait_hist_percentile(h, 990)
+    };
+    return p;
+}
+
+static TimingConfig Config_From_Payload(const PayloadConfig* payload) {
+    TimingConfig config = {
+        .green_st = payload->green_st, .green_lt = payload->green_lt,
+        .yellow = payload->yellow, .all_red = payload->all_red, .red_yellow = 1,
+        .ext_threshold = payload->ext_threshold, .max_ext = payload->max_ext,
+        .skip_limit = payload->skip_limit
+    };
+    return config;
+}
+
+#ifdef TRAFFIC_FRAMED_PROTOCOL
+/*
+ * Framed link (see frame_codec.h): commands are read from the payload of the
+ * last received frame and responses are collected into one reply frame with
+ * the same seq. The reply is kept until the next frame so a retransmission
+ * is answered without executing its commands twice.
+ */
+static FrameDecoder rx_decoder;
+static size_t rx_pos;
+static uint8_t tx_payload[FRAME_MAX_PAYLOAD];
+static size_t tx_len;
+static bool tx_overflow;
+static uint8_t tx_frame[FRAME_ENCODED_SIZE(FRAME_MAX_PAYLOAD)];
+static size_t tx_frame_len;
+
+static bool Comm_Receive(void* data, size_t len, uint32_t timeout) {
+    (void)timeout;
+    if (rx_pos + len > rx_decoder.payload_len) {
+        rx_pos = rx_decoder.payload_len; // Truncated message: ignore the rest of the frame
+        return false;
+    }
+    memcpy(data, &rx_decoder.payload[rx_pos], len);
+    rx_pos += len;
+    return true;
+}
+
+static void Comm_Transmit(const void* data, size_t len) {
+    if (tx_len + len > sizeof(tx_payload)) {
+        tx_overflow = true;
+        return;
+    }
+    memcpy(&tx_payload[tx_len], data, len);
+    tx_len += len;
+}
+#else
+static bool Comm_Receive(void* data, size_t len, uint32_t timeout) {
+    return HAL_UART_Receive(COMM_UART, (uint8_t*)data, (uint16_t)len, timeout) == HAL_OK;
+}
+
+static void Comm_Transmit(const void* data, size_t len) {
+    HAL_UART_Transmit(COMM_UART, (uint8_t*)data, (uint16_t)len, 1000);
+}
+#endif
+
+static void Stream_Transmit(void* ctx, const void* data, size_t len) {
+    (void)ctx;
+    Comm_Transmit(data, len);
+}
+
+static void Stack_Paint(void) {
+    uint8_t* heap_end = (uint8_t*)_sbrk(0);
+    uint8_t* reserved = _end + (uintptr_t)_Min_Heap_Size;
+    uintptr_t low = (uintptr_t)(heap_end > reserved ? heap_end : reserved);
+    uintptr_t high = (uintptr_t)__get_MSP() - STACK_PAINT_MARGIN;
+
+    stack_low = (uint32_t*)((low + 3u) & ~(uintptr_t)3u);
+    stack_high = (uint32_t*)(high & ~(uintptr_t)3u);
+    if (stack_high > stack_low) {
+        stack_paint(stack_low, stack_high);
+    } else {
+        stack_low = stack_high = NULL;
+    }
+}
+
 void Traffic_Lights_Init(void) {
+    Stack_Paint(); // First, so the mark covers everything after boot
+
     Road_Off(&North); Road_Off(&South); Road_Off(&East); Road_Off(&West);
+
+    // Safe state first, before anything that depends on flash contents
+    Apply_LightColor_To_Physical(&North, LIGHT_RED);
+    Apply_LightColor_To_Physical(&South, LIGHT_RED);
+    Apply_LightColor_To_Physical(&East, LIGHT_RED);
+    Apply_LightColor_To_Physical(&West, LIGHT_RED);
     
     TimingConfig default_config = DEFAULT_TIMING;
     traffic_init(&sys, default_config);
+
+    // Warm boot: last configuration (or checkpoint) without waiting for the host.
+    // Mounting reads the 16 KB region once, so this takes bounded time.
+    if (persist_mount(&store, &persist_flash) &&
+        persist_restore(&store, &sys) == PERSIST_RESTORED_CHECKPOINT) {
+        traffic_restart_cycle(&sys); // Lights were dark: resume through All-Red
+    }
     Update_Hardware_From_FSM();
+
+#ifdef TRAFFIC_FRAMED_PROTOCOL
+    frame_decoder_init(&rx_decoder);
+#endif
 }
 
-void TrafficLights_Main(void) {
+static void Process_Command(void) {
     CmdHeader header;
     char discharged_ids[ROAD_COUNT * LANES_PER_ROAD][VEHICLE_ID_LEN];
 
-    if (HAL_UART_Receive(COMM_UART, (uint8_t*)&header, sizeof(CmdHeader), HAL_MAX_DELAY) == HAL_OK) {
+    if (Comm_Receive(&header, sizeof(CmdHeader), HAL_MAX_DELAY)) {
         if (header.cmd_type == CMD_CONFIG) {
             PayloadConfig payload;
-            if (HAL_UART_Receive(COMM_UART, (uint8_t*)&payload, sizeof(PayloadConfig), 1000) == HAL_OK) {
-                TimingConfig config = {
-                    .green_st = payload.green_st, .green_lt = payload.green_lt,
-                    .yellow = payload.yellow, .all_red = payload.all_red,
-                    .ext_threshold = payload.ext_threshold, .max_ext = payload.max_ext,
-                    .skip_limit = payload.skip_limit
-                };
+            if (Comm_Receive(&payload, sizeof(PayloadConfig), 1000)) {
+                TimingConfig config = Config_From_Payload(&payload);
                 traffic_init(&sys, config);
                 Update_Hardware_From_FSM();
+                persist_save_config(&store, &config);
+                state_stream_resync(&state_stream);
             }
         } 
+
+        else if (header.cmd_type == CMD_UPDATE_TIMING) {
+            PayloadConfig payload;
+            if (Comm_Receive(&payload, sizeof(PayloadConfig), 1000)) {
+                TimingConfig config = Config_From_Payload(&payload);
+                traffic_update_timing(&sys, &config);
+                persist_save_config(&store, &config);
+            }
+        }
+
+        else if (header.cmd_type == CMD_ADD_TIMING_PLAN) {
+            PayloadTimingPlan payload;
+            if (Comm_Receive(&payload, sizeof(PayloadTimingPlan), 1000)) {
+                TimingPlan plan = {.start_step = payload.start_step, .timing = Config_From_Payload(&payload.timing)};
+                traffic_add_timing_plan(&sys, &plan);
+            }
+        }
         
+        else if (header.cmd_type == CMD_SET_STRATEGY) {
+            PayloadStrategy payload;
+            if (Comm_Receive(&payload, sizeof(PayloadStrategy), 1000)) {
+                traffic_set_strategy(&sys, (TrafficStrategyId)payload.strategy);
+                Update_Hardware_From_FSM();
+            }
+        }
+
         else if (header.cmd_type == CMD_ADD_VEHICLE) {
             PayloadAddVehicle payload;
-            if (HAL_UART_Receive(COMM_UART, (uint8_t*)&payload, sizeof(PayloadAddVehicle), 1000) == HAL_OK) {
+            if (Comm_Receive(&payload, sizeof(PayloadAddVehicle), 1000)) {
                 payload.vehicle_id[VEHICLE_ID_LEN - 1] = '\0';
                 traffic_add_vehicle(&sys, payload.vehicle_id, payload.start_road, payload.end_road, payload.arrival_time);
                 Update_Hardware_From_FSM();
@@ -93,6 +301,9 @@ void TrafficLights_Main(void) {
 
         else if (header.cmd_type == CMD_STEP) {
             memset(discharged_ids, 0, sizeof(discharged_ids));
+            if (state_subscribed) {
+                state_stream_before_step(&state_stream, &sys);
+            }
             int count = traffic_fsm_step(&sys, discharged_ids);
             Update_Hardware_From_FSM();
 
@@ -105,11 +316,154 @@ void TrafficLights_Main(void) {
             resp.light_ew_lt = (uint8_t)sys.lights[EAST][LANE_LEFT];
             resp.vehicles_out = (uint16_t)count;
 
-            HAL_UART_Transmit(COMM_UART, (uint8_t*)&resp, sizeof(ResponseStep), 1000);
+            Comm_Transmit(&resp, sizeof(ResponseStep));
 
             if (count > 0) {
-                HAL_UART_Transmit(COMM_UART, (uint8_t*)discharged_ids, VEHICLE_ID_LEN * count, 1000);
+                Comm_Transmit(discharged_ids, VEHICLE_ID_LEN * count);
+            }
+            if (state_subscribed && state_stream_after_step(&state_stream, &sys)) {
+                state_stream_send(&state_stream, &sys, Stream_Transmit, NULL);
             }
+
+#if TRAFFIC_CHECKPOINT_INTERVAL > 0
+            if (sys.current_step % TRAFFIC_CHECKPOINT_INTERVAL == 0) {
+                persist_save_checkpoint(&store, &sys);
+            }
+#endif
+        }
+
+        else if (header.cmd_type == CMD_SUBSCRIBE_STATE) {
+            PayloadSubscribe payload;
+            if (Comm_Receive(&payload, sizeof(PayloadSubscribe), 1000)) {
+                state_subscribed = payload.session_id == 0 && payload.every > 0;
+                if (state_subscribed) {
+                    state_stream_init(&state_stream, 0, payload.every);
+                    state_stream_send(&state_stream, &sys, Stream_Transmit, NULL);
+                } else if (payload.every > 0) {
+                    StateUpdateHeader invalid = {.session_id = payload.session_id, .flags = STATE_UPDATE_INVALID};
+                    Comm_Transmit(&invalid, sizeof(StateUpdateHeader));
+                }
+            }
+        }
+
+        else if (header.cmd_type == CMD_GET_STATS) {
+            ResponseStats resp = {
+                .current_step = sys.current_step,
+                .departures = sys.stats.departures,
+                .total_wait = sys.stats.total_wait,
+                .max_wait = sys.stats.max_wait,
+                .left_departures = sys.stats.left_departures,
+                .left_total_wait = sys.stats.left_total_wait
+            };
+
+            Comm_Transmit(&resp, sizeof(ResponseStats));
+        }
+
+        else if (header.cmd_type == CMD_GET_WAIT_PERCENTILES) {
+            ResponseWaitPercentiles resp;
+            WaitHistogram merged;
+
+            for (uint8_t i = 0; i < ROAD_COUNT * LANES_PER_ROAD; i++) {
+                resp.lanes[i] = Percentiles_Of(queue_get_wait_hist(&sys.queues[i / LANES_PER_ROAD][i % LANES_PER_ROAD]));
+            }
+            for (uint8_t movement = 0; movement < MOVEMENT_COUNT; movement++) {
+                traffic_movement_wait_hist(&sys, movement, &merged);
+                resp.movements[movement] = Percentiles_Of(&merged);
+            }
+
+            Comm_Transmit(&resp, sizeof(ResponseWaitPercentiles));
+        }
+
+        else if (header.cmd_type == CMD_GET_WAIT_HISTOGRAM) {
+            // Same layout as ResponseWaitHistogram, sent lane by lane to avoid a 2 KB stack copy
+            for (uint8_t i = 0; i < ROAD_COUNT * LANES_PER_ROAD; i++) {
+                const WaitHistogram* h = queue_get_wait_hist(&sys.queues[i / LANES_PER_ROAD][i % LANES_PER_ROAD]);
+                Comm_Transmit(h->counts, sizeof(h->counts));
+            }
+        }
+
+        else if (header.cmd_type == CMD_SAVE_CHECKPOINT) {
+            persist_save_checkpoint(&store, &sys);
         }
+
+        else if (header.cmd_type == CMD_GET_MEMORY) {
+            // No free() on the board: the heap only grows, so its end is also its peak
+            uint32_t heap = (uint32_t)((uint8_t*)_sbrk(0) - _end);
+            ResponseMemory resp = {
+                .ram_size = (uint32_t)((uintptr_t)_estack - SRAM_BASE),
+                .static_bytes = (uint32_t)((_edata - _sdata) + (_ebss - _sbss)),
+                .system_bytes = sizeof(TrafficSystem),
+                .heap_bytes = heap,
+                .heap_peak = heap
+            };
+            if (stack_low) {
+                // Measured from the top of RAM, so the frames above the painted region count too
+                resp.stack_size = (uint32_t)((uintptr_t)_estack - (uintptr_t)stack_low);
+                resp.stack_peak = stack_high_water(stack_low, stack_high) + (uint32_t)((uintptr_t)_estack - (uintptr_t)stack_high);
+            }
+
+            Comm_Transmit(&resp, sizeof(ResponseMemory));
+        }
+
+#ifdef TRAFFIC_FRAMED_PROTOCOL
+        else if (header.cmd_type == CMD_GET_LINK_STATS) {
+            ResponseLinkStats resp = {
+                .frames_ok = rx_decoder.stats.frames_ok,
+                .frames_dropped = rx_decoder.stats.frames_dropped,
+                .frames_duplicate = rx_decoder.stats.frames_duplicate,
+                .seq_gaps = rx_decoder.stats.seq_gaps
+            };
+
+            Comm_Transmit(&resp, sizeof(ResponseLinkStats));
+        }
+#endif
+    }
+}
+
+#ifdef TRAFFIC_FRAMED_PROTOCOL
+static void Send_Frame(uint8_t seq, uint8_t flags, const uint8_t* payload, size_t len) {
+    tx_frame_len = frame_encode(seq, flags, payload, len, tx_frame, sizeof(tx_frame));
+    HAL_UART_Transmit(COMM_UART, tx_frame, (uint16_t)tx_frame_len, 1000);
+}
+
+void TrafficLights_Main(void) {
+    uint8_t byte;
+
+    // No timeouts inside a message: a lost byte costs one frame, not a stall
+    if (HAL_UART_Receive(COMM_UART, &byte, 1, HAL_MAX_DELAY) != HAL_OK) {
+        return;
+    }
+
+    switch (frame_decoder_push(&rx_decoder, byte)) {
+        case FRAME_OK:
+            rx_pos = 0;
+            tx_len = 0;
+            tx_overflow = false;
+            while (rx_pos < rx_decoder.payload_len) {
+                Process_Command();
+            }
+            if (tx_overflow) {
+                Send_Frame(rx_decoder.seq, FRAME_FLAG_NAK, NULL, 0);
+            } else {
+                Send_Frame(rx_decoder.seq, 0, tx_payload, tx_len);
+            }
+            break;
+
+        case FRAME_DUPLICATE:
+            // Our reply was lost: resend it without executing the frame again
+            HAL_UART_Transmit(COMM_UART, tx_frame, (uint16_t)tx_frame_len, 1000);
+            break;
+
+        case FRAME_DROPPED:
+            Send_Frame(rx_decoder.last_seq, FRAME_FLAG_NAK, NULL, 0);
+            break;
+
+        default:
+            break;
     }
-}
\ No newline at end of file
+}
+#else
+void TrafficLights_Main(void) {
+    Process_Command();
+}
+#endif
@@ -0,0 +1,185 @@
+/**
+ * @file frame_codec.c
+ * @brief COBS + CRC-16 framing of protocol messages
+ */
+
+#include <string.h>
+#include "frame_codec.h"
+
+/**
+ * @brief CRC-16/CCITT remainders of a 4-bit value (half-byte table, 32 bytes of flash)
+ */
+static const uint16_t CRC16_NIBBLE[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+uint16_t frame_crc16(uint16_t crc, const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        crc = (uint16_t)((crc << 4) ^ CRC16_NIBBLE[(crc >> 12) ^ (data[i] >> 4)]);
+        crc = (uint16_t)((crc << 4) ^ CRC16_NIBBLE[(crc >> 12) ^ (data[i] & 0x0F)]);
+    }
+    return crc;
+}
+
+/**
+ * @brief COBS writer state: code byte position and run length of the current block
+ */
+typedef struct {
+    uint8_t* out;
+    size_t capacity;
+    size_t pos;
+    size_t code_pos;
+    uint8_t code;
+    bool overflow;
+} CobsWriter;
+
+static void cobs_start_block(CobsWriter* w) {
+    w->code_pos = w->pos++;
+    w->code = 1;
+    if (w->code_pos >= w->capacity) {
+        w->overflow = true;
+    }
+}
+
+static void cobs_finish_block(CobsWriter* w) {
+    if (!w->overflow) {
+        w->out[w->code_pos] = w->code;
+    }
+}
+
+static void cobs_put(CobsWriter* w, uint8_t byte) {
+    if (byte == 0) {
+        cobs_finish_block(w);
+        cobs_start_block(w);
+        return;
+    }
+
+    if (w->pos >= w->capacity) {
+        w->overflow = true;
+    } else {
+        w->out[w->pos] = byte;
+    }
+    w->pos++;
+
+    if (++w->code == 0xFF) {
+        cobs_finish_block(w);
+        cobs_start_block(w);
+    }
+}
+
+static void cobs_put_bytes(CobsWriter* w, const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        cobs_put(w, data[i]);
+    }
+}
+
+size_t frame_encode(uint8_t seq, uint8_t flags, const uint8_t* payload, size_t len,
+                    uint8_t* out, size_t capacity) {
+    if (!out || (len > 0 && !payload)) return 0;
+
+    uint8_t header[FRAME_HEADER_SIZE] = {seq, flags};
+    uint16_t crc = frame_crc16(0xFFFF, header, sizeof(header));
+    crc = frame_crc16(crc, payload, len);
+    uint8_t trailer[FRAME_CRC_SIZE] = {(uint8_t)(crc & 0xFF), (uint8_t)(crc >> 8)};
+
+    CobsWriter w = {.out = out, .capacity = capacity};
+    cobs_start_block(&w);
+    cobs_put_bytes(&w, header, sizeof(header));
+    cobs_put_bytes(&w, payload, len);
+    cobs_put_bytes(&w, trailer, sizeof(trailer));
+    cobs_finish_block(&w);
+
+    if (w.overflow || w.pos >= capacity) {
+        return 0;
+    }
+    out[w.pos++] = FRAME_DELIMITER;
+    return w.pos;
+}
+
+/**
+ * @brief Decodes a COBS block in place
+ *
+ * @return Decoded length, 0 on malformed input
+ */
+static size_t cobs_decode_in_place(uint8_t* buf, size_t len) {
+    size_t in = 0;
+    size_t out = 0;
+
+    while (in < len) {
+        uint8_t code = buf[in++];
+        if (code == 0 || in + code - 1 > len) {
+            return 0;
+        }
+
+        for (uint8_t i = 1; i < code; i++) {
+            buf[out++] = buf[in++];
+        }
+        if (code != 0xFF && in < len) {
+            buf[out++] = 0;
+        }
+    }
+    return out;
+}
+
+void frame_decoder_init(FrameDecoder* d) {
+    if (!d) return;
+    memset(d, 0, sizeof(FrameDecoder));
+}
+
+/**
+ * @brief Validates the collected frame and updates the counters
+ */
+static FrameResult finish_frame(FrameDecoder* d) {
+    size_t len = d->overflow ? 0 : cobs_decode_in_place(d->buf, d->len);
+
+    if (len < FRAME_HEADER_SIZE + FRAME_CRC_SIZE) {
+        d->stats.frames_dropped++;
+        return FRAME_DROPPED;
+    }
+
+    size_t body = len - FRAME_CRC_SIZE;
+    uint16_t crc = (uint16_t)(d->buf[body] | (d->buf[body + 1] << 8));
+    if (frame_crc16(0xFFFF, d->buf, body) != crc) {
+        d->stats.frames_dropped++;
+        return FRAME_DROPPED;
+    }
+
+    d->seq = d->buf[0];
+    d->flags = d->buf[1];
+    d->payload = &d->buf[FRAME_HEADER_SIZE];
+    d->payload_len = body - FRAME_HEADER_SIZE;
+
+    if (d->has_seq && d->seq == d->last_seq) {
+        d->stats.frames_duplicate++;
+        return FRAME_DUPLICATE;
+    }
+    if (d->has_seq && d->seq != (uint8_t)(d->last_seq + 1)) {
+        d->stats.seq_gaps++;
+    }
+
+    d->has_seq = true;
+    d->last_seq = d->seq;
+    d->stats.frames_ok++;
+    return FRAME_OK;
+}
+
+FrameResult frame_decoder_push(FrameDecoder* d, uint8_t byte) {
+    if (byte != FRAME_DELIMITER) {
+        if (d->len < sizeof(d->buf)) {
+            d->buf[d->len++] = byte;
+        } else {
+            d->overflow = true;
+        }
+        return FRAME_NONE;
+    }
+
+    if (d->len == 0 && !d->overflow) {
+        return FRAME_NONE; // Idle delimiters (e.g. line flush) are not frames
+    }
+
+    FrameResult result = finish_frame(d);
+    d->len = 0;
+    d->overflow = false;
+    return result;
+}
@@ -21,6 +21,21 @@ typedef enum {
     CMD_CONFIG = 0,
     CMD_ADD_VEHICLE = 1,
     CMD_STEP = 2,
+    CMD_GET_STATS = 3,
+    CMD_GET_WAIT_PERCENTILES = 4,
+    CMD_GET_WAIT_HISTOGRAM = 5,
+    CMD_SET_STRATEGY = 6,
+    CMD_UPDATE_TIMING = 7,
+    CMD_ADD_TIMING_PLAN = 8,
+    CMD_SESSION_CREATE = 9,
+    CMD_SESSION_SELECT = 10,
+    CMD_SESSION_DESTROY = 11,
+    CMD_STEP_SESSIONS = 12,
+    CMD_GET_LINK_STATS = 13,
+    CMD_SAVE_CHECKPOINT = 14, // Persists the system now (flash on the MCU, --checkpoint file on PC)
+    CMD_SET_AGGREGATION = 15, // Replaces the step responses of session 0 by bucket records
+    CMD_SUBSCRIBE_STATE = 16, // Streams the queue contents of a session (StateUpdateHeader)
+    CMD_GET_MEMORY = 17, // RAM, heap and stack high-water marks (ResponseMemory)
     CMD_STOP = 99
 } CommandType;
 
@@ -45,6 +60,42 @@ typedef struct __attribute__((packed)) {
     uint32_t skip_limit;
 } PayloadConfig;
 
+/**
+ * @brief Payload for CMD_ADD_TIMING_PLAN (32 bytes).
+ * Appends a time-of-day plan; start steps must increase. CMD_CONFIG clears the table.
+ * CMD_UPDATE_TIMING carries a bare PayloadConfig. Unlike CMD_CONFIG, both keep the
+ * queues and statistics and take effect at the next phase boundary.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t start_step;
+    PayloadConfig timing;
+} PayloadTimingPlan;
+
+/**
+ * @brief Payload for CMD_SESSION_SELECT and CMD_SESSION_DESTROY (2 bytes).
+ * Session 0 is the default intersection and always exists.
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t session_id;
+} PayloadSession;
+
+/**
+ * @brief Payload for CMD_SESSION_CREATE (30 bytes).
+ * Creates an intersection with the given timing (as CMD_CONFIG does for session 0).
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t session_id;
+    PayloadConfig timing;
+} PayloadSessionCreate;
+
+/**
+ * @brief Payload for CMD_STEP_SESSIONS (2 bytes).
+ * Followed by `count` uint16_t session IDs, stepped in the given order.
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t count;
+} PayloadStepSessions;
+
 /**
  * @brief Payload for CMD_ADD_VEHICLE (38 bytes).
  */
@@ -55,6 +106,79 @@ typedef struct __attribute__((packed)) {
     uint32_t arrival_time; // Timestamp of vehicle appearance
 } PayloadAddVehicle;
 
+/**
+ * @brief Payload for CMD_SET_STRATEGY (1 byte).
+ * Selects the controller strategy (TrafficStrategyId) for the rest of the session.
+ * CMD_CONFIG restores the default strategy, so it is sent after the configuration.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t strategy;
+} PayloadStrategy;
+
+/**
+ * @brief Payload for CMD_SET_AGGREGATION (5 bytes).
+ * mode is an AggregateMode (traffic_aggregate.h): 0 = off (one ResponseStep per
+ * step), 1 = every bucket_steps steps, 2 = every signal cycle (bucket_steps caps
+ * the cycle bucket, 0 = no cap). While aggregating, CMD_STEP of session 0 sends
+ * nothing except a ResponseBucket whenever a bucket completes. The command first
+ * closes the open bucket, if any, and sends it with BUCKET_FINAL set.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t mode;
+    uint32_t bucket_steps;
+} PayloadAggregation;
+
+/**
+ * @brief Payload for CMD_SUBSCRIBE_STATE (4 bytes).
+ * The response is a keyframe of the session (all queued vehicles and the lights).
+ * Afterwards, every `every` steps of the session, a delta update follows its step
+ * response (ResponseStep or ResponseSessionStep and the departing IDs, or the
+ * ResponseBucket/nothing of an aggregated step). every = 0 unsubscribes (no response).
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t session_id;
+    uint16_t every;
+} PayloadSubscribe;
+
+#define STATE_UPDATE_KEYFRAME 0x01 // Queues restart from empty (full state follows)
+#define STATE_UPDATE_LIGHTS 0x02 // StateLights follows the header
+#define STATE_UPDATE_INVALID 0x80 // Unknown session, nothing follows
+
+/**
+ * @brief Header of a queue state update (8 bytes).
+ * 
+ * Followed by StateLights if flags has STATE_UPDATE_LIGHTS, then, for every lane
+ * set in lane_mask (bit road * 2 + lane, ascending), a StateLaneDelta and its
+ * appended vehicles, each encoded as id_len:u8, id (no terminator), end_road:u8,
+ * arrival_step:u32. A lane is updated by removing `popped` vehicles from its head
+ * and appending the new ones, which reproduces the queue of the core.
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t session_id;
+    uint32_t step;
+    uint8_t flags;
+    uint8_t lane_mask;
+} StateUpdateHeader;
+
+/**
+ * @brief FSM state and lights of a state update (5 bytes, as in ResponseStep).
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t state;
+    uint8_t light_ns_st;
+    uint8_t light_ns_lt;
+    uint8_t light_ew_st;
+    uint8_t light_ew_lt;
+} StateLights;
+
+/**
+ * @brief Change of one lane in a state update (2 bytes).
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t popped; // Vehicles removed from the head since the previous update
+    uint8_t appended; // Vehicles appended at the tail (encoded after this struct)
+} StateLaneDelta;
+
 /**
  * @brief Response sent from Core to Host after CMD_STEP (11 bytes).
  * * Note: If vehicles_out > 0, this struct is immediately followed by 
@@ -73,4 +197,182 @@ typedef struct __attribute__((packed)) {
     uint16_t vehicles_out;      
 } ResponseStep;
 
+#define SESSION_STATE_INVALID 0xFF // step.current_state of an unknown session
+
+/**
+ * @brief Per-session entry of the CMD_STEP_SESSIONS response (13 bytes).
+ * 
+ * One entry per requested ID, followed by (step.vehicles_out * VEHICLE_ID_LEN)
+ * bytes of departing vehicle IDs like a ResponseStep.
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t session_id;
+    ResponseStep step;
+} ResponseSessionStep;
+
+#define BUCKET_FINAL 0x01 // Last bucket of an aggregation (closed early, steps may be 0)
+
+/**
+ * @brief Aggregated bucket sent while CMD_SET_AGGREGATION is on (237 bytes).
+ * 
+ * Lane arrays are indexed [road * 2 + lane]. Mean wait = total_wait / departures,
+ * mean queue = queue_sum / steps. phase_steps counts the steps in the four green
+ * phases (NS straight, NS left, EW straight, EW left) and in clearance states.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t first_step;
+    uint32_t steps;
+    uint8_t flags;
+    uint32_t arrivals[8];
+    uint32_t departures[8];
+    uint64_t total_wait[8];
+    uint32_t max_wait[8];
+    uint32_t queue_sum[8];
+    uint16_t queue_max[8];
+    uint32_t phase_steps[5];
+} ResponseBucket;
+
+/**
+ * @brief Accumulated wait statistics (32 bytes).
+ * 
+ * Response to CMD_GET_STATS. The sweep tool emits one per CMD_CONFIG received,
+ * in the same order. Wait times are expressed in simulation steps.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t current_step;
+    uint32_t departures;
+    uint64_t total_wait;
+    uint32_t max_wait;
+    uint32_t left_departures;
+    uint64_t left_total_wait;
+} ResponseStats;
+
+/**
+ * @brief Response to CMD_GET_LINK_STATS (16 bytes).
+ * 
+ * Counters of the framed encoding (frame_codec.h) as seen by the receiving core.
+ * All zero when the raw encoding is used.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t frames_ok;
+    uint32_t frames_dropped;
+    uint32_t frames_duplicate; // Retransmissions received
+    uint32_t seq_gaps;
+} ResponseLinkStats;
+
+/**
+ * @brief Response to CMD_GET_MEMORY (28 bytes).
+ * 
+ * The heap is the C heap on the MCU and the session arena (traffic_sessions.h) on
+ * PC. The stack is the region painted at start-up (stack_watermark.h): the free
+ * RAM between heap and stack on the MCU, the stack of the command loop on PC.
+ * 0 = not known on this target.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t ram_size; // Total RAM
+    uint32_t static_bytes; // .data + .bss
+    uint32_t system_bytes; // sizeof(TrafficSystem)
+    uint32_t heap_bytes; // In use now
+    uint32_t heap_peak; // High-water mark
+    uint32_t stack_size; // Stack region, from the low end of the paint to the top
+    uint32_t stack_peak; // Deepest stack use since start-up
+} ResponseMemory;
+
+/**
+ * @brief Wait-time percentiles of one lane or movement (16 bytes).
+ * 
+ * Values are upper bounds of the log-buckets holding the percentile (steps).
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t departures;
+    uint32_t p50;
+    uint32_t p95;
+    uint32_t p99;
+} WaitPercentiles;
+
+/**
+ * @brief Response to CMD_GET_WAIT_PERCENTILES (192 bytes).
+ * 
+ * Lanes are indexed [road * 2 + lane], movements as in traffic_movement_wait_hist()
+ * (NS straight/right, NS left, EW straight/right, EW left).
+ */
+typedef struct __attribute__((packed)) {
+    WaitPercentiles lanes[8];
+    WaitPercentiles movements[4];
+} ResponseWaitPercentiles;
+
+/**
+ * @brief Response to CMD_GET_WAIT_HISTOGRAM (8 * WAIT_HIST_BUCKETS * 4 bytes).
+ * 
+ * Raw bucket counts of every lane, indexed [road * 2 + lane][bucket].
+ * Histograms of several runs or workers are merged by adding the counts.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t counts[8][WAIT_HIST_BUCKETS];
+} ResponseWaitHistogram;
+
+#define TELEMETRY_MAGIC 0x4D4C5454 // "TTLM"
+#define TELEMETRY_FINISHED 0x01 // The simulation ended, the record is final
+
+/**
+ * @brief Telemetry sample of session 0 (2108 bytes), see traffic_telemetry.h.
+ * 
+ * Not a response: traffic_sim --telemetry keeps the latest sample in a
+ * memory-mapped file that monitors read while the simulation runs. sequence is
+ * odd while the record is being written; a reader retries until it sees the
+ * same even value before and after copying the record. Lane arrays are
+ * indexed [road * 2 + lane].
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint32_t sequence;
+    uint32_t every; // Steps between samples
+    uint32_t current_step;
+    uint32_t departures;
+    uint32_t max_wait;
+    uint64_t total_wait;
+    uint16_t queue_lengths[8];
+    uint16_t extension_steps; // Extra green steps granted in the current phase
+    uint16_t max_extension; // Limit of the current timing (max_ext)
+    uint8_t current_state;
+    uint8_t light_ns_st;
+    uint8_t light_ns_lt;
+    uint8_t light_ew_st;
+    uint8_t light_ew_lt;
+    uint8_t strategy;
+    uint8_t flags;
+    uint8_t reserved;
+    uint32_t wait_hist[8][WAIT_HIST_BUCKETS]; // As ResponseWaitHistogram
+} TelemetryRecord;
+
+/**
+ * @brief Per-configuration analytical estimate sent by the sweep tool (80 bytes).
+ * 
+ * Emitted instead of ResponseStats when the tool runs in estimate mode.
+ * Delays are expressed in steps, queue growth in vehicles per step.
+ * Lane arrays are indexed [road * 2 + lane].
+ */
+typedef struct __attribute__((packed)) {
+    float avg_delay;
+    float max_delay;
+    float left_delay;
+    float cycle_length;
+    float lane_delay[8];
+    float lane_growth[8];
+} ResponseEstimate;
+
+/**
+ * @brief Per-configuration certified wait bounds sent by the sweep tool (36 bytes).
+ * 
+ * Emitted instead of ResponseStats in bounds mode (see traffic_explore.h).
+ * Waits are in steps and hold for any arrival pattern, 0xFFFFFFFF meaning the
+ * movement can starve. Movement arrays are indexed [axis * 2 + lane].
+ * states is 0 if the configuration could not be certified.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t starvation[4]; // Vehicle arriving at an empty lane
+    uint32_t max_wait[4]; // Vehicle arriving at any queue up to its capacity
+    uint32_t states;
+} ResponseBounds;
+
 #endif
\ No newline at end of file
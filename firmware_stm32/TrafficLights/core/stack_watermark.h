@@ -0,0 +1,39 @@
+/**
+ * @file stack_watermark.h
+ * @brief Stack high-water mark by painting
+ *
+ * A stack region is filled with a known word before it is used. The deepest
+ * word that no longer holds it marks the most stack ever used, as the stack
+ * grows down from the high end. A pushed value equal to the paint word at the
+ * very bottom is missed, so the result may be a few bytes low.
+ */
+
+#ifndef STACK_WATERMARK_H
+#define STACK_WATERMARK_H
+
+#include <stdint.h>
+
+/**
+ * @def STACK_PAINT_WORD
+ * @brief Value of an unused stack word
+ */
+#define STACK_PAINT_WORD 0xC5C5C5C5u
+
+/**
+ * @brief Paint the words [low, high)
+ * 
+ * @param low Lowest word of the region
+ * @param high End of the region (the stack grows down from here)
+ */
+void stack_paint(uint32_t* low, uint32_t* high);
+
+/**
+ * @brief Most stack used in a painted region since it was painted
+ * 
+ * @param low Lowest word of the region
+ * @param high End of the region
+ * @return Bytes between high and the deepest overwritten word (0 if untouched)
+ */
+uint32_t stack_high_water(const uint32_t* low, const uint32_t* high);
+
+#endif // STACK_WATERMARK_H
@@ -75,13 +75,13 @@ static const StateTransition STATE_TRANSITIONS[] = {
 /**
  * @brief Retrieves the target duration (in steps) for a given timing index.
  */
-static inline uint32_t get_timing_value(const TrafficSystem* sys, uint8_t idx) {
+static inline uint32_t get_timing_value(const TimingConfig* timing, uint8_t idx) {
     switch(idx) {
-        case 0: { return sys->timing.green_st; }
-        case 1: { return sys->timing.green_lt; }
-        case 2: { return sys->timing.yellow; }
-        case 3: { return sys->timing.all_red; }
-        case 4: { return sys->timing.red_yellow; }
+        case 0: { return timing->green_st; }
+        case 1: { return timing->green_lt; }
+        case 2: { return timing->yellow; }
+        case 3: { return timing->all_red; }
+        case 4: { return timing->red_yellow; }
         
         default: { return 0; }
     }
@@ -111,6 +111,27 @@ static inline bool is_yellow_phase(TrafficState state) {
             state == STATE_EW_STRAIGHT_YELLOW || state == STATE_EW_LEFT_YELLOW);
 }
 
+/*
+ * Frozen build (-DTRAFFIC_FROZEN_TIMING=<TimingConfig initializer>): every function
+ * of the decision path reads its timing through FREEZE_TIMING, which replaces the
+ * passed timing by a compile-time constant, so all durations and thresholds fold
+ * into the code. The configured timing (CMD_CONFIG, updates, plans) is ignored.
+ */
+#ifdef TRAFFIC_FROZEN_TIMING
+static const TimingConfig FROZEN_TIMING = TRAFFIC_FROZEN_TIMING;
+#define FREEZE_TIMING(timing) ((timing) = &FROZEN_TIMING)
+#else
+#define FREEZE_TIMING(timing) ((void)(timing))
+#endif
+
+/**
+ * @brief Phase boundary where a new timing can take over (no light is green or yellow).
+ */
+static inline bool is_preparation_phase(TrafficState state) {
+    return (state == STATE_NS_RED_YELLOW || state == STATE_NS_LEFT_RED_YELLOW ||
+            state == STATE_EW_RED_YELLOW || state == STATE_EW_LEFT_RED_YELLOW);
+}
+
 /**
  * @brief Maps a green phase state to an array index (0-3).
  * Useful for accessing phase_skip_counters array.
@@ -187,29 +208,48 @@ static bool is_phase_empty(const TrafficSystem* sys, TrafficState state) {
 // --- CORE FSM LOGIC ---
 
 /**
- * @brief Computes the next state of the intersection based on current timers and queue loads.
+ * @brief Resolves transitions fixed by the transition table and timers.
  * 
- * @details Implements Phase Skipping logic. If a target phase is empty, it skips to the 
- * next one, unless the starvation limit (skip_limit) has been reached.
+ * @return true if next was resolved, false if the strategy has to select the next phase
+ * (end of Yellow, or waking up from All-Red)
  */
-static TrafficState get_next_state(TrafficSystem* sys) {
+static inline bool get_table_transition(const TrafficSystem* sys, const TimingConfig* timing,
+                                        TrafficState* next) {
+    FREEZE_TIMING(timing);
     if (sys->current_state >= ARRAY_SIZE(STATE_TRANSITIONS)) {
-        return STATE_ALL_RED; 
+        *next = STATE_ALL_RED;
+        return true;
     }
 
     const StateTransition* transition = &STATE_TRANSITIONS[sys->current_state];
 
     // Wait until the timer for the current state expires
-    if (sys->state_timer < get_timing_value(sys, transition->timing_idx)) {
-        return sys->current_state;
+    if (sys->state_timer < get_timing_value(timing, transition->timing_idx)) {
+        *next = sys->current_state;
+        return true;
     }
 
     // RULE 1: Static transitions (Green -> Yellow, Red/Yellow -> Green)
     if (!is_yellow_phase(sys->current_state) && sys->current_state != STATE_ALL_RED) {
-        return transition->next;
+        *next = transition->next;
+        return true;
     }
 
-    // RULE 2: Phase selection (End of Yellow, or waking up from All-Red)
+    return false;
+}
+
+/**
+ * @brief Scans the phases following the current state for one with waiting vehicles.
+ * 
+ * @details Implements Phase Skipping logic. If a target phase is empty, it skips to the 
+ * next one. With use_limit, a phase skipped skip_limit times in a row is executed anyway
+ * (starvation prevention). Starvation counters are updated in skip_counters instead of
+ * the system itself.
+ */
+static inline TrafficState scan_phases(const TrafficSystem* sys, const TimingConfig* timing,
+                                       uint8_t skip_counters[ROAD_COUNT], bool use_limit) {
+    FREEZE_TIMING(timing);
+    // RULE 2: Phase selection
     TrafficState candidate_green = get_phase_after_yellow(sys->current_state);
 
     // Scan ahead up to 4 phases to skip empty queues
@@ -223,14 +263,18 @@ static TrafficState get_next_state(TrafficSystem* sys) {
         
         // If phase has vehicles OR starvation limit is reached -> Execute this phase
         if (!is_phase_empty(sys, candidate_green) || 
-            sys->phase_skip_counters[phase_idx] >= sys->timing.skip_limit) {
+            (use_limit && skip_counters[phase_idx] >= timing->skip_limit)) {
             
-            sys->phase_skip_counters[phase_idx] = 0; // Reset starvation counter
+            if (use_limit) {
+                skip_counters[phase_idx] = 0; // Reset starvation counter
+            }
             return get_preparation_state(candidate_green);
         }
         
         // Phase is empty -> increment starvation counter and test the next one
-        sys->phase_skip_counters[phase_idx]++;
+        if (use_limit) {
+            skip_counters[phase_idx]++;
+        }
         candidate_green = get_next_green_phase(candidate_green);
     }
     
@@ -239,27 +283,194 @@ static TrafficState get_next_state(TrafficSystem* sys) {
 }
 
 /**
- * @brief Translates the state into physical light signals for all lanes.
+ * @brief Returns the longest queue among lanes that currently have green light.
  */
-static void set_lights_for_state(TrafficSystem* sys) {
-    // First set all lights to red
-    memset(sys->lights, LIGHT_RED, sizeof(sys->lights));
+static uint16_t longest_green_queue(const TrafficSystem* sys) {
+    uint16_t longest = 0;
+
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            if (sys->lights[road][lane] != LIGHT_GREEN) continue;
+
+            uint16_t count = queue_count(&sys->queues[road][lane]);
+            if (count > longest) longest = count;
+        }
+    }
+    return longest;
+}
+
+/**
+ * @brief Determines if the current green phase should be extended based on queue length
+ */
+static bool should_extend_current_phase(const TrafficSystem* sys, const TimingConfig* timing) {
+    FREEZE_TIMING(timing);
+    if (!is_green_phase(sys->current_state)) return false;
     
-    // Apply specific lights from state table
-    for (uint8_t i = 0; i < ARRAY_SIZE(STATE_LIGHTS); i++) {
-        if (sys->current_state == STATE_LIGHTS[i].state) {
-            sys->lights[STATE_LIGHTS[i].road1][STATE_LIGHTS[i].lane] = STATE_LIGHTS[i].color;
-            sys->lights[STATE_LIGHTS[i].road2][STATE_LIGHTS[i].lane] = STATE_LIGHTS[i].color;
+    // Check all lanes that currently have green light
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            if (!(sys->lights[road][lane] == LIGHT_GREEN)) {
+                continue;
+            }
+
+            if (queue_count(&sys->queues[road][lane]) >= timing->ext_threshold) {
+                return true;
+            }
+            
+        }
+    }
+
+    return false;
+}
+
+// --- STRATEGY HOOKS ---
+
+/**
+ * @brief V1: every phase runs in sequence, regardless of occupancy.
+ */
+static TrafficState select_phase_fixed(const TrafficSystem* sys, const TimingConfig* timing,
+                                       uint8_t skip_counters[ROAD_COUNT]) {
+    (void)timing;
+    (void)skip_counters;
+    return get_preparation_state(get_phase_after_yellow(sys->current_state));
+}
+
+/**
+ * @brief V2-V5: empty phases are always skipped.
+ */
+static TrafficState select_phase_skip_empty(const TrafficSystem* sys, const TimingConfig* timing,
+                                            uint8_t skip_counters[ROAD_COUNT]) {
+    return scan_phases(sys, timing, skip_counters, false);
+}
+
+/**
+ * @brief V6: empty phases are skipped at most skip_limit times in a row.
+ */
+static TrafficState select_phase_skip_limited(const TrafficSystem* sys, const TimingConfig* timing,
+                                              uint8_t skip_counters[ROAD_COUNT]) {
+    return scan_phases(sys, timing, skip_counters, true);
+}
+
+static bool extend_never(const TrafficSystem* sys, const TimingConfig* timing) {
+    (void)sys;
+    (void)timing;
+    return false;
+}
+
+/**
+ * @brief V3, V4, V6: extend while a green queue reaches ext_threshold, up to max_ext steps.
+ */
+static bool extend_on_queue(const TrafficSystem* sys, const TimingConfig* timing) {
+    FREEZE_TIMING(timing);
+    return should_extend_current_phase(sys, timing) && sys->extension_timer < timing->max_ext;
+}
+
+/**
+ * @brief V5: as extend_on_queue, but every waiting vehicle on a green lane raises the limit.
+ *
+ * @details Not the historical road-specific limits: one limit per phase, from
+ * the longest green queue. Limits computed per road from the current queues give
+ * the same result, and the per-road state of the original was not documented.
+ */
+static bool extend_on_pressure(const TrafficSystem* sys, const TimingConfig* timing) {
+    FREEZE_TIMING(timing);
+    uint32_t limit = timing->max_ext + longest_green_queue(sys);
+    return should_extend_current_phase(sys, timing) && sys->extension_timer < limit;
+}
+
+/**
+ * @brief V1-V3: lights of the transition table without permissive right arrows.
+ */
+static void state_lights_no_arrows(TrafficState state, LightColor lights[ROAD_COUNT][LANES_PER_ROAD]) {
+    traffic_state_lights(state, lights);
+
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            if (lights[road][lane] == LIGHT_RIGHT_ARROW_GREEN) {
+                lights[road][lane] = LIGHT_RED;
+            }
         }
     }
 }
 
+/**
+ * @brief Built-in strategies, indexed by TrafficStrategyId.
+ */
+static const TrafficStrategy STRATEGIES[STRATEGY_COUNT] = {
+    [STRATEGY_V1] = {"v1_fixed", select_phase_fixed, extend_never, state_lights_no_arrows},
+    [STRATEGY_V2] = {"v2_skip", select_phase_skip_empty, extend_never, state_lights_no_arrows},
+    [STRATEGY_V3] = {"v3_extend", select_phase_skip_empty, extend_on_queue, state_lights_no_arrows},
+    [STRATEGY_V4] = {"v4_arrows", select_phase_skip_empty, extend_on_queue, traffic_state_lights},
+    [STRATEGY_V5] = {"v5_adaptive", select_phase_skip_empty, extend_on_pressure, traffic_state_lights},
+    [STRATEGY_V6] = {"v6_limits", select_phase_skip_limited, extend_on_queue, traffic_state_lights},
+};
+
+/**
+ * @brief Production decision: STRATEGY_V6 hooks called directly (no indirect calls).
+ */
+static inline void decide_production(const TrafficSystem* sys, const TimingConfig* timing, TrafficDecision* out) {
+    if (!get_table_transition(sys, timing, &out->next_state)) {
+        out->next_state = select_phase_skip_limited(sys, timing, out->phase_skip_counters);
+    }
+
+    // Green Extension Logic
+    if (out->next_state != sys->current_state && is_green_phase(sys->current_state) &&
+        extend_on_queue(sys, timing)) {
+        out->extended = true;
+        out->next_state = sys->current_state; // Stay in current green phase
+    }
+}
+
+/**
+ * @brief Decision of any strategy through its hooks.
+ */
+static void decide_with_strategy(const TrafficSystem* sys, const TimingConfig* timing,
+                                 const TrafficStrategy* strategy, TrafficDecision* out) {
+    if (!get_table_transition(sys, timing, &out->next_state)) {
+        out->next_state = strategy->select_phase(sys, timing, out->phase_skip_counters);
+    }
+
+    if (out->next_state != sys->current_state && is_green_phase(sys->current_state) &&
+        strategy->should_extend(sys, timing)) {
+        out->extended = true;
+        out->next_state = sys->current_state;
+    }
+}
+
+/**
+ * @brief Translates the state into physical light signals for all lanes.
+ */
+static void set_lights_for_state(TrafficSystem* sys) {
+    if (sys->strategy == STRATEGY_V6) {
+        traffic_state_lights(sys->current_state, sys->lights);
+    } else {
+        STRATEGIES[sys->strategy].state_lights(sys->current_state, sys->lights);
+    }
+}
+
+/**
+ * @brief Adds a single departure to the accumulated statistics.
+ */
+static inline void record_departure(TrafficStats* stats, uint8_t lane, uint32_t wait_time) {
+    stats->departures++;
+    stats->total_wait += wait_time;
+    if (wait_time > stats->max_wait) {
+        stats->max_wait = wait_time;
+    }
+    if (lane == LANE_LEFT) {
+        stats->left_departures++;
+        stats->left_total_wait += wait_time;
+    }
+}
+
 /**
  * @brief Iterates through all queues and dequeues vehicles that have a green light
  * 
- * @details Implements logic for permissive right turns
+ * @details Implements logic for permissive right turns. The departing IDs are copied
+ * to out_ids, or passed to the sink of traffic_run() if out_ids is NULL.
  */
-static uint8_t process_discharges(TrafficSystem* sys, char out_ids[][VEHICLE_ID_LEN]) {
+static inline uint8_t process_discharges(TrafficSystem* sys, char out_ids[][VEHICLE_ID_LEN],
+                                         const TrafficRunSink* sink) {
     uint8_t discharged = 0;
     
     for (uint8_t road = 0; road < ROAD_COUNT; road++) {
@@ -284,8 +495,16 @@ static uint8_t process_discharges(TrafficSystem* sys, char out_ids[][VEHICLE_ID_
                 }
                 
                 // Dequeue the vehicle and record its ID
-                uint32_t wait_time;
-                queue_dequeue(q, out_ids[discharged++], sys->current_step, &wait_time);
+                const Vehicle* v = &q->vehicles[q->head];
+                uint32_t wait_time = 0;
+                queue_dequeue(q, out_ids ? out_ids[discharged] : NULL, sys->current_step, &wait_time);
+                record_departure(&sys->stats, lane, wait_time);
+                discharged++;
+
+                // The slot is only reused by the next enqueue
+                if (sink) {
+                    sink->departure(sink->ctx, v, sys->current_step, wait_time);
+                }
             }
         }
     }
@@ -293,29 +512,6 @@ static uint8_t process_discharges(TrafficSystem* sys, char out_ids[][VEHICLE_ID_
     return discharged;
 }
 
-/**
- * @brief Determines if the current green phase should be extended based on queue length
- */
-static bool should_extend_current_phase(const TrafficSystem* sys) {
-    if (!is_green_phase(sys->current_state)) return false;
-    
-    // Check all lanes that currently have green light
-    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
-        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
-            if (!(sys->lights[road][lane] == LIGHT_GREEN)) {
-                continue;
-            }
-
-            if (queue_count(&sys->queues[road][lane]) >= sys->timing.ext_threshold) {
-                return true;
-            }
-            
-        }
-    }
-
-    return false;
-}
-
 // --- PUBLIC API IMPLEMENTATION ---
 
 void traffic_init(TrafficSystem* sys, TimingConfig config) {
@@ -330,11 +526,59 @@ void traffic_init(TrafficSystem* sys, TimingConfig config) {
         }
     }
     
+    sys->current_state = STATE_ALL_RED;
+    sys->state_timer = 0;
+    sys->strategy = DEFAULT_STRATEGY;
+    set_lights_for_state(sys);
+}
+
+void traffic_restart_cycle(TrafficSystem* sys) {
+    if (!sys) return;
+
     sys->current_state = STATE_ALL_RED;
     sys->state_timer = 0;
     set_lights_for_state(sys);
 }
 
+bool traffic_set_strategy(TrafficSystem* sys, TrafficStrategyId strategy) {
+    if (!sys || strategy >= STRATEGY_COUNT) {
+        return false;
+    }
+
+    sys->strategy = (uint8_t)strategy;
+    set_lights_for_state(sys);
+    return true;
+}
+
+const TrafficStrategy* traffic_get_strategy(TrafficStrategyId strategy) {
+    return (strategy < STRATEGY_COUNT) ? &STRATEGIES[strategy] : NULL;
+}
+
+void traffic_update_timing(TrafficSystem* sys, const TimingConfig* timing) {
+    if (!sys || !timing) return;
+
+    if (sys->current_state == STATE_ALL_RED) {
+        sys->timing = *timing;
+        sys->timing_pending = false;
+        return;
+    }
+
+    sys->pending_timing = *timing;
+    sys->timing_pending = true;
+}
+
+bool traffic_add_timing_plan(TrafficSystem* sys, const TimingPlan* plan) {
+    if (!sys || !plan || sys->plan_count >= TIMING_PLAN_MAX) {
+        return false;
+    }
+    if (sys->plan_count > 0 && plan->start_step <= sys->plans[sys->plan_count - 1].start_step) {
+        return false;
+    }
+
+    sys->plans[sys->plan_count++] = *plan;
+    return true;
+}
+
 bool traffic_add_vehicle(TrafficSystem* sys, const char* id, Direction start, Direction end, uint32_t arrival_time) {
     if (!sys || start == end || 
         start >= ROAD_COUNT || end >= ROAD_COUNT) {
@@ -345,31 +589,158 @@ bool traffic_add_vehicle(TrafficSystem* sys, const char* id, Direction start, Di
     return queue_enqueue(&sys->queues[start][lane], id, start, end, arrival_time);
 }
 
+uint32_t traffic_add_vehicles(TrafficSystem* sys, const Vehicle* vehicles, uint32_t n) {
+    if (!sys || !vehicles) return 0;
+
+    uint32_t added = 0;
+    uint32_t i = 0;
+    while (i < n) {
+        const Vehicle* v = &vehicles[i];
+        if (v->start_road == v->end_road || v->start_road >= ROAD_COUNT || v->end_road >= ROAD_COUNT) {
+            i++;
+            continue;
+        }
+
+        // Longest run of valid vehicles for the same lane
+        uint8_t lane = get_lane_for_turn(v->start_road, v->end_road);
+        uint32_t run = 1;
+        while (i + run < n && run < MAX_VEHICLES_PER_ROAD) {
+            const Vehicle* next = &vehicles[i + run];
+            if (next->start_road != v->start_road || next->end_road == next->start_road ||
+                next->end_road >= ROAD_COUNT || get_lane_for_turn(next->start_road, next->end_road) != lane) {
+                break;
+            }
+            run++;
+        }
+
+        added += queue_enqueue_n(&sys->queues[v->start_road][lane], v, (uint16_t)run);
+        i += run;
+    }
+    return added;
+}
+
 uint8_t traffic_fsm_step(TrafficSystem* sys, char out_ids[][VEHICLE_ID_LEN]) {
     if (!sys || !out_ids) return 0;
     
+    traffic_fsm_advance_clock(sys);
+
+    TrafficDecision decision;
+    traffic_fsm_decide(sys, &sys->timing, &decision);
+    return traffic_fsm_apply(sys, &decision, out_ids);
+}
+
+void traffic_fsm_advance_clock(TrafficSystem* sys) {
+    if (!sys) return;
+
     sys->current_step++;
     sys->state_timer++;
-    
-    TrafficState next_state = get_next_state(sys);
-    
-    // Green Extension Logic
-    if (next_state != sys->current_state && is_green_phase(sys->current_state)) {
-        if (should_extend_current_phase(sys) && sys->extension_timer < sys->timing.max_ext) {
-            sys->extension_timer++;
-            next_state = sys->current_state; // Stay in current green phase
-        }
+
+    // The latest plan that has started wins
+    while (sys->next_plan < sys->plan_count &&
+           sys->plans[sys->next_plan].start_step <= sys->current_step) {
+        traffic_update_timing(sys, &sys->plans[sys->next_plan].timing);
+        sys->next_plan++;
+    }
+}
+
+
+void traffic_fsm_decide(const TrafficSystem* sys, const TimingConfig* timing, TrafficDecision* out) {
+    if (!sys || !timing || !out) return;
+
+    memcpy(out->phase_skip_counters, sys->phase_skip_counters, sizeof(out->phase_skip_counters));
+    out->extended = false;
+
+    // Compile-time specialized fast path for the production strategy
+    if (sys->strategy == STRATEGY_V6) {
+        decide_production(sys, timing, out);
+    } else {
+        decide_with_strategy(sys, timing, &STRATEGIES[sys->strategy], out);
+    }
+}
+
+/**
+ * @brief Shared body of traffic_fsm_apply() and traffic_run().
+ */
+static inline uint8_t apply_decision(TrafficSystem* sys, const TrafficDecision* decision,
+                                     char out_ids[][VEHICLE_ID_LEN], const TrafficRunSink* sink) {
+    memcpy(sys->phase_skip_counters, decision->phase_skip_counters, sizeof(sys->phase_skip_counters));
+
+    if (decision->extended) {
+        sys->extension_timer++;
     }
     
     // Perform state transition if needed
-    if (next_state != sys->current_state) {
-        sys->current_state = next_state;
+    if (decision->next_state != sys->current_state) {
+        sys->current_state = decision->next_state;
         sys->state_timer = 0;
         sys->extension_timer = 0;
+
+        if (sys->timing_pending && is_preparation_phase(sys->current_state)) {
+            sys->timing = sys->pending_timing;
+            sys->timing_pending = false;
+        }
     }
     
     set_lights_for_state(sys);
-    return process_discharges(sys, out_ids);
+    return process_discharges(sys, out_ids, sink);
+}
+
+uint8_t traffic_fsm_apply(TrafficSystem* sys, const TrafficDecision* decision, char out_ids[][VEHICLE_ID_LEN]) {
+    if (!sys || !decision || !out_ids) return 0;
+
+    return apply_decision(sys, decision, out_ids, NULL);
+}
+
+uint32_t traffic_run(TrafficSystem* sys, const TrafficArrival* arrivals, uint32_t n_arrivals, uint32_t n_steps,
+                     const TrafficRunSink* sink) {
+    if (!sys || (!arrivals && n_arrivals > 0) || (sink && !sink->departure)) return 0;
+
+    uint32_t next = 0;
+    for (uint32_t step = 0; step < n_steps; step++) {
+        while (next < n_arrivals && arrivals[next].step <= sys->current_step) {
+            const TrafficArrival* a = &arrivals[next++];
+            traffic_add_vehicle(sys, a->id, (Direction)a->start_road, (Direction)a->end_road, a->step);
+        }
+
+        traffic_fsm_advance_clock(sys);
+
+        TrafficDecision decision;
+        traffic_fsm_decide(sys, &sys->timing, &decision);
+        apply_decision(sys, &decision, NULL, sink);
+    }
+    return next;
+}
+
+bool traffic_decision_equal(const TrafficDecision* a, const TrafficDecision* b) {
+    return a->next_state == b->next_state && a->extended == b->extended &&
+           memcmp(a->phase_skip_counters, b->phase_skip_counters, sizeof(a->phase_skip_counters)) == 0;
+}
+
+void traffic_state_lights(TrafficState state, LightColor lights[ROAD_COUNT][LANES_PER_ROAD]) {
+    // First set all lights to red
+    memset(lights, LIGHT_RED, sizeof(LightColor) * ROAD_COUNT * LANES_PER_ROAD);
+    
+    // Apply specific lights from state table
+    for (uint8_t i = 0; i < ARRAY_SIZE(STATE_LIGHTS); i++) {
+        if (state == STATE_LIGHTS[i].state) {
+            lights[STATE_LIGHTS[i].road1][STATE_LIGHTS[i].lane] = STATE_LIGHTS[i].color;
+            lights[STATE_LIGHTS[i].road2][STATE_LIGHTS[i].lane] = STATE_LIGHTS[i].color;
+        }
+    }
+}
+
+uint32_t traffic_state_duration(const TimingConfig* timing, TrafficState state) {
+    if (!timing || state >= ARRAY_SIZE(STATE_TRANSITIONS)) {
+        return 0;
+    }
+    return get_timing_value(timing, STATE_TRANSITIONS[state].timing_idx);
+}
+
+TrafficState traffic_state_successor(TrafficState state) {
+    if (state >= ARRAY_SIZE(STATE_TRANSITIONS)) {
+        return STATE_ALL_RED;
+    }
+    return STATE_TRANSITIONS[state].next;
 }
 
 uint16_t traffic_get_queue_size(const TrafficSystem* sys, Direction road, uint8_t lane) {
@@ -377,4 +748,16 @@ uint16_t traffic_get_queue_size(const TrafficSystem* sys, Direction road, uint8_
         return 0;
     }
     return queue_count(&sys->queues[road][lane]);
+}
+
+void traffic_movement_wait_hist(const TrafficSystem* sys, uint8_t movement, WaitHistogram* out) {
+    if (!out) return;
+    wait_hist_init(out);
+    if (!sys || movement >= MOVEMENT_COUNT) return;
+
+    uint8_t axis = movement / LANES_PER_ROAD; // 0 = NORTH/SOUTH, 1 = EAST/WEST
+    uint8_t lane = movement % LANES_PER_ROAD;
+
+    wait_hist_merge(out, queue_get_wait_hist(&sys->queues[axis][lane]));
+    wait_hist_merge(out, queue_get_wait_hist(&sys->queues[axis + 2][lane]));
 }
\ No newline at end of file
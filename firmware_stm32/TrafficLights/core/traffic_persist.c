@@ -0,0 +1,279 @@
+/**
+ * @file traffic_persist.c
+ * @brief Implementation of the flash record log.
+ */
+
+#include <string.h>
+#include "traffic_persist.h"
+#include "traffic_snapshot.h"
+#include "frame_codec.h"
+
+// --- INTERNAL DATA STRUCTURES ---
+
+#define PERSIST_MAGIC 0x5254 // "TR"
+
+/**
+ * @brief Record header, followed by len data bytes and 0xFF padding
+ * up to PERSIST_WRITE_ALIGN. The CRC covers the header fields before it and the data.
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint8_t kind;
+    uint8_t version;
+    uint32_t seq;
+    uint16_t len;
+    uint16_t crc;
+} PersistHeader;
+
+#define HEADER_SIZE sizeof(PersistHeader)
+#define CRC_SPAN offsetof(PersistHeader, crc)
+#define RECORD_SIZE(len) \
+    ((HEADER_SIZE + (len) + PERSIST_WRITE_ALIGN - 1) & ~(size_t)(PERSIST_WRITE_ALIGN - 1))
+#define CONFIG_RECORD_SIZE RECORD_SIZE(sizeof(TimingConfig))
+
+// --- HELPER FUNCTIONS ---
+
+static uint32_t record_size(uint32_t len) {
+    return (uint32_t)RECORD_SIZE(len);
+}
+
+static uint16_t record_crc(const PersistHeader* header, const uint8_t* data) {
+    uint16_t crc = frame_crc16(0xFFFF, (const uint8_t*)header, CRC_SPAN);
+    return frame_crc16(crc, data, header->len);
+}
+
+static bool is_erased(const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] != 0xFF) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Takes note of a valid record found while mounting.
+ */
+static void index_record(PersistStore* store, const PersistHeader* header, uint32_t data_offset) {
+    const uint8_t* data = store->flash->base + data_offset;
+
+    if (header->kind == PERSIST_RECORD_CONFIG && header->len == sizeof(TimingConfig)) {
+        if (!store->has_config || header->seq > store->config_seq) {
+            store->has_config = true;
+            store->config_seq = header->seq;
+            store->config_page = (uint16_t)(data_offset / store->flash->page_size);
+            memcpy(&store->config, data, sizeof(TimingConfig));
+        }
+    } else if (header->kind == PERSIST_RECORD_CHECKPOINT) {
+        if (!store->has_checkpoint || header->seq > store->checkpoint_seq) {
+            store->has_checkpoint = true;
+            store->checkpoint_seq = header->seq;
+            store->checkpoint_offset = data_offset;
+            store->checkpoint_len = header->len;
+        }
+    }
+}
+
+/**
+ * @brief Scans one page, returns the end of its valid records.
+ *
+ * @details A page ending in anything but erased flash (torn write, foreign data)
+ * reports page_size, so nothing is ever appended after damaged bytes.
+ */
+static uint32_t scan_page(PersistStore* store, uint16_t page, bool* newest_here) {
+    const PersistFlash* flash = store->flash;
+    uint32_t page_start = (uint32_t)page * flash->page_size;
+    uint32_t offset = 0;
+
+    *newest_here = false;
+
+    while (offset + HEADER_SIZE <= flash->page_size) {
+        const uint8_t* raw = flash->base + page_start + offset;
+        PersistHeader header;
+        memcpy(&header, raw, HEADER_SIZE);
+
+        if (is_erased(raw, HEADER_SIZE)) {
+            return offset;
+        }
+
+        bool valid = header.magic == PERSIST_MAGIC && header.version == PERSIST_VERSION &&
+                     record_size(header.len) <= flash->page_size - offset &&
+                     record_crc(&header, raw + HEADER_SIZE) == header.crc;
+        if (!valid) {
+            return flash->page_size;
+        }
+
+        index_record(store, &header, page_start + offset + HEADER_SIZE);
+        if (header.seq >= store->seq) {
+            store->seq = header.seq;
+            *newest_here = true;
+        }
+        offset += record_size(header.len);
+    }
+    return offset;
+}
+
+/**
+ * @brief Programs a record prepared in buf (data after the header space) at the
+ * write position of the active page.
+ */
+static bool program_record(PersistStore* store, uint8_t* buf, PersistRecordKind kind, uint32_t len, uint32_t seq) {
+    const PersistFlash* flash = store->flash;
+    uint32_t size = record_size(len);
+
+    PersistHeader header = {
+        .magic = PERSIST_MAGIC,
+        .kind = (uint8_t)kind,
+        .version = PERSIST_VERSION,
+        .seq = seq,
+        .len = (uint16_t)len
+    };
+    header.crc = record_crc(&header, buf + HEADER_SIZE);
+    memcpy(buf, &header, HEADER_SIZE);
+    memset(buf + HEADER_SIZE + len, 0xFF, size - HEADER_SIZE - len);
+
+    uint32_t offset = (uint32_t)store->page * flash->page_size + store->write_offset;
+    store->write_offset += size; // Even a failed write leaves the bytes unusable
+    if (!flash->program(flash->ctx, offset, buf, size)) {
+        return false;
+    }
+
+    if (seq > store->seq) {
+        store->seq = seq;
+    }
+    if (kind == PERSIST_RECORD_CONFIG) {
+        store->has_config = true;
+        store->config_seq = seq;
+        store->config_page = store->page;
+        memcpy(&store->config, buf + HEADER_SIZE, sizeof(TimingConfig));
+    } else {
+        store->has_checkpoint = true;
+        store->checkpoint_seq = seq;
+        store->checkpoint_offset = offset + HEADER_SIZE;
+        store->checkpoint_len = len;
+    }
+    return true;
+}
+
+/**
+ * @brief Copies the configuration into the active page.
+ *
+ * @details The copy keeps the sequence number of the original, so it never makes
+ * a newer checkpoint stale.
+ */
+static bool carry_config(PersistStore* store) {
+    uint8_t config_buf[CONFIG_RECORD_SIZE];
+    memcpy(config_buf + HEADER_SIZE, &store->config, sizeof(TimingConfig));
+    return program_record(store, config_buf, PERSIST_RECORD_CONFIG, sizeof(TimingConfig), store->config_seq);
+}
+
+/**
+ * @brief Appends a record prepared in buf (data after the header space).
+ *
+ * @details Moves to the next page when the active one is full. A page that does not
+ * hold the configuration keeps room for it at its end: the configuration is copied
+ * there before the next page is erased, so a reset during the erase never loses it.
+ */
+static bool append_record(PersistStore* store, uint8_t* buf, PersistRecordKind kind, uint32_t len) {
+    const PersistFlash* flash = store->flash;
+    uint32_t size = record_size(len);
+    bool carry = store->has_config && store->config_page != store->page;
+    uint32_t reserve = carry ? CONFIG_RECORD_SIZE : 0;
+
+    if (store->write_offset + size + reserve > flash->page_size) {
+        bool carried = !carry;
+        if (carry && store->write_offset + CONFIG_RECORD_SIZE <= flash->page_size) {
+            carried = carry_config(store);
+        }
+
+        uint16_t next = (uint16_t)((store->page + 1) % flash->page_count);
+        if (!flash->erase(flash->ctx, next)) {
+            return false;
+        }
+
+        uint32_t page_start = (uint32_t)next * flash->page_size;
+        if (store->has_checkpoint && store->checkpoint_offset >= page_start &&
+            store->checkpoint_offset < page_start + flash->page_size) {
+            store->has_checkpoint = false;
+        }
+
+        store->page = next;
+        store->write_offset = 0;
+
+        // No room left in the old page (damaged records found while mounting)
+        if (!carried && !carry_config(store)) {
+            return false;
+        }
+    }
+
+    return program_record(store, buf, kind, len, store->seq + 1);
+}
+
+// --- PUBLIC API ---
+
+bool persist_mount(PersistStore* store, const PersistFlash* flash) {
+    if (!store || !flash || !flash->base || !flash->erase || !flash->program ||
+        flash->page_count < 2 || flash->page_size < 2 * CONFIG_RECORD_SIZE ||
+        flash->page_size % PERSIST_WRITE_ALIGN != 0) {
+        return false;
+    }
+
+    memset(store, 0, offsetof(PersistStore, record));
+    store->flash = flash;
+
+    // Empty region: the first write erases page 0
+    store->page = (uint16_t)(flash->page_count - 1);
+    store->write_offset = flash->page_size;
+
+    for (uint16_t page = 0; page < flash->page_count; page++) {
+        bool newest_here;
+        uint32_t end = scan_page(store, page, &newest_here);
+        if (newest_here) {
+            store->page = page;
+            store->write_offset = end;
+        }
+    }
+    return true;
+}
+
+bool persist_save_config(PersistStore* store, const TimingConfig* config) {
+    if (!store || !store->flash || !config) return false;
+
+    memcpy(store->record + HEADER_SIZE, config, sizeof(TimingConfig));
+    return append_record(store, store->record, PERSIST_RECORD_CONFIG, sizeof(TimingConfig));
+}
+
+bool persist_save_checkpoint(PersistStore* store, const TrafficSystem* sys) {
+    if (!store || !store->flash || !sys) return false;
+
+    // Must fit a page next to the carried-over configuration
+    uint32_t capacity = store->flash->page_size - CONFIG_RECORD_SIZE;
+    if (capacity > sizeof(store->record)) {
+        capacity = sizeof(store->record);
+    }
+    capacity = (capacity & ~(uint32_t)(PERSIST_WRITE_ALIGN - 1)) - HEADER_SIZE;
+    if (capacity > UINT16_MAX) {
+        capacity = UINT16_MAX;
+    }
+
+    size_t len = traffic_snapshot_save(sys, store->record + HEADER_SIZE, capacity);
+    if (len == 0) {
+        return false;
+    }
+    return append_record(store, store->record, PERSIST_RECORD_CHECKPOINT, (uint32_t)len);
+}
+
+PersistRestored persist_restore(const PersistStore* store, TrafficSystem* sys) {
+    if (!store || !store->flash || !sys) return PERSIST_RESTORED_NONE;
+
+    if (store->has_checkpoint && (!store->has_config || store->checkpoint_seq > store->config_seq)) {
+        const uint8_t* snapshot = store->flash->base + store->checkpoint_offset;
+        if (traffic_snapshot_load(sys, snapshot, store->checkpoint_len)) {
+            return PERSIST_RESTORED_CHECKPOINT;
+        }
+    }
+
+    if (store->has_config) {
+        traffic_init(sys, store->config);
+        return PERSIST_RESTORED_CONFIG;
+    }
+    return PERSIST_RESTORED_NONE;
+}
@@ -0,0 +1,316 @@
+/**
+ * @file traffic_snapshot.c
+ * @brief Implementation of the compact TrafficSystem serialization.
+ */
+
+#include <string.h>
+#include "traffic_snapshot.h"
+
+// --- INTERNAL DATA STRUCTURES ---
+
+typedef struct {
+    uint8_t* buf;
+    size_t capacity;
+    size_t pos;
+    bool overflow;
+} SnapshotWriter;
+
+typedef struct {
+    const uint8_t* buf;
+    size_t len;
+    size_t pos;
+    bool underflow;
+} SnapshotReader;
+
+// --- HELPER FUNCTIONS ---
+
+static void put_bytes(SnapshotWriter* w, const void* data, size_t n) {
+    if (w->overflow || w->pos + n > w->capacity) {
+        w->overflow = true;
+        return;
+    }
+    if (w->buf) {
+        memcpy(w->buf + w->pos, data, n);
+    }
+    w->pos += n;
+}
+
+static void get_bytes(SnapshotReader* r, void* data, size_t n) {
+    if (r->underflow || r->pos + n > r->len) {
+        r->underflow = true;
+        return;
+    }
+    memcpy(data, r->buf + r->pos, n);
+    r->pos += n;
+}
+
+#define PUT(w, value) put_bytes((w), &(value), sizeof(value))
+#define GET(r, value) get_bytes((r), &(value), sizeof(value))
+
+/**
+ * @brief Length of a vehicle ID (bounded by the fixed-size buffer).
+ */
+static uint8_t id_length(const char* id) {
+    uint8_t len = 0;
+    while (len < VEHICLE_ID_LEN - 1 && id[len] != '\0') {
+        len++;
+    }
+    return len;
+}
+
+/**
+ * @brief Whether a restored vehicle belongs to the queue of `road` and `lane`.
+ *
+ * The FSM indexes per-road and per-lane arrays with these values, so a
+ * corrupt road or a turn that does not match the lane must be rejected.
+ */
+static bool vehicle_fits_queue(const Vehicle* v, uint8_t road, uint8_t lane) {
+    if (v->start_road != road || v->end_road >= ROAD_COUNT || v->end_road == v->start_road) {
+        return false;
+    }
+    bool left = (v->end_road - v->start_road + ROAD_COUNT) % ROAD_COUNT == 1;
+    return lane == (left ? LANE_LEFT : LANE_STRAIGHT_RIGHT);
+}
+
+/**
+ * @brief Writes the non-empty buckets of a histogram (count, then index/value pairs).
+ */
+static void write_histogram(SnapshotWriter* w, const WaitHistogram* h) {
+    uint8_t used = 0;
+    for (uint8_t i = 0; i < WAIT_HIST_BUCKETS; i++) {
+        if (h->counts[i]) used++;
+    }
+
+    PUT(w, used);
+    for (uint8_t i = 0; i < WAIT_HIST_BUCKETS; i++) {
+        if (h->counts[i]) {
+            PUT(w, i);
+            PUT(w, h->counts[i]);
+        }
+    }
+}
+
+/**
+ * @brief Reads a histogram written by write_histogram() (out may be NULL).
+ */
+static bool read_histogram(SnapshotReader* r, WaitHistogram* out) {
+    uint8_t used = 0;
+    GET(r, used);
+    if (r->underflow || used > WAIT_HIST_BUCKETS) {
+        return false;
+    }
+
+    for (uint8_t n = 0; n < used; n++) {
+        uint8_t bucket = 0;
+        uint32_t value = 0;
+
+        GET(r, bucket);
+        GET(r, value);
+        if (r->underflow || bucket >= WAIT_HIST_BUCKETS) {
+            return false;
+        }
+        if (out) {
+            out->counts[bucket] = value;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Writes the whole snapshot (or only measures it when w->buf is NULL).
+ */
+static void write_snapshot(SnapshotWriter* w, const TrafficSystem* sys) {
+    uint8_t version = SNAPSHOT_VERSION;
+    uint8_t state = (uint8_t)sys->current_state;
+
+    PUT(w, version);
+    PUT(w, sys->timing);
+    PUT(w, state);
+    PUT(w, sys->current_step);
+    PUT(w, sys->state_timer);
+    PUT(w, sys->extension_timer);
+    PUT(w, sys->phase_skip_counters);
+    PUT(w, sys->stats);
+    PUT(w, sys->strategy);
+
+    uint8_t pending = sys->timing_pending ? 1 : 0;
+    PUT(w, pending);
+    if (pending) {
+        PUT(w, sys->pending_timing);
+    }
+    PUT(w, sys->plan_count);
+    PUT(w, sys->next_plan);
+    put_bytes(w, sys->plans, sys->plan_count * sizeof(TimingPlan));
+
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            const VehicleQueue* q = &sys->queues[road][lane];
+            uint16_t count = queue_count(q);
+
+            PUT(w, q->max_wait_time);
+            write_histogram(w, &q->wait_hist);
+            PUT(w, count);
+
+            for (uint16_t i = 0; i < count; i++) {
+                const Vehicle* v = queue_vehicle_at(q, i);
+                uint8_t id_len = id_length(v->id);
+
+                PUT(w, id_len);
+                put_bytes(w, v->id, id_len);
+                PUT(w, v->start_road);
+                PUT(w, v->end_road);
+                PUT(w, v->arrival_step);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Parses a snapshot into sys, or only validates it when sys is NULL.
+ */
+static bool read_snapshot(SnapshotReader* r, TrafficSystem* sys) {
+    uint8_t version = 0;
+    uint8_t state = 0;
+    TimingConfig timing;
+    uint32_t current_step, state_timer, extension_timer;
+    uint8_t skip_counters[ROAD_COUNT];
+    TrafficStats stats;
+    uint8_t strategy = 0;
+    uint8_t pending = 0, plan_count = 0, next_plan = 0;
+    TimingConfig pending_timing;
+    TimingPlan plans[TIMING_PLAN_MAX];
+
+    GET(r, version);
+    if (r->underflow || version != SNAPSHOT_VERSION) {
+        return false;
+    }
+
+    GET(r, timing);
+    GET(r, state);
+    GET(r, current_step);
+    GET(r, state_timer);
+    GET(r, extension_timer);
+    GET(r, skip_counters);
+    GET(r, stats);
+    GET(r, strategy);
+
+    GET(r, pending);
+    if (pending) {
+        GET(r, pending_timing);
+    }
+    GET(r, plan_count);
+    GET(r, next_plan);
+    if (r->underflow || pending > 1 || plan_count > TIMING_PLAN_MAX || next_plan > plan_count) {
+        return false;
+    }
+    get_bytes(r, plans, plan_count * sizeof(TimingPlan));
+
+    if (r->underflow || state > STATE_EW_LEFT_YELLOW || strategy >= STRATEGY_COUNT) {
+        return false;
+    }
+
+    if (sys) {
+        traffic_init(sys, timing);
+        sys->current_state = (TrafficState)state;
+        sys->current_step = current_step;
+        sys->state_timer = state_timer;
+        sys->extension_timer = extension_timer;
+        memcpy(sys->phase_skip_counters, skip_counters, sizeof(skip_counters));
+        sys->stats = stats;
+
+        sys->timing_pending = pending;
+        if (pending) {
+            sys->pending_timing = pending_timing;
+        }
+        memcpy(sys->plans, plans, plan_count * sizeof(TimingPlan));
+        sys->plan_count = plan_count;
+        sys->next_plan = next_plan;
+    }
+
+    for (uint8_t road = 0; road < ROAD_COUNT; road++) {
+        for (uint8_t lane = 0; lane < LANES_PER_ROAD; lane++) {
+            uint32_t max_wait_time = 0;
+            uint16_t count = 0;
+
+            GET(r, max_wait_time);
+            if (!read_histogram(r, sys ? &sys->queues[road][lane].wait_hist : NULL)) {
+                return false;
+            }
+            GET(r, count);
+            if (r->underflow || count > MAX_VEHICLES_PER_ROAD) {
+                return false;
+            }
+
+            for (uint16_t i = 0; i < count; i++) {
+                Vehicle v;
+                uint8_t id_len = 0;
+
+                GET(r, id_len);
+                if (r->underflow || id_len >= VEHICLE_ID_LEN) {
+                    return false;
+                }
+                memset(v.id, 0, VEHICLE_ID_LEN);
+                get_bytes(r, v.id, id_len);
+                GET(r, v.start_road);
+                GET(r, v.end_road);
+                GET(r, v.arrival_step);
+                if (r->underflow || !vehicle_fits_queue(&v, road, lane)) {
+                    return false;
+                }
+
+                if (sys) {
+                    sys->queues[road][lane].vehicles[i] = v;
+                }
+            }
+
+            if (sys) {
+                VehicleQueue* q = &sys->queues[road][lane];
+                q->max_wait_time = max_wait_time;
+                q->head = 0;
+                q->tail = QUEUE_RING_WRAP(count);
+                q->count = count;
+                q->peak_count = count; // Not serialized, the restored queue is the lower bound
+            }
+        }
+    }
+
+    if (r->underflow || r->pos != r->len) {
+        return false;
+    }
+
+    if (sys) {
+        traffic_set_strategy(sys, (TrafficStrategyId)strategy); // Also restores the lights
+    }
+    return true;
+}
+
+// --- PUBLIC API IMPLEMENTATION ---
+
+size_t traffic_snapshot_size(const TrafficSystem* sys) {
+    if (!sys) return 0;
+
+    SnapshotWriter w = {NULL, SIZE_MAX, 0, false};
+    write_snapshot(&w, sys);
+    return w.pos;
+}
+
+size_t traffic_snapshot_save(const TrafficSystem* sys, uint8_t* buf, size_t capacity) {
+    if (!sys || !buf) return 0;
+
+    SnapshotWriter w = {buf, capacity, 0, false};
+    write_snapshot(&w, sys);
+    return w.overflow ? 0 : w.pos;
+}
+
+bool traffic_snapshot_load(TrafficSystem* sys, const uint8_t* buf, size_t len) {
+    if (!sys || !buf) return false;
+
+    // Validate first so a malformed snapshot leaves sys untouched
+    SnapshotReader r = {buf, len, 0, false};
+    if (!read_snapshot(&r, NULL)) {
+        return false;
+    }
+
+    r.pos = 0;
+    return read_snapshot(&r, sys);
+}
@@ -0,0 +1,81 @@
+/**
+ * @file traffic_stream.h
+ * @brief Delta-encoded stream of the queue contents of a system (CMD_SUBSCRIBE_STATE).
+ * @details A subscriber first receives a keyframe with every queued vehicle, then,
+ * every `every` steps, only what changed: per lane the number of vehicles that
+ * left the head and the vehicles appended at the tail, plus the lights if they
+ * changed. An idle intersection costs an 8-byte header per update. The wire
+ * layout is StateUpdateHeader in protocol.h.
+ *
+ * The stream observes the system around each step, so neither the FSM nor the
+ * queues are modified. Updates are written through a callback (stdout on the PC,
+ * the UART on the STM32) without buffering a whole keyframe.
+ */
+
+#ifndef TRAFFIC_STREAM_H
+#define TRAFFIC_STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "traffic_fsm.h"
+
+#define STREAM_LANES (ROAD_COUNT * LANES_PER_ROAD)
+
+/**
+ * @brief Output of the encoded updates.
+ */
+typedef void (*StateStreamWrite)(void* ctx, const void* data, size_t len);
+
+/**
+ * @brief Subscription to one system.
+ */
+typedef struct {
+    uint16_t session_id;
+    uint16_t every; // Steps between updates
+    uint16_t countdown; // Steps until the next update (0 = due)
+    bool keyframe; // Next update restarts from empty queues
+
+    uint16_t sent_counts[STREAM_LANES]; // Queue lengths known to the subscriber
+    uint16_t departed[STREAM_LANES]; // Vehicles that left each lane since the last update
+    uint16_t before[STREAM_LANES]; // Queue lengths before the current step
+    uint8_t sent_lights[5]; // State and lights known to the subscriber (StateLights)
+} StateStream;
+
+/**
+ * @brief Starts a subscription; the first update sent is a keyframe.
+ *
+ * @param s Pointer to StateStream
+ * @param session_id Session reported in the updates
+ * @param every Steps between updates (at least 1)
+ */
+void state_stream_init(StateStream* s, uint16_t session_id, uint16_t every);
+
+/**
+ * @brief Makes the next update a keyframe (after the system was reset or replaced).
+ */
+void state_stream_resync(StateStream* s);
+
+/**
+ * @brief Records the queue lengths before traffic_fsm_step().
+ */
+void state_stream_before_step(StateStream* s, const TrafficSystem* sys);
+
+/**
+ * @brief Accounts for the step just executed.
+ *
+ * @return true if an update is due (send it with state_stream_send())
+ */
+bool state_stream_after_step(StateStream* s, const TrafficSystem* sys);
+
+/**
+ * @brief Encodes an update (a keyframe if one is pending) and restarts the countdown.
+ *
+ * @param s Pointer to StateStream
+ * @param sys Subscribed system
+ * @param write Output callback
+ * @param ctx Passed to the callback
+ */
+void state_stream_send(StateStream* s, const TrafficSystem* sys, StateStreamWrite write, void* ctx);
+
+#endif // TRAFFIC_STREAM_H
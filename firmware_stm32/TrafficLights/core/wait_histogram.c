@@ -0,0 +1,93 @@
+/**
+ * @file wait_histogram.c
+ * @brief Log-bucketed histogram of vehicle wait times
+ */
+
+#include <string.h>
+#include "wait_histogram.h"
+
+/**
+ * @brief Index of the highest set bit (value must be non-zero)
+ */
+static inline uint8_t highest_bit(uint32_t value) {
+#if defined(__GNUC__)
+    return (uint8_t)(31 - __builtin_clz(value));
+#else
+    uint8_t bit = 0;
+    while (value >>= 1) {
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+void wait_hist_init(WaitHistogram* h) {
+    if (!h) return;
+    memset(h, 0, sizeof(WaitHistogram));
+}
+
+uint8_t wait_hist_bucket(uint32_t wait) {
+    if (wait < WAIT_HIST_LINEAR_LIMIT) {
+        return (uint8_t)wait;
+    }
+
+    uint8_t exponent = highest_bit(wait);
+    uint32_t sub = (wait >> (exponent - WAIT_HIST_SUB_BITS)) & (WAIT_HIST_SUB_BUCKETS - 1);
+    uint32_t bucket = WAIT_HIST_LINEAR_LIMIT +
+                      (uint32_t)(exponent - (WAIT_HIST_SUB_BITS + 1)) * WAIT_HIST_SUB_BUCKETS + sub;
+
+    return (uint8_t)(bucket < WAIT_HIST_BUCKETS ? bucket : WAIT_HIST_BUCKETS - 1);
+}
+
+uint32_t wait_hist_bucket_min(uint8_t bucket) {
+    if (bucket < WAIT_HIST_LINEAR_LIMIT) {
+        return bucket;
+    }
+
+    uint32_t octave = (bucket - WAIT_HIST_LINEAR_LIMIT) / WAIT_HIST_SUB_BUCKETS;
+    uint32_t sub = (bucket - WAIT_HIST_LINEAR_LIMIT) % WAIT_HIST_SUB_BUCKETS;
+    uint8_t exponent = (uint8_t)(octave + WAIT_HIST_SUB_BITS + 1);
+
+    return (1u << exponent) + (sub << (exponent - WAIT_HIST_SUB_BITS));
+}
+
+uint32_t wait_hist_bucket_max(uint8_t bucket) {
+    if (bucket >= WAIT_HIST_BUCKETS - 1) {
+        return UINT32_MAX;
+    }
+    return wait_hist_bucket_min(bucket + 1) - 1;
+}
+
+void wait_hist_merge(WaitHistogram* dst, const WaitHistogram* src) {
+    if (!dst || !src) return;
+
+    for (uint8_t i = 0; i < WAIT_HIST_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+}
+
+uint32_t wait_hist_total(const WaitHistogram* h) {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < WAIT_HIST_BUCKETS; i++) {
+        total += h->counts[i];
+    }
+    return total;
+}
+
+uint32_t wait_hist_percentile(const WaitHistogram* h, uint16_t permille) {
+    uint32_t total = wait_hist_total(h);
+    if (total == 0) return 0;
+
+    // Rank of the percentile sample (1-based, rounded up)
+    uint64_t rank = ((uint64_t)total * permille + 999) / 1000;
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (uint8_t i = 0; i < WAIT_HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            return wait_hist_bucket_max(i);
+        }
+    }
+    return wait_hist_bucket_max(WAIT_HIST_BUCKETS - 1);
+}
@@ -0,0 +1,133 @@
+"""
+Generates the V1-V6 version comparison tables in the README.
+
+Every controller strategy of the C core is run against all nine scenario
+profiles (same seed, same timing) in parallel worker processes. The script
+prints the AWT table for the normal scenarios and the MAX table for the jam
+scenarios, and can store the raw metrics as JSON for regression checks.
+
+Usage:
+    python3 benchmark_versions.py [--json results.json] [--jobs N]
+                                  [--timing ST,LT,YELLOW,ALL_RED,EXT_T,MAX_EXT,SKIP_L]
+"""
+import json
+import os
+import sys
+import time
+from multiprocessing import Pool
+from typing import Dict, List
+
+from optimize_timings import (SCENARIOS, JAM_SCENARIOS, STRATEGIES, SEED, C_BINARY_PATH,
+                              TimingParams, create_command_list, run_single_simulation)
+
+ALL_SCENARIOS = SCENARIOS + JAM_SCENARIOS
+BASELINE = "v1"
+
+# Optimal configuration from the README (DEFAULT_TIMING in traffic_fsm.h)
+DEFAULT_PARAMS = TimingParams(green_st=4, green_lt=3, yellow=2, all_red=3,
+                              ext_threshold=1, max_ext=15, skip_limit=2)
+
+
+def run_job(job) -> dict:
+    """Worker: one strategy on one scenario (scenarios are passed by index, their lambdas do not pickle)."""
+    strategy, scenario_idx, params = job
+    scenario = ALL_SCENARIOS[scenario_idx]
+
+    metrics = run_single_simulation(create_command_list(scenario, seed=SEED), params, strategy)
+    return {'strategy': strategy, 'scenario': scenario.name, **metrics.__dict__}
+
+
+def run_benchmark(params: TimingParams = DEFAULT_PARAMS, jobs: int = None) -> Dict[str, Dict[str, dict]]:
+    """Runs all strategies x scenarios, returns {strategy: {scenario: metrics}}."""
+    work = [(strategy, idx, params) for strategy in STRATEGIES for idx in range(len(ALL_SCENARIOS))]
+
+    with Pool(processes=jobs) as pool:
+        rows = pool.map(run_job, work)
+
+    results = {strategy: {} for strategy in STRATEGIES}
+    for row in rows:
+        results[row.pop('strategy')][row.pop('scenario')] = row
+    return results
+
+
+def mean_metric(results: Dict[str, dict], scenarios: list, key: str) -> float:
+    values = [results[s.name][key] for s in scenarios]
+    return sum(values) / len(values) if values else 0.0
+
+
+def summarize(results: Dict[str, Dict[str, dict]]) -> Dict[str, dict]:
+    """Mean AWT over normal scenarios and mean MAX over jam scenarios, with improvement vs V1."""
+    base_awt = mean_metric(results[BASELINE], SCENARIOS, 'avg_wait')
+    base_max = mean_metric(results[BASELINE], JAM_SCENARIOS, 'max_wait')
+
+    summary = {}
+    for strategy, per_scenario in results.items():
+        awt = mean_metric(per_scenario, SCENARIOS, 'avg_wait')
+        max_wait = mean_metric(per_scenario, JAM_SCENARIOS, 'max_wait')
+        summary[strategy] = {
+            'normal_awt': awt,
+            'normal_awt_improvement': (1 - awt / base_awt) * 100 if base_awt > 0 else 0.0,
+            'jam_max': max_wait,
+            'jam_max_improvement': (1 - max_wait / base_max) * 100 if base_max > 0 else 0.0,
+        }
+    return summary
+
+
+def print_tables(results: Dict[str, Dict[str, dict]], summary: Dict[str, dict]) -> None:
+    for title, scenarios, key, label in (("Normal traffic scenarios", SCENARIOS, 'avg_wait', 'AWT'),
+                                         ("Jam traffic scenarios", JAM_SCENARIOS, 'max_wait', 'MAX')):
+        print(f"\n**{title}** ({label} per scenario)\n")
+        print("| Version | " + " | ".join(s.name for s in scenarios) + f" | Mean | Improvement ({label}) vs V1 |")
+        print("| ------- | " + " | ".join("---" for _ in scenarios) + " | ---- | --- |")
+
+        mean_key, imp_key = ('normal_awt', 'normal_awt_improvement') if key == 'avg_wait' \
+            else ('jam_max', 'jam_max_improvement')
+        for strategy, per_scenario in results.items():
+            cells = " | ".join(f"{per_scenario[s.name][key]:.1f}" for s in scenarios)
+            print(f"| {strategy.upper()} | {cells} | {summary[strategy][mean_key]:.1f} "
+                  f"| {summary[strategy][imp_key]:+.0f}% |")
+
+
+def parse_timing(text: str) -> TimingParams:
+    values = [int(v) for v in text.split(',')]
+    if len(values) != 7:
+        raise ValueError("expected 7 comma separated values")
+    return TimingParams(*values)
+
+
+if __name__ == "__main__":
+    args = sys.argv[1:]
+    options = {'--json': None, '--jobs': None, '--timing': None}
+    for name in options:
+        if name in args:
+            idx = args.index(name)
+            if idx + 1 >= len(args):
+                print(__doc__)
+                sys.exit(1)
+            options[name] = args[idx + 1]
+            del args[idx:idx + 2]
+
+    if args:
+        print(__doc__)
+        sys.exit(1)
+
+    if not os.path.exists(C_BINARY_PATH):
+        print(f"Binary not found: {C_BINARY_PATH} (run make in core/)")
+        sys.exit(1)
+
+    params = parse_timing(options['--timing']) if options['--timing'] else DEFAULT_PARAMS
+    jobs = int(options['--jobs']) if options['--jobs'] else None
+
+    start = time.perf_counter()
+    results = run_benchmark(params, jobs)
+    summary = summarize(results)
+    elapsed = time.perf_counter() - start
+
+    print_tables(results, summary)
+    print(f"\n{len(STRATEGIES) * len(ALL_SCENARIOS)} simulations in {elapsed:.2f}s")
+
+    if options['--json']:
+        with open(options['--json'], 'w') as f:
+            json.dump({'seed': SEED, 'timing': params.to_dict(),
+                       'results': results, 'summary': summary}, f, indent=2)
+        print(f"Raw metrics saved to {options['--json']}")
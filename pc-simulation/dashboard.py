@@ -0,0 +1,173 @@
+"""
+Live terminal dashboard of a running traffic_sim.
+
+Attaches to the telemetry file of `traffic_sim --telemetry FILE` (a memory-mapped
+TelemetryRecord, see core/traffic_telemetry.h) and redraws the per-approach queue
+depths, the current phase and lights, extension usage, wait percentiles and the
+simulation speed at a fixed rate. The core publishes a sample every N steps
+(--telemetry-every) and never waits for the dashboard, so observing a run costs
+it well under one percent (`make bench`, bench_telemetry).
+
+Usage: python dashboard.py FILE [--rate HZ] [--once] [--follow]
+
+--rate sets the refresh rate (default 4 Hz), --once prints a single frame
+(e.g. for logs), --follow keeps watching after the simulation finished, e.g.
+for the next run writing to the same file.
+"""
+import mmap
+import os
+import struct
+import sys
+import time
+from typing import Any, Dict, Optional
+
+from run_simulation import WAIT_HIST_BUCKETS, LANE_COUNT, histogram_percentile, merge_histograms
+
+# Shares protocol.h structure (TelemetryRecord, packed, Little-Endian)
+TELEMETRY_MAGIC = 0x4D4C5454
+TELEMETRY_FINISHED = 0x01
+TELEMETRY_FORMAT = f'<IIIIIIQ{LANE_COUNT}HHHBBBBBBBB{LANE_COUNT * WAIT_HIST_BUCKETS}I'
+TELEMETRY_SIZE = struct.calcsize(TELEMETRY_FORMAT)
+SEQUENCE_OFFSET = 4
+
+STATE_NAMES = [
+    "ALL RED",
+    "NS red-yellow", "NS straight", "NS straight yellow",
+    "NS left red-yellow", "NS left", "NS left yellow",
+    "EW red-yellow", "EW straight", "EW straight yellow",
+    "EW left red-yellow", "EW left", "EW left yellow",
+]
+LIGHT_NAMES = ["red", "yellow", "GREEN", "red-yellow", "arrow"]
+STRATEGY_NAMES = ["v1", "v2", "v3", "v4", "v5", "v6"]
+ROADS = ["north", "east", "south", "west"]
+QUEUE_CAPACITY = 50  # MAX_VEHICLES_PER_ROAD
+BAR_WIDTH = 25
+
+
+def decode_sample(data: bytes) -> Dict[str, Any]:
+    fields = struct.unpack(TELEMETRY_FORMAT, data)
+    hist = fields[24:]
+    return {
+        "magic": fields[0],
+        "sequence": fields[1],
+        "every": fields[2],
+        "step": fields[3],
+        "departures": fields[4],
+        "max_wait": fields[5],
+        "total_wait": fields[6],
+        "queues": list(fields[7:15]),
+        "extension": fields[15],
+        "max_extension": fields[16],
+        "state": fields[17],
+        "lights": fields[18:22],
+        "strategy": fields[22],
+        "flags": fields[23],
+        "wait_hist": [list(hist[i * WAIT_HIST_BUCKETS:(i + 1) * WAIT_HIST_BUCKETS]) for i in range(LANE_COUNT)],
+    }
+
+
+def read_sample(view: mmap.mmap, attempts: int = 100) -> Optional[Dict[str, Any]]:
+    """Copies a complete sample (same even sequence before and after the copy)."""
+    for _ in range(attempts):
+        before = struct.unpack_from('<I', view, SEQUENCE_OFFSET)[0]
+        if before % 2 == 0:
+            data = view[:TELEMETRY_SIZE]
+            after = struct.unpack_from('<I', view, SEQUENCE_OFFSET)[0]
+            if before == after:
+                sample = decode_sample(data)
+                return sample if sample["magic"] == TELEMETRY_MAGIC else None
+        time.sleep(0)
+    return None
+
+
+def attach(path: str) -> mmap.mmap:
+    """Maps the telemetry file, waiting until traffic_sim has created it."""
+    while True:
+        try:
+            with open(path, 'rb') as f:
+                if os.fstat(f.fileno()).st_size >= TELEMETRY_SIZE:
+                    return mmap.mmap(f.fileno(), TELEMETRY_SIZE, access=mmap.ACCESS_READ)
+        except FileNotFoundError:
+            pass
+        time.sleep(0.2)
+
+
+def bar(value: int, capacity: int) -> str:
+    filled = min(BAR_WIDTH, (value * BAR_WIDTH + capacity - 1) // capacity)
+    return '#' * filled + '.' * (BAR_WIDTH - filled)
+
+
+def percentiles(hist) -> str:
+    return "/".join(str(histogram_percentile(hist, f)) for f in (0.5, 0.95, 0.99))
+
+
+def render(sample: Dict[str, Any], steps_per_second: float) -> str:
+    state = STATE_NAMES[sample["state"]] if sample["state"] < len(STATE_NAMES) else str(sample["state"])
+    strategy = STRATEGY_NAMES[sample["strategy"]] if sample["strategy"] < len(STRATEGY_NAMES) else "?"
+    lights = [LIGHT_NAMES[c] if c < len(LIGHT_NAMES) else "?" for c in sample["lights"]]
+    if sample["flags"] & TELEMETRY_FINISHED:
+        status = "finished"
+    else:
+        status = f"{steps_per_second:,.0f} steps/s" if steps_per_second else "measuring speed"
+    mean_wait = sample["total_wait"] / sample["departures"] if sample["departures"] else 0.0
+
+    lines = [
+        f"traffic_sim  step {sample['step']:,}  ({status}, sample every {sample['every']} steps)",
+        f"phase  {state:<20} strategy {strategy}",
+        f"lights NS {lights[0]}/{lights[1]} (left)   EW {lights[2]}/{lights[3]} (left)",
+        f"extension {sample['extension']}/{sample['max_extension']} steps",
+        "",
+        f"{'approach':<8} {'straight':>8} {'':<{BAR_WIDTH}} {'left':>4} {'':<{BAR_WIDTH}}  P50/P95/P99",
+    ]
+    for road, name in enumerate(ROADS):
+        straight, left = sample["queues"][road * 2], sample["queues"][road * 2 + 1]
+        hist = merge_histograms(sample["wait_hist"][road * 2:road * 2 + 2])
+        lines.append(f"{name:<8} {straight:>8} {bar(straight, QUEUE_CAPACITY)} {left:>4} "
+                     f"{bar(left, QUEUE_CAPACITY)}  {percentiles(hist)}")
+    lines += [
+        "",
+        f"departures {sample['departures']:,}  mean wait {mean_wait:.2f}  max {sample['max_wait']}  "
+        f"P50/P95/P99 {percentiles(merge_histograms(sample['wait_hist']))} steps",
+    ]
+    return "\n".join(lines)
+
+
+def run(path: str, rate: float, once: bool, follow: bool) -> None:
+    view = attach(path)
+    interval = 1.0 / rate
+    last_step, last_time, speed = None, None, 0.0
+
+    while True:
+        sample = read_sample(view)
+        now = time.monotonic()
+        if sample is None:
+            time.sleep(interval)
+            continue
+
+        if last_step is not None and sample["step"] >= last_step and now > last_time:
+            current = (sample["step"] - last_step) / (now - last_time)
+            speed = current if speed == 0.0 else 0.7 * speed + 0.3 * current
+        last_step, last_time = sample["step"], now
+
+        frame = render(sample, speed)
+        if once:
+            print(frame)
+            return
+        sys.stdout.write("\x1b[H\x1b[2J" + frame + "\n")
+        sys.stdout.flush()
+
+        if sample["flags"] & TELEMETRY_FINISHED and not follow:
+            return
+        time.sleep(interval)
+
+
+if __name__ == "__main__":
+    args = sys.argv[1:]
+    if not args or args[0].startswith('--'):
+        print(__doc__)
+        sys.exit(1)
+    rate = float(args[args.index('--rate') + 1]) if '--rate' in args else 4.0
+    try:
+        run(args[0], rate, '--once' in args, '--follow' in args)
+    except KeyboardInterrupt:
+        pass
@@ -0,0 +1,236 @@
+"""
+Framed transport for `traffic_sim --framed` (see core/lib/frame_codec.h).
+
+Raw protocol messages are packed into frames
+
+    COBS(seq | flags | messages | crc16) 0x00
+
+so a corrupted or lost byte damages only one frame. The core answers every
+frame with one frame carrying the same seq, a NAK frame for a damaged one, and
+the cached response for a retransmitted one, so FramedLink can retransmit
+until each frame is executed exactly once.
+
+Usage (demo/benchmark on a simulated noisy link):
+    python3 framing.py [--noise BYTE_ERROR_RATE] [--frame-size BYTES] [--scenario NAME]
+
+Smaller frames survive noisier links: a frame gets through with probability
+(1 - noise) ** size, so e.g. 256-byte frames suit byte error rates around 1e-3.
+"""
+import binascii
+import os
+import random
+import select
+import struct
+import subprocess
+import sys
+import time
+from typing import List, Optional, Tuple
+
+FRAME_MAX_PAYLOAD = 2304  # Must match frame_codec.h
+FRAME_FLAG_NAK = 0x01
+
+CMD_STEP_SESSIONS = 12
+
+# Size of each fixed-size message (header included), see protocol.h
+MESSAGE_SIZES = {
+    0: 29, 1: 39, 2: 1, 3: 1, 4: 1, 5: 1, 6: 2, 7: 29, 8: 33,
+    9: 31, 10: 3, 11: 3, 13: 1, 14: 1, 15: 6, 16: 5, 17: 1, 99: 1,
+}
+
+
+def crc16(data: bytes, crc: int = 0xFFFF) -> int:
+    """CRC-16/CCITT-FALSE, same as frame_crc16() (binascii implements it in C)."""
+    return binascii.crc_hqx(data, crc)
+
+
+def cobs_encode(data: bytes) -> bytes:
+    out = bytearray()
+    for block in data.split(b'\x00'):
+        # Blocks longer than 254 bytes are split without an implied zero
+        while len(block) >= 254:
+            out.append(255)
+            out += block[:254]
+            block = block[254:]
+        out.append(len(block) + 1)
+        out += block
+    return bytes(out)
+
+
+def cobs_decode(data: bytes) -> Optional[bytes]:
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        code = data[pos]
+        if code == 0 or pos + code > len(data):
+            return None
+        out += data[pos + 1:pos + code]
+        pos += code
+        if code != 255 and pos < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def encode_frame(seq: int, flags: int, payload: bytes) -> bytes:
+    body = bytes((seq & 0xFF, flags)) + payload
+    return cobs_encode(body + struct.pack('<H', crc16(body))) + b'\x00'
+
+
+def decode_frame(raw: bytes) -> Optional[Tuple[int, int, bytes]]:
+    """(seq, flags, payload) of an encoded frame without delimiter, None if damaged."""
+    body = cobs_decode(raw)
+    if body is None or len(body) < 4:
+        return None
+    if crc16(body[:-2]) != struct.unpack('<H', body[-2:])[0]:
+        return None
+    return body[0], body[1], body[2:-2]
+
+
+def split_messages(stream: bytes, max_payload: int = FRAME_MAX_PAYLOAD) -> List[bytes]:
+    """Groups a raw command stream into frame payloads without cutting a message."""
+    chunks = []
+    start = pos = 0
+
+    while pos < len(stream):
+        cmd = stream[pos]
+        if cmd == CMD_STEP_SESSIONS:
+            size = 3 + 2 * struct.unpack_from('<H', stream, pos + 1)[0]
+        else:
+            size = MESSAGE_SIZES.get(cmd, 1)
+
+        if pos + size - start > max_payload and pos > start:
+            chunks.append(stream[start:pos])
+            start = pos
+        pos += size
+
+    if pos > start:
+        chunks.append(stream[start:pos])
+    return chunks
+
+
+class FramedLink:
+    """
+    Host side of the framed protocol over a traffic_sim --framed process.
+
+    `noise` simulates a bad link: every byte in both directions is replaced by a
+    random value with this probability.
+    """
+
+    def __init__(self, binary: str, timeout: float = 0.05, noise: float = 0.0, seed: int = 1,
+                 max_payload: int = FRAME_MAX_PAYLOAD):
+        self.proc = subprocess.Popen([binary, '--framed'], stdin=subprocess.PIPE,
+                                     stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
+        self.timeout = timeout
+        self.max_payload = max_payload
+        self.noise = noise
+        self.rng = random.Random(seed)
+        self.seq = 0
+        self.rx = bytearray()
+
+        self.frames_sent = 0
+        self.retransmits = 0
+        self.responses_dropped = 0
+        self.timeouts = 0
+
+    def _corrupt(self, data: bytes) -> bytes:
+        if self.noise <= 0:
+            return data
+        out = bytearray(data)
+        for i in range(len(out)):
+            if self.rng.random() < self.noise:
+                out[i] = self.rng.randrange(256)
+        return bytes(out)
+
+    def _read_frame(self) -> Optional[bytes]:
+        """Next encoded frame (delimiter stripped), None on timeout."""
+        fd = self.proc.stdout.fileno()
+        while True:
+            end = self.rx.find(b'\x00')
+            if end >= 0:
+                raw = bytes(self.rx[:end])
+                del self.rx[:end + 1]
+                if raw:
+                    return raw
+                continue
+
+            ready, _, _ = select.select([fd], [], [], self.timeout)
+            if not ready:
+                return None
+            chunk = os.read(fd, 65536)
+            if not chunk:
+                raise RuntimeError("traffic_sim closed the link")
+            self.rx += self._corrupt(chunk)
+
+    def transact(self, messages: bytes) -> bytes:
+        """Sends one frame of messages and returns the concatenated responses."""
+        seq = self.seq
+        frame = encode_frame(seq, 0, messages)
+        self.frames_sent += 1
+
+        while True:
+            self.proc.stdin.write(self._corrupt(frame))
+            self.proc.stdin.flush()
+
+            while True:
+                raw = self._read_frame()
+                if raw is None:
+                    self.timeouts += 1
+                    break
+
+                decoded = decode_frame(raw)
+                if decoded is None:
+                    self.responses_dropped += 1
+                    break
+
+                r_seq, r_flags, payload = decoded
+                if r_flags & FRAME_FLAG_NAK:
+                    break
+                if r_seq == seq:
+                    self.seq = (seq + 1) & 0xFF
+                    return payload
+                # Stale answer to an earlier retransmission - ignore
+
+            self.retransmits += 1
+
+    def run_stream(self, stream: bytes) -> bytes:
+        """Sends a raw command stream in frames, returns the raw response stream."""
+        return b''.join(self.transact(chunk) for chunk in split_messages(stream, self.max_payload))
+
+    def close(self) -> None:
+        self.proc.stdin.close()
+        self.proc.wait(timeout=5)
+
+
+if __name__ == "__main__":
+    from optimize_timings import (SCENARIOS, JAM_SCENARIOS, SEED, C_BINARY_PATH, TimingParams,
+                                  create_command_list, encode_scenario)
+
+    args = sys.argv[1:]
+    noise = float(args[args.index('--noise') + 1]) if '--noise' in args else 0.0
+    name = args[args.index('--scenario') + 1] if '--scenario' in args else 'extreme_rush'
+    frame_size = int(args[args.index('--frame-size') + 1]) if '--frame-size' in args else FRAME_MAX_PAYLOAD
+    scenario = next(s for s in SCENARIOS + JAM_SCENARIOS if s.name == name)
+
+    params = TimingParams(4, 3, ext_threshold=1, max_ext=15)
+    config = struct.pack('<BIIIIIII', 0, params.green_st, params.green_lt, params.yellow,
+                         params.all_red, params.ext_threshold, params.max_ext, params.skip_limit)
+    stream = config + encode_scenario(create_command_list(scenario, seed=SEED))
+
+    start = time.perf_counter()
+    raw = subprocess.run([C_BINARY_PATH], input=stream + b'\x63', capture_output=True).stdout
+    raw_time = time.perf_counter() - start
+
+    start = time.perf_counter()
+    link = FramedLink(C_BINARY_PATH, noise=noise, max_payload=frame_size)
+    framed = link.run_stream(stream)
+    link_stats = struct.unpack('<4I', link.transact(bytes([13])))
+    link.close()
+    framed_time = time.perf_counter() - start
+
+    print(f"Scenario {name}: {len(stream)} command bytes, {link.frames_sent} frames, noise {noise}")
+    print(f"  raw:    {raw_time * 1000:7.1f} ms")
+    print(f"  framed: {framed_time * 1000:7.1f} ms")
+    print(f"  responses identical: {framed == raw}")
+    print(f"  host:   {link.retransmits} retransmits, {link.responses_dropped} damaged responses, "
+          f"{link.timeouts} timeouts")
+    print(f"  core:   {link_stats[0]} ok, {link_stats[1]} dropped, {link_stats[2]} retransmitted, "
+          f"{link_stats[3]} seq gaps")
@@ -2,7 +2,7 @@ import json
 import random
 import itertools
 from dataclasses import dataclass
-from typing import Callable, List, Optional, Tuple
+from typing import Callable, Dict, List, Optional, Tuple
 import subprocess
 import os
 import struct
@@ -13,6 +13,7 @@ SEED = 42
 SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
 CORE_DIR = os.path.dirname(SCRIPT_DIR)
 C_BINARY_PATH = os.path.join(CORE_DIR, 'core', 'bin', 'traffic_sim')
+C_SWEEP_PATH = os.path.join(CORE_DIR, 'core', 'bin', 'traffic_sweep')
 
 # Grid Search Ranges
 # Note: To keep demonstration runtime reasonable, EXT_T, MAX_EXT and SKIP_L 
@@ -23,6 +24,22 @@ EXT_THRESHOLD_RANGE = [1]
 MAX_EXT_RANGE = [15]
 SKIP_LIMIT_RANGE = [2]
 
+# Controller strategies of the C core (TrafficStrategyId), see README "Optimization results"
+STRATEGIES = {"v1": 0, "v2": 1, "v3": 2, "v4": 3, "v5": 4, "v6": 5}
+DEFAULT_STRATEGY = "v6"
+
+# Analytical pre-screen: fraction of the grid (ranked by estimated cost)
+# that is actually simulated. 1.0 disables pre-screening.
+PRESCREEN_KEEP = 1.0
+# The cut is only applied on scenarios where the estimator's Spearman rank
+# correlation with the simulator, checked on every PRESCREEN_SAMPLE_STRIDE-th
+# candidate, reaches PRESCREEN_MIN_RHO. Other scenarios keep every candidate.
+PRESCREEN_MIN_RHO = 0.7
+PRESCREEN_SAMPLE_STRIDE = 4
+
+# Unix socket of a running sweep_daemon.py (--daemon), None runs sweeps locally
+SWEEP_DAEMON_SOCKET = None
+
 
 # ============ DATA STRUCTURES ============
 @dataclass
@@ -141,89 +158,261 @@ def create_command_list(scenario: Scenario, seed=None):
 
 # ============ SIMULATION ENGINE ============
 
-def run_single_simulation(scenario_data: dict, params: TimingParams) -> ScenarioMetrics:
+def encode_strategy(strategy: str) -> bytes:
+    """CMD_SET_STRATEGY for a strategy name (sent after CMD_CONFIG, which resets it)."""
+    return struct.pack('<BB', 6, STRATEGIES[strategy])
+
+
+def run_single_simulation(scenario_data: dict, params: TimingParams,
+                          strategy: str = DEFAULT_STRATEGY) -> ScenarioMetrics:
+    """
+    Runs one scenario as a single batch: the whole command stream is sent at once
+    and the step responses are decoded and reduced with numpy (see step_decoder).
+    """
+    from step_decoder import decode_step_responses, index_scenario, wait_metrics
+
     if not os.path.exists(C_BINARY_PATH):
         raise FileNotFoundError(f"Binary not found: {C_BINARY_PATH}")
 
-    proc = subprocess.Popen(
-        [C_BINARY_PATH],
-        stdin=subprocess.PIPE,
-        stdout=subprocess.PIPE,
-        stderr=subprocess.PIPE
-    )
+    config = struct.pack('<BIIIIIII', 0,  # CMD_CONFIG
+                         params.green_st, params.green_lt, params.yellow, params.all_red,
+                         params.ext_threshold, params.max_ext, params.skip_limit)
+    stream = config + encode_strategy(strategy) + encode_scenario(scenario_data) + struct.pack('<B', 99)  # CMD_STOP
+
+    result = subprocess.run([C_BINARY_PATH], input=stream, capture_output=True, timeout=60)
+
+    responses = decode_step_responses(result.stdout)
+    metrics = wait_metrics(responses, index_scenario(scenario_data))
+
+    return ScenarioMetrics(**metrics)
 
-    # Send config
-    header = struct.pack('<B', 0)  # CMD_CONFIG
-    payload = struct.pack('<IIIIIII',
-                        params.green_st,
-                        params.green_lt,
-                        params.yellow,
-                        params.all_red,
-                        params.ext_threshold,
-                        params.max_ext,
-                        params.skip_limit)
-    proc.stdin.write(header + payload)
-    proc.stdin.flush()
-
-    # Run simulation
-    arrival_times = {}
-    wait_times = []
-    left_wait_times = []
+def encode_scenario(scenario_data: dict) -> bytes:
+    """Encodes a command list into the binary stream understood by the C core."""
+    chunks = []
     current_step = 0
 
     for cmd in scenario_data["commands"]:
         if cmd["type"] == "addVehicle":
-            v_id = cmd["vehicleId"]
-            arrival_times[v_id] = current_step
             start_id = ROADS.index(cmd["startRoad"])
             end_id = ROADS.index(cmd["endRoad"])
-
-            header = struct.pack('<B', 1)  # CMD_ADD_VEHICLE
-            v_id_bytes = v_id.encode('utf-8')
-            payload = struct.pack('<32sBBI', v_id_bytes, start_id, end_id, current_step)
-            proc.stdin.write(header + payload)
-            proc.stdin.flush()
-
+            chunks.append(struct.pack('<B32sBBI', 1, cmd["vehicleId"].encode('utf-8'),
+                                      start_id, end_id, current_step))
         elif cmd["type"] == "step":
             current_step += 1
-            proc.stdin.write(struct.pack('<B', 2))  # CMD_STEP
-            proc.stdin.flush()
-
-            header_data = proc.stdout.read(11)
-            if len(header_data) < 11:
-                break
-
-            _, _, _, _, _, _, v_count = \
-                struct.unpack('<IBBBBBH', header_data)
-
-            if v_count > 0:
-                raw_ids = proc.stdout.read(v_count * 32)
-                for i in range(v_count):
-                    v_id = raw_ids[i*32:(i+1)*32].decode('utf-8').strip('\x00')
-                    if v_id in arrival_times:
-                        wait = current_step - arrival_times[v_id]
-                        wait_times.append(wait)
-
-                        # Check if it's left turn
-                        cmd_data = next((c for c in scenario_data["commands"]
-                                       if c.get("vehicleId") == v_id), None)
-                        if cmd_data:
-                            start = cmd_data["startRoad"]
-                            end = cmd_data["endRoad"]
-                            if get_left_turn_target(start) == end:
-                                left_wait_times.append(wait)
-
-    # Cleanup
-    proc.stdin.write(struct.pack('<B', 99))  # CMD_STOP
-    proc.stdin.flush()
-    proc.wait(timeout=1)
-
-    return ScenarioMetrics(
-        avg_wait=sum(wait_times) / len(wait_times) if wait_times else 0,
-        max_wait=max(wait_times) if wait_times else 0,
-        throughput=len(wait_times),
-        left_wait=sum(left_wait_times) / len(left_wait_times) if left_wait_times else 0
+            chunks.append(struct.pack('<B', 2))
+
+    return b''.join(chunks)
+
+
+def run_sweep(scenario_data: dict, params_list: List[TimingParams],
+              strategy: str = DEFAULT_STRATEGY) -> List[ScenarioMetrics]:
+    """
+    Evaluates many timing configurations on one scenario in a single C process.
+    Configurations share the simulated trajectory until their decisions differ,
+    results are identical to calling run_single_simulation for each of them.
+
+    With SWEEP_DAEMON_SOCKET set (--daemon), the sweep is submitted to the shared
+    sweep daemon instead (see sweep_daemon.py).
+    """
+    if SWEEP_DAEMON_SOCKET:
+        from sweep_daemon import submit_sweep
+        return submit_sweep(SWEEP_DAEMON_SOCKET, {'scenario': scenario_data}, params_list, strategy)['scenario']
+
+    return sweep_stream(encode_scenario(scenario_data), params_list, strategy)
+
+
+def sweep_stream(scenario_stream: bytes, params_list: List[TimingParams],
+                 strategy: str = DEFAULT_STRATEGY) -> List[ScenarioMetrics]:
+    """run_sweep on an already encoded scenario (encode_scenario)."""
+    if not os.path.exists(C_SWEEP_PATH):
+        raise FileNotFoundError(f"Binary not found: {C_SWEEP_PATH}")
+
+    configs = b''.join(
+        struct.pack('<BIIIIIII', 0,  # CMD_CONFIG
+                    p.green_st, p.green_lt, p.yellow, p.all_red,
+                    p.ext_threshold, p.max_ext, p.skip_limit)
+        for p in params_list
+    )
+    stream = configs + encode_strategy(strategy) + scenario_stream + struct.pack('<B', 99)  # CMD_STOP
+
+    result = subprocess.run([C_SWEEP_PATH], input=stream, capture_output=True, check=True)
+
+    RESULT_SIZE = 32
+    metrics = []
+    for i in range(len(params_list)):
+        _, departures, total_wait, max_wait, left_departures, left_total_wait = \
+            struct.unpack_from('<IIQIIQ', result.stdout, i * RESULT_SIZE)
+
+        metrics.append(ScenarioMetrics(
+            avg_wait=total_wait / departures if departures else 0,
+            max_wait=max_wait,
+            throughput=departures,
+            left_wait=left_total_wait / left_departures if left_departures else 0
+        ))
+
+    return metrics
+
+
+def estimate_candidates(scenario_data: dict, params_list: List[TimingParams]) -> List[ScenarioMetrics]:
+    """
+    Predicts AWT, MAX and LEFT of every configuration with the analytical
+    estimator of the C core (no simulation, microseconds per candidate).
+    """
+    if not os.path.exists(C_SWEEP_PATH):
+        raise FileNotFoundError(f"Binary not found: {C_SWEEP_PATH}")
+
+    configs = b''.join(
+        struct.pack('<BIIIIIII', 0,  # CMD_CONFIG
+                    p.green_st, p.green_lt, p.yellow, p.all_red,
+                    p.ext_threshold, p.max_ext, p.skip_limit)
+        for p in params_list
+    )
+    stream = configs + encode_scenario(scenario_data) + struct.pack('<B', 99)  # CMD_STOP
+
+    result = subprocess.run([C_SWEEP_PATH, '--estimate'], input=stream, capture_output=True, check=True)
+
+    RESULT_SIZE = 80
+    estimates = []
+    for i in range(len(params_list)):
+        avg_delay, max_delay, left_delay, _ = struct.unpack_from('<ffff', result.stdout, i * RESULT_SIZE)
+        estimates.append(ScenarioMetrics(
+            avg_wait=avg_delay,
+            max_wait=max_delay,
+            throughput=0,
+            left_wait=left_delay
+        ))
+
+    return estimates
+
+
+def certify_bounds(params_list: List[TimingParams], strategy: str = DEFAULT_STRATEGY) -> List[Optional[dict]]:
+    """
+    Worst-case waits that hold for ANY traffic, from an exhaustive exploration of the
+    controller state space (traffic_sweep --bounds, see core/traffic_explore.h).
+    Per configuration: {'starvation': [...], 'max_wait': [...]} indexed by movement
+    (NS straight, NS left, EW straight, EW left), None if it cannot be certified.
+    """
+    if not os.path.exists(C_SWEEP_PATH):
+        raise FileNotFoundError(f"Binary not found: {C_SWEEP_PATH}")
+
+    configs = b''.join(
+        struct.pack('<BIIIIIII', 0,  # CMD_CONFIG
+                    p.green_st, p.green_lt, p.yellow, p.all_red,
+                    p.ext_threshold, p.max_ext, p.skip_limit)
+        for p in params_list
     )
+    stream = configs + encode_strategy(strategy) + struct.pack('<B', 99)  # CMD_STOP
+
+    result = subprocess.run([C_SWEEP_PATH, '--bounds'], input=stream, capture_output=True, check=True)
+
+    RESULT_SIZE = 36
+    bounds = []
+    for i in range(len(params_list)):
+        values = struct.unpack_from('<9I', result.stdout, i * RESULT_SIZE)
+        if values[8] == 0:
+            bounds.append(None)
+            continue
+        unbounded = lambda v: float('inf') if v == 0xFFFFFFFF else v
+        bounds.append({
+            'starvation': [unbounded(v) for v in values[0:4]],
+            'max_wait': [unbounded(v) for v in values[4:8]],
+        })
+
+    return bounds
+
+
+def prescreen_candidates(scenarios: List[Scenario], params_list: List[TimingParams],
+                         weights: dict, keep: float) -> Dict[str, Optional[List[int]]]:
+    """Indices of the best `keep` fraction of candidates by estimated cost, per scenario.
+
+    A scenario whose estimator ranking does not reach PRESCREEN_MIN_RHO on the
+    simulated sample is not cut (None), with a warning. When the fraction keeps
+    every candidate, nothing is estimated or sampled.
+    """
+    n_keep = max(1, int(len(params_list) * keep))
+    if n_keep >= len(params_list):
+        if keep < 1.0:
+            print(f"Pre-screen: {keep:.0%} of {len(params_list)} candidates keeps all of them, skipped")
+        return {scenario.name: None for scenario in scenarios}
+
+    sample = range(0, len(params_list), PRESCREEN_SAMPLE_STRIDE)
+    cost = lambda m: m.cost(awt=weights['awt'], max=weights['max'], left=weights['left'])
+
+    kept = {}
+    for scenario in scenarios:
+        scenario_data = create_command_list(scenario, seed=SEED)
+        est_costs = [cost(est) for est in estimate_candidates(scenario_data, params_list)]
+
+        rho = rank_correlation([cost(m) for m in run_sweep(scenario_data, [params_list[idx] for idx in sample])],
+                               [est_costs[idx] for idx in sample])
+        if rho < PRESCREEN_MIN_RHO:
+            print(f"Warning: estimator rho={rho:+.3f} < {PRESCREEN_MIN_RHO} on {scenario.name}, "
+                  f"keeping all {len(params_list)} candidates")
+            kept[scenario.name] = None
+            continue
+
+        kept[scenario.name] = sorted(sorted(range(len(params_list)), key=lambda idx: est_costs[idx])[:n_keep])
+
+    return kept
+
+
+def rank_correlation(a: List[float], b: List[float]) -> float:
+    """Spearman rank correlation (average ranks for ties)."""
+    import numpy as np
+
+    def ranks(values):
+        values = np.asarray(values, dtype=float)
+        order = np.argsort(values, kind='mergesort')
+        r = np.empty(len(values))
+        r[order] = np.arange(len(values))
+        for value in np.unique(values):
+            tied = values == value
+            r[tied] = r[tied].mean()
+        return r
+
+    ra, rb = ranks(a), ranks(b)
+    if ra.std() == 0 or rb.std() == 0:
+        return 0.0
+    return float(np.corrcoef(ra, rb)[0, 1])
+
+
+def validate_estimator(weights: Optional[dict] = None) -> dict:
+    """Reports how well the estimator ranks candidates compared to the simulator."""
+    if weights is None:
+        weights = {'awt': 1.0, 'max': 0.5, 'left': 0.3}
+
+    grid = [
+        TimingParams(green_st=st, green_lt=lt, ext_threshold=eth, max_ext=mext, skip_limit=skip)
+        for st, lt, eth, mext, skip in itertools.product(
+            range(4, 19, 2), range(3, 13, 2), range(1, 6), [3, 9, 15], range(1, 4)
+        )
+    ]
+
+    print(f"Estimator validation on {len(grid)} candidates")
+    correlations = {}
+    for scenario in SCENARIOS + JAM_SCENARIOS:
+        scenario_data = create_command_list(scenario, seed=SEED)
+        simulated = run_sweep(scenario_data, grid)
+        estimated = estimate_candidates(scenario_data, grid)
+
+        rho = rank_correlation(
+            [m.cost(awt=weights['awt'], max=weights['max'], left=weights['left']) for m in simulated],
+            [m.cost(awt=weights['awt'], max=weights['max'], left=weights['left']) for m in estimated]
+        )
+        correlations[scenario.name] = rho
+        print(f" {scenario.name:20s}: Spearman rho = {rho:+.3f}")
+
+    return correlations
+
+
+def params_grid() -> List[TimingParams]:
+    """Materializes the configured search space."""
+    return [
+        TimingParams(green_st=st, green_lt=lt, ext_threshold=eth, max_ext=mext, skip_limit=skip)
+        for st, lt, eth, mext, skip in itertools.product(
+            ST_RANGE, LT_RANGE, EXT_THRESHOLD_RANGE, MAX_EXT_RANGE, SKIP_LIMIT_RANGE
+        )
+    ]
 
 # ============ GLOBAL NORMALIZATION ============
 
@@ -237,18 +426,8 @@ def calculate_global_norms(scenarios: List[Scenario]) -> Tuple[float, float, flo
     for scenario in scenarios:
         print(f" -> {scenario.name}")
         scenario_data = create_command_list(scenario, seed=SEED)
-        
-        current_search = itertools.product(
-            ST_RANGE, LT_RANGE, EXT_THRESHOLD_RANGE, MAX_EXT_RANGE, SKIP_LIMIT_RANGE
-        )
-
-        for st, lt, eth, mext, skip in current_search:
-            params = TimingParams(
-                green_st=st, green_lt=lt, 
-                ext_threshold=eth, max_ext=mext, skip_limit=skip
-            )
-            metrics = run_single_simulation(scenario_data, params)
 
+        for metrics in run_sweep(scenario_data, params_grid()):
             all_avg.append(metrics.avg_wait)
             all_max.append(metrics.max_wait)
             all_left.append(metrics.left_wait)
@@ -273,7 +452,8 @@ def calculate_global_norms(scenarios: List[Scenario]) -> Tuple[float, float, flo
 def grid_search(
     scenario: Scenario,
     global_norms: tuple,
-    weights: dict
+    weights: dict,
+    grid: Optional[List[TimingParams]] = None
 ) -> tuple:
     norm_avg, norm_max, norm_left = global_norms
     scenario_data = create_command_list(scenario, seed=SEED)
@@ -285,24 +465,13 @@ def grid_search(
     best_params = None
     results = []
     
-    search_space = itertools.product(
-        ST_RANGE, 
-        LT_RANGE, 
-        EXT_THRESHOLD_RANGE, 
-        MAX_EXT_RANGE, 
-        SKIP_LIMIT_RANGE
-    )
+    if grid is None:
+        grid = params_grid()
+    grid_metrics = run_sweep(scenario_data, grid)
 
-    for st, lt, eth, mext, skip in search_space:
-        params = TimingParams(
-            green_st=st, 
-            green_lt=lt, 
-            ext_threshold=eth, 
-            max_ext=mext, 
-            skip_limit=skip
-        )
-        
-        metrics = run_single_simulation(scenario_data, params)
+    for params, metrics in zip(grid, grid_metrics):
+        st, lt = params.green_st, params.green_lt
+        eth, mext, skip = params.ext_threshold, params.max_ext, params.skip_limit
 
         cost = metrics.cost(
             awt=weights['awt'],
@@ -351,12 +520,27 @@ def multi_scenario_optimization(
     global_norms = calculate_global_norms(scenarios)
     norm_avg, norm_max, norm_left = global_norms
 
+    full_grid = params_grid()
+    kept = prescreen_candidates(scenarios, full_grid, weights, PRESCREEN_KEEP)
+    grids = {name: full_grid if idx is None else [full_grid[i] for i in idx] for name, idx in kept.items()}
+
+    # The compromise is evaluated on the candidates kept by the scenarios that were cut
+    cut = [name for name, idx in kept.items() if idx is not None]
+    if cut:
+        survivors = set().union(*(kept[name] for name in cut))
+        grid = [full_grid[i] for i in sorted(survivors)]
+        print(f"Pre-screen kept {len(grid)} of {len(full_grid)} candidates (cut on {', '.join(cut)})")
+    else:
+        grid = full_grid
+        if PRESCREEN_KEEP < 1.0:
+            print(f"Pre-screen pruned nothing: no scenario reaches rho >= {PRESCREEN_MIN_RHO}")
+
     print("1. Individual scenario optima")
     
     scenario_optima = {}
     for scenario in scenarios:
         best_params, best_cost, _ = grid_search(
-            scenario, global_norms, weights
+            scenario, global_norms, weights, grids[scenario.name]
         )
         scenario_optima[scenario.name] = {
             'params': best_params.to_dict(),
@@ -367,25 +551,20 @@ def multi_scenario_optimization(
     
     compromise_results = []
 
-    search_space = itertools.product(
-        ST_RANGE, LT_RANGE, EXT_THRESHOLD_RANGE, MAX_EXT_RANGE, SKIP_LIMIT_RANGE
-    )
+    scenario_metrics = {
+        scenario.name: run_sweep(create_command_list(scenario, seed=SEED), grid)
+        for scenario in scenarios
+    }
 
-    for st, lt, eth, mext, skip in search_space:
-        params = TimingParams(
-            green_st=st, 
-            green_lt=lt, 
-            ext_threshold=eth, 
-            max_ext=mext, 
-            skip_limit=skip
-        )
+    for idx, params in enumerate(grid):
+        st, lt = params.green_st, params.green_lt
+        eth, mext, skip = params.ext_threshold, params.max_ext, params.skip_limit
         
         total_cost = 0.0
         scenario_costs = {}
 
         for scenario in scenarios:
-            scenario_data = create_command_list(scenario, seed=SEED)
-            metrics = run_single_simulation(scenario_data, params)
+            metrics = scenario_metrics[scenario.name][idx]
 
             cost = metrics.cost(
                 awt=weights['awt'],
@@ -458,7 +637,29 @@ if __name__ == "__main__":
     if len(sys.argv) > 1 and sys.argv[1] == "--generate-only":
         save_benchmarks()
 
+    elif len(sys.argv) > 1 and sys.argv[1] == "--validate-estimator":
+        validate_estimator()
+
+    elif len(sys.argv) > 1 and sys.argv[1] == "--bounds":
+        print(f"Certified worst-case waits (steps, any traffic), strategy {DEFAULT_STRATEGY}")
+        print(" ST  LT  EXT_T MAX_EXT SKIP_L | first vehicle | full queue")
+        grid = params_grid()
+        for p, b in zip(grid, certify_bounds(grid)):
+            if b is None:
+                print(f"{p.green_st:3d} {p.green_lt:3d} {p.ext_threshold:6d} {p.max_ext:7d} {p.skip_limit:6d} | not certified")
+                continue
+            print(f"{p.green_st:3d} {p.green_lt:3d} {p.ext_threshold:6d} {p.max_ext:7d} {p.skip_limit:6d} | "
+                  f"{max(b['starvation']):13} | {max(b['max_wait']):10}")
+
     elif len(sys.argv) > 1 and sys.argv[1] == "--optimize":
+        if "--prescreen" in sys.argv:
+            PRESCREEN_KEEP = 0.3
+        if "--daemon" in sys.argv:
+            from sweep_daemon import DEFAULT_SOCKET
+            idx = sys.argv.index("--daemon")
+            has_path = idx + 1 < len(sys.argv) and not sys.argv[idx + 1].startswith("--")
+            SWEEP_DAEMON_SOCKET = sys.argv[idx + 1] if has_path else DEFAULT_SOCKET
+
         policies = {
             'balanced': {'awt': 1.0, 'max': 0.5, 'left': 0.3},
             'fairness': {'awt': 0.7, 'max': 2.0, 'left': 0.5},
@@ -492,6 +693,13 @@ if __name__ == "__main__":
             print(f"  Avg normalized cost = {comp['avg_cost']:.3f}")
             print(f"  (Norms: AWT={norms['avg']:.0f}, MAX={norms['max']:.0f}, LEFT={norms['left']:.0f})")
 
+            params = TimingParams(green_st=comp['st'], green_lt=comp['lt'], ext_threshold=comp['eth'],
+                                  max_ext=comp['mext'], skip_limit=comp['skip'])
+            bounds = certify_bounds([params])[0]
+            if bounds:
+                print(f"  Certified MAX (any traffic): {max(bounds['starvation'])} steps for a first vehicle, "
+                      f"{max(bounds['max_wait'])} behind a full queue")
+
     else:
         save_benchmarks()
         print("\nRun with --optimize to perform optimization")
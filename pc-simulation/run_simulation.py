@@ -3,13 +3,48 @@ import struct
 import json
 import sys
 import os
-from typing import Any, Dict, Optional
+import re
+import threading
+from typing import Any, Dict, List, Optional
+
+from state_stream import pack_subscribe, read_update
 
 # Shares protocol.h structure
 CMD_CONFIG = 0
 CMD_ADD_VEHICLE = 1
 CMD_STEP = 2
+CMD_GET_STATS = 3
+CMD_GET_WAIT_PERCENTILES = 4
+CMD_GET_WAIT_HISTOGRAM = 5
+CMD_SET_STRATEGY = 6
+CMD_UPDATE_TIMING = 7
+CMD_ADD_TIMING_PLAN = 8
+CMD_SESSION_CREATE = 9
+CMD_SESSION_SELECT = 10
+CMD_SESSION_DESTROY = 11
+CMD_STEP_SESSIONS = 12
+CMD_SAVE_CHECKPOINT = 14
+CMD_SET_AGGREGATION = 15
+CMD_GET_MEMORY = 17
 CMD_STOP = 99
+SESSION_STATE_INVALID = 0xFF
+
+# ResponseBucket (CMD_SET_AGGREGATION)
+AGGREGATE_OFF, AGGREGATE_STEPS, AGGREGATE_CYCLES = 0, 1, 2
+BUCKET_FORMAT = '<IIB8I8I8Q8I8I8H5I'
+BUCKET_SIZE = struct.calcsize(BUCKET_FORMAT)
+BUCKET_FINAL = 0x01
+
+# Shares wait_histogram.h layout
+WAIT_HIST_SUB_BITS = 2
+WAIT_HIST_SUB_BUCKETS = 1 << WAIT_HIST_SUB_BITS
+WAIT_HIST_LINEAR_LIMIT = 2 * WAIT_HIST_SUB_BUCKETS
+WAIT_HIST_BUCKETS = 64
+LANE_COUNT = 8
+MOVEMENTS = ["ns_straight", "ns_left", "ew_straight", "ew_left"]
+
+# Controller strategies (TrafficStrategyId)
+STRATEGIES = {"v1": 0, "v2": 1, "v3": 2, "v4": 3, "v5": 4, "v6": 5}
 
 NORTH, EAST, SOUTH, WEST = 0, 1, 2, 3
 ROAD_MAP = {"north": 0, "east": 1, "south": 2, "west": 3}
@@ -17,27 +52,128 @@ ROAD_MAP = {"north": 0, "east": 1, "south": 2, "west": 3}
 SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
 CORE_DIR = os.path.dirname(SCRIPT_DIR)
 C_BINARY_PATH = os.path.join(CORE_DIR, 'core', 'bin', 'traffic_sim')
+C_ARCHIVE_PATH = os.path.join(CORE_DIR, 'core', 'bin', 'traffic_archive')
+
+def checkpoint_step(path: Optional[str]) -> int:
+    """
+    Step a --checkpoint file resumes at (0 if there is none). Read from the file,
+    since the core answers no command until the replayed scenario reaches it.
+    """
+    header = struct.Struct('<4sQQI')  # Magic, scenario bytes, file position, step
+    try:
+        with open(path, 'rb') as f:
+            magic, _, _, step = header.unpack(f.read(header.size))
+    except (TypeError, OSError, struct.error):
+        return 0
+    return step if magic == b'TSC2' else 0
+
+
+def hist_bucket_max(bucket: int) -> int:
+    """Largest wait time (steps) counted in a histogram bucket."""
+    def bucket_min(b):
+        if b < WAIT_HIST_LINEAR_LIMIT:
+            return b
+        octave, sub = divmod(b - WAIT_HIST_LINEAR_LIMIT, WAIT_HIST_SUB_BUCKETS)
+        exponent = octave + WAIT_HIST_SUB_BITS + 1
+        return (1 << exponent) + (sub << (exponent - WAIT_HIST_SUB_BITS))
+
+    if bucket >= WAIT_HIST_BUCKETS - 1:
+        return 0xFFFFFFFF
+    return bucket_min(bucket + 1) - 1
+
+
+def pack_timing(config: Dict[str, int]) -> bytes:
+    """Encodes PayloadConfig."""
+    return struct.pack('<IIIIIII',
+                       config['green_st'],
+                       config['green_lt'],
+                       config['yellow'],
+                       config['all_red'],
+                       config['ext_threshold'],
+                       config['max_ext'],
+                       config['skip_limit'])
+
+
+def decode_bucket(data: bytes) -> Dict[str, Any]:
+    """Converts a ResponseBucket into per-lane means and maxima and phase shares."""
+    fields = struct.unpack(BUCKET_FORMAT, data)
+    first_step, steps, flags = fields[:3]
+    arrivals, departures = fields[3:11], fields[11:19]
+    total_wait, max_wait = fields[19:27], fields[27:35]
+    queue_sum, queue_max = fields[35:43], fields[43:51]
+    phase_steps = fields[51:56]
+
+    return {
+        "firstStep": first_step,
+        "steps": steps,
+        "final": bool(flags & BUCKET_FINAL),
+        "arrivals": list(arrivals),
+        "departures": list(departures),
+        "meanWait": [round(w / d, 3) if d else 0 for w, d in zip(total_wait, departures)],
+        "maxWait": list(max_wait),
+        "meanQueue": [round(q / steps, 3) if steps else 0 for q in queue_sum],
+        "maxQueue": list(queue_max),
+        "phaseShares": {name: round(n / steps, 4) if steps else 0
+                        for name, n in zip(MOVEMENTS + ["clearance"], phase_steps)},
+    }
+
+
+def merge_histograms(histograms: List[List[int]]) -> List[int]:
+    """Adds bucket counts of histograms from several lanes, runs or workers."""
+    merged = [0] * WAIT_HIST_BUCKETS
+    for h in histograms:
+        for i, count in enumerate(h):
+            merged[i] += count
+    return merged
+
+
+def histogram_percentile(counts: List[int], fraction: float) -> int:
+    """Upper bound of the bucket holding the given percentile (same rule as the core)."""
+    total = sum(counts)
+    if total == 0:
+        return 0
+
+    permille = int(round(fraction * 1000))
+    rank = max(1, (total * permille + 999) // 1000)
+    seen = 0
+    for i, count in enumerate(counts):
+        seen += count
+        if seen >= rank:
+            return hist_bucket_max(i)
+    return hist_bucket_max(WAIT_HIST_BUCKETS - 1)
+
 
 class TrafficSimulator:
     """
     Manages the lifecycle and binary communication with the C FSM core.
     """
 
-    def __init__(self, config: Optional[Dict[str, int]] = None):
+    def __init__(self, config: Optional[Dict[str, int]] = None, checkpoint: Optional[str] = None,
+                 strategy: Optional[str] = None, stack_report: bool = False):
         if not os.path.exists(C_BINARY_PATH):
             raise FileNotFoundError(f"Could not find '{C_BINARY_PATH}'. Did you run 'make'?")
 
+        args = [C_BINARY_PATH]
+        if checkpoint:
+            args += ['--checkpoint', checkpoint]
+        if stack_report:
+            args.append('--stack-report')
+
         self.proc = subprocess.Popen(
-            [C_BINARY_PATH],
+            args,
             stdin=subprocess.PIPE,
             stdout=subprocess.PIPE,
             stderr=sys.stderr
         )
         
+        self.active_session = 0
+        self.subscriptions: Dict[int, List[int]] = {}  # Session -> [every, steps until the next update]
+        self.bucket_reader = None
+
         if config:
-            self.send_config(config)
+            self.config = dict(config)
         else:
-            default_config = {
+            self.config = {
                 'green_st': 4,
                 'green_lt': 3,
                 'yellow': 1,
@@ -46,7 +182,10 @@ class TrafficSimulator:
                 'max_ext': 15,
                 'skip_limit': 2
             }
-            self.send_config(default_config)
+        self.send_config(self.config)
+
+        if strategy:
+            self.set_strategy(strategy)
             
         print(f"C simulator running (PID: {self.proc.pid})")
 
@@ -54,16 +193,35 @@ class TrafficSimulator:
         print(f" -> [PY] Sending config: ST={config['green_st']}s, LT={config['green_lt']}s, Y={config['yellow']}s, AR={config['all_red']}s")
         
         header = struct.pack('<B', CMD_CONFIG)
-        payload = struct.pack('<IIIIIII', 
-                            config['green_st'],
-                            config['green_lt'], 
-                            config['yellow'],
-                            config['all_red'],
-                            config['ext_threshold'],
-                            config['max_ext'],
-                            config['skip_limit'])
-        
-        self.proc.stdin.write(header + payload)
+        self.proc.stdin.write(header + pack_timing(config))
+        self.proc.stdin.flush()
+
+    def update_timing(self, changes: Dict[str, int]) -> None:
+        """
+        Retunes the running controller. Only the given parameters change; queues and
+        statistics are kept and the core applies the timing at the next phase boundary.
+        """
+        self.config = {**self.config, **changes}
+        print(f" -> [PY] Updating timing: {changes}")
+        self.proc.stdin.write(struct.pack('<B', CMD_UPDATE_TIMING) + pack_timing(self.config))
+        self.proc.stdin.flush()
+
+    def add_timing_plan(self, start_step: int, changes: Dict[str, int]) -> None:
+        """Adds a time-of-day plan (relative to the initial config) that takes over at start_step."""
+        plan = {**self.config, **changes}
+        print(f" -> [PY] Timing plan from step {start_step}: {changes}")
+        self.proc.stdin.write(struct.pack('<BI', CMD_ADD_TIMING_PLAN, start_step) + pack_timing(plan))
+        self.proc.stdin.flush()
+
+    def save_checkpoint(self) -> None:
+        """Persists the system now (--checkpoint file on PC, flash on the STM32)."""
+        self.proc.stdin.write(struct.pack('<B', CMD_SAVE_CHECKPOINT))
+        self.proc.stdin.flush()
+
+    def set_strategy(self, strategy: str) -> None:
+        """Selects the controller strategy (v1-v6) for the rest of the session."""
+        print(f" -> [PY] Selecting strategy: {strategy}")
+        self.proc.stdin.write(struct.pack('<BB', CMD_SET_STRATEGY, STRATEGIES[strategy]))
         self.proc.stdin.flush()
 
     def add_vehicle(self, vehicle_id: str, start_road: str, end_road: str, arrival_time: int) -> None:
@@ -105,7 +263,175 @@ class TrafficSimulator:
                 v_id = raw_ids[i*32 : (i+1)*32].decode('utf-8').strip('\x00')
                 left_vehicles.append(v_id)
 
-        return {"step": step_idx, "leftVehicles": left_vehicles}
+        result = {"step": step_idx, "leftVehicles": left_vehicles}
+        self._read_state_update(self.active_session, result)
+        return result
+
+    def create_session(self, session_id: int, config: Optional[Dict[str, int]] = None) -> None:
+        """Creates an independent intersection hosted by the same core process (IDs 1-65535)."""
+        payload = struct.pack('<BH', CMD_SESSION_CREATE, session_id) + pack_timing(config or self.config)
+        self.proc.stdin.write(payload)
+        self.proc.stdin.flush()
+
+    def select_session(self, session_id: int) -> None:
+        """Directs add_vehicle, step, get_stats, ... to a session (0 = the default intersection)."""
+        self.proc.stdin.write(struct.pack('<BH', CMD_SESSION_SELECT, session_id))
+        self.proc.stdin.flush()
+        self.active_session = session_id
+
+    def destroy_session(self, session_id: int) -> None:
+        self.proc.stdin.write(struct.pack('<BH', CMD_SESSION_DESTROY, session_id))
+        self.proc.stdin.flush()
+        self.subscriptions.pop(session_id, None)
+        if session_id == self.active_session:
+            self.active_session = 0
+
+    def step_sessions(self, session_ids: List[int]) -> Dict[int, Dict[str, Any]]:
+        """Steps many sessions in one frame; unknown sessions are reported as None."""
+        frame = struct.pack(f'<BH{len(session_ids)}H', CMD_STEP_SESSIONS, len(session_ids), *session_ids)
+        self.proc.stdin.write(frame)
+        self.proc.stdin.flush()
+
+        results = {}
+        for _ in session_ids:
+            header = self.proc.stdout.read(13)
+            if len(header) < 13:
+                raise RuntimeError("C process did not respond")
+
+            session_id, step_idx, state, _, _, _, _, v_count = struct.unpack('<HIBBBBBH', header)
+            raw_ids = self.proc.stdout.read(v_count * 32) if v_count else b''
+            left_vehicles = [raw_ids[i*32:(i+1)*32].decode('utf-8').strip('\x00') for i in range(v_count)]
+
+            if state == SESSION_STATE_INVALID:
+                results[session_id] = None
+            else:
+                results[session_id] = {"step": step_idx, "leftVehicles": left_vehicles}
+                self._read_state_update(session_id, results[session_id])
+        return results
+
+    def subscribe_state(self, session_id: int, every: int = 1) -> Optional[Dict[str, Any]]:
+        """
+        Streams the queues of a session: returns the keyframe (None for an unknown
+        session) and adds a "state" update to every `every`-th step result of the
+        session (see state_stream.QueueStateMirror). every = 0 unsubscribes.
+        """
+        if self.bucket_reader:
+            raise RuntimeError("State updates cannot be read while aggregating")
+        self.proc.stdin.write(pack_subscribe(session_id, every))
+        self.proc.stdin.flush()
+
+        if every == 0:
+            self.subscriptions.pop(session_id, None)
+            return None
+
+        keyframe = read_update(self.proc.stdout.read)
+        if not keyframe["valid"]:
+            return None
+        self.subscriptions[session_id] = [every, every]
+        return keyframe
+
+    def _read_state_update(self, session_id: int, result: Dict[str, Any]) -> None:
+        """Reads the update that follows a step response when the subscription is due."""
+        subscription = self.subscriptions.get(session_id)
+        if subscription:
+            subscription[1] -= 1
+            if subscription[1] == 0:
+                subscription[1] = subscription[0]
+                result["state"] = read_update(self.proc.stdout.read)
+
+    def send_step(self) -> None:
+        """Sends a step the core already simulated before the checkpoint (no response)."""
+        self.proc.stdin.write(struct.pack('<B', CMD_STEP))
+
+    def get_stats(self) -> Dict[str, int]:
+        """Reads the wait statistics accumulated by the core (ResponseStats)."""
+        self.proc.stdin.write(struct.pack('<B', CMD_GET_STATS))
+        self.proc.stdin.flush()
+
+        data = self.proc.stdout.read(32)
+        if len(data) != 32:
+            raise RuntimeError("C process did not respond")
+
+        fields = struct.unpack('<IIQIIQ', data)
+        keys = ('current_step', 'departures', 'total_wait', 'max_wait', 'left_departures', 'left_total_wait')
+        return dict(zip(keys, fields))
+
+    def get_wait_percentiles(self) -> Dict[str, Any]:
+        """Reads P50/P95/P99 wait per lane and per movement (ResponseWaitPercentiles)."""
+        self.proc.stdin.write(struct.pack('<B', CMD_GET_WAIT_PERCENTILES))
+        self.proc.stdin.flush()
+
+        data = self.proc.stdout.read(16 * (LANE_COUNT + len(MOVEMENTS)))
+        if len(data) != 16 * (LANE_COUNT + len(MOVEMENTS)):
+            raise RuntimeError("C process did not respond")
+
+        entries = [dict(zip(('departures', 'p50', 'p95', 'p99'), fields))
+                   for fields in struct.iter_unpack('<IIII', data)]
+        return {"lanes": entries[:LANE_COUNT], "movements": dict(zip(MOVEMENTS, entries[LANE_COUNT:]))}
+
+    def get_wait_histogram(self) -> List[List[int]]:
+        """Reads the raw wait histogram of every lane, indexed [road * 2 + lane]."""
+        self.proc.stdin.write(struct.pack('<B', CMD_GET_WAIT_HISTOGRAM))
+        self.proc.stdin.flush()
+
+        size = LANE_COUNT * WAIT_HIST_BUCKETS * 4
+        data = self.proc.stdout.read(size)
+        if len(data) != size:
+            raise RuntimeError("C process did not respond")
+
+        counts = struct.unpack(f'<{LANE_COUNT * WAIT_HIST_BUCKETS}I', data)
+        return [list(counts[i * WAIT_HIST_BUCKETS:(i + 1) * WAIT_HIST_BUCKETS]) for i in range(LANE_COUNT)]
+
+    def get_memory(self) -> Dict[str, int]:
+        """
+        Reads the RAM high-water marks of the core in bytes (ResponseMemory, 0 = unknown).
+        The stack fields need a simulator created with stack_report=True.
+        """
+        self.proc.stdin.write(struct.pack('<B', CMD_GET_MEMORY))
+        self.proc.stdin.flush()
+
+        data = self.proc.stdout.read(28)
+        if len(data) != 28:
+            raise RuntimeError("C process did not respond")
+
+        keys = ('ram_size', 'static_bytes', 'system_bytes', 'heap_bytes', 'heap_peak', 'stack_size', 'stack_peak')
+        return dict(zip(keys, struct.unpack('<7I', data)))
+
+    def start_aggregation(self, bucket_steps: int, cycles: bool = False) -> None:
+        """
+        Replaces the step responses by one bucket record every bucket_steps steps
+        (or every signal cycle, capped at bucket_steps if not 0). Steps are then
+        sent with send_step(); a reader thread collects the buckets so neither
+        pipe can fill up.
+        """
+        if 0 in self.subscriptions:
+            raise RuntimeError("Unsubscribe session 0 before aggregating it")
+        mode = AGGREGATE_CYCLES if cycles else AGGREGATE_STEPS
+        self.proc.stdin.write(struct.pack('<BBI', CMD_SET_AGGREGATION, mode, bucket_steps))
+        self.proc.stdin.flush()
+
+        self.buckets = []
+        self.bucket_reader = threading.Thread(target=self._read_buckets, daemon=True)
+        self.bucket_reader.start()
+
+    def _read_buckets(self) -> None:
+        while True:
+            data = self.proc.stdout.read(BUCKET_SIZE)
+            if len(data) < BUCKET_SIZE:
+                return
+            bucket = decode_bucket(data)
+            if bucket["steps"] > 0:
+                self.buckets.append(bucket)
+            if bucket["final"]:
+                return
+
+    def finish_aggregation(self) -> List[Dict[str, Any]]:
+        """Closes the open bucket, returns all buckets and restores the step responses."""
+        self.proc.stdin.write(struct.pack('<BBI', CMD_SET_AGGREGATION, AGGREGATE_OFF, 0))
+        self.proc.stdin.flush()
+        self.bucket_reader.join()
+        self.bucket_reader = None
+        return self.buckets
 
     def close(self) -> None:
         """Gracefully terminates the C process, with a forced kill fallback."""
@@ -116,69 +442,173 @@ class TrafficSimulator:
         except:
             self.proc.kill()
 
-def run_simulation(input_file: str, output_file: str, timing_params: Optional[Dict[str, int]] = None) -> Dict[str, float]:
+def parse_aggregate(spec: str):
+    """'60' -> (60, False), 'cycle' -> (0, True), 'cycle:120' -> (120, True)."""
+    if spec.startswith('cycle'):
+        return (int(spec[6:]) if spec[5:6] == ':' else 0), True
+    return int(spec), False
+
+
+def run_simulation(input_file: str, output_file: str, timing_params: Optional[Dict[str, int]] = None,
+                   checkpoint: Optional[str] = None, strategy: Optional[str] = None,
+                   aggregate: Optional[str] = None) -> Dict[str, float]:
     """
     Main execution loop. Parses the scenario, steps the FSM, 
     calculates performance metrics, and dumps the output JSON.
+
+    Besides addVehicle and step commands the scenario may contain
+    {"type": "updateTiming", "timing": {...}} commands and a top-level
+    "timingPlans": [{"startStep": N, "timing": {...}}] table. Both only list
+    the parameters that change and keep the queues of the running controller.
+
+    With a checkpoint the core resumes where the previous run on the same
+    (appended) scenario stopped: the already simulated commands are replayed
+    to it without responses, only the new steps are appended to the output,
+    and the metrics cover the whole scenario.
+
+    A .tsa input is a scenario archive (see core/traffic_archive.h), expanded
+    to the same JSON with traffic_archive.
+
+    With aggregate ("N" steps, "cycle" or "cycle:N") the core aggregates the
+    steps into buckets and the output holds only the bucket records
+    ({"buckets": [...]}, see decode_bucket) instead of every step's leftVehicles.
     """
-    with open(input_file, 'r') as f:
-        scenario = json.load(f)
+    if input_file.endswith('.tsa'):
+        scenario = json.loads(subprocess.run([C_ARCHIVE_PATH, 'json', input_file],
+                                             capture_output=True, check=True).stdout)
+    else:
+        with open(input_file, 'r') as f:
+            scenario = json.load(f)
 
-    sim = TrafficSimulator(timing_params)
+    done_steps = checkpoint_step(checkpoint)
+    sim = TrafficSimulator(timing_params, checkpoint, strategy)
+    for plan in scenario.get("timingPlans", []):
+        sim.add_timing_plan(plan["startStep"], plan["timing"])
+    if aggregate:
+        return run_aggregated(sim, scenario, input_file, output_file, *parse_aggregate(aggregate))
     output_data = {"stepStatuses": []}
-    
-    arrival_times = {}
-    wait_times = []
+
+    if done_steps > 0:
+        with open(output_file, 'r') as f:
+            output_data["stepStatuses"] = json.load(f)["stepStatuses"][:done_steps]
+        print(f"Resuming from checkpoint at step {done_steps}...")
+
     current_step = 0
 
     print(f"Starting simulation from {input_file}...")
 
     for cmd in scenario.get("commands", []):
         if cmd["type"] == "addVehicle":
-            v_id = cmd["vehicleId"]
-            arrival_times[v_id] = current_step
-            sim.add_vehicle(v_id, cmd["startRoad"], cmd["endRoad"], current_step)
+            sim.add_vehicle(cmd["vehicleId"], cmd["startRoad"], cmd["endRoad"], current_step)
         
         elif cmd["type"] == "step":
             current_step += 1
+            if current_step <= done_steps:
+                sim.send_step()
+                continue
+
             result = sim.step()
-            
-            for v_id in result["leftVehicles"]:
-                if v_id in arrival_times:
-                    wait = current_step - arrival_times[v_id]
-                    wait_times.append(wait)
-            
             output_data["stepStatuses"].append({"leftVehicles": result["leftVehicles"]})
 
+        elif cmd["type"] == "updateTiming":
+            sim.update_timing(cmd["timing"])
+
+    # Wait times are accumulated by the core (wait = departure step - arrival step)
+    stats = sim.get_stats()
+    percentiles = sim.get_wait_percentiles()
+    overall = merge_histograms(sim.get_wait_histogram())
     sim.close()
 
     with open(output_file, 'w') as f:
         json.dump(output_data, f, indent=4)
 
-    if wait_times:
-        avg_wait = sum(wait_times) / len(wait_times)
-        max_wait = max(wait_times)
+    metrics = report_metrics(stats, percentiles, overall)
+    print(f"\n[PY] Simulation finished. Output saved to {output_file}")
+    return metrics
+
+
+def run_aggregated(sim: TrafficSimulator, scenario: Dict[str, Any], input_file: str, output_file: str,
+                   bucket_steps: int, cycles: bool) -> Dict[str, float]:
+    """Aggregated run: the scenario is streamed without waiting for step responses."""
+    print(f"Starting aggregated simulation from {input_file} "
+          f"({'cycles' if cycles else f'{bucket_steps}-step buckets'})...")
+    sim.start_aggregation(bucket_steps, cycles)
+
+    current_step = 0
+    for cmd in scenario.get("commands", []):
+        if cmd["type"] == "addVehicle":
+            sim.add_vehicle(cmd["vehicleId"], cmd["startRoad"], cmd["endRoad"], current_step)
+        elif cmd["type"] == "step":
+            current_step += 1
+            sim.send_step()
+        elif cmd["type"] == "updateTiming":
+            sim.update_timing(cmd["timing"])
+
+    buckets = sim.finish_aggregation()
+    for bucket in buckets:
+        del bucket["final"]
+
+    stats = sim.get_stats()
+    percentiles = sim.get_wait_percentiles()
+    overall = merge_histograms(sim.get_wait_histogram())
+    sim.close()
+
+    with open(output_file, 'w') as f:
+        # One bucket per line: indenting the lane lists would multiply the size
+        f.write('{"buckets": [\n' + ',\n'.join(json.dumps(b) for b in buckets) + '\n]}\n')
+
+    metrics = report_metrics(stats, percentiles, overall)
+    print(f"\n[PY] Simulation finished. {len(buckets)} buckets saved to {output_file}")
+    return metrics
+
+
+def report_metrics(stats: Dict[str, int], percentiles: Dict[str, Any], overall: List[int]) -> Dict[str, float]:
+    """Prints the performance summary of a run and returns its metrics."""
+    departures = stats['departures']
+    if departures:
         print("\n --- PERFORMANCE METRICS ---")
-        print(f"   Avg Wait Time: {avg_wait:.2f} steps")
-        print(f"   Max Wait Time: {max_wait} steps")
-        print(f"   Throughput:    {len(wait_times)} vehicles")
+        print(f"   Avg Wait Time: {stats['total_wait'] / departures:.2f} steps")
+        print(f"   Max Wait Time: {stats['max_wait']} steps")
+        print(f"   Throughput:    {departures} vehicles")
+        print(f"   P50/P95/P99:   {histogram_percentile(overall, 0.50)} / "
+              f"{histogram_percentile(overall, 0.95)} / {histogram_percentile(overall, 0.99)} steps")
+        for name, p in percentiles["movements"].items():
+            if p['departures']:
+                print(f"     {name:<12} P50={p['p50']:<4} P95={p['p95']:<4} P99={p['p99']:<4} ({p['departures']} vehicles)")
     else:
         print("\n --- PERFORMANCE METRICS ---")
         print("   No vehicles processed.")
-    
-    print(f"\n[PY] Simulation finished. Output saved to {output_file}")
-    
+
     metrics = {
-        'avg_wait': sum(wait_times) / len(wait_times) if wait_times else 0,
-        'max_wait': max(wait_times) if wait_times else 0,
-        'throughput': len(wait_times)
+        'avg_wait': stats['total_wait'] / departures if departures else 0,
+        'max_wait': stats['max_wait'],
+        'throughput': departures,
+        'p50_wait': histogram_percentile(overall, 0.50),
+        'p95_wait': histogram_percentile(overall, 0.95),
+        'p99_wait': histogram_percentile(overall, 0.99)
     }
     
     return metrics
 
 if __name__ == "__main__":
-    if len(sys.argv) < 3:
-        print("Usage: python3 run_simulation.py <input.json> <output.json>")
+    args = sys.argv[1:]
+    options = {'--checkpoint': None, '--strategy': None, '--aggregate': None}
+    for name in options:
+        if name in args:
+            idx = args.index(name)
+            if idx + 1 >= len(args):
+                args = []
+                break
+            options[name] = args[idx + 1]
+            del args[idx:idx + 2]
+
+    aggregate = options['--aggregate']
+    if len(args) < 2 or (options['--strategy'] and options['--strategy'] not in STRATEGIES) or \
+            (aggregate and (options['--checkpoint'] or not re.fullmatch(r'[1-9]\d*|cycle(:\d+)?', aggregate))):
+        print("Usage: python3 run_simulation.py <input.json> <output.json> "
+              "[--checkpoint <file>] [--strategy v1|v2|v3|v4|v5|v6] [--aggregate N|cycle[:N]]")
+        print("       (--aggregate cannot be combined with --checkpoint)")
         sys.exit(1)
     
-    run_simulation(sys.argv[1], sys.argv[2])
\ No newline at end of file
+    run_simulation(args[0], args[1], checkpoint=options['--checkpoint'], strategy=options['--strategy'],
+                   aggregate=aggregate)
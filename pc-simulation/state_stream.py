@@ -0,0 +1,95 @@
+"""
+Client side of the CMD_SUBSCRIBE_STATE queue state stream.
+
+The core answers a subscription with a keyframe (every queued vehicle and the
+lights) and then, every N steps of the session, sends only what changed since
+the previous update: per lane the number of vehicles that left the head and the
+vehicles appended at the tail. QueueStateMirror applies the updates, so a
+dashboard can follow the queues of many intersections without snapshots.
+"""
+import struct
+from typing import Any, Callable, Dict, List, Optional
+
+# Shares protocol.h structure (packed, Little-Endian)
+CMD_SUBSCRIBE_STATE = 16
+STATE_UPDATE_KEYFRAME = 0x01
+STATE_UPDATE_LIGHTS = 0x02
+STATE_UPDATE_INVALID = 0x80
+
+HEADER_FORMAT = '<HIBB'  # StateUpdateHeader
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+LIGHTS_SIZE = 5  # StateLights
+LANE_COUNT = 8  # Indexed road * 2 + lane
+
+ROADS = ["north", "east", "south", "west"]
+LANES = ["straight", "left"]
+
+
+def pack_subscribe(session_id: int, every: int) -> bytes:
+    """CMD_SUBSCRIBE_STATE frame; every = 0 ends the subscription."""
+    return struct.pack('<BHH', CMD_SUBSCRIBE_STATE, session_id, every)
+
+
+def read_update(read: Callable[[int], bytes]) -> Dict[str, Any]:
+    """
+    Reads one update through read(n) (e.g. a pipe's read method).
+
+    Returns {"session", "step", "keyframe", "valid", "lights", "lanes"}, where
+    lights is (state, ns_st, ns_lt, ew_st, ew_lt) or None if unchanged and lanes
+    maps a lane index to (popped, [(id, end_road, arrival_step), ...]).
+    """
+    def read_exact(n: int) -> bytes:
+        data = read(n)
+        if len(data) != n:
+            raise RuntimeError("Truncated state update")
+        return data
+
+    session_id, step, flags, lane_mask = struct.unpack(HEADER_FORMAT, read_exact(HEADER_SIZE))
+    update = {
+        "session": session_id,
+        "step": step,
+        "keyframe": bool(flags & STATE_UPDATE_KEYFRAME),
+        "valid": not flags & STATE_UPDATE_INVALID,
+        "lights": None,
+        "lanes": {},
+    }
+    if flags & STATE_UPDATE_LIGHTS:
+        update["lights"] = tuple(read_exact(LIGHTS_SIZE))
+
+    for lane in range(LANE_COUNT):
+        if not lane_mask & (1 << lane):
+            continue
+        popped, appended = read_exact(2)
+        vehicles = []
+        for _ in range(appended):
+            id_len = read_exact(1)[0]
+            vehicle_id = read_exact(id_len).decode('utf-8', errors='replace')
+            end_road, arrival = struct.unpack('<BI', read_exact(5))
+            vehicles.append((vehicle_id, end_road, arrival))
+        update["lanes"][lane] = (popped, vehicles)
+    return update
+
+
+class QueueStateMirror:
+    """Queues and lights of one session rebuilt from its updates."""
+
+    def __init__(self) -> None:
+        self.step = 0
+        self.lights: Optional[tuple] = None
+        self.lanes: List[List[tuple]] = [[] for _ in range(LANE_COUNT)]
+
+    def apply(self, update: Dict[str, Any]) -> None:
+        if update["keyframe"]:
+            self.lanes = [[] for _ in range(LANE_COUNT)]
+        if update["lights"] is not None:
+            self.lights = update["lights"]
+
+        for lane, (popped, vehicles) in update["lanes"].items():
+            if popped > len(self.lanes[lane]):
+                raise RuntimeError(f"Update for lane {lane} pops unknown vehicles (missed a keyframe?)")
+            del self.lanes[lane][:popped]
+            self.lanes[lane].extend(vehicles)
+        self.step = update["step"]
+
+    def queue_lengths(self) -> Dict[str, int]:
+        return {f"{ROADS[i // 2]}_{LANES[i % 2]}": len(queue) for i, queue in enumerate(self.lanes)}
@@ -0,0 +1,160 @@
+"""
+Vectorised decoding of traffic_sim step responses.
+
+A batch run (or a traffic_sim --input log) produces a stream of ResponseStep
+headers, each followed by `vehicles_out` 32-byte vehicle IDs. Instead of
+unpacking it header by header and ID by ID, the whole buffer is mapped onto a
+numpy structured dtype matching ResponseStep plus a fixed-width ID array, and
+wait metrics are computed with array operations.
+"""
+from typing import NamedTuple
+
+import numpy as np
+
+# Shares protocol.h structure (packed, Little-Endian)
+RESPONSE_STEP_DTYPE = np.dtype([
+    ('current_step', '<u4'),
+    ('current_state', 'u1'),
+    ('light_ns_st', 'u1'),
+    ('light_ns_lt', 'u1'),
+    ('light_ew_st', 'u1'),
+    ('light_ew_lt', 'u1'),
+    ('vehicles_out', '<u2'),
+])
+VEHICLE_ID_LEN = 32  # protocol.h; the core keeps VEHICLE_ID_LEN - 1 bytes of an ID
+VEHICLE_ID_DTYPE = np.dtype(f'S{VEHICLE_ID_LEN}')
+
+HEADER_SIZE = RESPONSE_STEP_DTYPE.itemsize
+ID_SIZE = VEHICLE_ID_DTYPE.itemsize
+VEHICLES_OUT_OFFSET = RESPONSE_STEP_DTYPE.fields['vehicles_out'][1]
+
+ROADS = ["north", "east", "south", "west"]
+
+
+class StepResponses(NamedTuple):
+    steps: np.ndarray       # RESPONSE_STEP_DTYPE, one record per step
+    ids: np.ndarray         # VEHICLE_ID_DTYPE, all discharged vehicles in order
+    id_steps: np.ndarray    # Step at which each vehicle left the intersection
+
+
+class ScenarioIndex(NamedTuple):
+    ids: np.ndarray         # VEHICLE_ID_DTYPE, sorted
+    arrival_steps: np.ndarray
+    is_left: np.ndarray
+
+
+def header_offsets(buf) -> np.ndarray:
+    """
+    Byte offsets of the step headers.
+
+    This stays a loop over the steps. A header is found only through the count of
+    the one before it, so the record lengths cannot be read before the offsets are
+    known, and a cumsum over them has nothing to start from. Resolving the chain in
+    numpy (pointer jumping over every byte position) costs O(bytes * log(steps)),
+    which is slower than this loop for any run. On the built-in scenarios the loop
+    takes 35-100 us, 10-40 % of decode_step_responses() + wait_metrics().
+    """
+    mv = memoryview(buf)
+    offsets = []
+    pos = 0
+    end = len(mv) - HEADER_SIZE
+
+    while pos <= end:
+        offsets.append(pos)
+        count = mv[pos + VEHICLES_OUT_OFFSET] | (mv[pos + VEHICLES_OUT_OFFSET + 1] << 8)
+        pos += HEADER_SIZE + count * ID_SIZE
+
+    if pos > len(mv):
+        offsets.pop()  # Truncated last step
+    return np.asarray(offsets, dtype=np.int64)
+
+
+def decode_step_responses(buf) -> StepResponses:
+    """
+    Maps a buffer of step responses onto numpy arrays.
+
+    When no vehicle left during the run the headers are a zero-copy view of the buffer.
+    Otherwise headers and IDs are gathered with a single fancy-index each.
+    """
+    raw = np.frombuffer(buf, dtype=np.uint8)
+    offsets = header_offsets(buf)
+    n_steps = len(offsets)
+
+    if n_steps == 0:
+        empty_steps = np.zeros(0, dtype=RESPONSE_STEP_DTYPE)
+        return StepResponses(empty_steps, np.zeros(0, dtype=VEHICLE_ID_DTYPE), np.zeros(0, dtype=np.uint32))
+
+    used = int(offsets[-1]) + HEADER_SIZE
+    if offsets[-1] == (n_steps - 1) * HEADER_SIZE:
+        # Fixed stride - no IDs in between
+        steps = raw[:used].view(RESPONSE_STEP_DTYPE)
+    else:
+        steps = raw[offsets[:, None] + np.arange(HEADER_SIZE)].reshape(-1).view(RESPONSE_STEP_DTYPE)
+
+    counts = steps['vehicles_out'].astype(np.int64)
+    used += int(counts[-1]) * ID_SIZE
+
+    # Everything that is not a header is an ID
+    is_id = np.ones(used, dtype=bool)
+    is_id[offsets[:, None] + np.arange(HEADER_SIZE)] = False
+    ids = raw[:used][is_id].view(VEHICLE_ID_DTYPE)
+
+    id_steps = np.repeat(steps['current_step'], counts)
+    return StepResponses(steps, ids, id_steps)
+
+
+def decode_file(path: str) -> StepResponses:
+    """Decodes the output of `traffic_sim --input` stored in a file."""
+    with open(path, 'rb') as f:
+        return decode_step_responses(f.read())
+
+
+def index_scenario(scenario_data: dict) -> ScenarioIndex:
+    """
+    Arrival step and left-turn flag of every vehicle, sorted by ID for lookups.
+    Repeated IDs keep their scenario order (stable sort).
+    """
+    ids = []
+    arrivals = []
+    left = []
+    current_step = 0
+
+    for cmd in scenario_data["commands"]:
+        if cmd["type"] == "addVehicle":
+            start = ROADS.index(cmd["startRoad"])
+            ids.append(cmd["vehicleId"].encode('utf-8')[:VEHICLE_ID_LEN - 1])  # As stored by the core
+            arrivals.append(current_step)
+            left.append(ROADS.index(cmd["endRoad"]) == (start + 1) % 4)
+        elif cmd["type"] == "step":
+            current_step += 1
+
+    ids = np.array(ids, dtype=VEHICLE_ID_DTYPE)
+    order = np.argsort(ids, kind='stable')
+    return ScenarioIndex(ids[order],
+                         np.array(arrivals, dtype=np.int64)[order],
+                         np.array(left, dtype=bool)[order])
+
+
+def wait_metrics(responses: StepResponses, index: ScenarioIndex) -> dict:
+    """
+    Wait time (departure step - arrival step) of every known discharged vehicle,
+    reduced to AWT, MAX, throughput and left-turn AWT. A repeated ID is matched
+    to its last arrival, as the per-step decoder did.
+    """
+    if len(index.ids) == 0 or len(responses.ids) == 0:
+        return {'avg_wait': 0, 'max_wait': 0, 'throughput': 0, 'left_wait': 0}
+
+    pos = np.searchsorted(index.ids, responses.ids, side='right') - 1
+    pos = np.maximum(pos, 0)
+    known = index.ids[pos] == responses.ids
+    pos = pos[known]
+
+    waits = responses.id_steps[known].astype(np.int64) - index.arrival_steps[pos]
+    left_waits = waits[index.is_left[pos]]
+
+    return {
+        'avg_wait': float(waits.mean()) if len(waits) else 0,
+        'max_wait': int(waits.max()) if len(waits) else 0,
+        'throughput': int(len(waits)),
+        'left_wait': float(left_waits.mean()) if len(left_waits) else 0,
+    }
@@ -0,0 +1,359 @@
+"""
+Local sweep daemon: one shared traffic_sweep worker pool for every user of a box.
+
+Clients submit sweep jobs (scenario streams, timing configurations, strategy)
+over a Unix socket. The daemon
+
+  * runs the simulations on a fixed number of workers, handing out chunks of
+    CHUNK_SIZE configurations round-robin over the active jobs, so a large
+    sweep cannot starve a small one;
+  * simulates each (scenario, strategy, params) key once: keys already queued
+    or running for another job are shared, finished keys come from a result
+    cache on disk;
+  * streams every result to the client as soon as its chunk finishes.
+
+The cache is appended after every chunk and is tied to the traffic_sweep
+binary it was produced with (rebuilding the core starts a fresh cache). An
+interrupted sweep (client killed, daemon restarted) therefore resumes where it
+stopped when it is submitted again; submit_sweep also resubmits on its own when
+the daemon goes away in the middle of a job.
+
+Protocol: one JSON object per line.
+    -> {"op": "submit", "strategy": "v6", "scenarios": {NAME: BASE64_STREAM},
+        "params": [[ST, LT, YELLOW, ALL_RED, EXT_T, MAX_EXT, SKIP_L], ...]}
+    <- {"type": "accepted", "job": ID, "total": N, "cached": K}
+    <- {"type": "result", "scenario": NAME, "index": I, "metrics": [AWT, MAX, THROUGHPUT, LEFT]}
+    <- {"type": "done", "job": ID}
+    -> {"op": "status"}
+    <- {"type": "status", "workers": W, "busy": B, "cached": C, "jobs": [...]}
+
+Usage:
+    python3 sweep_daemon.py serve [--socket PATH] [--workers N] [--state DIR]
+    python3 sweep_daemon.py status [--socket PATH]
+    python3 optimize_timings.py --optimize --daemon [PATH]
+"""
+import asyncio
+import base64
+import hashlib
+import json
+import os
+import socket
+import sys
+import time
+from collections import deque
+from concurrent.futures import ThreadPoolExecutor
+from typing import Callable, Dict, List, Optional
+
+from optimize_timings import (C_SWEEP_PATH, DEFAULT_STRATEGY, STRATEGIES, ScenarioMetrics,
+                              TimingParams, encode_scenario, sweep_stream)
+
+DEFAULT_SOCKET = f"/tmp/traffic_sweepd-{os.getuid()}.sock"
+DEFAULT_STATE_DIR = os.path.join(os.path.expanduser("~"), ".cache", "traffic_sweepd")
+CHUNK_SIZE = 16  # Configurations per traffic_sweep process
+RESUBMIT_ATTEMPTS = 5
+STREAM_LIMIT = 64 * 1024 * 1024  # Longest request line (base64 scenario streams)
+
+
+def params_tuple(p: TimingParams) -> tuple:
+    return (p.green_st, p.green_lt, p.yellow, p.all_red, p.ext_threshold, p.max_ext, p.skip_limit)
+
+
+def binary_fingerprint(path: str) -> str:
+    with open(path, 'rb') as f:
+        return hashlib.sha1(f.read()).hexdigest()[:12]
+
+
+# ============ DAEMON ============
+class Job:
+    """One submission: the keys it waits for and the chunks it owns in the queue"""
+
+    def __init__(self, job_id: str, writer: asyncio.StreamWriter):
+        self.id = job_id
+        self.writer = writer
+        self.chunks = deque()  # (scenario_key, strategy, [params tuple])
+        self.waiting = {}  # key -> [(scenario name, index)]
+        self.total = 0
+        self.done = 0
+
+    def send(self, message: dict):
+        if not self.writer.is_closing():
+            self.writer.write((json.dumps(message) + "\n").encode())
+
+
+class SweepDaemon:
+    def __init__(self, workers: int, state_dir: str):
+        self.workers = workers
+        self.busy = 0
+        self.state_dir = state_dir
+        self.streams = {}  # scenario_key -> encoded scenario
+        self.cache = {}  # key -> metrics list
+        self.owners = {}  # key -> jobs waiting for it (queued or running)
+        self.jobs = {}  # job id -> Job, in round-robin order
+        self.ready = asyncio.Condition()
+        self.executor = ThreadPoolExecutor(max_workers=workers)
+
+        os.makedirs(state_dir, exist_ok=True)
+        self.cache_path = os.path.join(state_dir, f"results-{binary_fingerprint(C_SWEEP_PATH)}.jsonl")
+        if os.path.exists(self.cache_path):
+            with open(self.cache_path) as f:
+                for line in f:
+                    try:
+                        entry = json.loads(line)
+                    except json.JSONDecodeError:
+                        continue  # Torn last line of a killed daemon
+                    self.cache[tuple(entry['key'][:2]) + (tuple(entry['key'][2]),)] = entry['metrics']
+        self.cache_file = open(self.cache_path, 'a')
+
+    # --- Scheduling ---
+    async def submit(self, request: dict, writer: asyncio.StreamWriter) -> Optional[Job]:
+        strategy = request.get('strategy', DEFAULT_STRATEGY)
+        if strategy not in STRATEGIES:
+            raise ValueError(f"Unknown strategy: {strategy}")
+        params = [tuple(int(v) for v in p) for p in request['params']]
+        if any(len(p) != 7 for p in params):
+            raise ValueError("Each configuration needs 7 timing values")
+
+        spec = json.dumps([strategy, request['scenarios'], params], sort_keys=True)
+        job = Job(hashlib.sha1(spec.encode()).hexdigest()[:12], writer)
+        while job.id in self.jobs:
+            job.id += "+"  # Same sweep submitted twice at once, the second shares all keys
+
+        cached = []
+        for name, encoded in request['scenarios'].items():
+            stream = base64.b64decode(encoded)
+            scenario_key = hashlib.sha1(stream).hexdigest()[:16]
+            self.streams[scenario_key] = stream
+
+            fresh = []
+            for index, p in enumerate(params):
+                key = (scenario_key, strategy, p)
+                job.total += 1
+                if key in self.cache:
+                    cached.append((name, index, self.cache[key]))
+                    continue
+                job.waiting.setdefault(key, []).append((name, index))
+                if key not in self.owners:
+                    self.owners[key] = []
+                    fresh.append(p)
+                if job not in self.owners[key]:
+                    self.owners[key].append(job)
+            for i in range(0, len(fresh), CHUNK_SIZE):
+                job.chunks.append((scenario_key, strategy, fresh[i:i + CHUNK_SIZE]))
+
+        job.send({'type': 'accepted', 'job': job.id, 'total': job.total, 'cached': len(cached)})
+        for name, index, metrics in cached:
+            job.done += 1
+            job.send({'type': 'result', 'scenario': name, 'index': index, 'metrics': metrics})
+
+        if not job.waiting:
+            job.send({'type': 'done', 'job': job.id})
+            return None
+
+        async with self.ready:
+            self.jobs[job.id] = job
+            self.ready.notify_all()
+        return job
+
+    async def cancel(self, job: Job):
+        """Client went away: its results stay cached, its queued chunks go to other waiters"""
+        async with self.ready:
+            self.jobs.pop(job.id, None)
+            for key in job.waiting:
+                if job in self.owners.get(key, []):
+                    self.owners[key].remove(job)
+            for scenario_key, strategy, chunk in job.chunks:
+                for p in chunk:
+                    key = (scenario_key, strategy, p)
+                    heirs = self.owners.get(key)
+                    if heirs:
+                        heirs[0].chunks.append((scenario_key, strategy, [p]))
+                    else:
+                        self.owners.pop(key, None)
+            job.chunks.clear()
+
+    def next_chunk(self):
+        """Round-robin: takes a chunk from the first job that has one and moves it to the back"""
+        for job_id in list(self.jobs):
+            job = self.jobs[job_id]
+            if job.chunks:
+                del self.jobs[job_id]
+                self.jobs[job_id] = job
+                return job.chunks.popleft()
+        return None
+
+    async def worker(self):
+        loop = asyncio.get_running_loop()
+        while True:
+            async with self.ready:
+                chunk = self.next_chunk()
+                while chunk is None:
+                    await self.ready.wait()
+                    chunk = self.next_chunk()
+                self.busy += 1
+
+            scenario_key, strategy, params = chunk
+            try:
+                metrics = await loop.run_in_executor(
+                    self.executor, sweep_stream, self.streams[scenario_key],
+                    [TimingParams(*p) for p in params], strategy)
+            except Exception as e:
+                print(f"Sweep failed: {e}", file=sys.stderr)
+                metrics = None
+
+            async with self.ready:
+                self.busy -= 1
+                self.finish(scenario_key, strategy, params, metrics)
+
+    def finish(self, scenario_key: str, strategy: str, params: list, metrics: Optional[list]):
+        for i, p in enumerate(params):
+            key = (scenario_key, strategy, p)
+            waiters = self.owners.pop(key, [])
+            if metrics is not None:
+                values = [metrics[i].avg_wait, metrics[i].max_wait, metrics[i].throughput, metrics[i].left_wait]
+                self.cache[key] = values
+                self.cache_file.write(json.dumps({'key': [scenario_key, strategy, list(p)],
+                                                  'metrics': values}) + "\n")
+
+            for job in waiters:
+                for name, index in job.waiting.pop(key, []):
+                    job.done += 1
+                    if metrics is None:
+                        job.send({'type': 'error', 'message': f"{name}: simulation failed"})
+                    else:
+                        job.send({'type': 'result', 'scenario': name, 'index': index, 'metrics': values})
+                if not job.waiting and job.id in self.jobs:
+                    del self.jobs[job.id]
+                    job.send({'type': 'done', 'job': job.id})
+        self.cache_file.flush()
+
+    # --- Connections ---
+    def status(self) -> dict:
+        return {
+            'type': 'status', 'workers': self.workers, 'busy': self.busy, 'cached': len(self.cache),
+            'jobs': [{'job': j.id, 'total': j.total, 'done': j.done, 'queued_chunks': len(j.chunks)}
+                     for j in self.jobs.values()],
+        }
+
+    async def handle(self, reader: asyncio.StreamReader, writer: asyncio.StreamWriter):
+        job = None
+        try:
+            while line := await reader.readline():
+                request = json.loads(line)
+                if request.get('op') == 'status':
+                    writer.write((json.dumps(self.status()) + "\n").encode())
+                elif request.get('op') == 'submit' and job is None:
+                    job = await self.submit(request, writer)
+                else:
+                    raise ValueError(f"Unexpected request: {request.get('op')}")
+                await writer.drain()
+        except (ValueError, KeyError, TypeError) as e:
+            writer.write((json.dumps({'type': 'error', 'message': str(e)}) + "\n").encode())
+        except (ConnectionError, asyncio.CancelledError):
+            pass  # Client gone, or daemon shutting down
+        finally:
+            if job is not None:
+                await self.cancel(job)
+            writer.close()
+
+    async def serve(self, socket_path: str):
+        if os.path.exists(socket_path):
+            os.unlink(socket_path)
+        server = await asyncio.start_unix_server(self.handle, path=socket_path, limit=STREAM_LIMIT)
+        os.chmod(socket_path, 0o600)
+        for _ in range(self.workers):
+            asyncio.create_task(self.worker())
+
+        print(f"Sweep daemon on {socket_path}: {self.workers} workers, "
+              f"{len(self.cache)} cached results ({self.cache_path})")
+        async with server:
+            await server.serve_forever()
+
+
+# ============ CLIENT ============
+def _request(socket_path: str, request: dict):
+    """Yields the daemon's answers to one request"""
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as sock:
+        sock.connect(socket_path)
+        sock.sendall((json.dumps(request) + "\n").encode())
+        with sock.makefile('r') as f:
+            for line in f:
+                yield json.loads(line)
+
+
+def submit_sweep(socket_path: str, scenarios: Dict[str, dict], params_list: List[TimingParams],
+                 strategy: str = DEFAULT_STRATEGY,
+                 on_result: Optional[Callable[[str, int, ScenarioMetrics], None]] = None
+                 ) -> Dict[str, List[ScenarioMetrics]]:
+    """
+    run_sweep through the daemon for several scenarios (name -> command list).
+    Returns the metrics of each scenario in params_list order; on_result sees
+    them in completion order.
+    """
+    request = {
+        'op': 'submit', 'strategy': strategy,
+        'scenarios': {name: base64.b64encode(encode_scenario(data)).decode()
+                      for name, data in scenarios.items()},
+        'params': [params_tuple(p) for p in params_list],
+    }
+    results = {name: [None] * len(params_list) for name in scenarios}
+
+    for attempt in range(RESUBMIT_ATTEMPTS):
+        if attempt > 0:
+            # Daemon restarted: resubmit, finished results come back from its cache
+            time.sleep(min(2 ** (attempt - 1), 10))
+        try:
+            for message in _request(socket_path, request):
+                if message['type'] == 'result':
+                    metrics = ScenarioMetrics(*message['metrics'])
+                    results[message['scenario']][message['index']] = metrics
+                    if on_result:
+                        on_result(message['scenario'], message['index'], metrics)
+                elif message['type'] == 'error':
+                    raise RuntimeError(f"Sweep daemon: {message['message']}")
+                elif message['type'] == 'done':
+                    return results
+        except (ConnectionError, FileNotFoundError):
+            if attempt == 0:
+                raise  # No daemon running
+    raise ConnectionError(f"Sweep daemon went away {RESUBMIT_ATTEMPTS} times before finishing the sweep")
+
+
+def main():
+    args = sys.argv[1:]
+
+    def option(name, default):
+        if name in args and args.index(name) + 1 < len(args):
+            return args[args.index(name) + 1]
+        return default
+
+    socket_path = option("--socket", DEFAULT_SOCKET)
+    command = args[0] if args else None
+
+    if command == "serve":
+        workers = int(option("--workers", os.cpu_count() or 1))
+        daemon_state = option("--state", DEFAULT_STATE_DIR)
+        if not os.path.exists(C_SWEEP_PATH):
+            sys.exit(f"Binary not found: {C_SWEEP_PATH} (run make in core/)")
+
+        async def run():
+            await SweepDaemon(workers, daemon_state).serve(socket_path)
+
+        try:
+            asyncio.run(run())
+        except KeyboardInterrupt:
+            pass
+        finally:
+            if os.path.exists(socket_path):
+                os.unlink(socket_path)
+    elif command == "status":
+        status = next(_request(socket_path, {'op': 'status'}))
+        print(f"{status['busy']}/{status['workers']} workers busy, {status['cached']} cached results")
+        for job in status['jobs']:
+            print(f"  job {job['job']}: {job['done']}/{job['total']} done, {job['queued_chunks']} chunks queued")
+    else:
+        print(__doc__)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
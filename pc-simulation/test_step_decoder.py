@@ -0,0 +1,66 @@
+"""
+Tests of step_decoder on hand-built step responses.
+
+Usage: python3 pc-simulation/test_step_decoder.py
+"""
+import unittest
+
+import numpy as np
+
+from step_decoder import (RESPONSE_STEP_DTYPE, VEHICLE_ID_LEN, decode_step_responses,
+                          header_offsets, index_scenario, wait_metrics)
+
+
+def step_response(step: int, ids: list) -> bytes:
+    """ResponseStep followed by its IDs, as written by traffic_sim."""
+    header = np.zeros(1, dtype=RESPONSE_STEP_DTYPE)
+    header['current_step'] = step
+    header['vehicles_out'] = len(ids)
+    return header.tobytes() + b''.join(i.encode('utf-8')[:VEHICLE_ID_LEN - 1].ljust(VEHICLE_ID_LEN, b'\0')
+                                       for i in ids)
+
+
+def add(vehicle_id: str, start: str = "north", end: str = "south") -> dict:
+    return {"type": "addVehicle", "vehicleId": vehicle_id, "startRoad": start, "endRoad": end}
+
+
+STEP = {"type": "step"}
+
+
+class StepDecoderTest(unittest.TestCase):
+    def test_offsets_skip_ids(self):
+        buf = step_response(1, []) + step_response(2, ["a", "b"]) + step_response(3, [])
+        self.assertEqual(header_offsets(buf).tolist(), [0, 11, 11 + 11 + 64])
+
+    def test_truncated_last_step_is_dropped(self):
+        buf = step_response(1, []) + step_response(2, ["a"])[:-1]
+        self.assertEqual(header_offsets(buf).tolist(), [0])
+
+    def test_repeated_id_matches_last_arrival(self):
+        # "car" arrives at step 0 and again at step 2; its departure at step 3 waited 1 step
+        scenario = {"commands": [add("car"), STEP, STEP, add("car"), STEP]}
+        buf = step_response(1, []) + step_response(2, []) + step_response(3, ["car"])
+
+        metrics = wait_metrics(decode_step_responses(buf), index_scenario(scenario))
+        self.assertEqual(metrics['throughput'], 1)
+        self.assertEqual(metrics['max_wait'], 1)
+
+    def test_long_id_matches_core_truncation(self):
+        long_id = "x" * 40
+        scenario = {"commands": [add(long_id), STEP, STEP]}
+        buf = step_response(1, []) + step_response(2, [long_id])
+
+        metrics = wait_metrics(decode_step_responses(buf), index_scenario(scenario))
+        self.assertEqual(metrics['throughput'], 1)
+        self.assertEqual(metrics['max_wait'], 2)
+
+    def test_unknown_id_is_ignored(self):
+        scenario = {"commands": [add("b"), STEP]}
+        buf = step_response(1, ["a", "b", "c"])
+
+        metrics = wait_metrics(decode_step_responses(buf), index_scenario(scenario))
+        self.assertEqual(metrics['throughput'], 1)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,143 @@
+"""
+Tests of the sweep daemon's scheduling with a fake traffic_sweep.
+
+Usage: python3 pc-simulation/test_sweep_daemon.py
+"""
+import asyncio
+import base64
+import json
+import os
+import socket
+import tempfile
+import threading
+import unittest
+from unittest import mock
+
+import sweep_daemon
+from optimize_timings import ScenarioMetrics
+
+SCENARIO = {'steady': base64.b64encode(b'scenario').decode()}
+
+
+def params(first: int, count: int) -> list:
+    return [[4, 3, 2, 3, 1, 15, p] for p in range(first, first + count)]
+
+
+class FakeSweep:
+    """Records every simulated configuration; blocks until released"""
+
+    def __init__(self):
+        self.simulated = []
+        self.release = threading.Event()
+        self.lock = threading.Lock()
+
+    def __call__(self, stream, params_list, strategy):
+        self.release.wait()
+        with self.lock:
+            self.simulated.extend(sweep_daemon.params_tuple(p) for p in params_list)
+        return [ScenarioMetrics(p.skip_limit, 2 * p.skip_limit, 1) for p in params_list]
+
+
+class SweepDaemonTest(unittest.IsolatedAsyncioTestCase):
+    async def asyncSetUp(self):
+        self.tmp = tempfile.TemporaryDirectory()
+        self.socket_path = os.path.join(self.tmp.name, "sweepd.sock")
+        self.sweep = FakeSweep()
+        patches = [mock.patch.object(sweep_daemon, 'sweep_stream', self.sweep),
+                   mock.patch.object(sweep_daemon, 'binary_fingerprint', lambda path: "test")]
+        for p in patches:
+            p.start()
+            self.addCleanup(p.stop)
+
+        self.daemon = sweep_daemon.SweepDaemon(1, self.tmp.name)
+        self.server = asyncio.create_task(self.daemon.serve(self.socket_path))
+        while not os.path.exists(self.socket_path):
+            await asyncio.sleep(0.01)
+
+    async def asyncTearDown(self):
+        self.sweep.release.set()
+        self.server.cancel()
+        await asyncio.gather(self.server, return_exceptions=True)
+        self.daemon.executor.shutdown()
+        self.daemon.cache_file.close()
+        self.tmp.cleanup()
+
+    async def submit(self, params_list: list):
+        reader, writer = await asyncio.open_unix_connection(self.socket_path)
+        request = {'op': 'submit', 'strategy': 'v6', 'scenarios': SCENARIO, 'params': params_list}
+        writer.write((json.dumps(request) + "\n").encode())
+        accepted = json.loads(await reader.readline())
+        self.assertEqual(accepted['type'], 'accepted')
+        return reader, writer
+
+    @staticmethod
+    async def results(reader) -> dict:
+        results = {}
+        while (message := json.loads(await reader.readline()))['type'] != 'done':
+            results[message['index']] = message['metrics']
+        return results
+
+    async def test_overlapping_sweeps_share_results(self):
+        reader_a, writer_a = await self.submit(params(0, 40))
+        reader_b, writer_b = await self.submit(params(20, 40))  # Keys 20-39 already queued by the first
+        self.sweep.release.set()
+
+        results_a = await self.results(reader_a)
+        results_b = await self.results(reader_b)
+        writer_a.close()
+        writer_b.close()
+
+        self.assertEqual(len(self.sweep.simulated), 60, "Every key should be simulated once")
+        self.assertEqual(len(set(self.sweep.simulated)), 60)
+        self.assertEqual(len(results_a), 40)
+        self.assertEqual(len(results_b), 40)
+        for index in range(20):
+            self.assertEqual(results_b[index], results_a[index + 20])
+
+    async def test_cancel_drops_queued_chunks(self):
+        reader, writer = await self.submit(params(0, 10 * sweep_daemon.CHUNK_SIZE))
+        while self.daemon.busy == 0:
+            await asyncio.sleep(0.01)  # First chunk taken by the only worker
+        writer.close()
+        while self.daemon.jobs:
+            await asyncio.sleep(0.01)
+        self.sweep.release.set()
+
+        # A later sweep runs behind whatever the cancelled one left over
+        reader_next, writer_next = await self.submit(params(1000, 1))
+        await self.results(reader_next)
+        writer_next.close()
+
+        self.assertEqual(len(self.sweep.simulated), sweep_daemon.CHUNK_SIZE + 1,
+                         "Only the chunk already running should finish")
+
+
+class SubmitRetryTest(unittest.TestCase):
+    def test_gives_up_when_daemon_keeps_closing(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            socket_path = os.path.join(tmp, "sweepd.sock")
+            server = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            server.bind(socket_path)
+            server.listen()
+            server.settimeout(10)  # No hanging test if the client stops early
+            accepted = []
+
+            def close_every_connection():
+                while len(accepted) < sweep_daemon.RESUBMIT_ATTEMPTS:
+                    conn, _ = server.accept()
+                    with conn, conn.makefile('r') as f:
+                        accepted.append(f.readline())  # Request read, connection closed before "done"
+
+            thread = threading.Thread(target=close_every_connection, daemon=True)
+            thread.start()
+            with mock.patch.object(sweep_daemon.time, 'sleep'):
+                with self.assertRaises(ConnectionError):
+                    sweep_daemon.submit_sweep(socket_path, {'steady': {'commands': []}},
+                                              [sweep_daemon.TimingParams(4, 3, 2, 3, 1, 15, 2)])
+            thread.join()
+            server.close()
+            self.assertEqual(len(accepted), sweep_daemon.RESUBMIT_ATTEMPTS)
+
+
+if __name__ == '__main__':
+    unittest.main()